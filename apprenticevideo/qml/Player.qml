@@ -16,6 +16,7 @@ Item
   signal skipToInPoint()
   signal skipToOutPoint()
   signal stepOneFrameForward()
+  signal stepOneFrameBackward()
   signal skipForward()
   signal skipBack()
 
@@ -72,6 +73,13 @@ Item
       stepOneFrameForward();
       event.accepted = true;
     }
+    else if (event.key == Qt.Key_B ||
+             event.key == Qt.Key_Left ||
+             event.key == Qt.Key_Up)
+    {
+      stepOneFrameBackward();
+      event.accepted = true;
+    }
     else if (event.key == Qt.Key_MediaNext ||
              event.key == Qt.Key_Period ||
              event.key == Qt.Key_Greater ||
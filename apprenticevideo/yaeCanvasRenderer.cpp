@@ -16,8 +16,12 @@
 #include <sstream>
 
 // boost includes:
+#include <boost/chrono/chrono.hpp>
 #include <boost/thread.hpp>
 
+// yae includes:
+#include "yae/utils/yae_benchmark.h"
+
 // local includes:
 #include "yaeCanvasRenderer.h"
 
@@ -1031,6 +1035,24 @@ namespace yae
 
     this->glProgramLocalParameter4dvARB = (TProgramLocalParameter4dvARB)
       opengl->getProcAddress("glProgramLocalParameter4dvARB");
+
+    this->glMapBuffer = (TMapBuffer)
+      opengl->getProcAddress("glMapBuffer");
+
+    this->glMapBufferRange = (TMapBufferRange)
+      opengl->getProcAddress("glMapBufferRange");
+
+    this->glUnmapBuffer = (TUnmapBuffer)
+      opengl->getProcAddress("glUnmapBuffer");
+
+    this->glFenceSync = (TFenceSync)
+      opengl->getProcAddress("glFenceSync");
+
+    this->glClientWaitSync = (TClientWaitSync)
+      opengl->getProcAddress("glClientWaitSync");
+
+    this->glDeleteSync = (TDeleteSync)
+      opengl->getProcAddress("glDeleteSync");
   }
 
   //----------------------------------------------------------------
@@ -1435,6 +1457,212 @@ namespace yae
   }
 
 
+  //----------------------------------------------------------------
+  // pbo_map_buffer_range_supported
+  //
+  static bool
+  pbo_map_buffer_range_supported()
+  {
+#ifdef YAE_USE_QOPENGL_WIDGET
+    YAE_OPENGL_HERE();
+    if (!opengl.glMapBufferRange)
+    {
+      return false;
+    }
+#endif
+
+    return yae_is_opengl_extension_supported("GL_ARB_map_buffer_range");
+  }
+
+  //----------------------------------------------------------------
+  // pbo_sync_supported
+  //
+  static bool
+  pbo_sync_supported()
+  {
+#ifdef YAE_USE_QOPENGL_WIDGET
+    YAE_OPENGL_HERE();
+    if (!(opengl.glFenceSync &&
+          opengl.glClientWaitSync &&
+          opengl.glDeleteSync))
+    {
+      return false;
+    }
+#endif
+
+    return yae_is_opengl_extension_supported("GL_ARB_sync");
+  }
+
+  //----------------------------------------------------------------
+  // TPixelUnpackBuffers::TPixelUnpackBuffers
+  //
+  TPixelUnpackBuffers::TPixelUnpackBuffers(std::size_t ringSize):
+    ring_(std::max<std::size_t>(1, ringSize)),
+    next_(0),
+    curr_(0)
+  {}
+
+  //----------------------------------------------------------------
+  // TPixelUnpackBuffers::supported
+  //
+  bool
+  TPixelUnpackBuffers::supported()
+  {
+#ifdef YAE_USE_QOPENGL_WIDGET
+    YAE_OPENGL_HERE();
+    if (!(opengl.glMapBuffer && opengl.glUnmapBuffer))
+    {
+      return false;
+    }
+#endif
+
+    return (yae_is_opengl_extension_supported("GL_ARB_pixel_buffer_object") ||
+            yae_is_opengl_extension_supported("GL_EXT_pixel_buffer_object"));
+  }
+
+  //----------------------------------------------------------------
+  // TPixelUnpackBuffers::destroy
+  //
+  void
+  TPixelUnpackBuffers::destroy()
+  {
+    YAE_OPENGL_HERE();
+
+    for (std::size_t i = 0; i < ring_.size(); i++)
+    {
+      Buffer & buffer = ring_[i];
+
+      if (buffer.fence_)
+      {
+        YAE_OPENGL(glDeleteSync(buffer.fence_));
+        buffer.fence_ = NULL;
+      }
+
+      if (buffer.pbo_)
+      {
+        YAE_OPENGL(glDeleteBuffers(1, &buffer.pbo_));
+        buffer.pbo_ = 0;
+      }
+
+      buffer.size_ = 0;
+    }
+
+    next_ = 0;
+    curr_ = 0;
+  }
+
+  //----------------------------------------------------------------
+  // TPixelUnpackBuffers::map
+  //
+  unsigned char *
+  TPixelUnpackBuffers::map(std::size_t numBytes)
+  {
+    YAE_OPENGL_HERE();
+
+    const bool fences = pbo_sync_supported();
+    const bool ranges = pbo_map_buffer_range_supported();
+
+    curr_ = next_;
+    next_ = (next_ + 1) % ring_.size();
+
+    Buffer & buffer = ring_[curr_];
+    if (!buffer.pbo_)
+    {
+      YAE_OPENGL(glGenBuffers(1, &buffer.pbo_));
+      buffer.size_ = 0;
+    }
+
+    if (buffer.fence_)
+    {
+      // the ring is deep enough that the GPU is usually done
+      // with this buffer by now, but don't overwrite it if not:
+      YAE_OPENGL(glClientWaitSync(buffer.fence_,
+                                  GL_SYNC_FLUSH_COMMANDS_BIT,
+                                  GLuint64(1000000000)));
+      YAE_OPENGL(glDeleteSync(buffer.fence_));
+      buffer.fence_ = NULL;
+    }
+
+    YAE_OPENGL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer.pbo_));
+
+    if (buffer.size_ < numBytes || !fences)
+    {
+      // allocate new storage, without fences this also orphans
+      // the old storage that the GPU may still be reading from:
+      buffer.size_ = std::max(buffer.size_, numBytes);
+      YAE_OPENGL(glBufferData(GL_PIXEL_UNPACK_BUFFER,
+                              (GLsizeiptr)(buffer.size_),
+                              NULL,
+                              GL_STREAM_DRAW));
+    }
+
+    void * ptr = NULL;
+    if (ranges)
+    {
+      GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT;
+      if (fences)
+      {
+        access |= GL_MAP_UNSYNCHRONIZED_BIT;
+      }
+
+      ptr = YAE_OPENGL(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER,
+                                        0,
+                                        (GLsizeiptr)numBytes,
+                                        access));
+    }
+    else
+    {
+      ptr = YAE_OPENGL(glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY));
+    }
+
+    if (!ptr)
+    {
+      YAE_OPENGL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+      yae_assert_gl_no_error();
+    }
+
+    return (unsigned char *)ptr;
+  }
+
+  //----------------------------------------------------------------
+  // TPixelUnpackBuffers::unmap
+  //
+  bool
+  TPixelUnpackBuffers::unmap()
+  {
+    YAE_OPENGL_HERE();
+
+    if (YAE_OPENGL(glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER)) != GL_TRUE)
+    {
+      // buffer contents were corrupted (display mode change, etc...):
+      YAE_OPENGL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+      return false;
+    }
+
+    return true;
+  }
+
+  //----------------------------------------------------------------
+  // TPixelUnpackBuffers::release
+  //
+  void
+  TPixelUnpackBuffers::release()
+  {
+    YAE_OPENGL_HERE();
+
+    if (pbo_sync_supported())
+    {
+      Buffer & buffer = ring_[curr_];
+      YAE_ASSERT(!buffer.fence_);
+      buffer.fence_ = YAE_OPENGL(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE,
+                                             0));
+    }
+
+    YAE_OPENGL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+    yae_assert_gl_no_error();
+  }
+
+
   //----------------------------------------------------------------
   // TBaseCanvas::TBaseCanvas
   //
@@ -1443,6 +1671,7 @@ namespace yae
     darCropped_(0.0),
     skipColorConverter_(false),
     verticalScalingEnabled_(false),
+    asyncUpload_(true),
     shader_(NULL)
   {
     double identity[] = {
@@ -1523,6 +1752,99 @@ namespace yae
     verticalScalingEnabled_ = enable;
   }
 
+  //----------------------------------------------------------------
+  // TBaseCanvas::enableAsyncUpload
+  //
+  void
+  TBaseCanvas::enableAsyncUpload(bool enable)
+  {
+    boost::lock_guard<boost::mutex> lock(mutex_);
+    asyncUpload_ = enable;
+  }
+
+  //----------------------------------------------------------------
+  // TBaseCanvas::uploadStats
+  //
+  TUploadStats
+  TBaseCanvas::uploadStats() const
+  {
+    boost::lock_guard<boost::mutex> lock(mutex_);
+    return uploadStats_;
+  }
+
+  //----------------------------------------------------------------
+  // TBaseCanvas::stagePlanes
+  //
+  bool
+  TBaseCanvas::stagePlanes(const TFragmentShader & shader,
+                           const unsigned char ** src,
+                           std::size_t & numBytes)
+  {
+    const IPlanarBuffer & planes = *(frame_->data_);
+    const VideoTraits & vtts = frame_->traits_;
+
+    std::size_t offset[4] = { 0 };
+    std::size_t size[4] = { 0 };
+    numBytes = 0;
+
+    for (std::size_t k = 0; k < shader.numPlanes_; k++)
+    {
+      src[k] = planes.data(k);
+      size[k] = planes.rowBytes(k) * (vtts.encodedHeight_ /
+                                      shader.subsample_y_[k]);
+
+      // keep each plane cache line aligned within the buffer:
+      offset[k] = numBytes;
+      numBytes += (size[k] + 63) & ~std::size_t(63);
+    }
+
+    if (!asyncUpload_ || !TPixelUnpackBuffers::supported())
+    {
+      return false;
+    }
+
+    unsigned char * dst = pbo_.map(numBytes);
+    if (!dst)
+    {
+      return false;
+    }
+
+    for (std::size_t k = 0; k < shader.numPlanes_; k++)
+    {
+      memcpy(dst + offset[k], src[k], size[k]);
+    }
+
+    if (!pbo_.unmap())
+    {
+      return false;
+    }
+
+    // while the buffer is bound the texture data pointers
+    // are interpreted as offsets into the buffer:
+    for (std::size_t k = 0; k < shader.numPlanes_; k++)
+    {
+      src[k] = reinterpret_cast<const unsigned char *>(offset[k]);
+    }
+
+    return true;
+  }
+
+  //----------------------------------------------------------------
+  // TBaseCanvas::updateUploadStats
+  //
+  void
+  TBaseCanvas::updateUploadStats(bool staged,
+                                 std::size_t numBytes,
+                                 uint64 usec)
+  {
+    uploadStats_.frames_++;
+    uploadStats_.staged_ += staged ? 1 : 0;
+    uploadStats_.bytes_ += numBytes;
+    uploadStats_.lastUsec_ = usec;
+    uploadStats_.maxUsec_ = std::max(uploadStats_.maxUsec_, usec);
+    uploadStats_.totalUsec_ += usec;
+  }
+
   //----------------------------------------------------------------
   // TBaseCanvas::getCroppedFrame
   //
@@ -2075,6 +2397,11 @@ namespace yae
       texId_.clear();
     }
 
+    if (TPixelUnpackBuffers::supported())
+    {
+      pbo_.destroy();
+    }
+
     dar_ = 0.0;
     darCropped_ = 0.0;
     crop_.clear();
@@ -2182,8 +2509,18 @@ namespace yae
 
     // upload texture data:
     const TFragmentShader & shader = shader_ ? *shader_ : builtinShader_;
-    TGLSaveClientState pushClientAttr(GL_CLIENT_ALL_ATTRIB_BITS);
     {
+      YAE_PROBE(probe, "TModernCanvas::upload");
+      boost::chrono::steady_clock::time_point
+        t0 = boost::chrono::steady_clock::now();
+
+      TGLSaveClientState pushClientAttr(GL_CLIENT_ALL_ATTRIB_BITS);
+
+      // stage the sample planes in a pixel unpack buffer, if possible:
+      const unsigned char * src[4] = { NULL };
+      std::size_t numBytes = 0;
+      bool staged = stagePlanes(shader, src, numBytes);
+
       YAE_OGL_11(glEnable(GL_TEXTURE_RECTANGLE_ARB));
 
       for (std::size_t i = 0; i < shader.numPlanes_; i++)
@@ -2193,7 +2530,7 @@ namespace yae
         YAE_OGL_11(glPixelStorei(GL_UNPACK_SWAP_BYTES,
                                  shader.shouldSwapBytes_[i]));
 
-        const unsigned char * data = frame->data_->data(i);
+        const unsigned char * data = src[i];
         std::size_t rowSize =
           frame->data_->rowBytes(i) / (shader.stride_[i] / 8);
         YAE_OGL_11(glPixelStorei(GL_UNPACK_ALIGNMENT,
@@ -2201,18 +2538,33 @@ namespace yae
         YAE_OGL_11(glPixelStorei(GL_UNPACK_ROW_LENGTH, (GLint)(rowSize)));
         yae_assert_gl_no_error();
 
-        YAE_OGL_11(glTexImage2D(GL_TEXTURE_RECTANGLE_ARB,
-                                0, // always 0 for GL_TEXTURE_RECTANGLE_ARB
-                                shader.internalFormatGL_[i],
-                                vtts.encodedWidth_ / shader.subsample_x_[i],
-                                vtts.encodedHeight_ / shader.subsample_y_[i],
-                                0, // border width
-                                shader.pixelFormatGL_[i],
-                                shader.dataTypeGL_[i],
-                                data));
+        // texture storage was allocated when the frame size
+        // or format changed, only replace the samples:
+        YAE_OGL_11(glTexSubImage2D(GL_TEXTURE_RECTANGLE_ARB,
+                                   0, // always 0 for GL_TEXTURE_RECTANGLE_ARB
+                                   0, // x-offset
+                                   0, // y-offset
+                                   vtts.encodedWidth_ /
+                                   shader.subsample_x_[i],
+                                   vtts.encodedHeight_ /
+                                   shader.subsample_y_[i],
+                                   shader.pixelFormatGL_[i],
+                                   shader.dataTypeGL_[i],
+                                   data));
         yae_assert_gl_no_error();
       }
       YAE_OGL_11(glDisable(GL_TEXTURE_RECTANGLE_ARB));
+
+      if (staged)
+      {
+        pbo_.release();
+      }
+
+      boost::chrono::steady_clock::time_point
+        t1 = boost::chrono::steady_clock::now();
+
+      updateUploadStats(staged, numBytes, boost::chrono::duration_cast
+                        <boost::chrono::microseconds>(t1 - t0).count());
     }
 
     if (shader_)
@@ -2466,6 +2818,11 @@ namespace yae
       texId_.clear();
     }
 
+    if (TPixelUnpackBuffers::supported())
+    {
+      pbo_.destroy();
+    }
+
     w_ = 0;
     h_ = 0;
     dar_ = 0.0;
@@ -2706,8 +3063,19 @@ namespace yae
       return false;
     }
 
-    // get the source data pointers:
+    YAE_PROBE(probe, "TLegacyCanvas::upload");
+    boost::chrono::steady_clock::time_point
+      t0 = boost::chrono::steady_clock::now();
+
+    TGLSaveClientState pushClientAttr(GL_CLIENT_ALL_ATTRIB_BITS);
+
+    // stage the sample planes in a pixel unpack buffer, if possible:
     const TFragmentShader & shader = shader_ ? *shader_ : builtinShader_;
+    const unsigned char * base[4] = { NULL };
+    std::size_t numBytes = 0;
+    bool staged = stagePlanes(shader, base, numBytes);
+
+    // get the source data pointers:
     const unsigned char * src[4] = { NULL };
 
     for (std::size_t k = 0; k < shader.numPlanes_; k++)
@@ -2717,13 +3085,12 @@ namespace yae
       const std::size_t bytesPerRow = frame_->data_->rowBytes(k);
       const std::size_t bytesPerPixel = ptts->stride_[k] / 8;
       src[k] =
-        frame_->data_->data(k) +
+        base[k] +
         (crop.y_ / subsample_y) * bytesPerRow +
         (crop.x_ / subsample_x) * bytesPerPixel;
     }
 
     // upload the texture data:
-    TGLSaveClientState pushClientAttr(GL_CLIENT_ALL_ATTRIB_BITS);
     for (std::size_t k = 0; k < shader.numPlanes_; k++)
     {
       unsigned int subsample_x = shader.subsample_x_[k];
@@ -2732,7 +3099,7 @@ namespace yae
       YAE_OGL_11(glPixelStorei(GL_UNPACK_SWAP_BYTES,
                                shader.shouldSwapBytes_[k]));
 
-      const unsigned char * data = frame->data_->data(k);
+      const unsigned char * data = base[k];
       std::size_t rowSize =
         frame->data_->rowBytes(k) / (ptts->stride_[k] / 8);
       YAE_OGL_11(glPixelStorei(GL_UNPACK_ALIGNMENT,
@@ -2859,6 +3226,17 @@ namespace yae
       }
     }
 
+    if (staged)
+    {
+      pbo_.release();
+    }
+
+    boost::chrono::steady_clock::time_point
+      t1 = boost::chrono::steady_clock::now();
+
+    updateUploadStats(staged, numBytes, boost::chrono::duration_cast
+                      <boost::chrono::microseconds>(t1 - t0).count());
+
     if (shader_)
     {
       YAE_OPENGL_HERE();
@@ -3170,6 +3548,29 @@ namespace yae
     }
   }
 
+  //----------------------------------------------------------------
+  // CanvasRenderer::enableAsyncUpload
+  //
+  void
+  CanvasRenderer::enableAsyncUpload(bool enable)
+  {
+    legacy_->enableAsyncUpload(enable);
+
+    if (modern_)
+    {
+      modern_->enableAsyncUpload(enable);
+    }
+  }
+
+  //----------------------------------------------------------------
+  // CanvasRenderer::uploadStats
+  //
+  TUploadStats
+  CanvasRenderer::uploadStats() const
+  {
+    return renderer_->uploadStats();
+  }
+
   //----------------------------------------------------------------
   // CanvasRenderer::getCroppedFrame
   //
@@ -118,6 +118,43 @@ namespace yae
                                                         GLuint index,
                                                         const GLdouble *);
 
+  //----------------------------------------------------------------
+  // TMapBuffer
+  //
+  typedef void * (APIENTRYP TMapBuffer)(GLenum target,
+                                        GLenum access);
+
+  //----------------------------------------------------------------
+  // TMapBufferRange
+  //
+  typedef void * (APIENTRYP TMapBufferRange)(GLenum target,
+                                             GLintptr offset,
+                                             GLsizeiptr length,
+                                             GLbitfield access);
+
+  //----------------------------------------------------------------
+  // TUnmapBuffer
+  //
+  typedef GLboolean (APIENTRYP TUnmapBuffer)(GLenum target);
+
+  //----------------------------------------------------------------
+  // TFenceSync
+  //
+  typedef GLsync (APIENTRYP TFenceSync)(GLenum condition,
+                                        GLbitfield flags);
+
+  //----------------------------------------------------------------
+  // TClientWaitSync
+  //
+  typedef GLenum (APIENTRYP TClientWaitSync)(GLsync sync,
+                                             GLbitfield flags,
+                                             GLuint64 timeout);
+
+  //----------------------------------------------------------------
+  // TDeleteSync
+  //
+  typedef void (APIENTRYP TDeleteSync)(GLsync sync);
+
   //----------------------------------------------------------------
   // YAE_GL_FRAGMENT_PROGRAM_ARB
   //
@@ -130,6 +167,14 @@ namespace yae
     TGenProgramsARB glGenProgramsARB;
     TProgramLocalParameter4dvARB glProgramLocalParameter4dvARB;
 
+    // pixel unpack buffer streaming, may be NULL:
+    TMapBuffer glMapBuffer;
+    TMapBufferRange glMapBufferRange;
+    TUnmapBuffer glUnmapBuffer;
+    TFenceSync glFenceSync;
+    TClientWaitSync glClientWaitSync;
+    TDeleteSync glDeleteSync;
+
     OpenGLFunctionPointers();
 
     static OpenGLFunctionPointers & get();
@@ -408,6 +453,89 @@ namespace yae
   };
 
 
+  //----------------------------------------------------------------
+  // TPixelUnpackBuffers
+  //
+  // A ring of pixel unpack buffer objects for asynchronous texture
+  // uploads.  Frame planes are copied into a write-only mapped buffer
+  // and glTex(Sub)Image2D sources the samples from the bound buffer,
+  // so the transfer to the texture happens on the GPU timeline instead
+  // of blocking the calling thread while the driver copies client memory.
+  //
+  // With GL_ARB_sync each buffer is fenced after use and the fence
+  // is waited on before the buffer is mapped again; without it
+  // the buffer storage is orphaned instead.
+  //
+  // NOTE: all methods must be called with the OpenGL context current.
+  //
+  struct TPixelUnpackBuffers
+  {
+    TPixelUnpackBuffers(std::size_t ringSize = 3);
+
+    static bool supported();
+
+    // release the buffer objects and fences:
+    void destroy();
+
+    // bind and map the next buffer in the ring, growing it if necessary;
+    // returns NULL if the buffer could not be mapped:
+    unsigned char * map(std::size_t numBytes);
+
+    // unmap the buffer, it remains bound to GL_PIXEL_UNPACK_BUFFER;
+    // returns false (and unbinds) if the buffer contents were lost:
+    bool unmap();
+
+    // call this after issuing all glTex(Sub)Image2D calls that source
+    // from the mapped buffer, this fences and unbinds the buffer:
+    void release();
+
+  protected:
+    struct Buffer
+    {
+      Buffer(): pbo_(0), size_(0), fence_(NULL) {}
+
+      GLuint pbo_;
+      std::size_t size_;
+      GLsync fence_;
+    };
+
+    std::vector<Buffer> ring_;
+    std::size_t next_;
+    std::size_t curr_;
+  };
+
+  //----------------------------------------------------------------
+  // TUploadStats
+  //
+  // texture upload timing, measured on the thread that calls loadFrame:
+  //
+  struct TUploadStats
+  {
+    TUploadStats():
+      frames_(0),
+      staged_(0),
+      bytes_(0),
+      lastUsec_(0),
+      maxUsec_(0),
+      totalUsec_(0)
+    {}
+
+    inline double avgUsec() const
+    { return frames_ ? double(totalUsec_) / double(frames_) : 0.0; }
+
+    // number of frames uploaded, and how many of those
+    // were staged through a pixel unpack buffer:
+    uint64 frames_;
+    uint64 staged_;
+
+    // sample plane bytes uploaded:
+    uint64 bytes_;
+
+    uint64 lastUsec_;
+    uint64 maxUsec_;
+    uint64 totalUsec_;
+  };
+
   //----------------------------------------------------------------
   // TBaseCanvas
   //
@@ -433,6 +561,15 @@ namespace yae
 
     void enableVerticalScaling(bool enable);
 
+    // stream texture uploads through pixel unpack buffers
+    // when supported, enabled by default:
+    void enableAsyncUpload(bool enable);
+
+    inline bool asyncUpload() const
+    { return asyncUpload_; }
+
+    TUploadStats uploadStats() const;
+
     bool getCroppedFrame(TCropFrame & crop) const;
 
     bool imageWidthHeight(double & w, double & h) const;
@@ -470,6 +607,21 @@ namespace yae
     bool setFrame(const TVideoFramePtr & frame,
                   bool & colorSpaceOrRangeChanged);
 
+    // helper, must hold the mutex and the context must be current;
+    // passes back per-plane pointers to pass to glTex(Sub)Image2D:
+    // pixel unpack buffer offsets if the frame planes were staged
+    // in a pixel unpack buffer, client memory pointers otherwise.
+    // returns true if the planes were staged, in which case
+    // pbo_.release() must be called after the texture uploads:
+    bool stagePlanes(const TFragmentShader & shader,
+                     const unsigned char ** src,
+                     std::size_t & numBytes);
+
+    // helper, must hold the mutex:
+    void updateUploadStats(bool staged,
+                           std::size_t numBytes,
+                           uint64 usec);
+
     mutable boost::mutex mutex_;
     TVideoFramePtr frame_;
     TCropFrame crop_;
@@ -477,6 +629,10 @@ namespace yae
     double darCropped_;
     bool skipColorConverter_;
     bool verticalScalingEnabled_;
+    bool asyncUpload_;
+
+    TPixelUnpackBuffers pbo_;
+    TUploadStats uploadStats_;
 
     TFragmentShader builtinShader_;
     std::map<TPixelFormatId, TFragmentShader> shaders_;
@@ -617,6 +773,14 @@ namespace yae
 
     void enableVerticalScaling(bool enable);
 
+    void enableAsyncUpload(bool enable);
+
+    inline bool asyncUpload() const
+    { return legacy_->asyncUpload(); }
+
+    // upload timing of the currently selected renderer:
+    TUploadStats uploadStats() const;
+
     bool getCroppedFrame(TCropFrame & crop) const;
 
     bool imageWidthHeight(double & w, double & h) const;
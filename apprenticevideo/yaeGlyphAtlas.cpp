@@ -0,0 +1,678 @@
+// -*- Mode: c++; tab-width: 8; c-basic-offset: 2; indent-tabs-mode: nil -*-
+// NOTE: the first line of this file sets up source code indentation rules
+// for Emacs; it is also a hint to anyone modifying this file.
+
+// Created      : Wed Oct 21 21:07:36 MDT 2026
+// Copyright    : Pavel Koshevoy
+// License      : MIT -- http://www.opensource.org/licenses/mit-license.php
+
+// standard libraries:
+#include <algorithm>
+#include <cmath>
+#include <list>
+#include <map>
+#include <utility>
+
+// Qt library:
+#include <QFontMetricsF>
+#include <QImage>
+#include <QList>
+#include <QPainter>
+#include <QRawFont>
+#include <QTextLayout>
+#include <QTextOption>
+#include <QVector>
+
+// local interfaces:
+#include "yaeGlyphAtlas.h"
+#include "yaeTexture.h"
+
+
+namespace yae
+{
+
+  //----------------------------------------------------------------
+  // kMaxRecentAtlases
+  //
+  // font sizes follow the window size, so atlases for sizes
+  // no longer in use must not pile up:
+  //
+  static const std::size_t kMaxRecentAtlases = 32;
+
+  //----------------------------------------------------------------
+  // clipSpan
+  //
+  // clip [a0, a1) to [lo, hi) and adjust texture coordinates
+  // [t0, t1) proportionally, returns false if nothing is left:
+  //
+  static bool
+  clipSpan(double & a0, double & a1,
+           double & t0, double & t1,
+           double lo, double hi)
+  {
+    double da = a1 - a0;
+    double dt = t1 - t0;
+
+    if (a0 < lo)
+    {
+      t0 += dt * (lo - a0) / da;
+      a0 = lo;
+    }
+
+    if (a1 > hi)
+    {
+      t1 -= dt * (a1 - hi) / da;
+      a1 = hi;
+    }
+
+    return a0 < a1;
+  }
+
+
+  //----------------------------------------------------------------
+  // GlyphAtlas::Batch::clear
+  //
+  void
+  GlyphAtlas::Batch::clear()
+  {
+    pages_.clear();
+  }
+
+  //----------------------------------------------------------------
+  // GlyphAtlas::Batch::empty
+  //
+  bool
+  GlyphAtlas::Batch::empty() const
+  {
+    for (std::size_t i = 0; i < pages_.size(); i++)
+    {
+      if (!pages_[i].empty())
+      {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+
+  //----------------------------------------------------------------
+  // GlyphAtlas::TPrivate
+  //
+  struct GlyphAtlas::TPrivate
+  {
+    TPrivate(const QFont & font, double supersample);
+    ~TPrivate();
+
+    //----------------------------------------------------------------
+    // Glyph
+    //
+    struct Glyph
+    {
+      Glyph():
+        page_(-1),
+        x0_(0), y0_(0), x1_(0), y1_(0),
+        u0_(0), v0_(0), u1_(0), v1_(0)
+      {}
+
+      // -1 for blank glyphs and glyphs too big for the atlas:
+      int page_;
+
+      // glyph cell relative to the pen position, supersampled pixels:
+      double x0_;
+      double y0_;
+      double x1_;
+      double y1_;
+
+      // glyph cell in the atlas page:
+      double u0_;
+      double v0_;
+      double u1_;
+      double v1_;
+    };
+
+    //----------------------------------------------------------------
+    // Pending
+    //
+    // rasterized glyph waiting to be uploaded:
+    //
+    struct Pending
+    {
+      Pending(int x, int y, const QImage & image):
+        x_(x),
+        y_(y),
+        image_(image)
+      {}
+
+      int x_;
+      int y_;
+      QImage image_;
+    };
+
+    //----------------------------------------------------------------
+    // Page
+    //
+    // glyphs are packed in rows (shelves), left to right:
+    //
+    struct Page
+    {
+      Page():
+        texId_(0),
+        shelfX_(0),
+        shelfY_(0),
+        shelfH_(0)
+      {}
+
+      GLuint texId_;
+      int shelfX_;
+      int shelfY_;
+      int shelfH_;
+      std::list<Pending> pending_;
+    };
+
+    const Glyph & lookup(const QRawFont & rawFont,
+                         const QString & rawFontKey,
+                         quint32 glyphIndex);
+
+    bool allocate(int w, int h, int & page, int & x, int & y);
+    void flush(Page & page);
+
+    typedef std::pair<QString, quint32> TGlyphKey;
+    std::map<TGlyphKey, Glyph> glyphs_;
+    std::vector<Page> pages_;
+    double supersample_;
+    unsigned int downsample_;
+    int pageSize_;
+  };
+
+  //----------------------------------------------------------------
+  // GlyphAtlas::TPrivate::TPrivate
+  //
+  GlyphAtlas::TPrivate::TPrivate(const QFont & font, double supersample):
+    supersample_(supersample),
+    downsample_(1),
+    pageSize_(512)
+  {
+    // supersampled glyphs are scaled down by a power-of-two factor
+    // before they are stored, same as downsampleImage:
+    while (supersample >= 2.0)
+    {
+      downsample_ *= 2;
+      supersample /= 2.0;
+    }
+
+    // make room for at least a few rows of glyphs per page:
+    QFontMetricsF fm(font);
+    int cellHeight = int(std::ceil(fm.height() / double(downsample_))) + 4;
+    pageSize_ = std::max<int>(pageSize_, powerOfTwoGEQ<int>(cellHeight * 4));
+  }
+
+  //----------------------------------------------------------------
+  // GlyphAtlas::TPrivate::~TPrivate
+  //
+  GlyphAtlas::TPrivate::~TPrivate()
+  {
+    for (std::size_t i = 0; i < pages_.size(); i++)
+    {
+      Page & page = pages_[i];
+      if (page.texId_)
+      {
+        YAE_OGL_11_HERE();
+        YAE_OGL_11(glDeleteTextures(1, &page.texId_));
+        page.texId_ = 0;
+      }
+    }
+  }
+
+  //----------------------------------------------------------------
+  // GlyphAtlas::TPrivate::lookup
+  //
+  const GlyphAtlas::TPrivate::Glyph &
+  GlyphAtlas::TPrivate::lookup(const QRawFont & rawFont,
+                               const QString & rawFontKey,
+                               quint32 glyphIndex)
+  {
+    TGlyphKey key(rawFontKey, glyphIndex);
+    std::map<TGlyphKey, Glyph>::iterator found = glyphs_.find(key);
+    if (found != glyphs_.end())
+    {
+      return found->second;
+    }
+
+    Glyph & glyph = glyphs_[key];
+
+    QRectF br = rawFont.boundingRect(glyphIndex);
+    if (br.isEmpty())
+    {
+      // whitespace:
+      return glyph;
+    }
+
+    // leave a margin for antialiasing, align the cell
+    // to the downsampling factor:
+    int n = int(downsample_);
+    int x0 = n * int(std::floor((br.left() - 1.0) / double(n)));
+    int y0 = n * int(std::floor((br.top() - 1.0) / double(n)));
+    int x1 = n * int(std::ceil((br.right() + 1.0) / double(n)));
+    int y1 = n * int(std::ceil((br.bottom() + 1.0) / double(n)));
+    int w = x1 - x0;
+    int h = y1 - y0;
+
+    QImage img(w, h, QImage::Format_ARGB32_Premultiplied);
+    img.fill(0);
+    {
+      QVector<quint32> glyphIndexes(1, glyphIndex);
+      QVector<QPointF> positions(1, QPointF(-x0, -y0));
+
+      QGlyphRun glyphRun;
+      glyphRun.setRawFont(rawFont);
+      glyphRun.setGlyphIndexes(glyphIndexes);
+      glyphRun.setPositions(positions);
+
+      QPainter painter(&img);
+      painter.setRenderHints(QPainter::TextAntialiasing);
+      painter.setPen(QColor(Qt::white));
+      painter.drawGlyphRun(QPointF(0, 0), glyphRun);
+    }
+
+    if (n > 1)
+    {
+      img = img.scaled(w / n,
+                       h / n,
+                       Qt::IgnoreAspectRatio,
+                       Qt::SmoothTransformation);
+    }
+
+    // store a white glyph with coverage in the alpha channel,
+    // so it can be drawn in any color:
+    int cw = img.width();
+    int ch = img.height();
+    QImage cell(cw, ch, QImage::Format_ARGB32);
+    for (int j = 0; j < ch; j++)
+    {
+      const QRgb * src = (const QRgb *)(img.constScanLine(j));
+      QRgb * dst = (QRgb *)(cell.scanLine(j));
+
+      for (int i = 0; i < cw; i++)
+      {
+        dst[i] = qRgba(255, 255, 255, qAlpha(src[i]));
+      }
+    }
+
+    int page = 0;
+    int x = 0;
+    int y = 0;
+    if (!allocate(cw, ch, page, x, y))
+    {
+      // too big for the atlas:
+      return glyph;
+    }
+
+    pages_[page].pending_.push_back(Pending(x, y, cell));
+
+    double size = double(pageSize_);
+    glyph.page_ = page;
+    glyph.x0_ = double(x0);
+    glyph.y0_ = double(y0);
+    glyph.x1_ = double(x1);
+    glyph.y1_ = double(y1);
+    glyph.u0_ = double(x) / size;
+    glyph.v0_ = double(y) / size;
+    glyph.u1_ = double(x + cw) / size;
+    glyph.v1_ = double(y + ch) / size;
+    return glyph;
+  }
+
+  //----------------------------------------------------------------
+  // GlyphAtlas::TPrivate::allocate
+  //
+  bool
+  GlyphAtlas::TPrivate::allocate(int w, int h, int & page, int & x, int & y)
+  {
+    // keep a blank texel between glyphs so that linear filtering
+    // does not bleed neighboring glyphs into each other:
+    w += 1;
+    h += 1;
+
+    if (w > pageSize_ || h > pageSize_)
+    {
+      return false;
+    }
+
+    if (pages_.empty())
+    {
+      pages_.push_back(Page());
+    }
+
+    Page * p = &(pages_.back());
+    if (p->shelfX_ + w > pageSize_)
+    {
+      // start a new shelf:
+      p->shelfY_ += p->shelfH_;
+      p->shelfX_ = 0;
+      p->shelfH_ = 0;
+    }
+
+    if (p->shelfY_ + h > pageSize_)
+    {
+      // start a new page:
+      pages_.push_back(Page());
+      p = &(pages_.back());
+    }
+
+    page = int(pages_.size() - 1);
+    x = p->shelfX_;
+    y = p->shelfY_;
+
+    p->shelfX_ += w;
+    p->shelfH_ = std::max(p->shelfH_, h);
+    return true;
+  }
+
+  //----------------------------------------------------------------
+  // GlyphAtlas::TPrivate::flush
+  //
+  void
+  GlyphAtlas::TPrivate::flush(Page & page)
+  {
+    if (!page.texId_)
+    {
+      // transparent white, so that filtering at the glyph edges
+      // does not darken the glyphs:
+      QImage blank(pageSize_, pageSize_, QImage::Format_ARGB32);
+      blank.fill(0x00ffffff);
+
+      if (!uploadTexture2D(blank, page.texId_, GL_LINEAR))
+      {
+        return;
+      }
+    }
+
+    while (!page.pending_.empty())
+    {
+      const Pending & pending = page.pending_.front();
+      uploadSubTexture2D(pending.image_,
+                         page.texId_,
+                         pending.x_,
+                         pending.y_);
+      page.pending_.pop_front();
+    }
+  }
+
+
+  //----------------------------------------------------------------
+  // GlyphAtlas::GlyphAtlas
+  //
+  GlyphAtlas::GlyphAtlas(const QFont & font, double supersample):
+    private_(new TPrivate(font, supersample)),
+    font_(font)
+  {}
+
+  //----------------------------------------------------------------
+  // GlyphAtlas::~GlyphAtlas
+  //
+  GlyphAtlas::~GlyphAtlas()
+  {
+    delete private_;
+  }
+
+  //----------------------------------------------------------------
+  // GlyphAtlas::get
+  //
+  TGlyphAtlasPtr
+  GlyphAtlas::get(const QFont & font, double supersample)
+  {
+    // items are painted on the rendering thread only, so no locking;
+    // intentionally leaked because the OpenGL context is gone
+    // by the time static objects are destroyed:
+    static std::list<TGlyphAtlasPtr> & recent =
+      *(new std::list<TGlyphAtlasPtr>());
+
+    QString key = font.key();
+    for (std::list<TGlyphAtlasPtr>::iterator i = recent.begin();
+         i != recent.end(); ++i)
+    {
+      TGlyphAtlasPtr atlas = *i;
+      if (atlas->private_->supersample_ == supersample &&
+          atlas->font_.key() == key)
+      {
+        recent.erase(i);
+        recent.push_front(atlas);
+        return atlas;
+      }
+    }
+
+    // atlases dropped from the list live on
+    // for as long as the items using them:
+    TGlyphAtlasPtr atlas(new GlyphAtlas(font, supersample));
+    recent.push_front(atlas);
+
+    if (recent.size() > kMaxRecentAtlases)
+    {
+      recent.pop_back();
+    }
+
+    return atlas;
+  }
+
+  //----------------------------------------------------------------
+  // GlyphAtlas::addText
+  //
+  void
+  GlyphAtlas::addText(Batch & batch,
+                      const QString & text,
+                      const QRectF & maxRect,
+                      int flags,
+                      const QRectF & clip)
+  {
+    // same line breaking and alignment as qt_format_text:
+    QString str(text);
+    for (int i = 0, len = str.length(); i < len; i++)
+    {
+      if (str[i] == QChar('\n'))
+      {
+        str[i] = (flags & Qt::TextSingleLine) ?
+          QChar(' ') : QChar(QChar::LineSeparator);
+      }
+    }
+
+    QTextOption option(Qt::Alignment(flags & Qt::AlignHorizontal_Mask));
+    option.setWrapMode((flags & Qt::TextWordWrap) ?
+                       QTextOption::WordWrap :
+                       QTextOption::ManualWrap);
+
+    QTextLayout layout(str, font_);
+    layout.setTextOption(option);
+
+    QFontMetricsF fm(font_);
+    qreal leading = fm.leading();
+    qreal height = -leading;
+
+    layout.beginLayout();
+    while (true)
+    {
+      QTextLine line = layout.createLine();
+      if (!line.isValid())
+      {
+        break;
+      }
+
+      line.setLineWidth(maxRect.width());
+      height += leading;
+      line.setPosition(QPointF(0, height));
+      height += line.height();
+    }
+    layout.endLayout();
+
+    qreal dy = 0;
+    if (flags & Qt::AlignBottom)
+    {
+      dy = maxRect.height() - height;
+    }
+    else if (flags & Qt::AlignVCenter)
+    {
+      dy = 0.5 * (maxRect.height() - height);
+    }
+
+    QPointF offset(maxRect.x(), maxRect.y() + dy);
+    QList<QGlyphRun> glyphRuns = layout.glyphRuns();
+    for (QList<QGlyphRun>::const_iterator i = glyphRuns.begin();
+         i != glyphRuns.end(); ++i)
+    {
+      addGlyphRun(batch, *i, offset, clip);
+    }
+  }
+
+  //----------------------------------------------------------------
+  // GlyphAtlas::addGlyphRun
+  //
+  void
+  GlyphAtlas::addGlyphRun(Batch & batch,
+                          const QGlyphRun & glyphRun,
+                          const QPointF & offset,
+                          const QRectF & clip)
+  {
+    // font fallback may substitute a different font for some glyphs:
+    QRawFont rawFont = glyphRun.rawFont();
+    QString rawFontKey = (rawFont.familyName() + QChar('|') +
+                          rawFont.styleName() + QChar('|') +
+                          QString::number(rawFont.pixelSize()));
+
+    QVector<quint32> glyphIndexes = glyphRun.glyphIndexes();
+    QVector<QPointF> positions = glyphRun.positions();
+    int numGlyphs = std::min(glyphIndexes.size(), positions.size());
+    double s = 1.0 / private_->supersample_;
+
+    for (int i = 0; i < numGlyphs; i++)
+    {
+      const TPrivate::Glyph & glyph =
+        private_->lookup(rawFont, rawFontKey, glyphIndexes[i]);
+
+      if (glyph.page_ < 0)
+      {
+        continue;
+      }
+
+      // glyphs are rasterized at whole pixel pen positions:
+      double px = std::floor(offset.x() + positions[i].x() + 0.5);
+      double py = std::floor(offset.y() + positions[i].y() + 0.5);
+
+      double x0 = px + glyph.x0_;
+      double x1 = px + glyph.x1_;
+      double y0 = py + glyph.y0_;
+      double y1 = py + glyph.y1_;
+      double u0 = glyph.u0_;
+      double u1 = glyph.u1_;
+      double v0 = glyph.v0_;
+      double v1 = glyph.v1_;
+
+      if (!clipSpan(x0, x1, u0, u1, clip.left(), clip.right()) ||
+          !clipSpan(y0, y1, v0, v1, clip.top(), clip.bottom()))
+      {
+        continue;
+      }
+
+      if (batch.pages_.size() <= std::size_t(glyph.page_))
+      {
+        batch.pages_.resize(glyph.page_ + 1);
+      }
+
+      Vertex v[4] = {
+        { GLfloat(x0 * s), GLfloat(y0 * s), GLfloat(u0), GLfloat(v0) },
+        { GLfloat(x0 * s), GLfloat(y1 * s), GLfloat(u0), GLfloat(v1) },
+        { GLfloat(x1 * s), GLfloat(y0 * s), GLfloat(u1), GLfloat(v0) },
+        { GLfloat(x1 * s), GLfloat(y1 * s), GLfloat(u1), GLfloat(v1) }
+      };
+
+      std::vector<Vertex> & vertices = batch.pages_[glyph.page_];
+      vertices.push_back(v[0]);
+      vertices.push_back(v[1]);
+      vertices.push_back(v[2]);
+      vertices.push_back(v[2]);
+      vertices.push_back(v[1]);
+      vertices.push_back(v[3]);
+    }
+  }
+
+  //----------------------------------------------------------------
+  // GlyphAtlas::draw
+  //
+  void
+  GlyphAtlas::draw(const Batch & batch,
+                   double x,
+                   double y,
+                   const Color & color,
+                   double opacity)
+  {
+    if (batch.empty())
+    {
+      return;
+    }
+
+    // upload new glyphs first, uploading unbinds the texture:
+    std::size_t numPages = std::min(batch.pages_.size(),
+                                    private_->pages_.size());
+    for (std::size_t i = 0; i < numPages; i++)
+    {
+      if (!batch.pages_[i].empty())
+      {
+        private_->flush(private_->pages_[i]);
+      }
+    }
+
+    YAE_OGL_11_HERE();
+    TGLSaveMatrixState pushMatrix(GL_MODELVIEW);
+    YAE_OGL_11(glTranslated(x, y, 0));
+    YAE_OGL_11(glEnable(GL_TEXTURE_2D));
+
+    YAE_OPENGL_HERE();
+    if (glActiveTexture)
+    {
+      YAE_OPENGL(glActiveTexture(GL_TEXTURE0));
+      yae_assert_gl_no_error();
+    }
+
+    YAE_OGL_11(glDisable(GL_LIGHTING));
+    YAE_OGL_11(glPolygonMode(GL_FRONT_AND_BACK, GL_FILL));
+    YAE_OGL_11(glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE));
+    YAE_OGL_11(glColor4ub(color.r(),
+                          color.g(),
+                          color.b(),
+                          Color::transform(color.a(), opacity)));
+
+    TGLSaveClientState pushClientAttr(GL_CLIENT_ALL_ATTRIB_BITS);
+    YAE_OGL_11(glEnableClientState(GL_VERTEX_ARRAY));
+    YAE_OGL_11(glEnableClientState(GL_TEXTURE_COORD_ARRAY));
+
+    for (std::size_t i = 0; i < numPages; i++)
+    {
+      const std::vector<Vertex> & vertices = batch.pages_[i];
+      const TPrivate::Page & page = private_->pages_[i];
+      if (vertices.empty() || !page.texId_)
+      {
+        continue;
+      }
+
+      YAE_OGL_11(glBindTexture(GL_TEXTURE_2D, page.texId_));
+      YAE_OGL_11(glVertexPointer(2, GL_FLOAT, sizeof(Vertex),
+                                 &(vertices[0].x_)));
+      YAE_OGL_11(glTexCoordPointer(2, GL_FLOAT, sizeof(Vertex),
+                                   &(vertices[0].u_)));
+      YAE_OGL_11(glDrawArrays(GL_TRIANGLES, 0, GLsizei(vertices.size())));
+    }
+
+    YAE_OGL_11(glDisableClientState(GL_TEXTURE_COORD_ARRAY));
+    YAE_OGL_11(glDisableClientState(GL_VERTEX_ARRAY));
+
+    // un-bind:
+    if (glActiveTexture)
+    {
+      YAE_OPENGL(glActiveTexture(GL_TEXTURE0));
+      yae_assert_gl_no_error();
+    }
+
+    YAE_OGL_11(glBindTexture(GL_TEXTURE_2D, 0));
+    YAE_OGL_11(glDisable(GL_TEXTURE_2D));
+  }
+
+}
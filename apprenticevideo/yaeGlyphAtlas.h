@@ -0,0 +1,132 @@
+// -*- Mode: c++; tab-width: 8; c-basic-offset: 2; indent-tabs-mode: nil -*-
+// NOTE: the first line of this file sets up source code indentation rules
+// for Emacs; it is also a hint to anyone modifying this file.
+
+// Created      : Wed Oct 21 21:07:36 MDT 2026
+// Copyright    : Pavel Koshevoy
+// License      : MIT -- http://www.opensource.org/licenses/mit-license.php
+
+#ifndef YAE_GLYPH_ATLAS_H_
+#define YAE_GLYPH_ATLAS_H_
+
+// standard libraries:
+#include <vector>
+
+// boost includes:
+#ifndef Q_MOC_RUN
+#include <boost/shared_ptr.hpp>
+#endif
+
+// Qt library:
+#include <QFont>
+#include <QGlyphRun>
+#include <QPointF>
+#include <QRectF>
+#include <QString>
+
+// local interfaces:
+#include "yaeCanvasRenderer.h"
+#include "yaeColor.h"
+
+
+namespace yae
+{
+
+  //----------------------------------------------------------------
+  // GlyphAtlas
+  //
+  // Glyphs of one font at one pixel size and supersampling factor,
+  // rasterized once and packed into shared texture pages.
+  //
+  // Text is drawn as a batch of textured quads, one draw call per
+  // atlas page, so changing the text of an item costs a re-layout
+  // and a vertex array rebuild instead of rasterizing the whole
+  // string and uploading a new texture.  Glyphs are white,
+  // the color is applied when the batch is drawn.
+  //
+  // NOTE: the atlas textures are created and updated lazily
+  // and must be used with the OpenGL context current.
+  //
+  struct GlyphAtlas
+  {
+    //----------------------------------------------------------------
+    // Vertex
+    //
+    struct Vertex
+    {
+      GLfloat x_;
+      GLfloat y_;
+      GLfloat u_;
+      GLfloat v_;
+    };
+
+    //----------------------------------------------------------------
+    // Batch
+    //
+    // Glyph quads (as triangle pairs) in item coordinates,
+    // grouped by atlas page:
+    //
+    struct Batch
+    {
+      void clear();
+      bool empty() const;
+
+      std::vector<std::vector<Vertex> > pages_;
+    };
+
+    // font pixel size must already be scaled by supersample factor:
+    GlyphAtlas(const QFont & font, double supersample);
+    ~GlyphAtlas();
+
+    // shared atlas for a given supersampled font:
+    static boost::shared_ptr<GlyphAtlas> get(const QFont & font,
+                                             double supersample);
+
+    inline const QFont & font() const
+    { return font_; }
+
+    // lay out the text the way QPainter::drawText(maxRect, flags, text)
+    // would and add the glyph quads to the batch.
+    //
+    // maxRect and clip are in supersampled pixels, glyphs outside
+    // of the clip rect are dropped and glyphs that cross it are cut:
+    //
+    void addText(Batch & batch,
+                 const QString & text,
+                 const QRectF & maxRect,
+                 int flags,
+                 const QRectF & clip);
+
+    // add already shaped glyphs, offset in supersampled pixels:
+    void addGlyphRun(Batch & batch,
+                     const QGlyphRun & glyphRun,
+                     const QPointF & offset,
+                     const QRectF & clip);
+
+    // upload any new glyphs and draw the batch at a given origin:
+    void draw(const Batch & batch,
+              double x,
+              double y,
+              const Color & color,
+              double opacity);
+
+  private:
+    // intentionally disabled:
+    GlyphAtlas(const GlyphAtlas &);
+    GlyphAtlas & operator = (const GlyphAtlas &);
+
+    struct TPrivate;
+    TPrivate * private_;
+
+    QFont font_;
+  };
+
+  //----------------------------------------------------------------
+  // TGlyphAtlasPtr
+  //
+  typedef boost::shared_ptr<GlyphAtlas> TGlyphAtlasPtr;
+
+}
+
+
+#endif // YAE_GLYPH_ATLAS_H_
@@ -0,0 +1,249 @@
+// -*- Mode: c++; tab-width: 8; c-basic-offset: 2; indent-tabs-mode: nil -*-
+// NOTE: the first line of this file sets up source code indentation rules
+// for Emacs; it is also a hint to anyone modifying this file.
+
+// Created      : Thu Oct 22 20:36:17 MDT 2026
+// Copyright    : Pavel Koshevoy
+// License      : MIT -- http://www.opensource.org/licenses/mit-license.php
+
+// local interfaces:
+#include "yaeItemRef.h"
+
+
+namespace yae
+{
+
+  //----------------------------------------------------------------
+  // evaluating_
+  //
+  // the node whose value is being computed right now, if any:
+  //
+  static const RefNode * evaluating_ = NULL;
+
+  //----------------------------------------------------------------
+  // evaluatingId_
+  //
+  // evaluations are numbered in the order they start,
+  // this is the number of the one in progress:
+  //
+  static std::size_t evaluatingId_ = 0;
+
+  //----------------------------------------------------------------
+  // evaluations_
+  //
+  static std::size_t evaluations_ = 0;
+
+  //----------------------------------------------------------------
+  // passes_
+  //
+  static std::size_t passes_ = 0;
+
+
+  //----------------------------------------------------------------
+  // RefNode::RefNode
+  //
+  RefNode::RefNode():
+    readBy_(0),
+    pass_(0)
+  {}
+
+  //----------------------------------------------------------------
+  // RefNode::RefNode
+  //
+  RefNode::RefNode(const RefNode & other):
+    readBy_(0),
+    pass_(0)
+  {
+    (void)other;
+  }
+
+  //----------------------------------------------------------------
+  // RefNode::operator =
+  //
+  RefNode &
+  RefNode::operator = (const RefNode & other)
+  {
+    (void)other;
+    return *this;
+  }
+
+  //----------------------------------------------------------------
+  // RefNode::~RefNode
+  //
+  RefNode::~RefNode()
+  {
+    // whatever was computed from this node is stale now:
+    uncacheDependents();
+    dropDependencies();
+
+    for (std::size_t i = 0, n = dependents_.size(); i < n; i++)
+    {
+      const Edge & edge = dependents_[i];
+      edge.node_->eraseDependency(edge.mirror_);
+    }
+  }
+
+  //----------------------------------------------------------------
+  // RefNode::invalidate
+  //
+  void
+  RefNode::invalidate() const
+  {
+    uncache();
+    uncacheDependents();
+  }
+
+  //----------------------------------------------------------------
+  // RefNode::evaluations
+  //
+  std::size_t
+  RefNode::evaluations()
+  {
+    return evaluations_;
+  }
+
+  //----------------------------------------------------------------
+  // RefNode::notifyRead
+  //
+  void
+  RefNode::notifyRead() const
+  {
+    if (!evaluating_ || evaluating_ == this)
+    {
+      return;
+    }
+
+    if (readBy_ == evaluatingId_)
+    {
+      // already recorded:
+      return;
+    }
+
+    std::vector<Edge> & deps = evaluating_->dependencies_;
+    if (readBy_ > evaluatingId_)
+    {
+      // a nested evaluation read it last, the one in progress
+      // may or may not have read it before that:
+      for (std::size_t i = 0, n = deps.size(); i < n; i++)
+      {
+        if (deps[i].node_ == this)
+        {
+          readBy_ = evaluatingId_;
+          return;
+        }
+      }
+    }
+
+    readBy_ = evaluatingId_;
+    deps.push_back(Edge(this, dependents_.size()));
+    dependents_.push_back(Edge(evaluating_, deps.size() - 1));
+  }
+
+  //----------------------------------------------------------------
+  // RefNode::uncacheDependents
+  //
+  void
+  RefNode::uncacheDependents() const
+  {
+    if (dependents_.empty())
+    {
+      return;
+    }
+
+    // the graph may be deep, so avoid recursion;
+    // the pass number makes sure each node is visited once:
+    std::size_t pass = ++passes_;
+    pass_ = pass;
+
+    std::vector<const RefNode *> todo;
+    todo.reserve(dependents_.size());
+    for (std::size_t i = 0, n = dependents_.size(); i < n; i++)
+    {
+      todo.push_back(dependents_[i].node_);
+    }
+
+    while (!todo.empty())
+    {
+      const RefNode * node = todo.back();
+      todo.pop_back();
+
+      if (node->pass_ == pass)
+      {
+        continue;
+      }
+
+      node->pass_ = pass;
+      node->uncache();
+
+      for (std::size_t i = 0, n = node->dependents_.size(); i < n; i++)
+      {
+        todo.push_back(node->dependents_[i].node_);
+      }
+    }
+  }
+
+  //----------------------------------------------------------------
+  // RefNode::dropDependencies
+  //
+  void
+  RefNode::dropDependencies() const
+  {
+    for (std::size_t i = 0, n = dependencies_.size(); i < n; i++)
+    {
+      const Edge & edge = dependencies_[i];
+      edge.node_->eraseDependent(edge.mirror_);
+    }
+
+    dependencies_.clear();
+  }
+
+  //----------------------------------------------------------------
+  // RefNode::eraseDependency
+  //
+  void
+  RefNode::eraseDependency(std::size_t i) const
+  {
+    // order doesn't matter:
+    const Edge & last = dependencies_.back();
+    last.node_->dependents_[last.mirror_].mirror_ = i;
+    dependencies_[i] = last;
+    dependencies_.pop_back();
+  }
+
+  //----------------------------------------------------------------
+  // RefNode::eraseDependent
+  //
+  void
+  RefNode::eraseDependent(std::size_t i) const
+  {
+    // order doesn't matter:
+    const Edge & last = dependents_.back();
+    last.node_->dependencies_[last.mirror_].mirror_ = i;
+    dependents_[i] = last;
+    dependents_.pop_back();
+  }
+
+
+  //----------------------------------------------------------------
+  // RefNode::Evaluating::Evaluating
+  //
+  RefNode::Evaluating::Evaluating(const RefNode & node):
+    prev_(evaluating_),
+    prevId_(evaluatingId_)
+  {
+    // dependencies may differ from the last time:
+    node.dropDependencies();
+    evaluating_ = &node;
+    evaluatingId_ = ++evaluations_;
+  }
+
+  //----------------------------------------------------------------
+  // RefNode::Evaluating::~Evaluating
+  //
+  RefNode::Evaluating::~Evaluating()
+  {
+    evaluating_ = prev_;
+    evaluatingId_ = prevId_;
+  }
+
+}
@@ -10,7 +10,9 @@
 #define YAE_ITEM_REF_H_
 
 // standard libraries:
+#include <cstddef>
 #include <stdexcept>
+#include <vector>
 
 // boost includes:
 #ifndef Q_MOC_RUN
@@ -27,6 +29,106 @@
 namespace yae
 {
 
+  //----------------------------------------------------------------
+  // RefNode
+  //
+  // Property references form a dependency graph.  While a reference
+  // is being evaluated every other reference it reads is recorded
+  // as its dependency, so when a value changes only the references
+  // that were computed from it (directly or transitively) need
+  // to be uncached.  Replacing or destroying a reference
+  // invalidates its dependents automatically.
+  //
+  // NOTE: just like the items themselves this is not thread safe,
+  // references must be evaluated on one thread.
+  //
+  struct RefNode
+  {
+    RefNode();
+
+    // dependency edges are not copied:
+    RefNode(const RefNode & other);
+    RefNode & operator = (const RefNode & other);
+
+    virtual ~RefNode();
+
+    // discard the cached value of this node only:
+    virtual void uncache() const = 0;
+
+    // discard the cached value of this node and of everything
+    // that depends on it:
+    void invalidate() const;
+
+    // total number of reference evaluations (cache misses) so far,
+    // sample it before and after a frame to profile the frame:
+    static std::size_t evaluations();
+
+  protected:
+    //----------------------------------------------------------------
+    // Evaluating
+    //
+    // While in scope the given node is being evaluated: dependencies
+    // from its previous evaluation are dropped and every node read
+    // in the meantime is recorded as a new dependency.
+    //
+    struct Evaluating
+    {
+      Evaluating(const RefNode & node);
+      ~Evaluating();
+
+    private:
+      // intentionally disabled:
+      Evaluating(const Evaluating &);
+      Evaluating & operator = (const Evaluating &);
+
+      const RefNode * prev_;
+      std::size_t prevId_;
+    };
+
+    friend struct Evaluating;
+
+    // record that the node being evaluated, if any, reads this one:
+    void notifyRead() const;
+
+  private:
+    //----------------------------------------------------------------
+    // Edge
+    //
+    // each edge is recorded by both of its nodes, and each record
+    // knows where the other one is, so either end can remove it
+    // in constant time:
+    //
+    struct Edge
+    {
+      Edge(const RefNode * node = NULL, std::size_t mirror = 0):
+        node_(node),
+        mirror_(mirror)
+      {}
+
+      const RefNode * node_;
+
+      // index of the matching record in the edge list of node_:
+      std::size_t mirror_;
+    };
+
+    void uncacheDependents() const;
+    void dropDependencies() const;
+
+    // remove an edge record, the last record takes its place:
+    void eraseDependency(std::size_t i) const;
+    void eraseDependent(std::size_t i) const;
+
+    mutable std::vector<Edge> dependencies_;
+    mutable std::vector<Edge> dependents_;
+
+    // most recent evaluation that recorded a read of this node:
+    mutable std::size_t readBy_;
+
+    // last invalidation pass that visited this node:
+    mutable std::size_t pass_;
+  };
+
+
   //----------------------------------------------------------------
   // DataRef
   //
@@ -51,7 +153,7 @@ namespace yae
     //----------------------------------------------------------------
     // IRef
     //
-    struct IRef
+    struct IRef : RefNode
     {
       virtual ~IRef() {}
 
@@ -97,7 +199,13 @@ namespace yae
       virtual void set_cacheable(bool cacheable) { (void)cacheable; }
       virtual void uncache() const {}
       virtual void cache(const TData & value) const { (void)value; }
-      virtual const TData & get_value() const { return value_; }
+
+      virtual const TData & get_value() const
+      {
+        // constants can still be replaced, so they are tracked too:
+        this->notifyRead();
+        return value_;
+      }
 
       TData value_;
    };
@@ -117,6 +225,17 @@ namespace yae
         YAE_ASSERT(prop != kPropertyUnspecified);
       }
 
+      // a copy has no dependencies recorded, so it starts uncached:
+      Ref(const Ref & other):
+        IRef(other),
+        ref_(other.ref_),
+        prop_(other.prop_),
+        cacheable_(other.cacheable_),
+        visited_(false),
+        cached_(false),
+        value_(other.value_)
+      {}
+
       virtual Ref * copy() const
       { return new Ref(*this); }
 
@@ -148,6 +267,8 @@ namespace yae
 
       virtual const TData & get_value() const
       {
+        this->notifyRead();
+
         if (cached_)
         {
           return value_;
@@ -165,7 +286,10 @@ namespace yae
         visited_ = cacheable_;
 
         TData v;
-        ref_.get(prop_, v);
+        {
+          RefNode::Evaluating evaluating(*this);
+          ref_.get(prop_, v);
+        }
         value_ = v;
 
         cached_ = cacheable_;
@@ -241,6 +365,10 @@ namespace yae
     inline void uncache() const
     { if (private_) private_->uncache(); }
 
+    // uncache this property and every property computed from it:
+    inline void invalidate() const
+    { if (private_) private_->invalidate(); }
+
     // cache an externally computed value:
     inline void cache(const TData & value) const
     { if (private_) private_->cache(value); }
@@ -316,6 +444,8 @@ namespace yae
 
       virtual const double & get_value() const
       {
+        this->notifyRead();
+
         if (!TDataRef::Ref::cached_)
         {
           double v = TDataRef::Ref::get_value();
@@ -500,6 +630,8 @@ namespace yae
 
       virtual const bool & get_value() const
       {
+        this->notifyRead();
+
         if (!TDataRef::Ref::cached_)
         {
           // invert the value:
@@ -643,6 +775,8 @@ namespace yae
 
       virtual const Color & get_value() const
       {
+        this->notifyRead();
+
         if (!TDataRef::Ref::cached_)
         {
           TVec4D v(TDataRef::Ref::get_value());
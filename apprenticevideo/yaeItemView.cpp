@@ -37,6 +37,11 @@
 //
 #define YAE_DEBUG_ITEM_VIEW_REPAINT 0
 
+//----------------------------------------------------------------
+// YAE_DEBUG_ITEM_VIEW_EVALUATIONS
+//
+#define YAE_DEBUG_ITEM_VIEW_EVALUATIONS 0
+
 
 namespace yae
 {
@@ -129,8 +134,9 @@ namespace yae
   ItemView::ItemView(const char * name):
     Canvas::ILayer(),
     devicePixelRatio_(1.0),
-    w_(0.0),
-    h_(0.0),
+    w_(ItemRef::constant(0.0)),
+    h_(ItemRef::constant(0.0)),
+    evaluations_(0),
     pressed_(NULL),
     dragged_(NULL),
     startPt_(std::numeric_limits<double>::max(),
@@ -162,8 +168,8 @@ namespace yae
     Item & root = *root_;
     root.anchors_.left_ = ItemRef::constant(0.0);
     root.anchors_.top_ = ItemRef::constant(0.0);
-    root.width_ = ItemRef::constant(w_);
-    root.height_ = ItemRef::constant(h_);
+    root.width_ = ItemRef::constant(w_.get());
+    root.height_ = ItemRef::constant(h_.get());
   }
 
   //----------------------------------------------------------------
@@ -297,20 +303,30 @@ namespace yae
     int w = canvas->canvasWidth();
     int h = canvas->canvasHeight();
 
-    if (devicePixelRatio == devicePixelRatio_ && w == w_ && h_ == h)
+    if (devicePixelRatio == devicePixelRatio_ &&
+        w == w_.get() &&
+        h == h_.get())
     {
       return false;
     }
 
-    devicePixelRatio_ = devicePixelRatio;
-    w_ = w;
-    h_ = h;
+    // replacing a constant invalidates everything computed from it,
+    // so only the properties that depend on the view size
+    // (directly or via the root item) are re-evaluated:
+    w_ = ItemRef::constant(w);
+    h_ = ItemRef::constant(h);
 
     Item & root = *root_;
-    root.width_ = ItemRef::constant(w_);
-    root.height_ = ItemRef::constant(h_);
+    root.width_ = ItemRef::constant(w);
+    root.height_ = ItemRef::constant(h);
+
+    if (devicePixelRatio != devicePixelRatio_)
+    {
+      // fonts, textures, etc... are not tracked, redo everything:
+      devicePixelRatio_ = devicePixelRatio;
+      requestUncache(&root);
+    }
 
-    requestUncache(&root);
     return true;
   }
 
@@ -324,6 +340,7 @@ namespace yae
 
     requestRepaintEvent_.setDelivered(true);
 
+    std::size_t evaluations = RefNode::evaluations();
     animate();
 
     // uncache prior to painting:
@@ -379,6 +396,13 @@ namespace yae
 
     Item & root = *root_;
     root.paint(xregion, yregion, canvas);
+
+    evaluations_ = RefNode::evaluations() - evaluations;
+
+#if YAE_DEBUG_ITEM_VIEW_EVALUATIONS
+    std::cerr << "ItemView::paint " << root_->id_
+              << ", evaluations: " << evaluations_ << std::endl;
+#endif
   }
 
   //----------------------------------------------------------------
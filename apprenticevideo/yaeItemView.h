@@ -307,11 +307,18 @@ namespace yae
     inline double devicePixelRatio() const
     { return devicePixelRatio_; }
 
+    // reading view dimensions from within an item expression
+    // makes that expression depend on them:
     inline double width() const
-    { return w_; }
+    { return w_.get(); }
 
     inline double height() const
-    { return h_; }
+    { return h_.get(); }
+
+    // number of item property evaluations during the last paint,
+    // a well behaved view re-evaluates only what has changed:
+    inline std::size_t evaluationsPerFrame() const
+    { return evaluations_; }
 
   public slots:
     void repaint();
@@ -330,8 +337,9 @@ namespace yae
     TImageProviders imageProviders_;
     ItemPtr root_;
     double devicePixelRatio_;
-    double w_;
-    double h_;
+    ItemRef w_;
+    ItemRef h_;
+    std::size_t evaluations_;
 
     // input handlers corresponding to the point where a mouse
     // button press occurred, will be cleared if layout changes
@@ -334,6 +334,9 @@ mainMayThrowException(int argc, char ** argv)
   yae::mainWindow->playbackSetTempo(percentTempo);
 
   app.exec();
+
+  // playback has stopped, the trace is complete:
+  yae::saveTrace();
   return 0;
 }
 
@@ -42,6 +42,7 @@
 // yae includes:
 #include "yae/utils/yae_benchmark.h"
 #include "yae/utils/yae_plugin_registry.h"
+#include "yae/utils/yae_trace.h"
 #include "yae/video/yae_pixel_formats.h"
 #include "yae/video/yae_pixel_format_traits.h"
 #include "yae/video/yae_video_renderer.h"
@@ -447,6 +448,9 @@ namespace yae
       loadBooleanSettingOrDefault(kSkipNonReferenceFrames, false);
     actionSkipNonReferenceFrames->setChecked(skipNonReferenceFrames);
 
+    // there is nothing to save unless started with YAE_TRACE=1:
+    actionSaveTrace->setVisible(TTrace::enabled());
+
 #if 1
     actionFullScreen->setShortcut(tr("Ctrl+F"));
 #elif defined(__APPLE__)
@@ -475,6 +479,7 @@ namespace yae
     shortcutCropOther_ = new QShortcut(this);
     shortcutAutoCrop_ = new QShortcut(this);
     shortcutNextChapter_ = new QShortcut(this);
+    shortcutSaveTrace_ = new QShortcut(this);
     shortcutRemove_ = new QShortcut(this);
     shortcutSelectAll_ = new QShortcut(this);
     shortcutAspectRatioNone_ = new QShortcut(this);
@@ -498,6 +503,7 @@ namespace yae
     shortcutCropOther_->setContext(Qt::ApplicationShortcut);
     shortcutAutoCrop_->setContext(Qt::ApplicationShortcut);
     shortcutNextChapter_->setContext(Qt::ApplicationShortcut);
+    shortcutSaveTrace_->setContext(Qt::ApplicationShortcut);
     shortcutAspectRatioNone_->setContext(Qt::ApplicationShortcut);
     shortcutAspectRatio1_33_->setContext(Qt::ApplicationShortcut);
     shortcutAspectRatio1_78_->setContext(Qt::ApplicationShortcut);
@@ -899,6 +905,14 @@ namespace yae
                  this, SLOT(helpAbout()));
     YAE_ASSERT(ok);
 
+    ok = connect(actionSaveTrace, SIGNAL(triggered()),
+                 this, SLOT(helpSaveTrace()));
+    YAE_ASSERT(ok);
+
+    ok = connect(shortcutSaveTrace_, SIGNAL(activated()),
+                 this, SLOT(helpSaveTrace()));
+    YAE_ASSERT(ok);
+
     ok = connect(this, SIGNAL(setInPoint()),
                  &timelineModel_, SLOT(setInPoint()));
     YAE_ASSERT(ok);
@@ -1118,6 +1132,10 @@ namespace yae
     ok = connect(playerItem, SIGNAL(stepOneFrameForward()),
                  this, SLOT(skipToNextFrame()));
     YAE_ASSERT(ok);
+
+    ok = connect(playerItem, SIGNAL(stepOneFrameBackward()),
+                 this, SLOT(skipToPrevFrame()));
+    YAE_ASSERT(ok);
 #endif
 
     // get a shortcut to the Canvas (owned by the QML canvas widget):
@@ -2508,6 +2526,7 @@ namespace yae
     yae::swapShortcuts(shortcutCropOther_, actionCropFrameOther);
     yae::swapShortcuts(shortcutAutoCrop_, actionCropFrameAutoDetect);
     yae::swapShortcuts(shortcutNextChapter_, actionNextChapter);
+    yae::swapShortcuts(shortcutSaveTrace_, actionSaveTrace);
     yae::swapShortcuts(shortcutAspectRatioNone_, actionAspectRatioAuto);
     yae::swapShortcuts(shortcutAspectRatio1_33_, actionAspectRatio1_33);
     yae::swapShortcuts(shortcutAspectRatio1_78_, actionAspectRatio1_78);
@@ -3149,6 +3168,17 @@ namespace yae
     about->show();
   }
 
+  //----------------------------------------------------------------
+  // MainWindow::helpSaveTrace
+  //
+  void
+  MainWindow::helpSaveTrace()
+  {
+    // the trace is a ring buffer, so this is a snapshot of the recent
+    // past -- save it right after a stutter to see what caused it:
+    yae::saveTrace();
+  }
+
   //----------------------------------------------------------------
   // MainWindow::processDropEventUrls
   //
@@ -3890,6 +3920,10 @@ namespace yae
     {
       skipToNextFrame();
     }
+    else if (key == Qt::Key_B)
+    {
+      skipToPrevFrame();
+    }
     else if (key == Qt::Key_MediaNext ||
              key == Qt::Key_Period ||
              key == Qt::Key_Greater)
@@ -3979,6 +4013,29 @@ namespace yae
     }
   }
 
+  //----------------------------------------------------------------
+  // MainWindow::skipToPrevFrame
+  //
+  void
+  MainWindow::skipToPrevFrame()
+  {
+    if (!playbackPaused_)
+    {
+      return;
+    }
+
+    VideoTraits vtts;
+    if (!reader_->getVideoTraits(vtts) || vtts.frameRate_ <= 0.0)
+    {
+      return;
+    }
+
+    // there is no decoding backwards, so seek to the previous frame;
+    // the video track caches the decoded GOPs around the playhead,
+    // so stepping back over them does not decode anything:
+    timelineModel_.seekFromCurrentTime(-1.0 / vtts.frameRate_);
+  }
+
   //----------------------------------------------------------------
   // addMenuCopyTo
   //
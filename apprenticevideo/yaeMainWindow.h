@@ -244,6 +244,7 @@ namespace yae
     void skipToInPoint();
     void skipToOutPoint();
     void skipToNextFrame();
+    void skipToPrevFrame();
     void skipForward();
     void skipBack();
 
@@ -265,6 +266,7 @@ namespace yae
 
     // help menu:
     void helpAbout();
+    void helpSaveTrace();
 
     // helpers:
     void setPlayingItem(const QModelIndex & index);
@@ -361,6 +363,7 @@ namespace yae
     QShortcut * shortcutCrop2_40_;
     QShortcut * shortcutCropOther_;
     QShortcut * shortcutNextChapter_;
+    QShortcut * shortcutSaveTrace_;
     QShortcut * shortcutAspectRatioNone_;
     QShortcut * shortcutAspectRatio1_33_;
     QShortcut * shortcutAspectRatio1_78_;
@@ -2565,8 +2565,8 @@ namespace yae
     Item & root = *root_;
     root.anchors_.left_ = ItemRef::constant(0.0);
     root.anchors_.top_ = ItemRef::constant(0.0);
-    root.width_ = ItemRef::constant(w_);
-    root.height_ = ItemRef::constant(h_);
+    root.width_ = ItemRef::constant(w_.get());
+    root.height_ = ItemRef::constant(h_.get());
     root.uncache();
     uncache_.clear();
 
@@ -7,16 +7,14 @@
 // License      : MIT -- http://www.opensource.org/licenses/mit-license.php
 
 // Qt library:
-#include <QColor>
 #include <QCoreApplication>
 #include <QFontMetricsF>
-#include <QImage>
-#include <QPainter>
 #include <QRectF>
 #include <QString>
 
 // local interfaces:
 #include "yaeCanvasRenderer.h"
+#include "yaeGlyphAtlas.h"
 #include "yaeText.h"
 #include "yaeTexture.h"
 #include "yaeUtilsQt.h"
@@ -210,20 +208,14 @@ namespace yae
     void paint(const Text & item);
 
     BoolRef ready_;
-    GLuint texId_;
-    GLuint iw_;
-    GLuint ih_;
-    GLuint downsample_;
+    TGlyphAtlasPtr atlas_;
+    GlyphAtlas::Batch glyphs_;
   };
 
   //----------------------------------------------------------------
   // Text::TPrivate::TPrivate
   //
-  Text::TPrivate::TPrivate():
-    texId_(0),
-    iw_(0),
-    ih_(0),
-    downsample_(1)
+  Text::TPrivate::TPrivate()
   {}
 
   //----------------------------------------------------------------
@@ -241,18 +233,20 @@ namespace yae
   Text::TPrivate::uncache()
   {
     ready_.uncache();
-
-    YAE_OGL_11_HERE();
-    YAE_OGL_11(glDeleteTextures(1, &texId_));
-    texId_ = 0;
+    glyphs_.clear();
   }
 
   //----------------------------------------------------------------
   // Text::TPrivate::uploadTexture
   //
+  // lay out the glyph quads, the glyphs themselves
+  // are shared by all items using the same font:
+  //
   bool
   Text::TPrivate::uploadTexture(const Text & item)
   {
+    glyphs_.clear();
+
     QRectF maxRect;
     getMaxRect(item, maxRect);
 
@@ -263,49 +257,26 @@ namespace yae
     BBox bboxContent;
     item.Item::get(kPropertyBBoxContent, bboxContent);
 
-    iw_ = (int)ceil(bboxContent.w_ * supersample);
-    ih_ = (int)ceil(bboxContent.h_ * supersample);
+    double iw = std::ceil(bboxContent.w_ * supersample);
+    double ih = std::ceil(bboxContent.h_ * supersample);
 
-    if (!(iw_ && ih_))
+    if (!(iw > 0.0 && ih > 0.0))
     {
       return true;
     }
 
-    GLsizei widthPowerOfTwo = powerOfTwoGEQ<GLsizei>(iw_);
-    GLsizei heightPowerOfTwo = powerOfTwoGEQ<GLsizei>(ih_);
-    QImage img(widthPowerOfTwo, heightPowerOfTwo, QImage::Format_ARGB32);
-    {
-      const Color & color = item.color_.get();
-
-#ifndef _WIN32
-      Color bg = color.transparent();
-#else
-      const Color & bg = item.background_.get();
-#endif
-      img.fill(QColor(bg).rgba());
-
-      QPainter painter(&img);
-      painter.setRenderHints(QPainter::TextAntialiasing);
-      QFont font = item.font_;
-      double fontSize = std::max(9.0, item.fontSize_.get());
-      font.setPixelSize(fontSize * supersample);
-      painter.setFont(font);
-
-      QFontMetricsF fm(font);
-      int flags = item.textFlags();
-      QString text = getElidedText(maxRect.width(), item, fm, flags);
-
-      painter.setPen(QColor(color));
-      painter.drawText(maxRect, flags, text);
-    }
+    QFont font = item.font_;
+    double fontSize = std::max(9.0, item.fontSize_.get());
+    font.setPixelSize(fontSize * supersample);
 
-    // do not upload supersampled texture at full size, scale down first:
-    downsample_ = downsampleImage(img, supersample);
+    QFontMetricsF fm(font);
+    int flags = item.textFlags();
+    QString text = getElidedText(maxRect.width(), item, fm, flags);
 
-    bool ok = yae::uploadTexture2D(img, texId_,
-                                   supersample == 1.0 ?
-                                   GL_NEAREST : GL_LINEAR_MIPMAP_LINEAR);
-    return ok;
+    // crop to the content bbox, same as a texture of that size would:
+    atlas_ = GlyphAtlas::get(font, supersample);
+    atlas_->addText(glyphs_, text, maxRect, flags, QRectF(0, 0, iw, ih));
+    return true;
   }
 
   //----------------------------------------------------------------
@@ -314,19 +285,21 @@ namespace yae
   void
   Text::TPrivate::paint(const Text & item)
   {
+    if (!atlas_ || glyphs_.empty())
+    {
+      return;
+    }
+
     BBox bbox;
     item.Item::get(kPropertyBBoxContent, bbox);
 
     // avoid rendering at fractional pixel coordinates:
-    bbox.x_ = std::floor(bbox.x_);
-    bbox.y_ = std::floor(bbox.y_);
-    bbox.w_ = std::ceil(bbox.w_);
-    bbox.h_ = std::ceil(bbox.h_);
+    double x = std::floor(bbox.x_);
+    double y = std::floor(bbox.y_);
 
-    int iw = (iw_ + downsample_ - 1) / downsample_;
-    int ih = (ih_ + downsample_ - 1) / downsample_;
+    const Color & color = item.color_.get();
     double opacity = item.opacity_.get();
-    paintTexture2D(bbox, texId_, iw, ih, opacity);
+    atlas_->draw(glyphs_, x, y, color, opacity);
   }
 
 
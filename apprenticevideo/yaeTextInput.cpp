@@ -11,13 +11,14 @@
 
 // Qt library:
 #include <QApplication>
-#include <QImage>
+#include <QGlyphRun>
 #include <QLineEdit>
-#include <QPainter>
+#include <QList>
 #include <QTextLayout>
 
 // local interfaces:
 #include "yaeCanvasRenderer.h"
+#include "yaeGlyphAtlas.h"
 #include "yaeItemFocus.h"
 #include "yaeTextInput.h"
 #include "yaeTexture.h"
@@ -60,12 +61,19 @@ namespace yae
 
     BoolRef ready_;
     qreal offset_;
-    GLuint texId_;
     GLuint iw_;
     GLuint ih_;
-    GLuint downsample_;
     int cursorDragStart_;
 
+    // glyph quads for unselected and selected text,
+    // selection and cursor rectangles, in item coordinates:
+    TGlyphAtlasPtr atlas_;
+    GlyphAtlas::Batch fg_;
+    GlyphAtlas::Batch selFg_;
+    BBox selBg_;
+    BBox cursor_;
+    bool cursorMultiply_;
+
     // optional id of focus proxy item that manages this text input;
     const Item * proxy_;
   };
@@ -75,11 +83,10 @@ namespace yae
   //
   TextInput::TPrivate::TPrivate(const QString & text):
     offset_(0),
-    texId_(0),
     iw_(0),
     ih_(0),
-    downsample_(1),
     cursorDragStart_(0),
+    cursorMultiply_(false),
     proxy_(NULL)
   {
     lineEdit_.hide();
@@ -258,10 +265,8 @@ namespace yae
   TextInput::TPrivate::uncache()
   {
     ready_.uncache();
-
-    YAE_OGL_11_HERE();
-    YAE_OGL_11(glDeleteTextures(1, &texId_));
-    texId_ = 0;
+    fg_.clear();
+    selFg_.clear();
   }
 
   //----------------------------------------------------------------
@@ -299,33 +304,99 @@ namespace yae
   }
 
   //----------------------------------------------------------------
-  // addFormatRange
+  // addGlyphRuns
   //
   static void
-  addFormatRange(QVector<QTextLayout::FormatRange> & ranges,
-                 int start,
-                 int length,
-                 const QFont & font,
-                 const Color & fg,
-                 const Color & bg)
+  addGlyphRuns(GlyphAtlas & atlas,
+               GlyphAtlas::Batch & batch,
+               const QTextLine & textLine,
+               int start,
+               int length,
+               const QPointF & offset,
+               const QRectF & clip)
   {
     if (length < 1)
     {
       return;
     }
 
-    ranges.push_back(QTextLayout::FormatRange());
-    QTextLayout::FormatRange & range = ranges.back();
-    range.start = start;
-    range.length = length;
-    range.format.setFont(font);
-    range.format.setBackground(QColor(bg));
-    range.format.setForeground(QColor(fg));
+    QList<QGlyphRun> glyphRuns = textLine.glyphRuns(start, length);
+    for (QList<QGlyphRun>::const_iterator i = glyphRuns.begin();
+         i != glyphRuns.end(); ++i)
+    {
+      atlas.addGlyphRun(batch, *i, offset, clip);
+    }
+  }
+
+  //----------------------------------------------------------------
+  // clipRect
+  //
+  // clip a rectangle given in supersampled pixels and
+  // convert it to item coordinates:
+  //
+  static BBox
+  clipRect(qreal x0, qreal y0, qreal x1, qreal y1,
+           const QRectF & clip,
+           double supersample)
+  {
+    x0 = std::max(x0, clip.left());
+    y0 = std::max(y0, clip.top());
+    x1 = std::min(x1, clip.right());
+    y1 = std::min(y1, clip.bottom());
+
+    BBox bbox;
+    if (x0 < x1 && y0 < y1)
+    {
+      bbox.x_ = x0 / supersample;
+      bbox.y_ = y0 / supersample;
+      bbox.w_ = (x1 - x0) / supersample;
+      bbox.h_ = (y1 - y0) / supersample;
+    }
+
+    return bbox;
+  }
+
+  //----------------------------------------------------------------
+  // paintRect
+  //
+  static void
+  paintRect(const BBox & bbox,
+            double x,
+            double y,
+            const Color & color,
+            double opacity)
+  {
+    if (bbox.isEmpty() || !color.a())
+    {
+      return;
+    }
+
+    double x0 = bbox.x_ + x;
+    double y0 = bbox.y_ + y;
+    double x1 = bbox.w_ + x0;
+    double y1 = bbox.h_ + y0;
+
+    YAE_OGL_11_HERE();
+    YAE_OGL_11(glColor4ub(color.r(),
+                          color.g(),
+                          color.b(),
+                          Color::transform(color.a(), opacity)));
+    YAE_OGL_11(glBegin(GL_TRIANGLE_STRIP));
+    {
+      YAE_OGL_11(glVertex2d(x0, y0));
+      YAE_OGL_11(glVertex2d(x0, y1));
+      YAE_OGL_11(glVertex2d(x1, y0));
+      YAE_OGL_11(glVertex2d(x1, y1));
+    }
+    YAE_OGL_11(glEnd());
   }
 
   //----------------------------------------------------------------
   // TextInput::TPrivate::uploadTexture
   //
+  // lay out the glyph quads, the glyphs themselves
+  // are shared by all items using the same font:
+  //
   bool
   TextInput::TPrivate::uploadTexture(const TextInput & item)
   {
@@ -353,71 +424,46 @@ namespace yae
       offset_ = cx1 - qreal(iw_);
     }
 
-    GLsizei widthPowerOfTwo = powerOfTwoGEQ<GLsizei>(iw_);
-    GLsizei heightPowerOfTwo = powerOfTwoGEQ<GLsizei>(ih_);
-    QImage img(widthPowerOfTwo, heightPowerOfTwo, QImage::Format_ARGB32);
-    {
-      const Color & fg = item.color_.get();
-
-#if (QT_VERSION < QT_VERSION_CHECK(5, 0, 0)) && defined(__APPLE__)
-      Color bg = fg.transparent();
-#else
-      const Color & bg = item.background_.get();
-#endif
-      img.fill(QColor(bg).rgba());
-
-      const Color & selFg = item.selectionFg_.get();
-      const Color & selBg = item.selectionBg_.get();
-
-      QVector<QTextLayout::FormatRange> ranges;
-      addFormatRange(ranges, 0, selStart, font_, fg, bg);
-      addFormatRange(ranges, selStart, selLength, font_, selFg, selBg);
-      addFormatRange(ranges, selEnd, textLen - selEnd, font_, fg, bg);
+    qreal lineHeight = textLine_.height();
+    YAE_ASSERT(lineHeight <= qreal(ih_));
 
-      qreal lineHeight = textLine_.height();
-      YAE_ASSERT(lineHeight <= qreal(ih_));
+    qreal yoffset = 0.5 * (qreal(ih_) - lineHeight);
+    QPointF offset(-offset_, yoffset);
+    QRectF clip(0, 0, qreal(iw_), qreal(ih_));
 
-      qreal yoffset = 0.5 * (qreal(ih_) - lineHeight);
-      QPointF offset(-offset_, yoffset);
+    fg_.clear();
+    selFg_.clear();
+    selBg_ = BBox();
 
-      QPainter painter(&img);
-      painter.setRenderHints(QPainter::TextAntialiasing);
-      textLayout_.draw(&painter, offset, ranges);
+    atlas_ = GlyphAtlas::get(font_, supersample);
+    addGlyphRuns(*atlas_, fg_, textLine_, 0, selStart, offset, clip);
+    addGlyphRuns(*atlas_, selFg_, textLine_, selStart, selLength,
+                 offset, clip);
+    addGlyphRuns(*atlas_, fg_, textLine_, selEnd, textLen - selEnd,
+                 offset, clip);
 
-      QColor cursorColor(item.cursorColor_.get());
-      QPen cursorPen(cursorColor);
-      painter.setPen(cursorPen);
-
-      // It appears Qt 5.9.3+ QTextLayout::drawCursor uses
-      // QPainter::RasterOp_NotDestination composition mode,
-      // which doesn't work as expected with a custom cursor color:
-#if 0
-      textLayout_.drawCursor(&painter, offset, cursorPos, cursorWidth);
-#else
-      if (cursorWidth > 1)
-      {
-        painter.setCompositionMode(QPainter::CompositionMode_Multiply);
-      }
-      else
-      {
-        painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
-      }
-
-      painter.fillRect(cx0 - offset_,
-                       -yoffset,
-                       cx1 - cx0,
-                       lineHeight,
-                       cursorPen.brush());
-#endif
+    if (selLength > 0)
+    {
+      qreal sx0 = textLine_.cursorToX(selStart) - offset_;
+      qreal sx1 = textLine_.cursorToX(selEnd) - offset_;
+      selBg_ = clipRect(std::min(sx0, sx1),
+                        yoffset,
+                        std::max(sx0, sx1),
+                        yoffset + lineHeight,
+                        clip,
+                        supersample);
     }
 
-    // do not upload supersampled texture at full size, scale down first:
-    downsample_ = downsampleImage(img, supersample);
+    cursor_ = clipRect(cx0 - offset_,
+                       yoffset,
+                       cx1 - offset_,
+                       yoffset + lineHeight,
+                       clip,
+                       supersample);
 
-    bool ok = yae::uploadTexture2D(img, texId_,
-                                   supersample == 1.0 ?
-                                   GL_NEAREST : GL_LINEAR_MIPMAP_LINEAR);
-    return ok;
+    // a block cursor (overwrite mode) must not hide the text under it:
+    cursorMultiply_ = (cursorWidth > 1);
+    return true;
   }
 
   //----------------------------------------------------------------
@@ -435,17 +481,35 @@ namespace yae
     BBox bbox;
     item.Item::get(kPropertyBBox, bbox);
 
-    bbox.x_ = floor(bbox.x_ + 0.5);
-    bbox.y_ = floor(bbox.y_ + 0.5);
+    double x = floor(bbox.x_ + 0.5);
+    double y = floor(bbox.y_ + 0.5);
 
     double supersample = item.supersample_.get();
-    bbox.w_ = double(iw_) / supersample;
-    bbox.h_ = double(ih_) / supersample;
+    BBox bg;
+    bg.w_ = double(iw_) / supersample;
+    bg.h_ = double(ih_) / supersample;
 
-    int iw = (iw_ + downsample_ - 1) / downsample_;
-    int ih = (ih_ + downsample_ - 1) / downsample_;
     double opacity = item.opacity_.get();
-    paintTexture2D(bbox, texId_, iw, ih, opacity);
+    paintRect(bg, x, y, item.background_.get(), opacity);
+    paintRect(selBg_, x, y, item.selectionBg_.get(), opacity);
+
+    if (atlas_)
+    {
+      atlas_->draw(fg_, x, y, item.color_.get(), opacity);
+      atlas_->draw(selFg_, x, y, item.selectionFg_.get(), opacity);
+    }
+
+    if (cursorMultiply_)
+    {
+      TGLSaveState pushAttr(GL_COLOR_BUFFER_BIT);
+      YAE_OGL_11_HERE();
+      YAE_OGL_11(glBlendFunc(GL_DST_COLOR, GL_ONE_MINUS_SRC_ALPHA));
+      paintRect(cursor_, x, y, item.cursorColor_.get(), opacity);
+    }
+    else
+    {
+      paintRect(cursor_, x, y, item.cursorColor_.get(), opacity);
+    }
   }
 
   //----------------------------------------------------------------
@@ -246,6 +246,87 @@ namespace yae
     return true;
   }
 
+  //----------------------------------------------------------------
+  // uploadSubTexture2D
+  //
+  bool
+  uploadSubTexture2D(const QImage & img,
+                     GLuint texId,
+                     GLint x,
+                     GLint y)
+  {
+    QImage::Format imgFormat = img.format();
+
+    TPixelFormatId formatId = pixelFormatIdFor(imgFormat);
+    const pixelFormat::Traits * ptts = pixelFormat::getTraits(formatId);
+    if (!ptts)
+    {
+      YAE_ASSERT(false);
+      return false;
+    }
+
+    unsigned char stride[4] = { 0 };
+    unsigned char planes = ptts->getPlanes(stride);
+    if (planes > 1 || stride[0] % 8)
+    {
+      YAE_ASSERT(false);
+      return false;
+    }
+
+    YAE_OGL_11_HERE();
+    YAE_OGL_11(glEnable(GL_TEXTURE_2D));
+    YAE_OGL_11(glBindTexture(GL_TEXTURE_2D, texId));
+    if (!YAE_OGL_11(glIsTexture(texId)))
+    {
+      YAE_ASSERT(false);
+      return false;
+    }
+
+    TGLSaveClientState pushClientAttr(GL_CLIENT_ALL_ATTRIB_BITS);
+
+    GLint internalFormat = 0;
+    GLenum pixelFormatGL = 0;
+    GLenum dataType = 0;
+    GLint shouldSwapBytes = 0;
+
+    yae_to_opengl(formatId,
+                  internalFormat,
+                  pixelFormatGL,
+                  dataType,
+                  shouldSwapBytes);
+
+    YAE_OGL_11(glPixelStorei(GL_UNPACK_SWAP_BYTES,
+                             shouldSwapBytes));
+
+    const QImage & constImg = img;
+    const unsigned char * data = constImg.bits();
+    const unsigned char bytesPerPixel = stride[0] >> 3;
+    const int bytesPerRow = constImg.bytesPerLine();
+    const int rowSize = bytesPerRow / bytesPerPixel;
+    const int padding = alignmentFor(data, bytesPerRow);
+
+    YAE_OGL_11(glPixelStorei(GL_UNPACK_ALIGNMENT, (GLint)(padding)));
+    YAE_OGL_11(glPixelStorei(GL_UNPACK_ROW_LENGTH, (GLint)(rowSize)));
+    YAE_OGL_11(glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0));
+    YAE_OGL_11(glPixelStorei(GL_UNPACK_SKIP_ROWS, 0));
+    yae_assert_gl_no_error();
+
+    YAE_OGL_11(glTexSubImage2D(GL_TEXTURE_2D,
+                               0, // mipmap level
+                               x, // x-offset
+                               y, // y-offset
+                               img.width(),
+                               img.height(),
+                               pixelFormatGL,
+                               dataType,
+                               data));
+    yae_assert_gl_no_error();
+
+    YAE_OGL_11(glBindTexture(GL_TEXTURE_2D, 0));
+    YAE_OGL_11(glDisable(GL_TEXTURE_2D));
+    return true;
+  }
+
   //----------------------------------------------------------------
   // paintTexture2D
   //
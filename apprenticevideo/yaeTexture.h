@@ -41,6 +41,17 @@ namespace yae
                   GLenum textureFilterMin,
                   GLenum textureFilterMag = GL_LINEAR);
 
+  //----------------------------------------------------------------
+  // uploadSubTexture2D
+  //
+  // replace a region of an existing texture with the given image:
+  //
+  bool
+  uploadSubTexture2D(const QImage & img,
+                     GLuint texId,
+                     GLint x,
+                     GLint y);
+
   //----------------------------------------------------------------
   // paintTexture2D
   //
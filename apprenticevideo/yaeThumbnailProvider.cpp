@@ -7,7 +7,9 @@
 // License      : MIT -- http://www.opensource.org/licenses/mit-license.php
 
 // standard C++ library:
+#include <algorithm>
 #include <map>
+#include <vector>
 
 // boost includes:
 #ifndef Q_MOC_RUN
@@ -27,6 +29,7 @@
 // local includes:
 #include "yaePlaylist.h"
 #include "yaeThumbnailProvider.h"
+#include "yaeThumbnailStore.h"
 #include "yaeUtilsQt.h"
 
 
@@ -108,7 +111,9 @@ namespace yae
   // getThumbnail
   //
   static TVideoFramePtr
-  getThumbnail(const yae::IReaderPtr & reader, const QSize & envelope)
+  getThumbnail(const yae::IReaderPtr & reader,
+               const QSize & envelope,
+               QueueWaitMgr & waitMgr)
   {
     TVideoFramePtr frame;
 
@@ -167,6 +172,31 @@ namespace yae
       return frame;
     }
 
+    // try the nearest keyframe first, it is decoded synchronously
+    // without starting the reader threads:
+    {
+      TTime start;
+      TTime duration;
+      double t = 0.0;
+
+      if (reader->isSeekable() && get_duration(reader.get(), start, duration))
+      {
+        // FIXME: check for a bookmark, seek to the bookmarked position:
+        double offset = std::min<double>(duration.sec() * 8e-2, 288.0);
+
+        // avoid seeking very short files (.jpg):
+        t = start.sec() + ((offset >= 0.016) ? offset : 0.0);
+      }
+
+      if (reader->readKeyframe(t, frame) && frame && frame->data_)
+      {
+        return frame;
+      }
+
+      frame.reset();
+    }
+
+    // fall back to playback, in case there are no keyframe flags:
     ISettingGroup * readerSettings = reader->settings();
     if (readerSettings)
     {
@@ -182,7 +212,6 @@ namespace yae
     reader->setPlaybackEnabled(true);
     reader->threadStart();
 
-    QueueWaitMgr waitMgr;
     TTime start;
     TTime duration;
     if (reader->isSeekable() && get_duration(reader.get(), start, duration))
@@ -212,13 +241,17 @@ namespace yae
   }
 
   //----------------------------------------------------------------
-  // ThumbnailProvider::requestImage
+  // getThumbnail
+  //
+  // cacheable is set to false when a placeholder icon is returned
+  // instead of a decoded frame:
   //
   static QImage
   getThumbnail(const yae::IReaderPtr & readerPrototype,
                const QSize & thumbnailMaxSize,
-               const TPlaylistModel & playlist,
-               const QString & id)
+               const QString & itemFilePath,
+               QueueWaitMgr & waitMgr,
+               bool & cacheable)
   {
     static QVector<QRgb> palette(256);
     static bool palette_ready = false;
@@ -241,15 +274,7 @@ namespace yae
       (QString::fromUtf8(":/images/broken-glass.png"));
 
     QImage image;
-
-    QString itemFilePath = playlist.lookupItemFilePath(id);
-#if 0
-    std::cerr
-      << "\nFIXME: getThumbnail"
-      << "\n item id: " << id.toUtf8().constData()
-      << "\nfilepath: " << itemFilePath.toUtf8().constData()
-      << std::endl;
-#endif
+    cacheable = false;
 
     IReaderPtr reader = yae::openFile(readerPrototype, itemFilePath);
     if (!reader)
@@ -257,7 +282,7 @@ namespace yae
       return iconBroken;
     }
 
-    TVideoFramePtr frame = getThumbnail(reader, thumbnailMaxSize);
+    TVideoFramePtr frame = getThumbnail(reader, thumbnailMaxSize, waitMgr);
     if (!frame || !frame->data_)
     {
       std::size_t numAudioTracks = reader->getNumberOfAudioTracks();
@@ -275,6 +300,8 @@ namespace yae
       return iconBroken;
     }
 
+    cacheable = true;
+
     // shortcut:
     const VideoTraits & vtts = frame->traits_;
 
@@ -342,7 +369,8 @@ namespace yae
     TPrivate(const IReaderPtr & readerPrototype,
              const TPlaylistModel & playlist,
              const QSize & envelopeSize,
-             std::size_t cacheCapacity);
+             std::size_t cacheCapacity,
+             std::size_t numWorkers);
     ~TPrivate();
 
     void setCacheCapacity(std::size_t cacheCapacity);
@@ -351,9 +379,12 @@ namespace yae
     void clearCacheFor(std::size_t n);
 
   public:
+    // waitMgr may be used to abort the request from another thread,
+    // an aborted request returns a null image:
     QImage requestImage(const QString & id,
                         QSize * size,
-                        const QSize & requestedSize);
+                        const QSize & requestedSize,
+                        QueueWaitMgr * waitMgr = NULL);
 
     void requestImageAsync(const QString & id,
                            const QSize & requestedSize,
@@ -407,6 +438,9 @@ namespace yae
     const TPlaylistModel & playlist_;
     QSize envelopeSize_;
 
+    // thumbnails that survive application restarts:
+    ThumbnailStore & store_;
+
     // thumbnail request queue and image cache:
     mutable boost::mutex mutex_;
     mutable boost::condition_variable ready_;
@@ -415,6 +449,10 @@ namespace yae
     std::map<QString, Request> request_;
     std::map<boost::uint64_t, Request *> priority_;
 
+    // requests currently being processed by the workers,
+    // so that cancelRequest can abort them:
+    std::multimap<QString, QueueWaitMgr *> busy_;
+
     // how many items can be kept in the cache:
     std::size_t cacheCapacity_;
 
@@ -425,8 +463,9 @@ namespace yae
     // to decide which image should be removed from the cache:
     std::map<boost::uint64_t, Payload *> mru_;
 
-    // request processing worker thread:
-    Thread<ThumbnailProvider::TPrivate> thread_;
+    // request processing worker threads, started on first use:
+    std::size_t numWorkers_;
+    std::vector<Thread<ThumbnailProvider::TPrivate> *> workers_;
   };
 
   //----------------------------------------------------------------
@@ -435,23 +474,51 @@ namespace yae
   ThumbnailProvider::TPrivate::TPrivate(const IReaderPtr & readerPrototype,
                                         const TPlaylistModel & playlist,
                                         const QSize & envelopeSize,
-                                        std::size_t cacheCapacity):
+                                        std::size_t cacheCapacity,
+                                        std::size_t numWorkers):
     readerPrototype_(readerPrototype),
     playlist_(playlist),
     envelopeSize_(envelopeSize),
+    store_(ThumbnailStore::singleton()),
     submitted_(0),
     completed_(0),
     cacheCapacity_(cacheCapacity),
-    thread_(this)
-  {}
+    numWorkers_(numWorkers)
+  {
+    if (!numWorkers_)
+    {
+      // each reader runs its own demuxer and decoder threads,
+      // so leave some cores for them:
+      numWorkers_ = std::max<std::size_t>
+        (1, boost::thread::hardware_concurrency() / 2);
+    }
+  }
 
   //----------------------------------------------------------------
   // ThumbnailProvider::TPrivate::~TPrivate
   //
   ThumbnailProvider::TPrivate::~TPrivate()
   {
-    thread_.stop();
-    thread_.wait();
+    {
+      // abort the requests in progress:
+      boost::lock_guard<boost::mutex> lock(mutex_);
+      for (std::multimap<QString, QueueWaitMgr *>::iterator
+             i = busy_.begin(); i != busy_.end(); ++i)
+      {
+        i->second->stopWaiting();
+      }
+    }
+
+    for (std::size_t i = 0; i < workers_.size(); i++)
+    {
+      workers_[i]->stop();
+    }
+
+    for (std::size_t i = 0; i < workers_.size(); i++)
+    {
+      workers_[i]->wait();
+      delete workers_[i];
+    }
   }
 
   //----------------------------------------------------------------
@@ -486,61 +553,92 @@ namespace yae
   QImage
   ThumbnailProvider::TPrivate::requestImage(const QString & id,
                                             QSize * size,
-                                            const QSize & requestedSize)
+                                            const QSize & requestedSize,
+                                            QueueWaitMgr * waitMgr)
   {
-    Payload * payload = NULL;
+    // the workers may evict cache entries concurrently,
+    // so the image is copied out while the mutex is locked:
+    QImage result;
     {
       boost::unique_lock<boost::mutex> lock(mutex_);
       std::map<QString, Payload>::iterator found = cache_.find(id);
 
       if (found != cache_.end())
       {
-        payload = &(found->second);
+        Payload * payload = &(found->second);
         mru_.erase(payload->mru_);
         payload->mru_ = completed_;
         completed_++;
         mru_[payload->mru_] = payload;
-      }
-      else
-      {
-        clearCacheFor(1);
+        result = payload->image_;
       }
     }
 
     const QSize & thumbnailMaxSize =
       requestedSize.isValid() ? requestedSize : envelopeSize_;
 
-    if (!payload)
+    if (result.isNull())
     {
-      QImage image = getThumbnail(readerPrototype_,
-                                  thumbnailMaxSize,
-                                  playlist_,
-                                  id);
+      // check the persistent store before opening the file:
+      QString itemFilePath = playlist_.lookupItemFilePath(id);
+      std::string key =
+        ThumbnailStore::makeKey(id, itemFilePath, thumbnailMaxSize);
 
-      bool sizeAcceptable =
-        (image.height() <= thumbnailMaxSize.height() &&
-         image.width() <= thumbnailMaxSize.width());
-
-      if (!sizeAcceptable)
+      QImage image;
+      if (!store_.load(key, image))
       {
-        image = image.scaledToHeight(90, Qt::SmoothTransformation);
+        QueueWaitMgr localWaitMgr;
+        bool cacheable = false;
+        image = getThumbnail(readerPrototype_,
+                             thumbnailMaxSize,
+                             itemFilePath,
+                             waitMgr ? *waitMgr : localWaitMgr,
+                             cacheable);
+
+        if (waitMgr && !waitMgr->keepWaiting())
+        {
+          // aborted, the placeholder image is not worth keeping:
+          return QImage();
+        }
+
+        bool sizeAcceptable =
+          (image.height() <= thumbnailMaxSize.height() &&
+           image.width() <= thumbnailMaxSize.width());
+
+        if (!sizeAcceptable)
+        {
+          image = image.scaledToHeight(90, Qt::SmoothTransformation);
+        }
+
+        if (cacheable)
+        {
+          store_.save(key, image);
+        }
       }
 
       boost::unique_lock<boost::mutex> lock(mutex_);
-      std::map<QString, Payload>::iterator where = cache_.
-        insert(std::make_pair(id, Payload(id, image, completed_))).first;
-      completed_++;
+      std::map<QString, Payload>::iterator where = cache_.find(id);
+      if (where == cache_.end())
+      {
+        clearCacheFor(1);
+        where = cache_.
+          insert(std::make_pair(id, Payload(id, image, completed_))).first;
+        completed_++;
+
+        Payload * payload = &(where->second);
+        mru_[payload->mru_] = payload;
+      }
 
-      payload = &(where->second);
-      mru_[payload->mru_] = payload;
+      // another worker may have made the same thumbnail meanwhile:
+      result = where->second.image_;
     }
 
     if (size)
     {
-      *size = payload->image_.size();
+      *size = result.size();
     }
 
-    return payload->image_;
+    return result;
   }
 
   //----------------------------------------------------------------
@@ -552,12 +650,13 @@ namespace yae
                     const QSize & requestedSize,
                     const boost::weak_ptr<ICallback> & callback)
   {
-    if (!thread_.isRunning())
+    boost::lock_guard<boost::mutex> lock(mutex_);
+    while (workers_.size() < numWorkers_)
     {
-      thread_.run();
+      workers_.push_back(new Thread<ThumbnailProvider::TPrivate>(this));
+      workers_.back()->run();
     }
 
-    boost::lock_guard<boost::mutex> lock(mutex_);
     std::map<QString, Request>::iterator found = request_.lower_bound(id);
     if (found == request_.end() || request_.key_comp()(id, found->first))
     {
@@ -595,6 +694,14 @@ namespace yae
       request_.erase(found);
       ready_.notify_all();
     }
+
+    // abort the work already in progress:
+    typedef std::multimap<QString, QueueWaitMgr *>::iterator TBusyIter;
+    std::pair<TBusyIter, TBusyIter> busy = busy_.equal_range(id);
+    for (TBusyIter i = busy.first; i != busy.second; ++i)
+    {
+      i->second->stopWaiting();
+    }
   }
 
   //----------------------------------------------------------------
@@ -609,6 +716,8 @@ namespace yae
       {
         // process the highest priority request:
         Request request;
+        QueueWaitMgr waitMgr;
+        std::multimap<QString, QueueWaitMgr *>::iterator busy;
         {
           boost::this_thread::interruption_point();
           boost::unique_lock<boost::mutex> lock(mutex_);
@@ -624,14 +733,32 @@ namespace yae
           request = *(next->second);
           priority_.erase(request.priority_);
           request_.erase(request.id_);
+          busy = busy_.insert(std::make_pair(request.id_, &waitMgr));
         }
 
-        boost::shared_ptr<ICallback> callback = request.callback_.lock();
-        if (callback)
+        try
+        {
+          boost::shared_ptr<ICallback> callback = request.callback_.lock();
+          if (callback)
+          {
+            QImage image =
+              requestImage(request.id_, NULL, request.size_, &waitMgr);
+
+            if (waitMgr.keepWaiting())
+            {
+              callback->imageReady(image);
+            }
+          }
+        }
+        catch (...)
         {
-          QImage image = requestImage(request.id_, NULL, request.size_);
-          callback->imageReady(image);
+          boost::unique_lock<boost::mutex> lock(mutex_);
+          busy_.erase(busy);
+          throw;
         }
+
+        boost::unique_lock<boost::mutex> lock(mutex_);
+        busy_.erase(busy);
       }
       catch (...)
       {
@@ -651,12 +778,14 @@ namespace yae
   ThumbnailProvider::ThumbnailProvider(const IReaderPtr & readerPrototype,
                                        const TPlaylistModel & playlist,
                                        const QSize & envelopeSize,
-                                       std::size_t cacheCapacity):
+                                       std::size_t cacheCapacity,
+                                       std::size_t numWorkers):
     ImageProvider(),
     private_(new TPrivate(readerPrototype,
                           playlist,
                           envelopeSize,
-                          cacheCapacity))
+                          cacheCapacity,
+                          numWorkers))
   {}
 
   //----------------------------------------------------------------
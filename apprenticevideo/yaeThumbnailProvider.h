@@ -48,7 +48,11 @@ namespace yae
                       const QSize & envelopeSize = QSize(384, 216),
 
                       // maximum number of images that may be cached in memory:
-                      std::size_t cacheCapacity = 1024);
+                      std::size_t cacheCapacity = 1024,
+
+                      // number of thumbnails that may be generated
+                      // concurrently, 0 means half the number of cores:
+                      std::size_t numWorkers = 0);
 
     virtual ~ThumbnailProvider();
 
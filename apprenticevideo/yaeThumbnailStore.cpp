@@ -0,0 +1,482 @@
+// -*- Mode: c++; tab-width: 8; c-basic-offset: 2; indent-tabs-mode: nil -*-
+// NOTE: the first line of this file sets up source code indentation rules
+// for Emacs; it is also a hint to anyone modifying this file.
+
+// Created      : Mon Oct 19 20:41:52 MDT 2026
+// Copyright    : Pavel Koshevoy
+// License      : MIT -- http://www.opensource.org/licenses/mit-license.php
+
+// standard C++ library:
+#include <map>
+#include <string.h>
+
+// boost includes:
+#ifndef Q_MOC_RUN
+#include <boost/thread.hpp>
+#endif
+
+// Qt includes:
+#include <QtGlobal>
+#include <QBuffer>
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 1, 0))
+#include <QLockFile>
+#endif
+
+// local includes:
+#include "yaeThumbnailStore.h"
+#include "yaeUtilsQt.h"
+
+
+namespace yae
+{
+
+  //----------------------------------------------------------------
+  // kPackMagic
+  //
+  static const char kPackMagic[] = "YAETHPK2";
+
+  //----------------------------------------------------------------
+  // kIndexMagic
+  //
+  static const char kIndexMagic[] = "YAETHIX2";
+
+  //----------------------------------------------------------------
+  // kMagicSize
+  //
+  static const qint64 kMagicSize = 8;
+
+  //----------------------------------------------------------------
+  // kKeySize
+  //
+  // SHA-1 digest:
+  //
+  static const std::size_t kKeySize = 20;
+
+  //----------------------------------------------------------------
+  // kRecordSize
+  //
+  // index record: key, pack file offset (8 bytes), image size (4 bytes)
+  //
+  static const std::size_t kRecordSize = kKeySize + 8 + 4;
+
+  //----------------------------------------------------------------
+  // kImageHeaderSize
+  //
+  // pack file image header: key, image size (4 bytes);
+  // load checks it against the index record, because another process
+  // may have reset the store since the index was loaded:
+  //
+  static const std::size_t kImageHeaderSize = kKeySize + 4;
+
+  //----------------------------------------------------------------
+  // kLockTimeoutMsec
+  //
+  // thumbnails are optional, don't wait long for another process:
+  //
+  static const int kLockTimeoutMsec = 250;
+
+  //----------------------------------------------------------------
+  // put_le
+  //
+  static void
+  put_le(unsigned char * dst, quint64 value, std::size_t nbytes)
+  {
+    for (std::size_t i = 0; i < nbytes; i++, value >>= 8)
+    {
+      dst[i] = (unsigned char)(value & 0xFF);
+    }
+  }
+
+  //----------------------------------------------------------------
+  // get_le
+  //
+  static quint64
+  get_le(const unsigned char * src, std::size_t nbytes)
+  {
+    quint64 value = 0;
+    for (std::size_t i = nbytes; i > 0; i--)
+    {
+      value = (value << 8) | src[i - 1];
+    }
+    return value;
+  }
+
+  //----------------------------------------------------------------
+  // PackLock
+  //
+  // serializes pack and index file modifications between processes
+  // sharing the same store, a no-op where QLockFile is unavailable:
+  //
+  struct PackLock
+  {
+    PackLock(const QString & path):
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 1, 0))
+      file_(path),
+      locked_(file_.tryLock(kLockTimeoutMsec))
+#else
+      locked_(true)
+#endif
+    {
+      (void)path;
+    }
+
+    inline bool isLocked() const
+    { return locked_; }
+
+  private:
+    // intentionally disabled:
+    PackLock(const PackLock &);
+    PackLock & operator = (const PackLock &);
+
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 1, 0))
+    QLockFile file_;
+#endif
+    bool locked_;
+  };
+
+  //----------------------------------------------------------------
+  // ThumbnailStore::TPrivate
+  //
+  struct ThumbnailStore::TPrivate
+  {
+    TPrivate(const QString & dir, qint64 maxPackSize);
+
+    bool open();
+
+    // must hold the pack lock:
+    void reset();
+
+    bool load(const std::string & key, QImage & image);
+    bool save(const std::string & key, const QImage & image);
+
+    //----------------------------------------------------------------
+    // Entry
+    //
+    struct Entry
+    {
+      Entry(qint64 offset = 0, qint64 size = 0):
+        offset_(offset),
+        size_(size)
+      {}
+
+      qint64 offset_;
+      qint64 size_;
+    };
+
+    mutable boost::mutex mutex_;
+    QFile pack_;
+    QFile index_;
+    QString lockPath_;
+    qint64 maxPackSize_;
+    std::map<std::string, Entry> entries_;
+  };
+
+  //----------------------------------------------------------------
+  // ThumbnailStore::TPrivate::TPrivate
+  //
+  ThumbnailStore::TPrivate::TPrivate(const QString & dir,
+                                     qint64 maxPackSize):
+    pack_(dir + QString::fromUtf8("/thumbnails.pack")),
+    index_(dir + QString::fromUtf8("/thumbnails.index")),
+    lockPath_(dir + QString::fromUtf8("/thumbnails.lock")),
+    maxPackSize_(maxPackSize)
+  {
+    QDir().mkpath(dir);
+
+    PackLock lock(lockPath_);
+    if (!open() && lock.isLocked())
+    {
+      reset();
+    }
+  }
+
+  //----------------------------------------------------------------
+  // ThumbnailStore::TPrivate::open
+  //
+  bool
+  ThumbnailStore::TPrivate::open()
+  {
+    // unbuffered, other processes may modify the files:
+    if (!pack_.open(QIODevice::ReadWrite | QIODevice::Unbuffered) ||
+        !index_.open(QIODevice::ReadWrite | QIODevice::Unbuffered))
+    {
+      pack_.close();
+      index_.close();
+      return false;
+    }
+
+    QByteArray packMagic = pack_.read(kMagicSize);
+    QByteArray indexMagic = index_.read(kMagicSize);
+    if (packMagic != QByteArray(kPackMagic, kMagicSize) ||
+        indexMagic != QByteArray(kIndexMagic, kMagicSize))
+    {
+      pack_.close();
+      index_.close();
+      return false;
+    }
+
+    // a record may be missing its image if the application
+    // did not exit cleanly, those records are ignored;
+    // a trailing partial record is ignored too:
+    qint64 packSize = pack_.size();
+    QByteArray records = index_.readAll();
+    const unsigned char * src = (const unsigned char *)records.constData();
+    std::size_t numRecords = std::size_t(records.size()) / kRecordSize;
+
+    for (std::size_t i = 0; i < numRecords; i++, src += kRecordSize)
+    {
+      std::string key((const char *)src, kKeySize);
+      qint64 offset = qint64(get_le(src + kKeySize, 8));
+      qint64 size = qint64(get_le(src + kKeySize + 8, 4));
+
+      if (offset >= kMagicSize &&
+          offset + qint64(kImageHeaderSize) + size <= packSize)
+      {
+        entries_[key] = Entry(offset, size);
+      }
+    }
+
+    return true;
+  }
+
+  //----------------------------------------------------------------
+  // ThumbnailStore::TPrivate::reset
+  //
+  void
+  ThumbnailStore::TPrivate::reset()
+  {
+    entries_.clear();
+    pack_.close();
+    index_.close();
+
+    if (!pack_.open(QIODevice::ReadWrite |
+                    QIODevice::Truncate |
+                    QIODevice::Unbuffered) ||
+        !index_.open(QIODevice::ReadWrite |
+                     QIODevice::Truncate |
+                     QIODevice::Unbuffered) ||
+        pack_.write(kPackMagic, kMagicSize) != kMagicSize ||
+        index_.write(kIndexMagic, kMagicSize) != kMagicSize)
+    {
+      // the cache is not usable, thumbnails will not be stored:
+      pack_.close();
+      index_.close();
+      return;
+    }
+
+    pack_.flush();
+    index_.flush();
+  }
+
+  //----------------------------------------------------------------
+  // ThumbnailStore::TPrivate::load
+  //
+  bool
+  ThumbnailStore::TPrivate::load(const std::string & key, QImage & image)
+  {
+    boost::lock_guard<boost::mutex> lock(mutex_);
+
+    std::map<std::string, Entry>::iterator found = entries_.find(key);
+    if (found == entries_.end())
+    {
+      return false;
+    }
+
+    const Entry & entry = found->second;
+    QByteArray data;
+    if (pack_.seek(entry.offset_))
+    {
+      data = pack_.read(qint64(kImageHeaderSize) + entry.size_);
+    }
+
+    // the pack file may have been reset and refilled by another process,
+    // so the image must be the one the index record refers to:
+    const unsigned char * src = (const unsigned char *)data.constData();
+    if (data.size() != qint64(kImageHeaderSize) + entry.size_ ||
+        memcmp(src, key.data(), kKeySize) != 0 ||
+        qint64(get_le(src + kKeySize, 4)) != entry.size_)
+    {
+      entries_.erase(found);
+      return false;
+    }
+
+    return image.loadFromData(src + kImageHeaderSize, int(entry.size_));
+  }
+
+  //----------------------------------------------------------------
+  // ThumbnailStore::TPrivate::save
+  //
+  bool
+  ThumbnailStore::TPrivate::save(const std::string & key,
+                                 const QImage & image)
+  {
+    // encode outside of the lock, JPEG is much more compact than PNG
+    // but the JPEG plugin may be missing and it doesn't do alpha:
+    QByteArray data;
+    {
+      QBuffer buffer(&data);
+      buffer.open(QIODevice::WriteOnly | QIODevice::Truncate);
+
+      bool ok = (!image.hasAlphaChannel() &&
+                 image.save(&buffer, "JPG", 85));
+      if (!ok)
+      {
+        buffer.close();
+        buffer.open(QIODevice::WriteOnly | QIODevice::Truncate);
+        ok = image.save(&buffer, "PNG");
+      }
+
+      if (!ok)
+      {
+        return false;
+      }
+    }
+
+    boost::lock_guard<boost::mutex> lock(mutex_);
+    if (!pack_.isOpen() || !index_.isOpen())
+    {
+      return false;
+    }
+
+    PackLock packLock(lockPath_);
+    if (!packLock.isLocked())
+    {
+      return false;
+    }
+
+    if (pack_.size() + qint64(kImageHeaderSize) + data.size() > maxPackSize_)
+    {
+      reset();
+
+      if (!pack_.isOpen() || !index_.isOpen())
+      {
+        return false;
+      }
+    }
+
+    // other processes may have appended since, so append at the end:
+    unsigned char header[kImageHeaderSize];
+    memcpy(header, key.data(), kKeySize);
+    put_le(header + kKeySize, quint64(data.size()), 4);
+
+    qint64 offset = pack_.size();
+    if (!pack_.seek(offset) ||
+        pack_.write((const char *)header, kImageHeaderSize) !=
+        qint64(kImageHeaderSize) ||
+        pack_.write(data) != data.size() ||
+        !pack_.flush())
+    {
+      return false;
+    }
+
+    // the image is written before the index record that refers to it:
+    unsigned char record[kRecordSize];
+    memcpy(record, key.data(), kKeySize);
+    put_le(record + kKeySize, quint64(offset), 8);
+    put_le(record + kKeySize + 8, quint64(data.size()), 4);
+
+    if (!index_.seek(index_.size()) ||
+        index_.write((const char *)record, kRecordSize) != kRecordSize ||
+        !index_.flush())
+    {
+      return false;
+    }
+
+    entries_[key] = Entry(offset, data.size());
+    return true;
+  }
+
+
+  //----------------------------------------------------------------
+  // ThumbnailStore::ThumbnailStore
+  //
+  ThumbnailStore::ThumbnailStore(const QString & dir, qint64 maxPackSize):
+    private_(new TPrivate(dir, maxPackSize))
+  {}
+
+  //----------------------------------------------------------------
+  // ThumbnailStore::~ThumbnailStore
+  //
+  ThumbnailStore::~ThumbnailStore()
+  {
+    delete private_;
+  }
+
+  //----------------------------------------------------------------
+  // ThumbnailStore::singleton
+  //
+  ThumbnailStore &
+  ThumbnailStore::singleton()
+  {
+    static ThumbnailStore store(YAE_STANDARD_LOCATION(CacheLocation) +
+                                QString::fromUtf8("/apprenticevideo"));
+    return store;
+  }
+
+  //----------------------------------------------------------------
+  // ThumbnailStore::makeKey
+  //
+  std::string
+  ThumbnailStore::makeKey(const QString & id,
+                          const QString & filePath,
+                          const QSize & envelopeSize)
+  {
+    QFileInfo fi(filePath);
+    if (!fi.exists())
+    {
+      return std::string();
+    }
+
+    QString details = QString::fromUtf8("%1 %2 %3 %4x%5").
+      arg(fi.size()).
+      arg(fi.lastModified().toMSecsSinceEpoch()).
+      arg(id).
+      arg(envelopeSize.width()).
+      arg(envelopeSize.height());
+
+    QByteArray digest =
+      QCryptographicHash::hash(details.toUtf8(), QCryptographicHash::Sha1);
+
+    return std::string(digest.constData(), digest.size());
+  }
+
+  //----------------------------------------------------------------
+  // ThumbnailStore::load
+  //
+  bool
+  ThumbnailStore::load(const std::string & key, QImage & image) const
+  {
+    return (key.size() == kKeySize) && private_->load(key, image);
+  }
+
+  //----------------------------------------------------------------
+  // ThumbnailStore::save
+  //
+  bool
+  ThumbnailStore::save(const std::string & key, const QImage & image)
+  {
+    return (key.size() == kKeySize) && private_->save(key, image);
+  }
+
+  //----------------------------------------------------------------
+  // ThumbnailStore::clear
+  //
+  void
+  ThumbnailStore::clear()
+  {
+    boost::lock_guard<boost::mutex> lock(private_->mutex_);
+
+    PackLock packLock(private_->lockPath_);
+    if (packLock.isLocked())
+    {
+      private_->reset();
+    }
+  }
+
+}
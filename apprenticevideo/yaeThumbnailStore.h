@@ -0,0 +1,73 @@
+// -*- Mode: c++; tab-width: 8; c-basic-offset: 2; indent-tabs-mode: nil -*-
+// NOTE: the first line of this file sets up source code indentation rules
+// for Emacs; it is also a hint to anyone modifying this file.
+
+// Created      : Mon Oct 19 20:41:52 MDT 2026
+// Copyright    : Pavel Koshevoy
+// License      : MIT -- http://www.opensource.org/licenses/mit-license.php
+
+#ifndef YAE_THUMBNAIL_STORE_H_
+#define YAE_THUMBNAIL_STORE_H_
+
+// standard libraries:
+#include <string>
+
+// Qt includes:
+#include <QImage>
+#include <QSize>
+#include <QString>
+
+
+namespace yae
+{
+
+  //----------------------------------------------------------------
+  // ThumbnailStore
+  //
+  // Persistent content-addressed thumbnail cache.  Encoded images
+  // are appended to one pack file, and an index file maps image keys
+  // to pack file offsets.  The index is loaded once, so a lookup
+  // costs one seek and one read of the pack file.
+  //
+  // Nothing is ever overwritten in place; once the pack file
+  // outgrows its size limit the store is cleared and starts over.
+  //
+  // Several processes may share the store: modifications are
+  // serialized by a lock file next to the pack file, and every
+  // image in the pack file is tagged with its key, so that an index
+  // entry made stale by another process is detected and dropped.
+  //
+  struct ThumbnailStore
+  {
+    ThumbnailStore(const QString & dir,
+                   qint64 maxPackSize = qint64(1) << 30);
+    ~ThumbnailStore();
+
+    // shared instance, kept in the user cache directory:
+    static ThumbnailStore & singleton();
+
+    // the key changes whenever the file is modified,
+    // returns an empty string if the file can not be stat'ed:
+    static std::string makeKey(const QString & id,
+                               const QString & filePath,
+                               const QSize & envelopeSize);
+
+    bool load(const std::string & key, QImage & image) const;
+    bool save(const std::string & key, const QImage & image);
+
+    // discard all stored thumbnails:
+    void clear();
+
+  private:
+    // intentionally disabled:
+    ThumbnailStore(const ThumbnailStore &);
+    ThumbnailStore & operator = (const ThumbnailStore &);
+
+    struct TPrivate;
+    TPrivate * private_;
+  };
+
+}
+
+
+#endif // YAE_THUMBNAIL_STORE_H_
@@ -7,9 +7,12 @@
 // License   : MIT -- http://www.opensource.org/licenses/mit-license.php
 
 // system includes:
+#include <iostream>
 #include <set>
+#include <stdlib.h>
 
 // yae includes:
+#include "yae/utils/yae_trace.h"
 #include "yae/video/yae_video.h"
 
 // local includes:
@@ -17,6 +20,7 @@
 
 // Qt includes:
 #include <QDateTime>
+#include <QDir>
 #include <QDirIterator>
 #include <QEvent>
 #include <QFile>
@@ -2077,4 +2081,30 @@ namespace yae
     return name;
   }
 
+  //----------------------------------------------------------------
+  // saveTrace
+  //
+  bool
+  saveTrace()
+  {
+    if (!TTrace::enabled())
+    {
+      return false;
+    }
+
+    const char * env = getenv("YAE_TRACE_FILE");
+    std::string path =
+      (env && *env) ? std::string(env) :
+      QDir(QDir::tempPath()).filePath("yae-trace.json").toUtf8().constData();
+
+    if (!TTrace::save(path.c_str()))
+    {
+      std::cerr << "failed to save trace to " << path << std::endl;
+      return false;
+    }
+
+    std::cerr << "saved trace to " << path << std::endl;
+    return true;
+  }
+
 }
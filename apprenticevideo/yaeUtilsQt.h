@@ -212,6 +212,15 @@ namespace yae
   //
   YAE_API const char * to_str(QEvent::Type et);
 
+  //----------------------------------------------------------------
+  // saveTrace
+  //
+  // dump the recent playback timeline for chrome://tracing,
+  // to YAE_TRACE_FILE if set, otherwise to the temp folder;
+  // returns false if tracing is disabled or the file could not be saved:
+  //
+  YAE_API bool saveTrace();
+
   //----------------------------------------------------------------
   // SignalBlocker
   //
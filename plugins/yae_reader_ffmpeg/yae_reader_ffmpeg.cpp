@@ -435,6 +435,21 @@ namespace yae
     return ok;
   }
 
+  //----------------------------------------------------------------
+  // ReaderFFMPEG::readKeyframe
+  //
+  bool
+  ReaderFFMPEG::readKeyframe(double t, TVideoFramePtr & frame)
+  {
+    bool ok = private_->movie_.decodeKeyframe(t, frame);
+    if (ok && frame)
+    {
+      frame->readerId_ = private_->readerId_;
+    }
+
+    return ok;
+  }
+
   //----------------------------------------------------------------
   // ReaderFFMPEG::readAudio
   //
@@ -145,7 +145,7 @@ namespace yae
   //----------------------------------------------------------------
   // TGopCache
   //
-  typedef LRUCache<std::string, TVideoFramesPtr> TGopCache;
+  typedef ShardedLRUCache<std::string, TVideoFramesPtr> TGopCache;
 
   //----------------------------------------------------------------
   // VideoFrameItem
@@ -20,6 +20,8 @@
 #include <wchar.h>
 #endif
 
+#include <stdlib.h>
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
 #include <limits>
@@ -152,6 +154,7 @@ usage(char ** argv, const char * message = NULL)
     << "\nUSAGE:\n"
     << argv[0]
     << " [-no-ui] [-w] [-o ${output_path}]"
+    << " [-k ${keyframes_folder}] [-wext png|jpg|pgm] [-j ${workers}]"
     << " [[-track track_id]"
     << " ${source_file}"
     << " [-t time_in time_out]*]+"
@@ -176,6 +179,12 @@ usage(char ** argv, const char * message = NULL)
     << " ~/Movies/bar.ts -t 00:02:29.440 00:02:36.656"
     << " -no-ui -o ~/Movies/two-clips-joined-together.ts"
     << "\n"
+    << "\n# remux, and save jpeg keyframes using 8 threads at the same time:\n"
+    << argv[0]
+    << " ~/Movies/foo.ts"
+    << " -no-ui -j 8 -wext jpg -k ~/Movies/keyframes"
+    << " -o ~/Movies/foo-remuxed.ts"
+    << "\n"
     << "\n# load source, show summary and GOP structure, then quit:\n"
     << argv[0]
     << " -no-ui ~/Movies/foo.ts"
@@ -284,6 +293,14 @@ mainMayThrowException(int argc, char ** argv)
   // yae::Application::setAttribute(Qt::AA_EnableHighDpiScaling, true);
 #endif
 
+  // remux summarizes every source, so it opts in to the persistent
+  // demuxer index, unless $YAE_INDEX_CACHE says where (or whether)
+  // to keep it:
+  if (!getenv("YAE_INDEX_CACHE"))
+  {
+    yae::set_demuxer_index_cache(yae::default_demuxer_index_cache());
+  }
+
   yae::Application app(argc, argv);
   QStringList args = app.arguments();
 
@@ -294,6 +311,9 @@ mainMayThrowException(int argc, char ** argv)
   std::set<std::string> clipped;
   std::string output_path;
   std::string curr_track;
+  std::string keyframes_folder;
+  std::string keyframes_ext("png");
+  std::size_t workers = 0;
   bool save_keyframes = false;
   bool no_ui = false;
 
@@ -332,6 +352,21 @@ mainMayThrowException(int argc, char ** argv)
     {
       save_keyframes = true;
     }
+    else if (arg == "-k")
+    {
+      ++i;
+      keyframes_folder = i->toUtf8().constData();
+    }
+    else if (arg == "-wext")
+    {
+      ++i;
+      keyframes_ext = i->toUtf8().constData();
+    }
+    else if (arg == "-j")
+    {
+      ++i;
+      workers = std::size_t(std::max(0, i->toInt()));
+    }
     else if (arg == "-no-ui")
     {
       no_ui = true;
@@ -428,12 +463,18 @@ mainMayThrowException(int argc, char ** argv)
 
       if (!save_keyframes)
       {
-        int err = yae::remux(output_path.c_str(), *demuxer);
+        yae::RemuxOptions options;
+        options.output_path_ = output_path;
+        options.keyframes_folder_ = keyframes_folder;
+        options.keyframes_ext_ = keyframes_ext;
+        options.workers_ = workers;
+
+        int err = yae::remux(*demuxer, options);
         return err;
       }
 
       // save the keyframes:
-      yae::demux(demuxer, output_path, save_keyframes);
+      yae::demux(demuxer, output_path, save_keyframes, workers, keyframes_ext);
     }
 
     return 0;
@@ -13,9 +13,6 @@
 #include <list>
 #include <string>
 
-// boost:
-#include <boost/filesystem/path.hpp>
-
 // jsoncpp:
 #include "json/json.h"
 
@@ -26,9 +23,6 @@
 #include "yaeRemux.h"
 #include "yaeVersion.h"
 
-// namespace shortcuts:
-namespace fs = boost::filesystem;
-
 
 namespace yae
 {
@@ -338,10 +332,20 @@ namespace yae
   void
   demux(const TDemuxerInterfacePtr & demuxer,
         const std::string & output_path,
-        bool save_keyframes)
+        bool save_keyframes,
+        std::size_t workers,
+        const std::string & keyframes_ext)
   {
     const DemuxerSummary & summary = demuxer->summary();
 
+    // decode and save keyframes in the background
+    // while the packets are being listed:
+    boost::shared_ptr<KeyframeSaver> keyframe_saver;
+    if (save_keyframes)
+    {
+      keyframe_saver.reset(new KeyframeSaver(workers));
+    }
+
     std::map<int, TTime> prog_dts;
     while (true)
     {
@@ -460,24 +464,28 @@ namespace yae
 
       std::cout << std::endl;
 
-      if (is_keyframe && save_keyframes)
+      if (is_keyframe && keyframe_saver)
       {
-        fs::path folder = (fs::path(output_path) /
-                           boost::replace_all_copy(pkt.trackId_, ":", "."));
-        fs::create_directories(folder);
-
-        std::string fn = (dts.to_hhmmss_frac(1000, "", ".") + ".png");
-        std::string path((folder / fn).string());
+        std::string path =
+          get_keyframe_path(output_path, pkt.trackId_, dts, keyframes_ext);
 
         TrackPtr track_ptr = yae::get(summary.decoders_, pkt.trackId_);
         VideoTrackPtr decoder_ptr =
           boost::dynamic_pointer_cast<VideoTrack, Track>(track_ptr);
 
-        if (!save_keyframe(path, decoder_ptr, packet_ptr, 0, 0, 0.0, 1.0))
+        if (!keyframe_saver->save(path,
+                                  decoder_ptr,
+                                  packet_ptr,
+                                  0, 0, 0.0, 1.0))
         {
           break;
         }
       }
     }
+
+    if (keyframe_saver)
+    {
+      keyframe_saver->wait();
+    }
   }
 }
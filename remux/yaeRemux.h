@@ -119,7 +119,9 @@ namespace yae
   void
   demux(const TDemuxerInterfacePtr & demuxer,
         const std::string & output_path = std::string(),
-        bool save_keyframes = false);
+        bool save_keyframes = false,
+        std::size_t workers = 0,
+        const std::string & keyframes_ext = std::string("png"));
 }
 
 
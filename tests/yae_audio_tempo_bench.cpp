@@ -0,0 +1,368 @@
+// -*- Mode: c++; tab-width: 8; c-basic-offset: 2; indent-tabs-mode: nil -*-
+// NOTE: the first line of this file sets up source code indentation rules
+// for Emacs; it is also a hint to anyone modifying this file.
+
+// Created   : Fri Oct 16 21:05:52 MDT 2026
+// Copyright : Pavel Koshevoy
+// License   : MIT -- http://www.opensource.org/licenses/mit-license.php
+
+// standard:
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// boost:
+#include <boost/chrono/chrono.hpp>
+
+// aeyae:
+#include "yae/ffmpeg/yae_audio_tempo_filter.h"
+#include "yae/ffmpeg/yae_audio_tempo_kernels.h"
+
+// shortcut:
+using namespace yae;
+
+
+//----------------------------------------------------------------
+// kKernelNames
+//
+static const char * kKernelNames[] = { "scalar", "sse2", "avx2" };
+
+//----------------------------------------------------------------
+// TLayout
+//
+struct TLayout
+{
+  const char * name_;
+  unsigned int channels_;
+};
+
+//----------------------------------------------------------------
+// kLayouts
+//
+static const TLayout kLayouts[] = {
+  { "mono", 1 },
+  { "stereo", 2 },
+  { "5.1", 6 },
+  { "7.1", 8 }
+};
+
+//----------------------------------------------------------------
+// usage
+//
+static int
+usage(const char * message = NULL)
+{
+  std::cerr
+    << "\nUSAGE:\n"
+    << "  aeyae-audio-tempo-bench [options]\n"
+    << "\nOPTIONS:\n"
+    << "  --rate N           sample rate, default 96000\n"
+    << "  --tempo T          tempo scale factor in [0.5, 2], default 1.5\n"
+    << "  --seconds N        duration of the test signal, default 10\n"
+    << "  --channels N       1, 2, 6 or 8, default all of them\n"
+    << "  --format F         u8, s16, s32, flt or dbl, default all of them\n"
+    << "  --kernels K        scalar, sse2 or avx2, default all supported\n"
+    << "\nReports the real-time factor -- seconds of input processed\n"
+    << "per second of wall time, per sample format and channel layout.\n"
+    << std::endl;
+
+  if (message)
+  {
+    std::cerr << "ERROR: " << message << std::endl;
+  }
+
+  return 1;
+}
+
+//----------------------------------------------------------------
+// make_signal
+//
+// a few partials with a slow vibrato plus some noise, each channel
+// at a different phase so that the downmix has to pick among them:
+//
+static void
+make_signal(std::vector<float> & signal,
+            unsigned int rate,
+            unsigned int channels,
+            double seconds)
+{
+  const std::size_t frames = std::size_t(seconds * double(rate));
+  signal.resize(frames * channels);
+
+  unsigned int seed = 1;
+  for (std::size_t i = 0; i < frames; i++)
+  {
+    double t = double(i) / double(rate);
+    double f = 220.0 * (1.0 + 0.01 * sin(2.0 * M_PI * 5.0 * t));
+
+    for (unsigned int j = 0; j < channels; j++)
+    {
+      double phase = double(j) * 0.7;
+      double s = (0.5 * sin(2.0 * M_PI * f * t + phase) +
+                  0.2 * sin(2.0 * M_PI * 3.0 * f * t + phase) +
+                  0.1 * sin(2.0 * M_PI * 7.0 * f * t + phase));
+
+      seed = seed * 1103515245 + 12345;
+      s += 0.05 * (double((seed >> 8) & 0xFFFF) / 32767.5 - 1.0);
+
+      signal[i * channels + j] = float(s);
+    }
+  }
+}
+
+//----------------------------------------------------------------
+// convert
+//
+template <typename TSample>
+static void
+convert(const std::vector<float> & signal,
+        double offset,
+        double scale,
+        std::vector<TSample> & samples)
+{
+  samples.resize(signal.size());
+  for (std::size_t i = 0; i < signal.size(); i++)
+  {
+    samples[i] = TSample(offset + scale * double(signal[i]));
+  }
+}
+
+//----------------------------------------------------------------
+// run
+//
+// returns the real-time factor:
+//
+template <typename TFilter>
+static double
+run(const std::vector<float> & signal,
+    unsigned int rate,
+    unsigned int channels,
+    double tempo,
+    double offset,
+    double scale)
+{
+  typedef typename TFilter::TData TSample;
+
+  std::vector<TSample> samples;
+  convert(signal, offset, scale, samples);
+
+  TFilter filter;
+  filter.reset(rate, channels);
+  filter.setTempo(tempo);
+
+  // tempo is at least 0.5, so the output is at most twice the input:
+  const std::size_t chunk = 1024 * channels * sizeof(TSample);
+  std::vector<unsigned char> output(chunk * 2 + filter.fragmentSize());
+
+  const unsigned char * src = (const unsigned char *)(&samples[0]);
+  const unsigned char * end = src + samples.size() * sizeof(TSample);
+
+  boost::chrono::steady_clock::time_point
+    t0 = boost::chrono::steady_clock::now();
+
+  while (src < end)
+  {
+    const unsigned char * srcEnd =
+      src + std::min<std::size_t>(chunk, end - src);
+    unsigned char * dst = &output[0];
+    unsigned char * dstEnd = dst + output.size();
+    filter.apply(&src, srcEnd, &dst, dstEnd);
+  }
+
+  while (true)
+  {
+    unsigned char * dst = &output[0];
+    unsigned char * dstEnd = dst + output.size();
+    if (filter.flush(&dst, dstEnd))
+    {
+      break;
+    }
+  }
+
+  boost::chrono::steady_clock::time_point
+    t1 = boost::chrono::steady_clock::now();
+
+  double elapsed = double(boost::chrono::duration_cast
+                          <boost::chrono::microseconds>(t1 - t0).
+                          count()) * 1e-6;
+
+  double duration = double(samples.size() / channels) / double(rate);
+  return duration / std::max(elapsed, 1e-6);
+}
+
+//----------------------------------------------------------------
+// run
+//
+static double
+run(const std::string & format,
+    const std::vector<float> & signal,
+    unsigned int rate,
+    unsigned int channels,
+    double tempo)
+{
+  if (format == "u8")
+  {
+    return run<TAudioTempoFilterU8>(signal, rate, channels, tempo,
+                                    128.0, 127.0);
+  }
+
+  if (format == "s16")
+  {
+    return run<TAudioTempoFilterI16>(signal, rate, channels, tempo,
+                                     0.0, 32767.0);
+  }
+
+  if (format == "s32")
+  {
+    return run<TAudioTempoFilterI32>(signal, rate, channels, tempo,
+                                     0.0, 2147483647.0);
+  }
+
+  if (format == "flt")
+  {
+    return run<TAudioTempoFilterF32>(signal, rate, channels, tempo,
+                                     0.0, 1.0);
+  }
+
+  return run<TAudioTempoFilterF64>(signal, rate, channels, tempo,
+                                   0.0, 1.0);
+}
+
+
+//----------------------------------------------------------------
+// main
+//
+int
+main(int argc, char ** argv)
+{
+  static const char * formats[] = { "u8", "s16", "s32", "flt", "dbl" };
+
+  unsigned int rate = 96000;
+  double tempo = 1.5;
+  double seconds = 10.0;
+  unsigned int channels = 0;
+  std::string format;
+  int kernels = -1;
+
+  for (int i = 1; i < argc; i++)
+  {
+    std::string arg(argv[i]);
+    bool has_value = (i + 1 < argc);
+
+    if (arg == "-h" || arg == "--help")
+    {
+      usage();
+      return 0;
+    }
+    else if (arg == "--rate" && has_value)
+    {
+      rate = (unsigned int)(std::max(8000, atoi(argv[++i])));
+    }
+    else if (arg == "--tempo" && has_value)
+    {
+      tempo = atof(argv[++i]);
+      if (tempo < 0.5 || tempo > 2.0)
+      {
+        return usage("--tempo must be within [0.5, 2]");
+      }
+    }
+    else if (arg == "--seconds" && has_value)
+    {
+      seconds = std::max(1.0, atof(argv[++i]));
+    }
+    else if (arg == "--channels" && has_value)
+    {
+      channels = (unsigned int)(atoi(argv[++i]));
+      if (channels != 1 && channels != 2 && channels != 6 && channels != 8)
+      {
+        return usage("unsupported --channels");
+      }
+    }
+    else if (arg == "--format" && has_value)
+    {
+      format = argv[++i];
+      if (format != "u8" && format != "s16" && format != "s32" &&
+          format != "flt" && format != "dbl")
+      {
+        return usage("unsupported --format");
+      }
+    }
+    else if (arg == "--kernels" && has_value)
+    {
+      std::string name(argv[++i]);
+      for (int k = 0; k <= TAudioTempoKernels::kKernelsAVX2; k++)
+      {
+        if (name == kKernelNames[k])
+        {
+          kernels = k;
+        }
+      }
+
+      if (kernels < 0 ||
+          !TAudioTempoKernels::useKernels(TAudioTempoKernels::TKernels
+                                          (kernels)))
+      {
+        return usage("--kernels are not supported by this CPU");
+      }
+    }
+    else
+    {
+      return usage(("unexpected parameter: " + arg).c_str());
+    }
+  }
+
+  const int k0 = kernels < 0 ? 0 : kernels;
+  const int k1 =
+    kernels < 0 ? int(TAudioTempoKernels::supportedKernels()) : kernels;
+
+  std::cout
+    << rate << " Hz, tempo " << tempo << ", " << seconds << " seconds\n"
+    << "real-time factor, higher is better:\n\n"
+    << std::setw(8) << "layout" << std::setw(8) << "format";
+
+  for (int k = k0; k <= k1; k++)
+  {
+    std::cout << std::setw(10) << kKernelNames[k];
+  }
+
+  std::cout << std::endl;
+
+  for (std::size_t i = 0; i < sizeof(kLayouts) / sizeof(kLayouts[0]); i++)
+  {
+    const TLayout & layout = kLayouts[i];
+    if (channels && channels != layout.channels_)
+    {
+      continue;
+    }
+
+    std::vector<float> signal;
+    make_signal(signal, rate, layout.channels_, seconds);
+
+    for (std::size_t j = 0; j < sizeof(formats) / sizeof(formats[0]); j++)
+    {
+      if (!format.empty() && format != formats[j])
+      {
+        continue;
+      }
+
+      std::cout << std::setw(8) << layout.name_ << std::setw(8) << formats[j];
+
+      for (int k = k0; k <= k1; k++)
+      {
+        TAudioTempoKernels::useKernels(TAudioTempoKernels::TKernels(k));
+
+        double rtf = run(formats[j], signal, rate, layout.channels_, tempo);
+        std::cout << std::setw(10) << std::fixed << std::setprecision(1)
+                  << rtf << std::flush;
+      }
+
+      std::cout << std::endl;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,292 @@
+// -*- Mode: c++; tab-width: 8; c-basic-offset: 2; indent-tabs-mode: nil -*-
+// NOTE: the first line of this file sets up source code indentation rules
+// for Emacs; it is also a hint to anyone modifying this file.
+
+// Created   : Fri Oct 16 21:05:52 MDT 2026
+// Copyright : Pavel Koshevoy
+// License   : MIT -- http://www.opensource.org/licenses/mit-license.php
+
+// standard:
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+// boost library:
+#include <boost/test/unit_test.hpp>
+
+// aeyae:
+#include "yae/ffmpeg/yae_audio_tempo_kernels.h"
+
+// shortcut:
+using namespace yae;
+
+
+//----------------------------------------------------------------
+// make_samples
+//
+// a loud waveform with some samples past the clipping threshold:
+//
+template <typename TSample>
+static void
+make_samples(std::vector<TSample> & samples,
+             std::size_t n,
+             double lo,
+             double hi,
+             unsigned int seed)
+{
+  samples.resize(n);
+  for (std::size_t i = 0; i < n; i++)
+  {
+    seed = seed * 1103515245 + 12345;
+    double t = double((seed >> 8) & 0xFFFF) / 65535.0;
+    samples[i] = TSample(lo + (hi - lo) * t);
+  }
+}
+
+//----------------------------------------------------------------
+// downmix_reference
+//
+// the original AudioFragment::downsample loop:
+//
+template <typename TSample>
+static void
+downmix_reference(const TSample * src,
+                  std::size_t frames,
+                  std::size_t channels,
+                  float max0,
+                  float * dst)
+{
+  for (std::size_t i = 0; i < frames; i++)
+  {
+    float max = float(*src++);
+    float s = std::min<float>(max0, fabsf(max));
+
+    for (std::size_t j = 1; j < channels; j++)
+    {
+      float ti = float(*src++);
+      float si = std::min<float>(max0, fabsf(ti));
+
+      if (s < si)
+      {
+        s = si;
+        max = ti;
+      }
+    }
+
+    dst[i] = max;
+  }
+}
+
+//----------------------------------------------------------------
+// check_downmix
+//
+template <typename TSample>
+static void
+check_downmix(double lo, double hi, float max0)
+{
+  const std::size_t channels[] = { 1, 2, 3, 6, 8 };
+  const std::size_t frames = 1031;
+
+  for (std::size_t c = 0; c < sizeof(channels) / sizeof(channels[0]); c++)
+  {
+    const std::size_t nc = channels[c];
+
+    std::vector<TSample> src;
+    make_samples(src, frames * nc, lo, hi, (unsigned int)(nc));
+
+    std::vector<float> expected(frames);
+    downmix_reference(&src[0], frames, nc, max0, &expected[0]);
+
+    for (int k = TAudioTempoKernels::kKernelsScalar;
+         k <= TAudioTempoKernels::supportedKernels(); k++)
+    {
+      TAudioTempoKernels::useKernels(TAudioTempoKernels::TKernels(k));
+
+      std::vector<float> dst(frames);
+      TAudioTempoKernels::downmix(&src[0], frames, nc, max0, &dst[0]);
+
+      BOOST_CHECK(memcmp(&dst[0], &expected[0], frames * sizeof(float)) == 0);
+    }
+  }
+
+  TAudioTempoKernels::useKernels(TAudioTempoKernels::supportedKernels());
+}
+
+//----------------------------------------------------------------
+// check_overlap_add
+//
+// all kernel sets must agree, and match the original
+// TSample(a * wa + b * wb) loop for in-range results:
+//
+template <typename TSample>
+static void
+check_overlap_add(double lo, double hi)
+{
+  const std::size_t n = 4099;
+
+  std::vector<TSample> a;
+  std::vector<TSample> b;
+  make_samples(a, n, lo, hi, 1);
+  make_samples(b, n, lo, hi, 2);
+
+  std::vector<float> wa;
+  std::vector<float> wb;
+  make_samples(wa, n, 0.0, 1.0, 3);
+  wb.resize(n);
+  for (std::size_t i = 0; i < n; i++)
+  {
+    wb[i] = 1.0f - wa[i];
+  }
+
+  std::vector<TSample> expected(n);
+  for (std::size_t i = 0; i < n; i++)
+  {
+    float t0 = float(a[i]);
+    float t1 = float(b[i]);
+    expected[i] = TSample(t0 * wa[i] + t1 * wb[i]);
+  }
+
+  for (int k = TAudioTempoKernels::kKernelsScalar;
+       k <= TAudioTempoKernels::supportedKernels(); k++)
+  {
+    TAudioTempoKernels::useKernels(TAudioTempoKernels::TKernels(k));
+
+    std::vector<TSample> dst(n);
+    TAudioTempoKernels::overlapAdd(&a[0], &b[0], &wa[0], &wb[0], n, &dst[0]);
+
+    BOOST_CHECK(memcmp(&dst[0], &expected[0], n * sizeof(TSample)) == 0);
+  }
+
+  TAudioTempoKernels::useKernels(TAudioTempoKernels::supportedKernels());
+}
+
+
+BOOST_AUTO_TEST_CASE(yae_audio_tempo_kernels_downmix)
+{
+  check_downmix<unsigned char>(0, 255, 255);
+  check_downmix<short int>(-32768, 32767, 32767);
+  check_downmix<int>(-2147483648.0, 2147483647.0, 2147483647.0f);
+  check_downmix<float>(-1.5, 1.5, 1);
+  check_downmix<double>(-1.5, 1.5, 1);
+}
+
+BOOST_AUTO_TEST_CASE(yae_audio_tempo_kernels_overlap_add)
+{
+  check_overlap_add<unsigned char>(0, 255);
+  check_overlap_add<short int>(-32768, 32767);
+  check_overlap_add<int>(-1073741824.0, 1073741824.0);
+  check_overlap_add<float>(-1, 1);
+  check_overlap_add<double>(-1, 1);
+}
+
+BOOST_AUTO_TEST_CASE(yae_audio_tempo_kernels_overlap_add_clip)
+{
+  const short int a[] = { 32767, -32768, 32767, -32768, 100 };
+  const short int b[] = { 32767, -32768, 32767, -32768, 100 };
+  const float w[] = { 0.75f, 0.75f, 0.5f, 0.5f, 0.5f };
+
+  for (int k = TAudioTempoKernels::kKernelsScalar;
+       k <= TAudioTempoKernels::supportedKernels(); k++)
+  {
+    TAudioTempoKernels::useKernels(TAudioTempoKernels::TKernels(k));
+
+    short int dst[5] = { 0 };
+    TAudioTempoKernels::overlapAdd(a, b, w, w, 5, dst);
+
+    BOOST_CHECK_EQUAL(dst[0], 32767);
+    BOOST_CHECK_EQUAL(dst[1], -32768);
+    BOOST_CHECK_EQUAL(dst[2], 32767);
+    BOOST_CHECK_EQUAL(dst[3], -32768);
+    BOOST_CHECK_EQUAL(dst[4], 100);
+  }
+
+  TAudioTempoKernels::useKernels(TAudioTempoKernels::supportedKernels());
+}
+
+BOOST_AUTO_TEST_CASE(yae_audio_tempo_kernels_correlation)
+{
+  const int window = 2048;
+
+  std::vector<float> xa;
+  std::vector<float> xb;
+  make_samples(xa, window * 2, -100, 100, 4);
+  make_samples(xb, window * 2, -100, 100, 5);
+
+  std::vector<float> expected(window * 2);
+  for (int i = 0; i < window; i++)
+  {
+    const float * a = &xa[i * 2];
+    const float * b = &xb[i * 2];
+    expected[i * 2] = (a[0] * b[0] + a[1] * b[1]);
+    expected[i * 2 + 1] = (a[1] * b[0] - a[0] * b[1]);
+  }
+
+  const int drifts[] = { -300, -17, 0, 5, 511 };
+  std::vector<int> peaks;
+  for (std::size_t j = 0; j < sizeof(drifts) / sizeof(drifts[0]); j++)
+  {
+    const int drift = drifts[j];
+    const int deltaMax = window / 2;
+    const int i0 = std::min<int>(std::max<int>(window / 2 - deltaMax - drift,
+                                               0), window);
+    const int i1 = std::max<int>(std::min<int>(window / 2 + deltaMax - drift,
+                                               window - window / 16), 0);
+
+    int best = -1;
+    float bestMetric = -FLT_MAX;
+    for (int i = i0; i < i1; i++)
+    {
+      float metric = expected[i];
+      float drifti = float(drift + i);
+      metric *= drifti * float(i - i0) * float(i1 - i);
+
+      if (metric > bestMetric)
+      {
+        bestMetric = metric;
+        best = i;
+      }
+    }
+
+    peaks.push_back(best);
+  }
+
+  for (int k = TAudioTempoKernels::kKernelsScalar;
+       k <= TAudioTempoKernels::supportedKernels(); k++)
+  {
+    TAudioTempoKernels::useKernels(TAudioTempoKernels::TKernels(k));
+
+    std::vector<float> xc(window * 2);
+    TAudioTempoKernels::crossSpectrum(&xa[0], &xb[0], window, &xc[0]);
+    BOOST_CHECK(memcmp(&xc[0], &expected[0], xc.size() * sizeof(float)) == 0);
+
+    for (std::size_t j = 0; j < sizeof(drifts) / sizeof(drifts[0]); j++)
+    {
+      const int drift = drifts[j];
+      const int deltaMax = window / 2;
+      const int i0 =
+        std::min<int>(std::max<int>(window / 2 - deltaMax - drift, 0),
+                      window);
+      const int i1 =
+        std::max<int>(std::min<int>(window / 2 + deltaMax - drift,
+                                    window - window / 16), 0);
+
+      int best = TAudioTempoKernels::correlationPeak(&xc[0], i0, i1, drift);
+      BOOST_CHECK_EQUAL(best, peaks[j]);
+    }
+
+    // ties are resolved in favor of the first peak,
+    // metric(i) = flat[i] * i * i * (50 - i):
+    std::vector<float> flat(64, 0.0f);
+    flat[9] = 42.0f * 42.0f * 8.0f;
+    flat[42] = 9.0f * 9.0f * 41.0f;
+    BOOST_CHECK_EQUAL(TAudioTempoKernels::correlationPeak(&flat[0],
+                                                          0, 50, 0), 9);
+    BOOST_CHECK_EQUAL(TAudioTempoKernels::correlationPeak(&flat[0],
+                                                          0, 0, 0), -1);
+  }
+
+  TAudioTempoKernels::useKernels(TAudioTempoKernels::supportedKernels());
+}
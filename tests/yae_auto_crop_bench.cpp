@@ -0,0 +1,230 @@
+// -*- Mode: c++; tab-width: 8; c-basic-offset: 2; indent-tabs-mode: nil -*-
+// NOTE: the first line of this file sets up source code indentation rules
+// for Emacs; it is also a hint to anyone modifying this file.
+
+// Created   : Fri Oct 16 22:14:09 MDT 2026
+// Copyright : Pavel Koshevoy
+// License   : MIT -- http://www.opensource.org/licenses/mit-license.php
+
+// standard:
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+// boost:
+#include <boost/chrono/chrono.hpp>
+
+// aeyae:
+#include "yae/video/yae_auto_crop.h"
+#include "yae/video/yae_pixel_formats.h"
+
+// shortcut:
+using namespace yae;
+
+
+//----------------------------------------------------------------
+// kKernelNames
+//
+static const char * kKernelNames[] = { "scalar", "sse2", "avx2" };
+
+//----------------------------------------------------------------
+// usage
+//
+static int
+usage(const char * message = NULL)
+{
+  std::cerr
+    << "\nUSAGE:\n"
+    << "  aeyae-auto-crop-bench [options]\n"
+    << "\nOPTIONS:\n"
+    << "  --iterations N     frames analyzed per measurement, default 20\n"
+    << "  --kernels K        scalar, sse2 or avx2, default all supported\n"
+    << "\nReports the time it takes to detect the letterbox of one\n"
+    << "1080p and 2160p frame, 8-bit and 10-bit, per kernel set.\n"
+    << std::endl;
+
+  if (message)
+  {
+    std::cerr << "ERROR: " << message << std::endl;
+  }
+
+  return 1;
+}
+
+//----------------------------------------------------------------
+// make_frame
+//
+// planar 4:2:0 frame with black borders around a noisy picture,
+// 8-bit or 10-bit little-endian luma:
+//
+static TVideoFramePtr
+make_frame(unsigned int w, unsigned int h,
+           unsigned int border_x, unsigned int border_y,
+           bool ten_bit)
+{
+  TVideoFramePtr frame(new TVideoFrame());
+  VideoTraits & vtts = frame->traits_;
+  vtts.pixelFormat_ =
+    ten_bit ? kPixelFormatYUV420P10LE : kPixelFormatYUV420P;
+  vtts.encodedWidth_ = w;
+  vtts.encodedHeight_ = h;
+  vtts.visibleWidth_ = w;
+  vtts.visibleHeight_ = h;
+  vtts.offsetLeft_ = 0;
+  vtts.offsetTop_ = 0;
+
+  const unsigned int bytes = ten_bit ? 2 : 1;
+  TPlanarBufferPtr buffer(new TPlanarBuffer(3),
+                          &IPlanarBuffer::deallocator);
+  buffer->resize(0, w * bytes, h);
+  buffer->resize(1, (w / 2) * bytes, h / 2);
+  buffer->resize(2, (w / 2) * bytes, h / 2);
+
+  unsigned int seed = 1;
+  for (unsigned int y = 0; y < h; y++)
+  {
+    unsigned char * row = buffer->data(0) + y * buffer->rowBytes(0);
+    for (unsigned int x = 0; x < w; x++)
+    {
+      bool border = (x < border_x || x >= w - border_x ||
+                     y < border_y || y >= h - border_y);
+
+      seed = seed * 1103515245 + 12345;
+      unsigned int v = border ? 16 : 64 + ((seed >> 16) % 160);
+
+      if (ten_bit)
+      {
+        v <<= 2;
+        row[x * 2] = (unsigned char)(v & 0xFF);
+        row[x * 2 + 1] = (unsigned char)(v >> 8);
+      }
+      else
+      {
+        row[x] = (unsigned char)v;
+      }
+    }
+  }
+
+  frame->data_ = buffer;
+  return frame;
+}
+
+//----------------------------------------------------------------
+// run
+//
+// returns the mean time to analyze one frame, in microseconds:
+//
+static double
+run(const TVideoFramePtr & frame, int iterations, TCropFrame & crop)
+{
+  boost::chrono::steady_clock::time_point
+    t0 = boost::chrono::steady_clock::now();
+
+  for (int j = 0; j < iterations; j++)
+  {
+    TAutoCropDetect::analyze(frame, crop);
+  }
+
+  boost::chrono::steady_clock::time_point
+    t1 = boost::chrono::steady_clock::now();
+
+  return double(boost::chrono::duration_cast
+                <boost::chrono::microseconds>(t1 - t0).
+                count()) / double(iterations);
+}
+
+
+//----------------------------------------------------------------
+// main
+//
+int
+main(int argc, char ** argv)
+{
+  int iterations = 20;
+  int kernels = -1;
+
+  for (int i = 1; i < argc; i++)
+  {
+    std::string arg(argv[i]);
+    bool has_value = (i + 1 < argc);
+
+    if (arg == "-h" || arg == "--help")
+    {
+      usage();
+      return 0;
+    }
+    else if (arg == "--iterations" && has_value)
+    {
+      iterations = std::max(1, atoi(argv[++i]));
+    }
+    else if (arg == "--kernels" && has_value)
+    {
+      std::string name(argv[++i]);
+      for (int k = 0; k <= TAutoCropDetect::kKernelsAVX2; k++)
+      {
+        if (name == kKernelNames[k])
+        {
+          kernels = k;
+        }
+      }
+
+      if (kernels < 0 ||
+          !TAutoCropDetect::useKernels(TAutoCropDetect::TKernels(kernels)))
+      {
+        return usage("--kernels are not supported by this CPU");
+      }
+    }
+    else
+    {
+      return usage(("unexpected parameter: " + arg).c_str());
+    }
+  }
+
+  const int k0 = kernels < 0 ? 0 : kernels;
+  const int k1 =
+    kernels < 0 ? int(TAutoCropDetect::supportedKernels()) : kernels;
+
+  std::cout
+    << "usec per frame, lower is better:\n\n"
+    << std::setw(10) << "size" << std::setw(8) << "depth";
+
+  for (int k = k0; k <= k1; k++)
+  {
+    std::cout << std::setw(10) << kKernelNames[k];
+  }
+
+  std::cout << std::endl;
+
+  const unsigned int sizes[][2] = { { 1920, 1080 }, { 3840, 2160 } };
+  for (int i = 0; i < 2; i++)
+  {
+    const unsigned int w = sizes[i][0];
+    const unsigned int h = sizes[i][1];
+
+    for (int ten_bit = 0; ten_bit < 2; ten_bit++)
+    {
+      TVideoFramePtr frame = make_frame(w, h, w / 16, h / 8, ten_bit != 0);
+
+      std::cout
+        << std::setw(5) << w << 'x' << std::setw(4) << std::left << h
+        << std::right << std::setw(8) << (ten_bit ? "10-bit" : "8-bit");
+
+      for (int k = k0; k <= k1; k++)
+      {
+        TAutoCropDetect::useKernels(TAutoCropDetect::TKernels(k));
+
+        TCropFrame crop;
+        double usec = run(frame, iterations, crop);
+
+        std::cout
+          << std::setw(10) << std::fixed << std::setprecision(1) << usec;
+      }
+
+      std::cout << std::endl;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,229 @@
+// -*- Mode: c++; tab-width: 8; c-basic-offset: 2; indent-tabs-mode: nil -*-
+// NOTE: the first line of this file sets up source code indentation rules
+// for Emacs; it is also a hint to anyone modifying this file.
+
+// Created   : Fri Oct 16 19:02:44 MDT 2026
+// Copyright : Pavel Koshevoy
+// License   : MIT -- http://www.opensource.org/licenses/mit-license.php
+
+// standard:
+#include <cstdlib>
+#include <sstream>
+
+// boost library:
+#include <boost/test/unit_test.hpp>
+
+// aeyae:
+#include "yae/video/yae_auto_crop.h"
+#include "yae/video/yae_pixel_formats.h"
+
+// shortcut:
+using namespace yae;
+
+
+//----------------------------------------------------------------
+// make_frame
+//
+// planar 4:2:0 frame with black borders around a noisy picture,
+// 8-bit or 10-bit little-endian luma; the picture is noise
+// in [lo, lo + 160), a low lo puts it close to the black level:
+//
+static TVideoFramePtr
+make_frame(unsigned int w, unsigned int h,
+           unsigned int border_x, unsigned int border_y,
+           bool ten_bit,
+           unsigned int lo = 64)
+{
+  TVideoFramePtr frame(new TVideoFrame());
+  VideoTraits & vtts = frame->traits_;
+  vtts.pixelFormat_ =
+    ten_bit ? kPixelFormatYUV420P10LE : kPixelFormatYUV420P;
+  vtts.encodedWidth_ = w;
+  vtts.encodedHeight_ = h;
+  vtts.visibleWidth_ = w;
+  vtts.visibleHeight_ = h;
+  vtts.offsetLeft_ = 0;
+  vtts.offsetTop_ = 0;
+
+  const unsigned int bytes = ten_bit ? 2 : 1;
+  TPlanarBufferPtr buffer(new TPlanarBuffer(3),
+                          &IPlanarBuffer::deallocator);
+  buffer->resize(0, w * bytes, h);
+  buffer->resize(1, (w / 2) * bytes, h / 2);
+  buffer->resize(2, (w / 2) * bytes, h / 2);
+
+  unsigned int seed = 1;
+  for (unsigned int y = 0; y < h; y++)
+  {
+    unsigned char * row = buffer->data(0) + y * buffer->rowBytes(0);
+    for (unsigned int x = 0; x < w; x++)
+    {
+      bool border = (x < border_x || x >= w - border_x ||
+                     y < border_y || y >= h - border_y);
+
+      seed = seed * 1103515245 + 12345;
+      unsigned int v = border ? 16 : lo + ((seed >> 16) % 160);
+
+      if (ten_bit)
+      {
+        v <<= 2;
+        row[x * 2] = (unsigned char)(v & 0xFF);
+        row[x * 2 + 1] = (unsigned char)(v >> 8);
+      }
+      else
+      {
+        row[x] = (unsigned char)v;
+      }
+    }
+  }
+
+  frame->data_ = buffer;
+  return frame;
+}
+
+//----------------------------------------------------------------
+// check_crop
+//
+static void
+check_crop(const TCropFrame & crop,
+           int x, int y, int w, int h)
+{
+  BOOST_CHECK_LE(std::abs(crop.x_ - x), 2);
+  BOOST_CHECK_LE(std::abs(crop.y_ - y), 2);
+  BOOST_CHECK_LE(std::abs(crop.w_ - w), 4);
+  BOOST_CHECK_LE(std::abs(crop.h_ - h), 4);
+}
+
+
+BOOST_AUTO_TEST_CASE(yae_auto_crop)
+{
+  TVideoFramePtr letterbox = make_frame(1920, 1080, 0, 140, false);
+  TVideoFramePtr pillarbox = make_frame(1920, 1080, 240, 0, true);
+
+  const TAutoCropDetect::TKernels supported =
+    TAutoCropDetect::supportedKernels();
+
+  TCropFrame expected[2];
+  for (int k = TAutoCropDetect::kKernelsScalar; k <= supported; k++)
+  {
+    BOOST_CHECK(TAutoCropDetect::useKernels(TAutoCropDetect::TKernels(k)));
+
+    TCropFrame crop[2];
+    BOOST_CHECK(TAutoCropDetect::analyze(letterbox, crop[0]));
+    BOOST_CHECK(TAutoCropDetect::analyze(pillarbox, crop[1]));
+
+    check_crop(crop[0], 0, 140, 1920, 800);
+    check_crop(crop[1], 240, 0, 1440, 1080);
+
+    if (k == TAutoCropDetect::kKernelsScalar)
+    {
+      expected[0] = crop[0];
+      expected[1] = crop[1];
+      continue;
+    }
+
+    // every kernel set must produce exactly the same result:
+    for (int i = 0; i < 2; i++)
+    {
+      BOOST_CHECK_EQUAL(crop[i].x_, expected[i].x_);
+      BOOST_CHECK_EQUAL(crop[i].y_, expected[i].y_);
+      BOOST_CHECK_EQUAL(crop[i].w_, expected[i].w_);
+      BOOST_CHECK_EQUAL(crop[i].h_, expected[i].h_);
+    }
+  }
+
+  BOOST_CHECK(TAutoCropDetect::useKernels(supported));
+}
+
+BOOST_AUTO_TEST_CASE(yae_auto_crop_degenerate)
+{
+  // a frame too small to have borders is analyzed, nothing is cropped:
+  TVideoFramePtr column = make_frame(1, 64, 0, 0, false);
+  TVideoFramePtr row = make_frame(64, 1, 0, 0, false);
+
+  TCropFrame crop;
+  BOOST_CHECK(TAutoCropDetect::analyze(column, crop));
+  BOOST_CHECK_EQUAL(crop.x_, 0);
+  BOOST_CHECK_EQUAL(crop.y_, 0);
+  BOOST_CHECK_EQUAL(crop.w_, 1);
+  BOOST_CHECK_EQUAL(crop.h_, 64);
+
+  BOOST_CHECK(TAutoCropDetect::analyze(row, crop));
+  BOOST_CHECK_EQUAL(crop.x_, 0);
+  BOOST_CHECK_EQUAL(crop.y_, 0);
+  BOOST_CHECK_EQUAL(crop.w_, 64);
+  BOOST_CHECK_EQUAL(crop.h_, 1);
+}
+
+BOOST_AUTO_TEST_CASE(yae_auto_crop_kernels_agree)
+{
+  // odd sizes leave a scalar tail after the vector loops,
+  // dim pictures put the edges close to the black level:
+  static const unsigned int frames[][4] = {
+    // width, height, border_x, border_y
+    { 1920, 1080, 0, 140 },
+    { 1918, 1078, 3, 131 },
+    { 1279, 719, 161, 0 },
+    { 721, 481, 37, 59 },
+    { 33, 65, 5, 9 }
+  };
+
+  static const unsigned int lo[] = { 64, 17 };
+
+  const TAutoCropDetect::TKernels supported =
+    TAutoCropDetect::supportedKernels();
+
+  if (supported == TAutoCropDetect::kKernelsScalar)
+  {
+    BOOST_TEST_MESSAGE("no SIMD kernels on this CPU, nothing to compare");
+  }
+
+  for (std::size_t i = 0; i < sizeof(frames) / sizeof(frames[0]); i++)
+  {
+    for (int ten_bit = 0; ten_bit < 2; ten_bit++)
+    {
+      for (std::size_t j = 0; j < sizeof(lo) / sizeof(lo[0]); j++)
+      {
+        TVideoFramePtr frame = make_frame(frames[i][0],
+                                          frames[i][1],
+                                          frames[i][2],
+                                          frames[i][3],
+                                          ten_bit != 0,
+                                          lo[j]);
+
+        BOOST_REQUIRE(TAutoCropDetect::useKernels
+                      (TAutoCropDetect::kKernelsScalar));
+
+        TCropFrame expected;
+        BOOST_CHECK(TAutoCropDetect::analyze(frame, expected));
+
+        for (int k = TAutoCropDetect::kKernelsSSE2; k <= supported; k++)
+        {
+          BOOST_REQUIRE(TAutoCropDetect::useKernels
+                        (TAutoCropDetect::TKernels(k)));
+
+          TCropFrame crop;
+          BOOST_CHECK(TAutoCropDetect::analyze(frame, crop));
+
+          std::ostringstream oss;
+          oss << frames[i][0] << 'x' << frames[i][1]
+              << (ten_bit ? " 10-bit" : " 8-bit")
+              << ", picture from " << lo[j]
+              << ", kernels " << k << ": "
+              << crop.x_ << ' ' << crop.y_ << ' '
+              << crop.w_ << ' ' << crop.h_ << ", scalar: "
+              << expected.x_ << ' ' << expected.y_ << ' '
+              << expected.w_ << ' ' << expected.h_;
+
+          BOOST_CHECK_MESSAGE(crop.x_ == expected.x_ &&
+                              crop.y_ == expected.y_ &&
+                              crop.w_ == expected.w_ &&
+                              crop.h_ == expected.h_,
+                              oss.str());
+        }
+      }
+    }
+  }
+
+  BOOST_CHECK(TAutoCropDetect::useKernels(supported));
+}
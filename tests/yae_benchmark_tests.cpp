@@ -9,6 +9,7 @@
 // standard C++ library:
 #include <iostream>
 #include <sstream>
+#include <vector>
 
 // boost library:
 #include <boost/test/unit_test.hpp>
@@ -17,6 +18,9 @@
 // aeyae:
 #include "yae/utils/yae_benchmark.h"
 
+// shortcut:
+using namespace yae;
+
 
 //----------------------------------------------------------------
 // func_a
@@ -39,6 +43,26 @@ static void func_b()
   }
 }
 
+//----------------------------------------------------------------
+// probe_a
+//
+static void probe_a()
+{
+  YAE_PROBE(probe, "probe_a");
+  boost::this_thread::sleep_for(boost::chrono::microseconds(100));
+}
+
+//----------------------------------------------------------------
+// probe_b
+//
+static void probe_b()
+{
+  for (int i = 0; i < 10; i++)
+  {
+    probe_a();
+  }
+}
+
 //----------------------------------------------------------------
 // to_string
 //
@@ -121,3 +145,43 @@ BOOST_AUTO_TEST_CASE(yae_benchmark)
 #endif
   }
 }
+
+BOOST_AUTO_TEST_CASE(yae_probe)
+{
+  TProbe::enable(true);
+  TProbe::clear();
+
+  boost::thread t1(&probe_b);
+  boost::thread t2(&probe_b);
+  probe_b();
+  t1.join();
+  t2.join();
+
+  // measurements from threads that already exited are retained:
+  std::vector<TProbe::Stats> stats;
+  TProbe::snapshot(stats, true);
+
+  BOOST_CHECK_EQUAL(stats.size(), 1u);
+  if (stats.size() == 1)
+  {
+    const TProbe::Stats & s = stats.front();
+    BOOST_CHECK_EQUAL(s.name_, std::string("probe_a"));
+    BOOST_CHECK_EQUAL(s.n_, 30u);
+    BOOST_CHECK(s.min_ >= 100.0);
+    BOOST_CHECK(s.min_ <= s.p50_);
+    BOOST_CHECK(s.p50_ <= s.p90_);
+    BOOST_CHECK(s.p90_ <= s.p99_);
+    BOOST_CHECK(s.p99_ <= s.max_);
+    BOOST_CHECK(s.max_ <= s.total_);
+  }
+
+  // the snapshot above reset the counters:
+  TProbe::snapshot(stats);
+  BOOST_CHECK(stats.empty());
+
+  // disabled probes do not record anything:
+  TProbe::enable(false);
+  probe_a();
+  TProbe::snapshot(stats);
+  BOOST_CHECK(stats.empty());
+}
@@ -0,0 +1,810 @@
+// -*- Mode: c++; tab-width: 8; c-basic-offset: 2; indent-tabs-mode: nil -*-
+// NOTE: the first line of this file sets up source code indentation rules
+// for Emacs; it is also a hint to anyone modifying this file.
+
+// Created   : Fri Oct 16 18:12:37 MDT 2026
+// Copyright : Pavel Koshevoy
+// License   : MIT -- http://www.opensource.org/licenses/mit-license.php
+
+// standard:
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+// boost:
+#include <boost/atomic.hpp>
+#include <boost/chrono/chrono.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/thread.hpp>
+
+// ffmpeg:
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/pixdesc.h>
+}
+
+// aeyae:
+#include "yae/ffmpeg/yae_demuxer.h"
+#include "yae/ffmpeg/yae_ffmpeg_utils.h"
+#include "yae/ffmpeg/yae_movie.h"
+#include "yae/ffmpeg/yae_pixel_format_ffmpeg.h"
+#include "yae/thread/yae_threading.h"
+#include "yae/thread/yae_work_stealing_pool.h"
+#include "yae/utils/yae_benchmark.h"
+#include "yae/utils/yae_trace.h"
+
+// local:
+#include "yae_test_media.h"
+
+// shortcut:
+using namespace yae;
+
+
+//----------------------------------------------------------------
+// usage
+//
+static int
+usage(const char * message = NULL)
+{
+  std::cerr
+    << "\nUSAGE:\n"
+    << "  aeyae-decode-bench [options] -i input [-i input ...]\n"
+    << "  aeyae-decode-bench --generate output.mkv [generator options]\n"
+    << "\nOPTIONS:\n"
+    << "  --threads N        decoder threads per codec, 0 means one per core\n"
+    << "  --pool N           decode on a private work-stealing pool "
+    << "of N workers\n"
+    << "  --shared-pool      decode on the shared work-stealing pool\n"
+    << "                     instead of a thread per track\n"
+    << "  --pixel-format F   override output pixel format (ffmpeg name)\n"
+    << "  --no-video         do not decode video\n"
+    << "  --no-audio         do not decode audio\n"
+    << "  --trace file.json  save a Chrome trace of the run\n"
+    << "  --seek N           instead of decoding, measure the latency of N\n"
+    << "                     random seeks with and without the keyframe\n"
+    << "                     index, inputs are played back-to-back\n"
+    << "\nGENERATOR OPTIONS:\n"
+    << "  --size WxH         frame size, default 1280x720\n"
+    << "  --frames N         number of video frames, default 750\n"
+    << "  --gop N            keyframe interval, default 25, use a long GOP\n"
+    << "                     to see what seeking without an index costs\n"
+    << "\nGenerated media (MPEG-4 video at 25 fps + PCM stereo audio)\n"
+    << "needs nothing but the built-in ffmpeg encoders, so the benchmark\n"
+    << "can run offline.\n"
+    << std::endl;
+
+  if (message)
+  {
+    std::cerr << "ERROR: " << message << std::endl;
+  }
+
+  return 1;
+}
+
+
+//----------------------------------------------------------------
+// VideoSink
+//
+// pulls decoded frames as fast as the decoder can make them:
+//
+struct VideoSink
+{
+  VideoSink(const VideoTrackPtr & track):
+    track_(track),
+    frames_(0),
+    thread_(this)
+  {}
+
+  void threadLoop()
+  {
+    TTrace::set_thread_name("VideoSink");
+
+    while (true)
+    {
+      TVideoFramePtr frame;
+      if (!track_->getNextFrame(frame, &terminator_))
+      {
+        break;
+      }
+
+      if (frame)
+      {
+        frames_++;
+      }
+    }
+  }
+
+  VideoTrackPtr track_;
+  QueueWaitMgr terminator_;
+  boost::atomic<uint64_t> frames_;
+  Thread<VideoSink> thread_;
+};
+
+//----------------------------------------------------------------
+// AudioSink
+//
+struct AudioSink
+{
+  AudioSink(const AudioTrackPtr & track):
+    track_(track),
+    frames_(0),
+    samples_(0),
+    thread_(this)
+  {}
+
+  void threadLoop()
+  {
+    TTrace::set_thread_name("AudioSink");
+
+    while (true)
+    {
+      TAudioFramePtr frame;
+      if (!track_->getNextFrame(frame, &terminator_))
+      {
+        break;
+      }
+
+      if (frame)
+      {
+        frames_++;
+        samples_ += frame->numSamples();
+      }
+    }
+  }
+
+  AudioTrackPtr track_;
+  QueueWaitMgr terminator_;
+  boost::atomic<uint64_t> frames_;
+  boost::atomic<uint64_t> samples_;
+  Thread<AudioSink> thread_;
+};
+
+
+//----------------------------------------------------------------
+// Options
+//
+struct Options
+{
+  Options():
+    pool_(-1),
+    pixelFormat_(AV_PIX_FMT_NONE),
+    video_(true),
+    audio_(true)
+  {}
+
+  int pool_;
+  enum AVPixelFormat pixelFormat_;
+  bool video_;
+  bool audio_;
+};
+
+//----------------------------------------------------------------
+// show_rusage
+//
+static void
+show_rusage(std::ostream & os, double elapsed)
+{
+#ifndef _WIN32
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+  {
+    return;
+  }
+
+#ifdef __APPLE__
+  // bytes:
+  double peak_rss_mb = double(usage.ru_maxrss) / double(1 << 20);
+#else
+  // kilobytes:
+  double peak_rss_mb = double(usage.ru_maxrss) / double(1 << 10);
+#endif
+
+  double cpu =
+    double(usage.ru_utime.tv_sec) + 1e-6 * double(usage.ru_utime.tv_usec) +
+    double(usage.ru_stime.tv_sec) + 1e-6 * double(usage.ru_stime.tv_usec);
+
+  os << "  peak RSS:     " << peak_rss_mb << " MB\n"
+     << "  CPU time:     " << cpu << " sec ("
+     << (elapsed > 0.0 ? 100.0 * cpu / elapsed : 0.0) << "% of wall)\n";
+#endif
+}
+
+//----------------------------------------------------------------
+// show_probes
+//
+static void
+show_probes(std::ostream & os)
+{
+  std::vector<TProbe::Stats> stats;
+  TProbe::snapshot(stats, true);
+
+  os << "  per-stage latency, usec:\n"
+     << "    " << std::left << std::setw(28) << "stage" << std::right
+     << std::setw(10) << "calls"
+     << std::setw(10) << "mean"
+     << std::setw(10) << "p50"
+     << std::setw(10) << "p90"
+     << std::setw(10) << "p99"
+     << std::setw(10) << "max" << '\n';
+
+  for (std::size_t i = 0; i < stats.size(); i++)
+  {
+    const TProbe::Stats & s = stats[i];
+    os << "    " << std::left << std::setw(28) << s.name_ << std::right
+       << std::setw(10) << s.n_
+       << std::setw(10) << (s.n_ ? s.total_ / double(s.n_) : 0.0)
+       << std::setw(10) << s.p50_
+       << std::setw(10) << s.p90_
+       << std::setw(10) << s.p99_
+       << std::setw(10) << s.max_ << '\n';
+  }
+}
+
+//----------------------------------------------------------------
+// count_calls
+//
+static uint64
+count_calls(const std::vector<TProbe::Stats> & stats, const char * name)
+{
+  for (std::size_t i = 0; i < stats.size(); i++)
+  {
+    if (stats[i].name_ == name)
+    {
+      return stats[i].n_;
+    }
+  }
+
+  return 0;
+}
+
+//----------------------------------------------------------------
+// bench
+//
+static bool
+bench(const std::string & path, const Options & options)
+{
+  Movie movie;
+  if (!movie.open(path.c_str()))
+  {
+    std::cerr << "ERROR: failed to open " << path << std::endl;
+    return false;
+  }
+
+  movie.setPlaybackEnabled(true);
+
+  VideoTrackPtr video;
+  if (options.video_ && movie.selectVideoTrack(0))
+  {
+    video = movie.getVideoTracks().front();
+
+    if (options.pixelFormat_ != AV_PIX_FMT_NONE)
+    {
+      VideoTraits traits;
+      video->getTraits(traits);
+      traits.pixelFormat_ = ffmpeg_to_yae(options.pixelFormat_);
+      video->setTraitsOverride(traits);
+    }
+  }
+  else
+  {
+    movie.selectVideoTrack(movie.getVideoTracks().size());
+  }
+
+  AudioTrackPtr audio;
+  if (options.audio_ && movie.selectAudioTrack(0))
+  {
+    audio = movie.getAudioTracks().front();
+  }
+  else
+  {
+    movie.selectAudioTrack(movie.getAudioTracks().size());
+  }
+
+  if (!video && !audio)
+  {
+    std::cerr << "ERROR: nothing to decode in " << path << std::endl;
+    return false;
+  }
+
+  boost::shared_ptr<WorkStealingPool> pool;
+  if (options.pool_ >= 0)
+  {
+    pool.reset(new WorkStealingPool(options.pool_));
+
+    if (video)
+    {
+      video->setWorkerPool(pool.get());
+    }
+
+    if (audio)
+    {
+      audio->setWorkerPool(pool.get());
+    }
+  }
+
+  boost::shared_ptr<VideoSink> vsink(video ? new VideoSink(video) : NULL);
+  boost::shared_ptr<AudioSink> asink(audio ? new AudioSink(audio) : NULL);
+
+  // discard anything recorded while opening the file:
+  std::vector<TProbe::Stats> stats;
+  TProbe::snapshot(stats, true);
+
+  boost::chrono::steady_clock::time_point
+    t0 = boost::chrono::steady_clock::now();
+
+  if (vsink)
+  {
+    vsink->thread_.run();
+  }
+
+  if (asink)
+  {
+    asink->thread_.run();
+  }
+
+  movie.threadStart();
+
+  // the demuxer thread exits once every frame has been consumed:
+  while (!movie.threadWaitFor(100))
+  {}
+
+  boost::chrono::steady_clock::time_point
+    t1 = boost::chrono::steady_clock::now();
+
+  if (vsink)
+  {
+    vsink->terminator_.stopWaiting(true);
+    video->frameQueue_.close();
+  }
+
+  if (asink)
+  {
+    asink->terminator_.stopWaiting(true);
+    audio->frameQueue_.close();
+  }
+
+  movie.threadStop();
+
+  if (vsink)
+  {
+    vsink->thread_.wait();
+  }
+
+  if (asink)
+  {
+    asink->thread_.wait();
+  }
+
+  double elapsed =
+    boost::chrono::duration<double>(t1 - t0).count();
+
+  TProbe::snapshot(stats, false);
+  uint64 packets = count_calls(stats, "Movie::demux");
+  uint64 bytes = boost::filesystem::file_size(path);
+
+  std::ostringstream oss;
+  oss << std::fixed << std::setprecision(1)
+      << path << ":\n"
+      << "  wall time:    " << elapsed << " sec\n";
+
+  if (vsink)
+  {
+    uint64_t frames = vsink->frames_.load();
+    VideoTraits traits;
+    video->getTraitsOverride(traits);
+
+    oss << "  video:        " << frames << " frames, "
+        << (elapsed > 0.0 ? double(frames) / elapsed : 0.0)
+        << " frames/sec, output "
+        << (traits.pixelFormat_ != kInvalidPixelFormat ?
+            av_get_pix_fmt_name(yae_to_ffmpeg(traits.pixelFormat_)) :
+            "unknown") << '\n';
+
+    VideoTrack::FrameStats fs = video->frameStats();
+    oss << "  video filter: " << fs.passedThrough_ << " passed through, "
+        << fs.filtered_ << " filtered, "
+        << 100.0 * fs.passThroughRate() << "% pass-through\n";
+    oss << "  gop cache:    " << fs.replayed_ << " frames replayed\n";
+  }
+
+  if (asink)
+  {
+    uint64_t frames = asink->frames_.load();
+    uint64_t samples = asink->samples_.load();
+
+    oss << "  audio:        " << frames << " frames, "
+        << (elapsed > 0.0 ? double(frames) / elapsed : 0.0)
+        << " frames/sec, "
+        << (elapsed > 0.0 ? double(samples) / elapsed : 0.0)
+        << " samples/sec\n";
+  }
+
+  oss << "  demuxer:      " << packets << " packets, "
+      << (elapsed > 0.0 ? double(packets) / elapsed : 0.0)
+      << " packets/sec, "
+      << (elapsed > 0.0 ? double(bytes) / (elapsed * 1048576.0) : 0.0)
+      << " MB/sec\n";
+
+  show_probes(oss);
+  show_rusage(oss, elapsed);
+
+  if (pool)
+  {
+    WorkStealingPool::Stats ps = pool->stats();
+    oss << "  pool:         " << pool->num_workers() << " workers, "
+        << ps.executed_ << " tasks, " << ps.stolen_ << " stolen\n";
+  }
+
+  std::cout << oss.str() << std::endl;
+
+  movie.close();
+  return true;
+}
+
+
+//----------------------------------------------------------------
+// SeekStats
+//
+struct SeekStats
+{
+  SeekStats():
+    seeks_(0),
+    missed_(0),
+    packets_(0),
+    total_(0.0),
+    max_(0.0)
+  {}
+
+  void add(double sec)
+  {
+    seeks_++;
+    total_ += sec;
+    max_ = std::max(max_, sec);
+  }
+
+  uint64 seeks_;
+
+  // seeks that failed or never reached the target sample:
+  uint64 missed_;
+
+  // packets of the sought track that were demuxed before
+  // reaching the target sample, a decoder would have to
+  // decode and discard all of them:
+  uint64 packets_;
+
+  // seek latency, in seconds:
+  double total_;
+  double max_;
+};
+
+//----------------------------------------------------------------
+// seek_to
+//
+// seek the way a player would and demux until the packet spanning
+// the target DTS comes out, that is the point where the decoder
+// could start producing the requested frame:
+//
+static void
+seek_to(DemuxerInterface & demuxer,
+        const std::string & track_id,
+        const TTime & target,
+        SeekStats & stats)
+{
+  boost::chrono::steady_clock::time_point
+    t0 = boost::chrono::steady_clock::now();
+
+  bool found = false;
+  uint64 packets = 0;
+
+  if (demuxer.seek(0, target, track_id) >= 0)
+  {
+    while (!found)
+    {
+      AVStream * src = NULL;
+      TPacketPtr packet_ptr = demuxer.get(src);
+      if (!packet_ptr)
+      {
+        break;
+      }
+
+      const AvPkt & pkt = *packet_ptr;
+      if (pkt.trackId_ != track_id)
+      {
+        continue;
+      }
+
+      const AVPacket & packet = pkt.get();
+      TTime dts;
+      if (get_dts(dts, src, packet))
+      {
+        TTime dur(packet.duration * src->time_base.num, src->time_base.den);
+        found = (target < dts + dur || target <= dts);
+      }
+
+      if (!found)
+      {
+        packets++;
+      }
+    }
+  }
+
+  boost::chrono::steady_clock::time_point
+    t1 = boost::chrono::steady_clock::now();
+
+  stats.add(boost::chrono::duration<double>(t1 - t0).count());
+  stats.packets_ += packets;
+
+  if (!found)
+  {
+    stats.missed_++;
+  }
+}
+
+//----------------------------------------------------------------
+// bench_seek
+//
+// compare random access latency with and without the keyframe index,
+// the inputs are played back-to-back via a SerialDemuxer:
+//
+static bool
+bench_seek(const std::vector<std::string> & inputs, int num_seeks)
+{
+  typedef yae::shared_ptr<DemuxerBuffer, DemuxerInterface> TBufferPtr;
+  std::vector<TBufferPtr> buffers;
+
+  TSerialDemuxerPtr serial(new SerialDemuxer());
+  for (std::size_t i = 0; i < inputs.size(); i++)
+  {
+    TDemuxerPtr demuxer = open_demuxer(inputs[i].c_str());
+    if (!demuxer)
+    {
+      std::cerr << "ERROR: failed to open " << inputs[i] << std::endl;
+      return false;
+    }
+
+    TBufferPtr buffer(new DemuxerBuffer(demuxer, 1.0));
+    buffer->update_summary();
+    serial->append(buffer);
+    buffers.push_back(buffer);
+  }
+
+  const DemuxerSummary & summary = serial->update_summary();
+
+  // seek by the first video track:
+  std::string track_id;
+  for (std::map<std::string, const AVStream *>::const_iterator
+         i = summary.streams_.begin(); i != summary.streams_.end(); ++i)
+  {
+    const AVStream * stream = i->second;
+    if (stream && stream->codecpar->codec_type == AVMEDIA_TYPE_VIDEO)
+    {
+      track_id = i->first;
+      break;
+    }
+  }
+
+  if (track_id.empty())
+  {
+    std::cerr << "ERROR: nothing to seek by, no video" << std::endl;
+    return false;
+  }
+
+  const Timeline::Track & tt = summary.get_track_timeline(track_id);
+  const std::size_t num_samples = tt.dts_.size();
+  if (!num_samples)
+  {
+    std::cerr << "ERROR: " << track_id << " has no samples" << std::endl;
+    return false;
+  }
+
+  // the same pseudo-random targets for both passes:
+  std::vector<TTime> targets(num_seeks);
+  unsigned int seed = 1;
+  for (int i = 0; i < num_seeks; i++)
+  {
+    seed = seed * 1103515245 + 12345;
+    targets[i] = tt.get_dts((seed >> 8) % num_samples);
+  }
+
+  double gop = double(num_samples) / double(std::max<std::size_t>
+                                            (1, tt.keyframes_.size()));
+
+  std::ostringstream oss;
+  oss << std::fixed << std::setprecision(1)
+      << "seeking " << track_id << ", "
+      << num_samples << " samples, "
+      << tt.keyframes_.size() << " keyframes, "
+      << gop << " samples per GOP on average:\n";
+
+  static const char * labels[] = { "no index:", "keyframe index:" };
+  for (int pass = 0; pass < 2; pass++)
+  {
+    for (std::size_t i = 0; i < buffers.size(); i++)
+    {
+      buffers[i]->set_keyframe_seek(pass == 1);
+    }
+
+    SeekStats stats;
+    for (int i = 0; i < num_seeks; i++)
+    {
+      seek_to(*serial, track_id, targets[i], stats);
+    }
+
+    double n = double(std::max<uint64>(1, stats.seeks_));
+    oss << "  " << std::left << std::setw(16) << labels[pass] << std::right
+        << std::setprecision(3)
+        << 1e3 * stats.total_ / n << " msec mean, "
+        << 1e3 * stats.max_ << " msec max, "
+        << std::setprecision(1)
+        << double(stats.packets_) / n << " packets to discard per seek";
+
+    if (stats.missed_)
+    {
+      oss << ", " << stats.missed_ << " missed";
+    }
+
+    oss << '\n';
+  }
+
+  std::cout << oss.str() << std::endl;
+  return true;
+}
+
+
+//----------------------------------------------------------------
+// main
+//
+int
+main(int argc, char ** argv)
+{
+  ensure_ffmpeg_initialized();
+  av_log_set_level(AV_LOG_ERROR);
+
+  std::vector<std::string> inputs;
+  std::string generate_path;
+  std::string trace_path;
+  Options options;
+  int w = 1280;
+  int h = 720;
+  int num_frames = 750;
+  int gop_size = 25;
+  int num_seeks = 0;
+
+  for (int i = 1; i < argc; i++)
+  {
+    std::string arg(argv[i]);
+    bool has_value = (i + 1 < argc);
+
+    if (arg == "-h" || arg == "--help")
+    {
+      usage();
+      return 0;
+    }
+    else if (arg == "-i" && has_value)
+    {
+      inputs.push_back(argv[++i]);
+    }
+    else if (arg == "--generate" && has_value)
+    {
+      generate_path = argv[++i];
+    }
+    else if (arg == "--size" && has_value)
+    {
+      if (sscanf(argv[++i], "%dx%d", &w, &h) != 2 || w < 16 || h < 16)
+      {
+        return usage("invalid --size");
+      }
+    }
+    else if (arg == "--frames" && has_value)
+    {
+      num_frames = atoi(argv[++i]);
+    }
+    else if (arg == "--gop" && has_value)
+    {
+      gop_size = std::max(1, atoi(argv[++i]));
+    }
+    else if (arg == "--seek" && has_value)
+    {
+      num_seeks = std::max(1, atoi(argv[++i]));
+    }
+    else if (arg == "--threads" && has_value)
+    {
+      set_decoder_threads((unsigned int)(atoi(argv[++i])));
+    }
+    else if (arg == "--pool" && has_value)
+    {
+      options.pool_ = std::max(0, atoi(argv[++i]));
+    }
+    else if (arg == "--shared-pool")
+    {
+      set_decoder_pool_enabled(true);
+    }
+    else if (arg == "--pixel-format" && has_value)
+    {
+      options.pixelFormat_ = av_get_pix_fmt(argv[++i]);
+      if (options.pixelFormat_ == AV_PIX_FMT_NONE ||
+          ffmpeg_to_yae(options.pixelFormat_) == kInvalidPixelFormat)
+      {
+        return usage("unsupported --pixel-format");
+      }
+    }
+    else if (arg == "--no-video")
+    {
+      options.video_ = false;
+    }
+    else if (arg == "--no-audio")
+    {
+      options.audio_ = false;
+    }
+    else if (arg == "--trace" && has_value)
+    {
+      trace_path = argv[++i];
+    }
+    else
+    {
+      return usage(("unexpected parameter: " + arg).c_str());
+    }
+  }
+
+  if (!generate_path.empty())
+  {
+    w &= ~1;
+    h &= ~1;
+    if (!generate_test_clip(generate_path,
+                            w, h, std::max(1, num_frames), gop_size))
+    {
+      std::cerr << "ERROR: failed to generate " << generate_path << std::endl;
+      return 1;
+    }
+
+    if (inputs.empty())
+    {
+      return 0;
+    }
+  }
+
+  if (inputs.empty())
+  {
+    return usage("no input files");
+  }
+
+  if (num_seeks)
+  {
+    return bench_seek(inputs, num_seeks) ? 0 : 1;
+  }
+
+  TProbe::enable(true);
+
+  if (!trace_path.empty())
+  {
+    TTrace::enable(true);
+  }
+
+  std::cout << "decoder threads: " << get_decoder_threads() << "\n"
+            << std::endl;
+
+  bool ok = true;
+  for (std::size_t i = 0; i < inputs.size(); i++)
+  {
+    ok = bench(inputs[i], options) && ok;
+  }
+
+  if (!trace_path.empty() && !TTrace::save(trace_path.c_str()))
+  {
+    std::cerr << "ERROR: failed to save " << trace_path << std::endl;
+    ok = false;
+  }
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,255 @@
+// -*- Mode: c++; tab-width: 8; c-basic-offset: 2; indent-tabs-mode: nil -*-
+// NOTE: the first line of this file sets up source code indentation rules
+// for Emacs; it is also a hint to anyone modifying this file.
+
+// Created   : Sat Oct 24 10:17:36 MDT 2026
+// Copyright : Pavel Koshevoy
+// License   : MIT -- http://www.opensource.org/licenses/mit-license.php
+
+// standard:
+#include <cstdio>
+#include <ctime>
+#include <string>
+
+// boost library:
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+// aeyae:
+#include "yae/ffmpeg/yae_demuxer.h"
+#include "yae/utils/yae_utils.h"
+
+// shortcut:
+using namespace yae;
+namespace fs = boost::filesystem;
+
+
+//----------------------------------------------------------------
+// TempFolder
+//
+// everything the index tests write goes here, never into $HOME:
+//
+struct TempFolder
+{
+  TempFolder():
+    path_(fs::temp_directory_path() /
+          fs::unique_path("yae-index-test-%%%%-%%%%-%%%%"))
+  {
+    fs::create_directories(path_);
+  }
+
+  ~TempFolder()
+  {
+    boost::system::error_code ec;
+    fs::remove_all(path_, ec);
+  }
+
+  std::string str(const char * name) const
+  { return (path_ / name).string(); }
+
+  fs::path path_;
+};
+
+//----------------------------------------------------------------
+// write_bytes
+//
+// the index does not parse the media, any content will do:
+//
+static void
+write_bytes(const std::string & path,
+            const char * mode,
+            std::size_t size,
+            unsigned char seed)
+{
+  std::string data(size, '\0');
+  for (std::size_t i = 0; i < size; i++)
+  {
+    data[i] = char((i * 131 + seed) & 0xFF);
+  }
+
+  FILE * file = fopenUtf8(path.c_str(), mode);
+  BOOST_REQUIRE(file);
+  BOOST_REQUIRE(yae::write(file, data));
+  fclose(file);
+}
+
+//----------------------------------------------------------------
+// patch_byte
+//
+// overwrite one byte in place, keeping the file size and mtime:
+//
+static void
+patch_byte(const std::string & path, long offset)
+{
+  std::time_t mtime = fs::last_write_time(path);
+
+  FILE * file = fopenUtf8(path.c_str(), "r+b");
+  BOOST_REQUIRE(file);
+  BOOST_REQUIRE_EQUAL(fseek(file, offset, SEEK_SET), 0);
+  int c = fgetc(file);
+  BOOST_REQUIRE_EQUAL(fseek(file, offset, SEEK_SET), 0);
+  fputc((c + 1) & 0xFF, file);
+  fclose(file);
+
+  fs::last_write_time(path, mtime);
+}
+
+//----------------------------------------------------------------
+// make_summary
+//
+static void
+make_summary(DemuxerSummary & summary, int num_packets)
+{
+  Timeline & timeline = summary.timeline_[0];
+  FramerateEstimator & fps = summary.fps_["v:000"];
+
+  for (int i = 0; i < num_packets; i++)
+  {
+    TTime dts(i * 1001, 30000);
+    TTime dur(1001, 30000);
+    bool keyframe = (i % 30) == 0;
+
+    timeline.add_packet("v:000", keyframe, 1000, dts, dts, dur, 0.1,
+                        i * 1000);
+    fps.push(dts);
+  }
+}
+
+//----------------------------------------------------------------
+// same_summary
+//
+static void
+same_summary(const DemuxerSummary & a, const DemuxerSummary & b)
+{
+  BOOST_REQUIRE_EQUAL(a.timeline_.size(), b.timeline_.size());
+  BOOST_CHECK_EQUAL(toText(a.timeline_.find(0)->second),
+                    toText(b.timeline_.find(0)->second));
+
+  BOOST_REQUIRE_EQUAL(a.fps_.size(), b.fps_.size());
+  BOOST_CHECK_EQUAL(toText(a.fps_.find("v:000")->second),
+                    toText(b.fps_.find("v:000")->second));
+}
+
+
+BOOST_AUTO_TEST_CASE(yae_demuxer_index_disabled)
+{
+  TempFolder tmp;
+  std::string src = tmp.str("src.bin");
+  write_bytes(src, "wb", 100000, 1);
+
+  // no folder, no index:
+  DemuxerIndex index(src, 0, 0.1, std::string());
+  BOOST_CHECK(index.cache_path().empty());
+
+  DemuxerSummary summary;
+  make_summary(summary, 10);
+  BOOST_CHECK(!index.save(summary));
+
+  DemuxerSummary loaded;
+  BOOST_CHECK_EQUAL(index.load(loaded), DemuxerIndex::kNoMatch);
+}
+
+BOOST_AUTO_TEST_CASE(yae_demuxer_index_round_trip)
+{
+  TempFolder tmp;
+  std::string src = tmp.str("src.bin");
+  std::string folder = tmp.str("index");
+  write_bytes(src, "wb", 100000, 1);
+
+  DemuxerSummary summary;
+  make_summary(summary, 90);
+  {
+    DemuxerIndex index(src, 0, 0.1, folder);
+    BOOST_CHECK(!index.cache_path().empty());
+    BOOST_CHECK(fs::path(index.cache_path()).parent_path() ==
+                fs::path(folder));
+    BOOST_CHECK(index.save(summary));
+  }
+
+  DemuxerIndex index(src, 0, 0.1, folder);
+  DemuxerSummary loaded;
+  BOOST_CHECK_EQUAL(index.load(loaded), DemuxerIndex::kExactMatch);
+  same_summary(loaded, summary);
+
+  // the key includes the track offset and tolerance:
+  DemuxerSummary other;
+  BOOST_CHECK_EQUAL(DemuxerIndex(src, 1, 0.1, folder).load(other),
+                    DemuxerIndex::kNoMatch);
+  BOOST_CHECK_EQUAL(DemuxerIndex(src, 0, 0.2, folder).load(other),
+                    DemuxerIndex::kNoMatch);
+}
+
+BOOST_AUTO_TEST_CASE(yae_demuxer_index_key_mismatch)
+{
+  TempFolder tmp;
+  std::string src = tmp.str("src.bin");
+  std::string folder = tmp.str("index");
+
+  DemuxerSummary summary;
+  make_summary(summary, 90);
+
+  // modified in place, same size but a different mtime:
+  {
+    write_bytes(src, "wb", 100000, 1);
+    BOOST_CHECK(DemuxerIndex(src, 0, 0.1, folder).save(summary));
+
+    std::time_t mtime = fs::last_write_time(src);
+    fs::last_write_time(src, mtime + 10);
+
+    DemuxerSummary loaded;
+    BOOST_CHECK_EQUAL(DemuxerIndex(src, 0, 0.1, folder).load(loaded),
+                      DemuxerIndex::kNoMatch);
+    BOOST_CHECK(loaded.timeline_.empty());
+  }
+
+  // shrunk:
+  {
+    write_bytes(src, "wb", 100000, 1);
+    BOOST_CHECK(DemuxerIndex(src, 0, 0.1, folder).save(summary));
+    write_bytes(src, "wb", 50000, 1);
+
+    DemuxerSummary loaded;
+    BOOST_CHECK_EQUAL(DemuxerIndex(src, 0, 0.1, folder).load(loaded),
+                      DemuxerIndex::kNoMatch);
+  }
+
+  // head content changed, same size and mtime:
+  {
+    write_bytes(src, "wb", 100000, 1);
+    BOOST_CHECK(DemuxerIndex(src, 0, 0.1, folder).save(summary));
+    patch_byte(src, 100);
+
+    DemuxerSummary loaded;
+    BOOST_CHECK_EQUAL(DemuxerIndex(src, 0, 0.1, folder).load(loaded),
+                      DemuxerIndex::kNoMatch);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(yae_demuxer_index_prefix_resume)
+{
+  TempFolder tmp;
+  std::string src = tmp.str("src.bin");
+  std::string folder = tmp.str("index");
+  write_bytes(src, "wb", 100000, 1);
+
+  DemuxerSummary summary;
+  make_summary(summary, 90);
+  BOOST_CHECK(DemuxerIndex(src, 0, 0.1, folder).save(summary));
+
+  // the file grows, as a recording in progress would:
+  write_bytes(src, "ab", 20000, 2);
+  {
+    DemuxerSummary loaded;
+    BOOST_CHECK_EQUAL(DemuxerIndex(src, 0, 0.1, folder).load(loaded),
+                      DemuxerIndex::kPrefixMatch);
+    same_summary(loaded, summary);
+  }
+
+  // the tail of the indexed region changed, it's not the same file:
+  patch_byte(src, 100000 - 10);
+  {
+    DemuxerSummary loaded;
+    BOOST_CHECK_EQUAL(DemuxerIndex(src, 0, 0.1, folder).load(loaded),
+                      DemuxerIndex::kNoMatch);
+  }
+}
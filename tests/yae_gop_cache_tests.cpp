@@ -0,0 +1,158 @@
+// -*- Mode: c++; tab-width: 8; c-basic-offset: 2; indent-tabs-mode: nil -*-
+// NOTE: the first line of this file sets up source code indentation rules
+// for Emacs; it is also a hint to anyone modifying this file.
+
+// Created   : Fri Oct 16 21:40:12 MDT 2026
+// Copyright : Pavel Koshevoy
+// License   : MIT -- http://www.opensource.org/licenses/mit-license.php
+
+// standard:
+#include <string>
+#include <vector>
+
+// boost library:
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+// ffmpeg:
+extern "C"
+{
+#include <libavutil/log.h>
+}
+
+// aeyae:
+#include "yae/ffmpeg/yae_ffmpeg_utils.h"
+#include "yae/ffmpeg/yae_movie.h"
+
+// local:
+#include "yae_test_media.h"
+
+// shortcut:
+using namespace yae;
+namespace fs = boost::filesystem;
+
+
+//----------------------------------------------------------------
+// TempClip
+//
+struct TempClip
+{
+  TempClip():
+    path_((fs::temp_directory_path() /
+           fs::unique_path("yae-gop-cache-test-%%%%-%%%%.mkv")).string())
+  {}
+
+  ~TempClip()
+  {
+    boost::system::error_code ec;
+    fs::remove(path_, ec);
+  }
+
+  std::string path_;
+};
+
+//----------------------------------------------------------------
+// pull_frames
+//
+// skip ahead to the start of the next sequence (a seek), then
+// collect the timestamps of the frames that follow it, until
+// a frame at or past t1 comes along:
+//
+static bool
+pull_frames(VideoTrack & track, double t1, std::vector<TTime> & times)
+{
+  bool started = false;
+  times.clear();
+
+  while (true)
+  {
+    TVideoFramePtr frame;
+    if (!track.getNextFrame(frame, NULL))
+    {
+      return false;
+    }
+
+    if (!frame)
+    {
+      continue;
+    }
+
+    if (resetTimeCountersIndicated(frame.get()))
+    {
+      started = true;
+      times.clear();
+      continue;
+    }
+
+    if (!started)
+    {
+      continue;
+    }
+
+    if (frame->time_.sec() >= t1)
+    {
+      return true;
+    }
+
+    times.push_back(frame->time_);
+  }
+}
+
+
+BOOST_AUTO_TEST_CASE(yae_gop_cache_backward_seek)
+{
+  ensure_ffmpeg_initialized();
+  av_log_set_level(AV_LOG_ERROR);
+
+  // 4 sec at 25 fps, a keyframe every second:
+  TempClip clip;
+  BOOST_REQUIRE(generate_test_clip(clip.path_, 160, 120, 100, 25));
+
+  Movie movie;
+  BOOST_REQUIRE(movie.open(clip.path_.c_str()));
+  movie.setPlaybackEnabled(true);
+
+  BOOST_REQUIRE(movie.selectVideoTrack(0));
+  movie.selectAudioTrack(movie.getAudioTracks().size());
+  VideoTrackPtr video = movie.getVideoTracks().front();
+
+  // the GOPs that follow a seek are cached:
+  BOOST_REQUIRE(movie.requestSeekTime(1.0));
+  BOOST_REQUIRE(movie.threadStart());
+
+  // once a frame of the next GOP is out the [1, 2) GOP is complete:
+  std::vector<TTime> decoded;
+  BOOST_REQUIRE(pull_frames(*video, 2.5, decoded));
+  BOOST_CHECK_EQUAL(video->frameStats().replayed_, uint64(0));
+
+  std::vector<TTime> expected;
+  for (std::size_t i = 0; i < decoded.size() && decoded[i].sec() < 2.0; i++)
+  {
+    expected.push_back(decoded[i]);
+  }
+  BOOST_REQUIRE_EQUAL(expected.size(), std::size_t(25));
+
+  // seek back, the same frames should come out of the cache:
+  BOOST_REQUIRE(movie.requestSeekTime(1.0));
+
+  std::vector<TTime> replayed;
+  BOOST_REQUIRE(pull_frames(*video, 2.0, replayed));
+  BOOST_CHECK_GE(video->frameStats().replayed_, uint64(expected.size()));
+
+  BOOST_REQUIRE_EQUAL(replayed.size(), expected.size());
+  for (std::size_t i = 0; i < expected.size(); i++)
+  {
+    BOOST_CHECK_EQUAL(replayed[i].to_hhmmss_ms(),
+                      expected[i].to_hhmmss_ms());
+
+    if (i)
+    {
+      BOOST_CHECK(replayed[i - 1] < replayed[i]);
+    }
+  }
+
+  // the decoder blocks on a full queue, nobody is pulling now:
+  video->frameQueue_.close();
+  movie.threadStop();
+  movie.close();
+}
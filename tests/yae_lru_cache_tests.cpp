@@ -8,10 +8,15 @@
 
 
 // standard:
+#include <list>
 #include <map>
+#include <string>
 
 // boost library:
+#include <boost/atomic.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/test/unit_test.hpp>
+#include <boost/thread.hpp>
 
 // aeyae:
 #include "yae/utils/yae_lru_cache.h"
@@ -130,3 +135,237 @@ BOOST_AUTO_TEST_CASE(yae_lru_cache)
   // verify that 200 was instantiated only once:
   BOOST_CHECK_EQUAL(factory_call_count[200], 1);
 }
+
+
+//----------------------------------------------------------------
+// sharded_factory
+//
+static bool
+sharded_factory(void * context, const int & key, unsigned int & value)
+{
+  if (context)
+  {
+    boost::atomic<int> * calls = (boost::atomic<int> *)context;
+    calls->fetch_add(1);
+  }
+
+  value = ((unsigned int)key) << 8;
+  return true;
+}
+
+//----------------------------------------------------------------
+// value_cost
+//
+static std::size_t
+value_cost(const std::string & value)
+{
+  return value.size();
+}
+
+BOOST_AUTO_TEST_CASE(yae_sharded_lru_cache)
+{
+  typedef ShardedLRUCache<int, unsigned int> TCache;
+
+  // a single shard makes the eviction order predictable:
+  boost::atomic<int> calls(0);
+  TCache cache(4, 1);
+  BOOST_CHECK_EQUAL(cache.num_shards(), 1u);
+
+  for (int i = 0; i < 4; i++)
+  {
+    TCache::TRefPtr ref = cache.get(i, &sharded_factory, &calls);
+    BOOST_CHECK_EQUAL(ref->value(), ((unsigned int)i) << 8);
+  }
+  BOOST_CHECK_EQUAL(calls.load(), 4);
+
+  // touch 0, so that 1 becomes the least recently used:
+  cache.get(0, &sharded_factory, &calls);
+  cache.get(4, &sharded_factory, &calls);
+  BOOST_CHECK_EQUAL(calls.load(), 5);
+
+  // 1 was evicted, 0 was not:
+  BOOST_CHECK(!cache.get(1));
+  BOOST_CHECK(cache.get(0));
+
+  TCache::Stats stats = cache.stats();
+  BOOST_CHECK_EQUAL(stats.entries_, 4u);
+  BOOST_CHECK_EQUAL(stats.evicted_, 1u);
+
+  // referenced values are never evicted, the shard over-commits instead:
+  std::list<TCache::TRefPtr> refs;
+  for (int i = 10; i < 16; i++)
+  {
+    refs.push_back(cache.get(i, &sharded_factory, &calls));
+  }
+
+  stats = cache.stats();
+  BOOST_CHECK_EQUAL(stats.entries_, 6u);
+
+  // every reference to a key shares the same value:
+  TCache::TRefPtr a = cache.get(10);
+  BOOST_CHECK(&(a->value()) == &(refs.front()->value()));
+
+  // replacing a referenced value leaves the old reference intact:
+  TCache::TRefPtr b = cache.put(10, 7);
+  BOOST_CHECK_EQUAL(a->value(), 10u << 8);
+  BOOST_CHECK_EQUAL(b->value(), 7u);
+
+  a.reset();
+  b.reset();
+  refs.clear();
+
+  // trimmed back to capacity once the references are released:
+  stats = cache.stats();
+  BOOST_CHECK_EQUAL(stats.entries_, 4u);
+
+  cache.purge_unreferenced_entries();
+  BOOST_CHECK_EQUAL(cache.stats().entries_, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(yae_sharded_lru_cache_cost)
+{
+  typedef ShardedLRUCache<int, std::string> TCache;
+
+  // 100 bytes in a single shard:
+  TCache cache(100, 1, &value_cost);
+
+  cache.put(0, std::string(40, 'a'));
+  cache.put(1, std::string(40, 'b'));
+  BOOST_CHECK_EQUAL(cache.stats().cost_, 80u);
+
+  // evicts 0 to make room:
+  cache.put(2, std::string(40, 'c'));
+  BOOST_CHECK(!cache.get(0));
+  BOOST_CHECK(cache.get(1));
+  BOOST_CHECK_EQUAL(cache.stats().cost_, 80u);
+
+  // evicts both 1 and 2:
+  cache.put(3, std::string(90, 'd'));
+  BOOST_CHECK_EQUAL(cache.stats().entries_, 1u);
+  BOOST_CHECK_EQUAL(cache.stats().cost_, 90u);
+}
+
+
+//----------------------------------------------------------------
+// CacheStress
+//
+// hammer a cache from several threads with a skewed key distribution,
+// verifying every value that comes back:
+//
+template <typename TCache>
+struct CacheStress
+{
+  CacheStress(TCache & cache,
+              int thread_index,
+              int iterations,
+              int num_keys,
+              boost::atomic<int> & errors):
+    cache_(cache),
+    seed_(thread_index * 7919 + 1),
+    iterations_(iterations),
+    num_keys_(num_keys),
+    errors_(errors)
+  {}
+
+  void operator()()
+  {
+    for (int i = 0; i < iterations_; i++)
+    {
+      // cheap LCG, half the lookups go to 1/16th of the keys:
+      seed_ = seed_ * 1103515245u + 12345u;
+      unsigned int r = (seed_ >> 8);
+      int key = (r & 1) ? (r >> 1) % (num_keys_ / 16) : (r >> 1) % num_keys_;
+
+      typename TCache::TRefPtr ref = cache_.get(key, &sharded_factory);
+      if (!ref || ref->value() != (((unsigned int)key) << 8))
+      {
+        errors_.fetch_add(1);
+      }
+    }
+  }
+
+  TCache & cache_;
+  unsigned int seed_;
+  int iterations_;
+  int num_keys_;
+  boost::atomic<int> & errors_;
+};
+
+//----------------------------------------------------------------
+// run_stress
+//
+template <typename TCache>
+static double
+run_stress(TCache & cache,
+           int num_threads,
+           int iterations,
+           int num_keys,
+           boost::atomic<int> & errors)
+{
+  boost::posix_time::ptime t0 =
+    boost::posix_time::microsec_clock::universal_time();
+
+  boost::thread_group threads;
+  for (int i = 0; i < num_threads; i++)
+  {
+    threads.create_thread(CacheStress<TCache>(cache,
+                                              i,
+                                              iterations,
+                                              num_keys,
+                                              errors));
+  }
+  threads.join_all();
+
+  boost::posix_time::ptime t1 =
+    boost::posix_time::microsec_clock::universal_time();
+
+  double sec = double((t1 - t0).total_microseconds()) * 1e-6;
+  return double(num_threads) * double(iterations) / std::max(sec, 1e-6);
+}
+
+BOOST_AUTO_TEST_CASE(yae_sharded_lru_cache_stress)
+{
+  typedef ShardedLRUCache<int, unsigned int> TCache;
+
+  static const int num_threads = 8;
+  static const int iterations = 50000;
+  static const int num_keys = 4096;
+
+  boost::atomic<int> errors(0);
+  TCache cache(num_keys / 4);
+  run_stress(cache, num_threads, iterations, num_keys, errors);
+  BOOST_CHECK_EQUAL(errors.load(), 0);
+
+  TCache::Stats stats = cache.stats();
+  BOOST_CHECK_EQUAL(stats.hits_ + stats.misses_,
+                    boost::uint64_t(num_threads * iterations));
+
+  // the per-shard budget is rounded up:
+  BOOST_CHECK(stats.cost_ <= cache.num_shards() *
+              ((cache.capacity() + cache.num_shards() - 1) /
+               cache.num_shards()));
+}
+
+BOOST_AUTO_TEST_CASE(yae_lru_cache_throughput)
+{
+  static const int num_threads = 8;
+  static const int iterations = 50000;
+  static const int num_keys = 4096;
+
+  boost::atomic<int> errors(0);
+
+  LRUCache<int, unsigned int> single(num_keys / 4);
+  double single_ops =
+    run_stress(single, num_threads, iterations, num_keys, errors);
+
+  ShardedLRUCache<int, unsigned int> sharded(num_keys / 4);
+  double sharded_ops =
+    run_stress(sharded, num_threads, iterations, num_keys, errors);
+
+  BOOST_CHECK_EQUAL(errors.load(), 0);
+
+  BOOST_TEST_MESSAGE("LRUCache, " << num_threads << " threads: "
+                     << int(single_ops) << " lookups/sec");
+  BOOST_TEST_MESSAGE("ShardedLRUCache, " << num_threads << " threads: "
+                     << int(sharded_ops) << " lookups/sec");
+}
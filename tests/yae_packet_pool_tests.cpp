@@ -0,0 +1,161 @@
+// -*- Mode: c++; tab-width: 8; c-basic-offset: 2; indent-tabs-mode: nil -*-
+// NOTE: the first line of this file sets up source code indentation rules
+// for Emacs; it is also a hint to anyone modifying this file.
+
+// Created   : Fri Oct 23 19:42:08 MDT 2026
+// Copyright : Pavel Koshevoy
+// License   : MIT -- http://www.opensource.org/licenses/mit-license.php
+
+
+// standard:
+#include <vector>
+
+// boost library:
+#include <boost/test/unit_test.hpp>
+#include <boost/thread.hpp>
+#include <boost/weak_ptr.hpp>
+
+// aeyae:
+#include "yae/ffmpeg/yae_track.h"
+
+// shortcut:
+using namespace yae;
+
+
+//----------------------------------------------------------------
+// ReleasePackets
+//
+struct ReleasePackets
+{
+  ReleasePackets(std::vector<TPacketPtr> & packets):
+    packets_(packets)
+  {}
+
+  void operator()()
+  {
+    packets_.clear();
+  }
+
+  std::vector<TPacketPtr> & packets_;
+};
+
+
+BOOST_AUTO_TEST_CASE(yae_packet_pool_reuse)
+{
+  TPacketPoolPtr pool(new PacketPool(4));
+
+  const AvPkt * first = NULL;
+  {
+    TPacketPtr pkt = pool->get();
+    first = pkt.get();
+
+    PacketPool::Stats stats = pool->stats();
+    BOOST_CHECK_EQUAL(stats.misses_, 1U);
+    BOOST_CHECK_EQUAL(stats.hits_, 0U);
+    BOOST_CHECK_EQUAL(stats.outstanding_, 1U);
+    BOOST_CHECK_EQUAL(stats.available_, 0U);
+  }
+
+  // released packet is back on the free list:
+  BOOST_CHECK_EQUAL(pool->stats().outstanding_, 0U);
+  BOOST_CHECK_EQUAL(pool->stats().available_, 1U);
+
+  // and is handed out again instead of a new allocation:
+  TPacketPtr pkt = pool->get();
+  BOOST_CHECK(pkt.get() == first);
+
+  PacketPool::Stats stats = pool->stats();
+  BOOST_CHECK_EQUAL(stats.misses_, 1U);
+  BOOST_CHECK_EQUAL(stats.hits_, 1U);
+  BOOST_CHECK_EQUAL(stats.high_water_mark_, 1U);
+}
+
+BOOST_AUTO_TEST_CASE(yae_packet_pool_reset)
+{
+  TPacketPoolPtr pool(new PacketPool(4));
+
+  const AvPkt * first = NULL;
+  {
+    TPacketPtr pkt = pool->get();
+    first = pkt.get();
+
+    AVPacket & packet = pkt->get();
+    BOOST_CHECK_EQUAL(av_new_packet(&packet, 64), 0);
+    packet.pts = 1001;
+    packet.dts = 1000;
+    packet.stream_index = 3;
+
+    pkt->program_ = 2;
+    pkt->trackId_ = "v:000";
+  }
+
+  TPacketPtr pkt = pool->get();
+  BOOST_CHECK(pkt.get() == first);
+
+  // the payload and the origin of the previous packet are gone:
+  const AVPacket & packet = pkt->get();
+  BOOST_CHECK(packet.buf == NULL);
+  BOOST_CHECK(packet.data == NULL);
+  BOOST_CHECK_EQUAL(packet.size, 0);
+  BOOST_CHECK(packet.pts == AV_NOPTS_VALUE);
+  BOOST_CHECK(packet.dts == AV_NOPTS_VALUE);
+  BOOST_CHECK_EQUAL(packet.stream_index, 0);
+
+  BOOST_CHECK(pkt->pbuffer_ == NULL);
+  BOOST_CHECK(pkt->demuxer_ == NULL);
+  BOOST_CHECK_EQUAL(pkt->program_, 0);
+  BOOST_CHECK(pkt->trackId_.empty());
+}
+
+BOOST_AUTO_TEST_CASE(yae_packet_pool_max_available)
+{
+  TPacketPoolPtr pool(new PacketPool(4));
+  {
+    std::vector<TPacketPtr> packets;
+    for (int i = 0; i < 6; i++)
+    {
+      packets.push_back(pool->get());
+    }
+
+    BOOST_CHECK_EQUAL(pool->stats().outstanding_, 6U);
+    BOOST_CHECK_EQUAL(pool->stats().high_water_mark_, 6U);
+  }
+
+  // packets beyond the free list limit are deleted:
+  PacketPool::Stats stats = pool->stats();
+  BOOST_CHECK_EQUAL(stats.outstanding_, 0U);
+  BOOST_CHECK_EQUAL(stats.available_, 4U);
+}
+
+BOOST_AUTO_TEST_CASE(yae_packet_pool_shutdown)
+{
+  TPacketPoolPtr pool(new PacketPool(4));
+  boost::weak_ptr<PacketPool> weak(pool);
+
+  std::vector<TPacketPtr> packets;
+  for (int i = 0; i < 8; i++)
+  {
+    packets.push_back(pool->get());
+    BOOST_CHECK_EQUAL(av_new_packet(&(packets.back()->get()), 256), 0);
+  }
+
+  // the owner goes away while packets are still in flight,
+  // the pool must stay alive until they are all released:
+  pool.reset();
+  BOOST_CHECK(!weak.expired());
+
+  TPacketPtr last = packets.back();
+  packets.pop_back();
+
+  // release most of them from another thread:
+  boost::thread t((ReleasePackets(packets)));
+  t.join();
+
+  BOOST_CHECK(packets.empty());
+  BOOST_CHECK(!weak.expired());
+  BOOST_CHECK_EQUAL(weak.lock()->stats().outstanding_, 1U);
+
+  // the last packet takes the pool with it:
+  last.reset();
+  BOOST_CHECK(weak.expired());
+}
@@ -0,0 +1,291 @@
+// -*- Mode: c++; tab-width: 8; c-basic-offset: 2; indent-tabs-mode: nil -*-
+// NOTE: the first line of this file sets up source code indentation rules
+// for Emacs; it is also a hint to anyone modifying this file.
+
+// Created   : Fri Oct 16 11:02:17 MDT 2026
+// Copyright : Pavel Koshevoy
+// License   : MIT -- http://www.opensource.org/licenses/mit-license.php
+
+// boost library:
+#include <boost/atomic.hpp>
+#include <boost/test/unit_test.hpp>
+#include <boost/thread.hpp>
+
+// aeyae:
+#include "yae/thread/yae_ring_queue.h"
+
+// shortcut:
+using namespace yae;
+
+
+//----------------------------------------------------------------
+// Producer
+//
+struct Producer
+{
+  Producer(RingQueue<int> & queue, int n):
+    queue_(queue),
+    n_(n)
+  {}
+
+  void operator()()
+  {
+    for (int i = 0; i < n_; i++)
+    {
+      if (!queue_.push(i))
+      {
+        break;
+      }
+    }
+
+    // end-of-stream marker:
+    queue_.push(-1);
+  }
+
+  RingQueue<int> & queue_;
+  int n_;
+};
+
+
+BOOST_AUTO_TEST_CASE(yae_ring_queue_fifo)
+{
+  RingQueue<int> queue(3);
+  BOOST_CHECK(queue.isClosed());
+  BOOST_CHECK_EQUAL(queue.getMaxSize(), 3u);
+  BOOST_CHECK_EQUAL(queue.capacity() & (queue.capacity() - 1), 0u);
+
+  queue.open();
+  BOOST_CHECK(queue.push(1));
+  BOOST_CHECK(queue.push(2));
+  BOOST_CHECK(queue.push(3));
+
+  int x = 0;
+  BOOST_CHECK(queue.peek(x));
+  BOOST_CHECK_EQUAL(x, 1);
+
+  // sequence markers ignore max size:
+  queue.startNewSequence(4);
+
+  for (int i = 1; i <= 4; i++)
+  {
+    BOOST_CHECK(queue.pop(x, NULL, false));
+    BOOST_CHECK_EQUAL(x, i);
+  }
+
+  BOOST_CHECK(queue.isEmpty());
+  BOOST_CHECK(!queue.pop(x, NULL, false));
+
+  queue.push(5);
+  queue.clear();
+  BOOST_CHECK(queue.isEmpty());
+
+  // a closed empty queue must not block:
+  queue.close();
+  BOOST_CHECK(!queue.pop(x));
+}
+
+BOOST_AUTO_TEST_CASE(yae_ring_queue_wait_mgr)
+{
+  RingQueue<int> queue(1);
+  queue.open();
+  BOOST_CHECK(queue.push(0));
+
+  // a full queue must not block when told to stop waiting:
+  QueueWaitMgr waitMgr;
+  waitMgr.stopWaiting();
+  BOOST_CHECK(!queue.push(1, &waitMgr));
+}
+
+BOOST_AUTO_TEST_CASE(yae_ring_queue_spsc)
+{
+  static const int n = 100000;
+
+  RingQueue<int> queue(7);
+  queue.open();
+
+  Producer producer(queue, n);
+  boost::thread thread(producer);
+
+  int expected = 0;
+  int x = 0;
+  while (queue.pop(x) && x >= 0)
+  {
+    if (x != expected)
+    {
+      break;
+    }
+
+    expected++;
+  }
+
+  thread.join();
+  BOOST_CHECK_EQUAL(expected, n);
+  BOOST_CHECK(queue.isEmpty());
+}
+
+//----------------------------------------------------------------
+// CountObserver
+//
+static void
+CountObserver(void * context)
+{
+  int * count = (int *)context;
+  (*count)++;
+}
+
+BOOST_AUTO_TEST_CASE(yae_ring_queue_pop_or_park)
+{
+  int notified = 0;
+  RingQueue<int> queue(4);
+  queue.setObserver(&CountObserver, &notified);
+  queue.open();
+
+  int x = 0;
+  BOOST_CHECK(!queue.popOrPark(x));
+  BOOST_CHECK(queue.consumerIsBlocked());
+  BOOST_CHECK(queue.waitForConsumerToBlock(0.0));
+
+  BOOST_CHECK(queue.push(1));
+  BOOST_CHECK(queue.push(2));
+  BOOST_CHECK_EQUAL(notified, 2);
+
+  BOOST_CHECK(queue.popOrPark(x));
+  BOOST_CHECK_EQUAL(x, 1);
+  BOOST_CHECK(!queue.consumerIsBlocked());
+
+  BOOST_CHECK(queue.popOrPark(x));
+  BOOST_CHECK_EQUAL(x, 2);
+  BOOST_CHECK(!queue.popOrPark(x));
+  BOOST_CHECK(queue.consumerIsBlocked());
+
+  queue.close();
+  BOOST_CHECK_EQUAL(notified, 3);
+
+  queue.setObserver(NULL, NULL);
+  queue.open();
+  queue.push(3);
+  BOOST_CHECK_EQUAL(notified, 3);
+}
+
+//----------------------------------------------------------------
+// test_push_or_park
+//
+template <typename TQueue>
+static void
+test_push_or_park(TQueue & queue)
+{
+  int notified = 0;
+  queue.setRoomObserver(&CountObserver, &notified);
+  queue.open();
+
+  BOOST_CHECK(queue.pushOrPark(1));
+  BOOST_CHECK(queue.pushOrPark(2));
+  BOOST_CHECK(!queue.pushOrPark(3));
+
+  // a push was parked, so making room calls the observer:
+  int x = 0;
+  BOOST_CHECK(queue.pop(x));
+  BOOST_CHECK_EQUAL(x, 1);
+  BOOST_CHECK_EQUAL(notified, 1);
+
+  // only once per parked push:
+  BOOST_CHECK(queue.pushOrPark(3));
+  BOOST_CHECK(queue.pop(x));
+  BOOST_CHECK_EQUAL(x, 2);
+  BOOST_CHECK_EQUAL(notified, 1);
+
+  BOOST_CHECK(queue.pushOrPark(4));
+  BOOST_CHECK(!queue.pushOrPark(5));
+  queue.clear();
+  BOOST_CHECK_EQUAL(notified, 2);
+
+  BOOST_CHECK(queue.pushOrPark(5));
+  BOOST_CHECK(queue.pushOrPark(6));
+  BOOST_CHECK(!queue.pushOrPark(7));
+  queue.close();
+  BOOST_CHECK_EQUAL(notified, 3);
+  BOOST_CHECK(!queue.pushOrPark(7));
+}
+
+BOOST_AUTO_TEST_CASE(yae_ring_queue_push_or_park)
+{
+  RingQueue<int> ring(2);
+  test_push_or_park(ring);
+
+  Queue<int> queue(2);
+  test_push_or_park(queue);
+}
+
+//----------------------------------------------------------------
+// SlowObserver
+//
+struct SlowObserver
+{
+  SlowObserver():
+    entered_(false),
+    running_(false)
+  {}
+
+  static void callback(void * context)
+  {
+    SlowObserver * observer = (SlowObserver *)context;
+    observer->running_.store(true);
+    observer->entered_.store(true);
+    boost::this_thread::sleep_for(boost::chrono::milliseconds(50));
+    observer->running_.store(false);
+  }
+
+  boost::atomic<bool> entered_;
+  boost::atomic<bool> running_;
+};
+
+//----------------------------------------------------------------
+// PushOne
+//
+template <typename TQueue>
+struct PushOne
+{
+  PushOne(TQueue & queue):
+    queue_(queue)
+  {}
+
+  void operator()()
+  {
+    queue_.push(1);
+  }
+
+  TQueue & queue_;
+};
+
+//----------------------------------------------------------------
+// test_observer_handshake
+//
+template <typename TQueue>
+static void
+test_observer_handshake(TQueue & queue)
+{
+  SlowObserver observer;
+  queue.setObserver(&SlowObserver::callback, &observer);
+  queue.open();
+
+  boost::thread t((PushOne<TQueue>(queue)));
+  while (!observer.entered_.load())
+  {
+    boost::this_thread::yield();
+  }
+
+  // once setObserver returns the old observer is no longer running,
+  // so its context may be destroyed:
+  queue.setObserver(NULL, NULL);
+  BOOST_CHECK(!observer.running_.load());
+  t.join();
+}
+
+BOOST_AUTO_TEST_CASE(yae_ring_queue_observer_handshake)
+{
+  RingQueue<int> ring(4);
+  test_observer_handshake(ring);
+
+  Queue<int> queue(4);
+  test_observer_handshake(queue);
+}
@@ -0,0 +1,287 @@
+// -*- Mode: c++; tab-width: 8; c-basic-offset: 2; indent-tabs-mode: nil -*-
+// NOTE: the first line of this file sets up source code indentation rules
+// for Emacs; it is also a hint to anyone modifying this file.
+
+// Created   : Fri Oct 16 18:12:37 MDT 2026
+// Copyright : Pavel Koshevoy
+// License   : MIT -- http://www.opensource.org/licenses/mit-license.php
+
+// standard:
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+// ffmpeg:
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/channel_layout.h>
+}
+
+// aeyae:
+#include "yae/ffmpeg/yae_demuxer.h"
+#include "yae/ffmpeg/yae_ffmpeg_utils.h"
+
+// local:
+#include "yae_test_media.h"
+
+// shortcut:
+using namespace yae;
+
+
+//----------------------------------------------------------------
+// encode
+//
+// send a frame (or NULL to flush) to the encoder
+// and write out whatever packets it produces:
+//
+static bool
+encode(AVFormatContext * muxer,
+       AVCodecContext * encoder,
+       AVStream * dst,
+       const AVFrame * frame)
+{
+  int err = avcodec_send_frame(encoder, frame);
+  while (err >= 0)
+  {
+    AvPkt pkt;
+    AVPacket & out = pkt.get();
+    err = avcodec_receive_packet(encoder, &out);
+    if (err == AVERROR(EAGAIN) || err == AVERROR_EOF)
+    {
+      return true;
+    }
+
+    if (err < 0)
+    {
+      break;
+    }
+
+    out.stream_index = dst->index;
+    av_packet_rescale_ts(&out, encoder->time_base, dst->time_base);
+    err = av_interleaved_write_frame(muxer, &out);
+  }
+
+  av_log(NULL, AV_LOG_ERROR,
+         "encode error %i: \"%s\"\n",
+         err, yae::av_strerr(err).c_str());
+  return false;
+}
+
+//----------------------------------------------------------------
+// open_encoder
+//
+// w, h and gop_size are ignored for audio:
+//
+static AvCodecContextPtr
+open_encoder(AVFormatContext * muxer,
+             enum AVCodecID codec_id,
+             int w,
+             int h,
+             int gop_size,
+             AVStream *& dst)
+{
+  const AVCodec * codec = avcodec_find_encoder(codec_id);
+  if (!codec)
+  {
+    av_log(NULL, AV_LOG_ERROR,
+           "avcodec_find_encoder(%i) failed\n", codec_id);
+    return AvCodecContextPtr();
+  }
+
+  AvCodecContextPtr encoder_ptr(avcodec_alloc_context3(codec));
+  AVCodecContext & encoder = *encoder_ptr;
+
+  if (codec->type == AVMEDIA_TYPE_VIDEO)
+  {
+    encoder.width = w;
+    encoder.height = h;
+    encoder.time_base.num = 1;
+    encoder.time_base.den = 25;
+    encoder.framerate.num = 25;
+    encoder.framerate.den = 1;
+    encoder.gop_size = gop_size;
+    encoder.max_b_frames = 2;
+    encoder.pix_fmt = AV_PIX_FMT_YUV420P;
+    encoder.bit_rate = w * h * 4;
+  }
+  else
+  {
+    encoder.sample_rate = 48000;
+    encoder.sample_fmt = AV_SAMPLE_FMT_S16;
+    encoder.channel_layout = AV_CH_LAYOUT_STEREO;
+    encoder.channels = 2;
+    encoder.time_base.num = 1;
+    encoder.time_base.den = encoder.sample_rate;
+  }
+
+  if (muxer->oformat->flags & AVFMT_GLOBALHEADER)
+  {
+    encoder.flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+  }
+
+  int err = avcodec_open2(&encoder, codec, NULL);
+  if (err < 0)
+  {
+    av_log(NULL, AV_LOG_ERROR,
+           "avcodec_open2 error %i: \"%s\"\n",
+           err, yae::av_strerr(err).c_str());
+    return AvCodecContextPtr();
+  }
+
+  dst = avformat_new_stream(muxer, NULL);
+  dst->time_base = encoder.time_base;
+  avcodec_parameters_from_context(dst->codecpar, &encoder);
+  return encoder_ptr;
+}
+
+//----------------------------------------------------------------
+// generate_test_clip
+//
+bool
+generate_test_clip(const std::string & path,
+                   int w,
+                   int h,
+                   int num_frames,
+                   int gop_size)
+{
+  AvOutputContextPtr muxer_ptr(avformat_alloc_context());
+  AVFormatContext * muxer = muxer_ptr.get();
+  muxer->url = av_strdup(path.c_str());
+  muxer->oformat = av_guess_format("matroska", path.c_str(), NULL);
+
+  if (!muxer->oformat)
+  {
+    av_log(NULL, AV_LOG_ERROR, "matroska muxer is not available\n");
+    return false;
+  }
+
+  AVStream * vdst = NULL;
+  AvCodecContextPtr venc_ptr =
+    open_encoder(muxer, AV_CODEC_ID_MPEG4, w, h, gop_size, vdst);
+
+  AVStream * adst = NULL;
+  AvCodecContextPtr aenc_ptr =
+    open_encoder(muxer, AV_CODEC_ID_PCM_S16LE, w, h, gop_size, adst);
+
+  if (!venc_ptr || !aenc_ptr)
+  {
+    return false;
+  }
+
+  AVCodecContext * venc = venc_ptr.get();
+  AVCodecContext * aenc = aenc_ptr.get();
+
+  int err = avio_open2(&(muxer->pb), path.c_str(), AVIO_FLAG_WRITE, NULL, NULL);
+  if (err < 0)
+  {
+    av_log(NULL, AV_LOG_ERROR,
+           "avio_open2(%s) error %i: \"%s\"\n",
+           path.c_str(), err, yae::av_strerr(err).c_str());
+    return false;
+  }
+
+  err = avformat_write_header(muxer, NULL);
+  if (err < 0)
+  {
+    av_log(NULL, AV_LOG_ERROR,
+           "avformat_write_header(%s) error %i: \"%s\"\n",
+           path.c_str(), err, yae::av_strerr(err).c_str());
+    return false;
+  }
+
+  AvFrm vfrm;
+  AVFrame & vf = vfrm.get();
+  vf.format = venc->pix_fmt;
+  vf.width = w;
+  vf.height = h;
+  av_frame_get_buffer(&vf, 32);
+
+  static const int samples_per_frame = 1024;
+  AvFrm afrm;
+  AVFrame & af = afrm.get();
+  af.format = aenc->sample_fmt;
+  af.channel_layout = aenc->channel_layout;
+  af.channels = aenc->channels;
+  af.sample_rate = aenc->sample_rate;
+  af.nb_samples = samples_per_frame;
+  av_frame_get_buffer(&af, 0);
+
+  static const double two_pi = 6.283185307179586;
+  int64_t audio_pts = 0;
+  for (int i = 0; i < num_frames; i++)
+  {
+    av_frame_make_writable(&vf);
+
+    const int bx = (i * 7) % std::max(1, w - w / 8);
+    const int by = (i * 5) % std::max(1, h - h / 8);
+
+    for (int y = 0; y < h; y++)
+    {
+      uint8_t * luma = vf.data[0] + y * vf.linesize[0];
+      for (int x = 0; x < w; x++)
+      {
+        bool box = (x >= bx && x < bx + w / 8 && y >= by && y < by + h / 8);
+        luma[x] = box ? 235 : uint8_t(16 + ((x + y + i * 3) & 0x7F));
+      }
+    }
+
+    for (int y = 0; y < h / 2; y++)
+    {
+      uint8_t * cb = vf.data[1] + y * vf.linesize[1];
+      uint8_t * cr = vf.data[2] + y * vf.linesize[2];
+      for (int x = 0; x < w / 2; x++)
+      {
+        cb[x] = uint8_t(128 + ((x + i) & 0x3F) - 32);
+        cr[x] = uint8_t(128 + ((y - i) & 0x3F) - 32);
+      }
+    }
+
+    vf.pts = i;
+    if (!encode(muxer, venc, vdst, &vf))
+    {
+      return false;
+    }
+
+    // keep the audio interleaved with the video:
+    while (audio_pts * 25 < int64_t(i + 1) * aenc->sample_rate)
+    {
+      av_frame_make_writable(&af);
+
+      int16_t * samples = (int16_t *)(af.data[0]);
+      for (int j = 0; j < samples_per_frame; j++)
+      {
+        double t = double(audio_pts + j) / double(aenc->sample_rate);
+        int16_t s = int16_t(8192.0 * sin(two_pi * 440.0 * t));
+        samples[j * 2] = s;
+        samples[j * 2 + 1] = s;
+      }
+
+      af.pts = audio_pts;
+      audio_pts += samples_per_frame;
+
+      if (!encode(muxer, aenc, adst, &af))
+      {
+        return false;
+      }
+    }
+  }
+
+  if (!encode(muxer, venc, vdst, NULL) ||
+      !encode(muxer, aenc, adst, NULL))
+  {
+    return false;
+  }
+
+  err = av_write_trailer(muxer);
+  if (err < 0)
+  {
+    av_log(NULL, AV_LOG_ERROR,
+           "av_write_trailer(%s) error %i: \"%s\"\n",
+           path.c_str(), err, yae::av_strerr(err).c_str());
+    return false;
+  }
+
+  return true;
+}
@@ -0,0 +1,33 @@
+// -*- Mode: c++; tab-width: 8; c-basic-offset: 2; indent-tabs-mode: nil -*-
+// NOTE: the first line of this file sets up source code indentation rules
+// for Emacs; it is also a hint to anyone modifying this file.
+
+// Created   : Fri Oct 16 18:12:37 MDT 2026
+// Copyright : Pavel Koshevoy
+// License   : MIT -- http://www.opensource.org/licenses/mit-license.php
+
+#ifndef YAE_TEST_MEDIA_H_
+#define YAE_TEST_MEDIA_H_
+
+// standard:
+#include <string>
+
+
+//----------------------------------------------------------------
+// generate_test_clip
+//
+// synthesize a test clip: a scrolling gradient with a moving box
+// over a 440Hz tone, MPEG-4 video at 25 fps + PCM stereo audio
+// in matroska.  The picture changes every frame so the decoder
+// can not skip any work, and nothing but the built-in ffmpeg
+// encoders is needed:
+//
+bool
+generate_test_clip(const std::string & path,
+                   int w,
+                   int h,
+                   int num_frames,
+                   int gop_size);
+
+
+#endif // YAE_TEST_MEDIA_H_
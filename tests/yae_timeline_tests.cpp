@@ -6,6 +6,8 @@
 // Copyright : Pavel Koshevoy
 // License   : MIT -- http://www.opensource.org/licenses/mit-license.php
 
+// standard:
+#include <sstream>
 
 // boost library:
 #include <boost/test/unit_test.hpp>
@@ -262,4 +264,107 @@ BOOST_AUTO_TEST_CASE(yae_timeline_track)
   BOOST_CHECK_EQUAL(kd, 26);
   BOOST_CHECK_EQUAL(ia, 11);
   BOOST_CHECK_EQUAL(ib, 18);
+
+  // keyframe a decoder has to start from to reach a given DTS,
+  // clamped to the timeline:
+  std::size_t k = std::numeric_limits<std::size_t>::max();
+  BOOST_CHECK(tt.find_keyframe_by_dts(TTime(-5, 1), k));
+  BOOST_CHECK_EQUAL(k, 0);
+
+  BOOST_CHECK(tt.find_keyframe_by_dts(TTime(10.5), k));
+  BOOST_CHECK_EQUAL(k, 0);
+
+  BOOST_CHECK(tt.find_keyframe_by_dts(TTime(11, 1), k));
+  BOOST_CHECK_EQUAL(k, 13);
+
+  BOOST_CHECK(tt.find_keyframe_by_dts(TTime(30, 1), k));
+  BOOST_CHECK_EQUAL(k, 26);
+
+  BOOST_CHECK(tt.find_keyframe_by_dts(TTime(100, 1), k));
+  BOOST_CHECK_EQUAL(k, 39);
+
+  // positions were not given:
+  BOOST_CHECK_EQUAL(tt.get_pos(13), -1);
+}
+
+BOOST_AUTO_TEST_CASE(yae_timeline_save_load)
+{
+  // build a timeline incrementally, as a resumed index scan would,
+  // and check that it matches one built in a single pass:
+  Timeline full;
+  FramerateEstimator full_fps;
+
+  Timeline head;
+  FramerateEstimator head_fps;
+
+  for (int i = 0; i < 300; i++)
+  {
+    // 29.97 fps video with B-frames, and some audio:
+    TTime dts(i * 1001, 30000);
+    TTime pts((i + (i % 3 == 1 ? 2 : 0)) * 1001, 30000);
+    TTime dur(1001, 30000);
+    bool keyframe = (i % 30) == 0;
+
+    full.add_packet("v:000", keyframe, 1000 + i, dts, pts, dur, 0.1,
+                    i * 1384);
+    full.add_packet("a:000", true, 384, dts, dts, dur, 0.1,
+                    i * 1384 + 1000 + i);
+    full_fps.push(dts);
+
+    if (i < 200)
+    {
+      head.add_packet("v:000", keyframe, 1000 + i, dts, pts, dur, 0.1,
+                      i * 1384);
+      head.add_packet("a:000", true, 384, dts, dts, dur, 0.1,
+                      i * 1384 + 1000 + i);
+      head_fps.push(dts);
+    }
+  }
+
+  std::ostringstream oss;
+  head.save(oss);
+  head_fps.save(oss);
+
+  // truncated input must be rejected:
+  {
+    std::string data = oss.str();
+    std::istringstream iss(data.substr(0, data.size() / 2));
+    Timeline t;
+    BOOST_CHECK(!t.load(iss));
+    BOOST_CHECK(t.tracks_.empty());
+  }
+
+  std::istringstream iss(oss.str());
+  Timeline resumed;
+  FramerateEstimator resumed_fps;
+  BOOST_CHECK(resumed.load(iss));
+  BOOST_CHECK(resumed_fps.load(iss));
+
+  for (int i = 200; i < 300; i++)
+  {
+    TTime dts(i * 1001, 30000);
+    TTime pts((i + (i % 3 == 1 ? 2 : 0)) * 1001, 30000);
+    TTime dur(1001, 30000);
+    bool keyframe = (i % 30) == 0;
+
+    resumed.add_packet("v:000", keyframe, 1000 + i, dts, pts, dur, 0.1,
+                       i * 1384);
+    resumed.add_packet("a:000", true, 384, dts, dts, dur, 0.1,
+                       i * 1384 + 1000 + i);
+    resumed_fps.push(dts);
+  }
+
+  BOOST_CHECK_EQUAL(toText(resumed), toText(full));
+  BOOST_CHECK_EQUAL(toText(resumed_fps), toText(full_fps));
+  BOOST_CHECK_EQUAL(resumed_fps.best_guess(), full_fps.best_guess());
+
+  const Timeline::Track & a = resumed.tracks_["v:000"];
+  const Timeline::Track & b = full.tracks_["v:000"];
+  BOOST_CHECK(a.keyframes_ == b.keyframes_);
+  BOOST_CHECK(a.size_ == b.size_);
+  BOOST_CHECK(a.dts_ == b.dts_);
+  BOOST_CHECK(a.pts_ == b.pts_);
+  BOOST_CHECK(a.dur_ == b.dur_);
+  BOOST_CHECK(a.pos_ == b.pos_);
+  BOOST_CHECK_EQUAL(a.pts_span_.size(), b.pts_span_.size());
 }
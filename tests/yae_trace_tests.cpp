@@ -0,0 +1,86 @@
+// -*- Mode: c++; tab-width: 8; c-basic-offset: 2; indent-tabs-mode: nil -*-
+// NOTE: the first line of this file sets up source code indentation rules
+// for Emacs; it is also a hint to anyone modifying this file.
+
+// Created   : Fri Oct 16 17:12:26 MDT 2026
+// Copyright : Pavel Koshevoy
+// License   : MIT -- http://www.opensource.org/licenses/mit-license.php
+
+// standard C++ library:
+#include <sstream>
+#include <string>
+
+// boost library:
+#include <boost/test/unit_test.hpp>
+#include <boost/thread.hpp>
+
+// aeyae:
+#include "yae/utils/yae_trace.h"
+
+// shortcut:
+using namespace yae;
+
+
+//----------------------------------------------------------------
+// trace_worker
+//
+static void trace_worker()
+{
+  TTrace::set_thread_name("trace \"worker\"");
+
+  for (int i = 0; i < 100; i++)
+  {
+    YAE_TRACE_SPAN(span, "trace_worker");
+  }
+
+  YAE_TRACE_INSTANT("trace_worker done");
+}
+
+//----------------------------------------------------------------
+// count
+//
+static std::size_t
+count(const std::string & text, const std::string & pattern)
+{
+  std::size_t n = 0;
+  for (std::size_t i = text.find(pattern); i != std::string::npos;
+       i = text.find(pattern, i + pattern.size()))
+  {
+    n++;
+  }
+
+  return n;
+}
+
+BOOST_AUTO_TEST_CASE(yae_trace)
+{
+  TTrace::enable(true);
+  TTrace::set_capacity(64);
+  TTrace::clear();
+
+  boost::thread t1(&trace_worker);
+  t1.join();
+
+  std::ostringstream oss;
+  TTrace::write(oss);
+  std::string json = oss.str();
+
+  BOOST_CHECK_EQUAL(json.find("{\"traceEvents\":["), 0u);
+  BOOST_CHECK(json.find("\"args\":{\"name\":\"trace \\\"worker\\\"\"}")
+              != std::string::npos);
+
+  // the ring keeps only the most recent 64 events,
+  // 63 spans and the instant event:
+  BOOST_CHECK_EQUAL(count(json, "\"name\":\"trace_worker\""), 63u);
+  BOOST_CHECK_EQUAL(count(json, "\"ph\":\"X\""), 63u);
+  BOOST_CHECK_EQUAL(count(json, "\"name\":\"trace_worker done\""), 1u);
+  BOOST_CHECK_EQUAL(count(json, "\"ph\":\"i\""), 1u);
+
+  TTrace::clear();
+  TTrace::enable(false);
+  trace_worker();
+
+  oss.str(std::string());
+  TTrace::write(oss);
+  BOOST_CHECK_EQUAL(count(oss.str(), "\"ph\":\"X\""), 0u);
+}
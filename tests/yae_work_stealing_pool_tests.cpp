@@ -0,0 +1,81 @@
+// -*- Mode: c++; tab-width: 8; c-basic-offset: 2; indent-tabs-mode: nil -*-
+// NOTE: the first line of this file sets up source code indentation rules
+// for Emacs; it is also a hint to anyone modifying this file.
+
+// Created   : Fri Oct 16 14:05:38 MDT 2026
+// Copyright : Pavel Koshevoy
+// License   : MIT -- http://www.opensource.org/licenses/mit-license.php
+
+// boost library:
+#include <boost/atomic.hpp>
+#include <boost/test/unit_test.hpp>
+#include <boost/thread.hpp>
+
+// aeyae:
+#include "yae/thread/yae_work_stealing_pool.h"
+
+// shortcut:
+using namespace yae;
+
+
+//----------------------------------------------------------------
+// CountdownTask
+//
+// each task re-submits a few children until the depth runs out,
+// so most of the work is submitted from the worker threads:
+//
+struct CountdownTask : public WorkStealingPool::Task
+{
+  CountdownTask(WorkStealingPool & pool,
+                boost::atomic<int> & done,
+                int depth):
+    pool_(pool),
+    done_(done),
+    depth_(depth)
+  {}
+
+  // virtual:
+  void run()
+  {
+    if (depth_ > 0)
+    {
+      for (int i = 0; i < 2; i++)
+      {
+        pool_.submit(WorkStealingPool::TaskPtr
+                     (new CountdownTask(pool_, done_, depth_ - 1)));
+      }
+    }
+
+    done_.fetch_add(1);
+  }
+
+  WorkStealingPool & pool_;
+  boost::atomic<int> & done_;
+  int depth_;
+};
+
+
+BOOST_AUTO_TEST_CASE(yae_work_stealing_pool)
+{
+  static const int depth = 12;
+  static const int expected = (1 << (depth + 1)) - 1;
+
+  boost::atomic<int> done(0);
+  {
+    WorkStealingPool pool(4);
+    BOOST_CHECK_EQUAL(pool.num_workers(), 4u);
+
+    pool.submit(WorkStealingPool::TaskPtr
+                (new CountdownTask(pool, done, depth)));
+
+    for (int i = 0; i < 1000 && done.load() < expected; i++)
+    {
+      boost::this_thread::sleep_for(boost::chrono::milliseconds(10));
+    }
+
+    WorkStealingPool::Stats stats = pool.stats();
+    BOOST_CHECK_EQUAL(stats.submitted_, uint64_t(expected));
+  }
+
+  BOOST_CHECK_EQUAL(done.load(), expected);
+}
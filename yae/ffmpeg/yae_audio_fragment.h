@@ -29,6 +29,7 @@
 // yae includes:
 #include "../utils/yae_utils.h"
 #include "../video/yae_video.h"
+#include "yae_audio_tempo_kernels.h"
 
 // ffmpeg includes:
 extern "C"
@@ -97,10 +98,6 @@ namespace yae
                float min0 = float(std::numeric_limits<TSample>::min()),
                float max0 = float(std::numeric_limits<TSample>::max()))
     {
-      // shortcuts:
-      const unsigned char * src = data_.empty() ? NULL : &data_[0];
-      const unsigned char * srcEnd = src + numSamples_ * stride_;
-
       unsigned int nlevels = floor_log2(window);
       YAE_ASSERT(window == (1 << nlevels));
 
@@ -108,59 +105,15 @@ namespace yae
       xdat_.resize<FFTComplex>(window + 1);
       memset(xdat_.data(), 0, xdat_.rowBytes());
 
-      if (numChannels_ == 1)
-      {
-        FFTSample * xdat = xdat_.template data<FFTSample>();
-        TSample tmp;
-
-        while (src < srcEnd)
-        {
-          tmp = *(const TSample *)src;
-          src += sizeof(TSample);
-
-          *xdat = (FFTSample)tmp;
-          xdat++;
-        }
-      }
-      else
+      if (data_.empty())
       {
-        FFTSample * xdat = xdat_.template data<FFTSample>();
-
-        // temporary buffer for a row of samples:
-        TSample tmp;
-        float s;
-        float max;
-        float ti;
-        float si;
-
-        while (src < srcEnd)
-        {
-          tmp = *(const TSample *)src;
-          src += sizeof(TSample);
-
-          max = (float)tmp;
-          s = std::min<float>(max0, fabsf(max));
-
-          for (std::size_t i = 1; i < numChannels_; i++)
-          {
-            tmp = *(const TSample *)src;
-            src += sizeof(TSample);
-
-            ti = (float)tmp;
-            si = std::min<float>(max0, fabsf(ti));
-
-            // store max amplitude only:
-            if (s < si)
-            {
-              s   = si;
-              max = ti;
-            }
-          }
-
-          *xdat = max;
-          xdat++;
-        }
+        return;
       }
+
+      // downmix to mono, keep the sample with the largest amplitude:
+      const TSample * src = (const TSample *)(&data_[0]);
+      FFTSample * xdat = xdat_.template data<FFTSample>();
+      TAudioTempoKernels::downmix(src, numSamples_, numChannels_, max0, xdat);
     }
 
     //----------------------------------------------------------------
@@ -202,11 +155,8 @@ namespace yae
         xb++;
         xc++;
 
-        for (int i = 1; i < window; i++, xa++, xb++, xc++)
-        {
-          xc->re = (xa->re * xb->re + xa->im * xb->im);
-          xc->im = (xa->im * xb->re - xa->re * xb->im);
-        }
+        TAudioTempoKernels::crossSpectrum(&xa->re, &xb->re, window - 1,
+                                          &xc->re);
 
         // apply inverse rDFT transform:
         av_rdft_calc(complexToReal, correlation);
@@ -214,7 +164,6 @@ namespace yae
 
       // identify peaks:
       int bestOffset = -drift;
-      FFTSample bestMetric = -std::numeric_limits<FFTSample>::max();
 
       int i0 = std::max<int>(window / 2 - deltaMax - drift, 0);
       i0 = std::min<int>(i0, window);
@@ -223,20 +172,11 @@ namespace yae
                              window - window / 16);
       i1 = std::max<int>(i1, 0);
 
-      FFTSample * xc = correlation + i0;
-      for (int i = i0; i < i1; i++, xc++)
+      int best = TAudioTempoKernels::correlationPeak(correlation,
+                                                     i0, i1, drift);
+      if (best >= 0)
       {
-        FFTSample metric = *xc;
-
-        // normalize:
-        FFTSample drifti = FFTSample(drift + i);
-        metric *= drifti * FFTSample(i - i0) * FFTSample(i1 - i);
-
-        if (metric > bestMetric)
-        {
-          bestMetric = metric;
-          bestOffset = i - window / 2;
-        }
+        bestOffset = best - window / 2;
       }
 
       return bestOffset;
@@ -19,12 +19,14 @@
 #endif
 
 // std includes:
+#include <algorithm>
 #include <math.h>
 #include <string.h>
 #include <vector>
 
 // yae includes:
 #include "yae_audio_fragment.h"
+#include "yae_audio_tempo_kernels.h"
 #include "../video/yae_video.h"
 
 
@@ -159,12 +161,18 @@ namespace yae
       unsigned int samplesToBuffer = window_ * 3;
       buffer_.resize(samplesToBuffer * channels_);
 
-      // sample the Hann window function:
-      hann_.resize(window_);
+      // sample the Hann window function, repeat each coefficient
+      // for every channel so that the overlap-add kernel does not
+      // have to care about channel interleaving:
+      hann_.resize(window_ * channels_);
       for (std::size_t i = 0; i < window_; i++)
       {
-        hann_[i] = float(0.5 * (1.0 - cos(2.0 * M_PI * double(i) /
-                                          double(window_ - 1))));
+        float h = float(0.5 * (1.0 - cos(2.0 * M_PI * double(i) /
+                                         double(window_ - 1))));
+
+        std::fill(hann_.begin() + i * channels_,
+                  hann_.begin() + (i + 1) * channels_,
+                  h);
       }
 
       clear();
@@ -335,29 +343,41 @@ namespace yae
       const int64 ia = startHere - prev.position_[1];
       const int64 ib = startHere - frag.position_[1];
 
-      const float * wa = &hann_[0] + ia;
-      const float * wb = &hann_[0] + ib;
+      const float * wa = &hann_[0] + ia * channels_;
+      const float * wb = &hann_[0] + ib * channels_;
 
       // this is risky, waveform pyramid does not guarantee alignment:
       const std::size_t stride = channels_ * sizeof(TSample);
       const TSample * a = (const TSample *)(&prev.data_[0] + ia * stride);
       const TSample * b = (const TSample *)(&frag.data_[0] + ib * stride);
 
-      for (int64 i = 0; i < overlap && dst < dstEnd;
-           i++, position_[1]++, wa++, wb++)
-      {
-        float w0 = *wa;
-        float w1 = *wb;
+      // number of whole frames that fit in the output buffer:
+      const int64 n = std::min<int64>(overlap,
+                                      int64(dstEnd - dst) / int64(channels_));
 
-        for (unsigned int j = 0; j < channels_; j++, a++, b++, dst++)
-        {
-          float t0 = float(*a);
-          float t1 = float(*b);
+      // the left half of the first fragment is passed through as is,
+      // see clear():
+      const int64 n0 =
+        std::min<int64>(n, std::max<int64>(0, -frag.position_[0]));
+      if (n0)
+      {
+        memcpy(dst, a, n0 * stride);
+      }
 
-          *dst = (frag.position_[0] + i < 0) ? *a : TSample(t0 * w0 + t1 * w1);
-        }
+      if (n0 < n)
+      {
+        const std::size_t k = n0 * channels_;
+        TAudioTempoKernels::overlapAdd(a + k,
+                                       b + k,
+                                       wa + k,
+                                       wb + k,
+                                       (n - n0) * channels_,
+                                       dst + k);
       }
 
+      dst += n * channels_;
+      position_[1] += n;
+
       bool done = position_[1] == stopHere;
       return done;
     }
@@ -669,7 +689,8 @@ namespace yae
     std::size_t channels_;
 
     // Hann window coefficients, for feathering
-    // (blending) the overlapping fragment region:
+    // (blending) the overlapping fragment region,
+    // repeated for each channel:
     std::vector<float> hann_;
 
     // fragment window size, power-of-two integer:
@@ -0,0 +1,1397 @@
+// -*- Mode: c++; tab-width: 8; c-basic-offset: 2; indent-tabs-mode: nil -*-
+// NOTE: the first line of this file sets up source code indentation rules
+// for Emacs; it is also a hint to anyone modifying this file.
+
+// Created   : Fri Oct 16 21:05:52 MDT 2026
+// Copyright : Pavel Koshevoy
+// License   : MIT -- http://www.opensource.org/licenses/mit-license.php
+
+// system includes:
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+// boost includes:
+#include <boost/atomic.hpp>
+
+// SIMD kernels are compiled for x86 regardless of the compiler flags,
+// the best set supported by the CPU is selected at runtime:
+#if defined(__x86_64__) || defined(__i386__) || \
+    defined(_M_X64) || defined(_M_IX86)
+#define YAE_AUDIO_TEMPO_X86 1
+#include <emmintrin.h>
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#else
+#define YAE_AUDIO_TEMPO_X86 0
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define YAE_TARGET_SSE2 __attribute__((target("sse2")))
+#define YAE_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define YAE_TARGET_SSE2
+#define YAE_TARGET_AVX2
+#endif
+
+// yae includes:
+#include "yae_audio_tempo_kernels.h"
+
+
+namespace yae
+{
+
+  //----------------------------------------------------------------
+  // TKernelsImpl
+  //
+  // Integer and double precision samples are converted to floats
+  // in small blocks, so that the float kernels can be shared
+  // by all sample formats:
+  //
+  struct TKernelsImpl
+  {
+    void (*u8ToFloat_)(const unsigned char * src, std::size_t n, float * dst);
+    void (*s16ToFloat_)(const short int * src, std::size_t n, float * dst);
+    void (*s32ToFloat_)(const int * src, std::size_t n, float * dst);
+    void (*f64ToFloat_)(const double * src, std::size_t n, float * dst);
+
+    void (*floatToU8_)(const float * src, std::size_t n, unsigned char * dst);
+    void (*floatToS16_)(const float * src, std::size_t n, short int * dst);
+    void (*floatToS32_)(const float * src, std::size_t n, int * dst);
+    void (*floatToF64_)(const float * src, std::size_t n, double * dst);
+
+    // see TAudioTempoKernels::downmix:
+    void (*peakAbs_)(const float * src,
+                     std::size_t frames,
+                     std::size_t channels,
+                     float max0,
+                     float * dst);
+
+    // dst[i] = a[i] * wa[i] + b[i] * wb[i], dst may be the same as a:
+    void (*blend_)(const float * a,
+                   const float * b,
+                   const float * wa,
+                   const float * wb,
+                   std::size_t n,
+                   float * dst);
+
+    void (*crossSpectrum_)(const float * xa,
+                           const float * xb,
+                           std::size_t n,
+                           float * xc);
+
+    int (*correlationPeak_)(const float * xc, int i0, int i1, int drift);
+  };
+
+  //----------------------------------------------------------------
+  // clip
+  //
+  // same as _mm_max_ps(_mm_min_ps(v, hi), lo), including NaN handling:
+  //
+  static inline float
+  clip(float v, float lo, float hi)
+  {
+    float t = v < hi ? v : hi;
+    return t > lo ? t : lo;
+  }
+
+  //----------------------------------------------------------------
+  // kS32Max
+  //
+  // largest float that does not overflow an int:
+  //
+  static const float kS32Max = 2147483520.0f;
+
+  //----------------------------------------------------------------
+  // convert_scalar
+  //
+  template <typename TSrc, typename TDst>
+  static void
+  convert_scalar(const TSrc * src, std::size_t n, TDst * dst)
+  {
+    for (std::size_t i = 0; i < n; i++)
+    {
+      dst[i] = TDst(src[i]);
+    }
+  }
+
+  //----------------------------------------------------------------
+  // floatToU8_scalar
+  //
+  static void
+  floatToU8_scalar(const float * src, std::size_t n, unsigned char * dst)
+  {
+    for (std::size_t i = 0; i < n; i++)
+    {
+      dst[i] = (unsigned char)(clip(src[i], 0.0f, 255.0f));
+    }
+  }
+
+  //----------------------------------------------------------------
+  // floatToS16_scalar
+  //
+  static void
+  floatToS16_scalar(const float * src, std::size_t n, short int * dst)
+  {
+    for (std::size_t i = 0; i < n; i++)
+    {
+      dst[i] = (short int)(clip(src[i], -32768.0f, 32767.0f));
+    }
+  }
+
+  //----------------------------------------------------------------
+  // floatToS32_scalar
+  //
+  static void
+  floatToS32_scalar(const float * src, std::size_t n, int * dst)
+  {
+    for (std::size_t i = 0; i < n; i++)
+    {
+      dst[i] = (int)(clip(src[i], -2147483648.0f, kS32Max));
+    }
+  }
+
+  //----------------------------------------------------------------
+  // peakAbs_scalar
+  //
+  static void
+  peakAbs_scalar(const float * src,
+                 std::size_t frames,
+                 std::size_t channels,
+                 float max0,
+                 float * dst)
+  {
+    for (std::size_t i = 0; i < frames; i++, src += channels)
+    {
+      float max = src[0];
+      float s = std::min<float>(max0, fabsf(max));
+
+      for (std::size_t j = 1; j < channels; j++)
+      {
+        float ti = src[j];
+        float si = std::min<float>(max0, fabsf(ti));
+
+        // store max amplitude only:
+        if (s < si)
+        {
+          s = si;
+          max = ti;
+        }
+      }
+
+      dst[i] = max;
+    }
+  }
+
+  //----------------------------------------------------------------
+  // blend_scalar
+  //
+  static void
+  blend_scalar(const float * a,
+               const float * b,
+               const float * wa,
+               const float * wb,
+               std::size_t n,
+               float * dst)
+  {
+    for (std::size_t i = 0; i < n; i++)
+    {
+      dst[i] = a[i] * wa[i] + b[i] * wb[i];
+    }
+  }
+
+  //----------------------------------------------------------------
+  // crossSpectrum_scalar
+  //
+  static void
+  crossSpectrum_scalar(const float * xa,
+                       const float * xb,
+                       std::size_t n,
+                       float * xc)
+  {
+    for (std::size_t i = 0; i < n; i++, xa += 2, xb += 2, xc += 2)
+    {
+      xc[0] = (xa[0] * xb[0] + xa[1] * xb[1]);
+      xc[1] = (xa[1] * xb[0] - xa[0] * xb[1]);
+    }
+  }
+
+  //----------------------------------------------------------------
+  // correlationPeak_scalar
+  //
+  // continues the search from i, with the best candidate found so far:
+  //
+  static int
+  correlationPeak_scalar(const float * xc,
+                         int i,
+                         int i0,
+                         int i1,
+                         int drift,
+                         int best,
+                         float bestMetric)
+  {
+    for (; i < i1; i++)
+    {
+      float metric = xc[i];
+
+      // normalize:
+      float drifti = float(drift + i);
+      metric *= drifti * float(i - i0) * float(i1 - i);
+
+      if (metric > bestMetric)
+      {
+        bestMetric = metric;
+        best = i;
+      }
+    }
+
+    return best;
+  }
+
+  //----------------------------------------------------------------
+  // correlationPeak_scalar
+  //
+  static int
+  correlationPeak_scalar(const float * xc, int i0, int i1, int drift)
+  {
+    return correlationPeak_scalar(xc, i0, i0, i1, drift, -1, -FLT_MAX);
+  }
+
+  //----------------------------------------------------------------
+  // reducePeak
+  //
+  // pick the best lane, the lowest index wins a tie:
+  //
+  static void
+  reducePeak(const float * metric,
+             const int * index,
+             int lanes,
+             int & best,
+             float & bestMetric)
+  {
+    for (int i = 0; i < lanes; i++)
+    {
+      if (index[i] < 0)
+      {
+        continue;
+      }
+
+      if (metric[i] > bestMetric ||
+          (metric[i] == bestMetric && index[i] < best))
+      {
+        bestMetric = metric[i];
+        best = index[i];
+      }
+    }
+  }
+
+#if YAE_AUDIO_TEMPO_X86
+
+  //----------------------------------------------------------------
+  // u8ToFloat_sse2
+  //
+  YAE_TARGET_SSE2 static void
+  u8ToFloat_sse2(const unsigned char * src, std::size_t n, float * dst)
+  {
+    const __m128i zero = _mm_setzero_si128();
+
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+      __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+      __m128i lo = _mm_unpacklo_epi8(v, zero);
+      __m128i hi = _mm_unpackhi_epi8(v, zero);
+
+      __m128i a = _mm_unpacklo_epi16(lo, zero);
+      __m128i b = _mm_unpackhi_epi16(lo, zero);
+      __m128i c = _mm_unpacklo_epi16(hi, zero);
+      __m128i d = _mm_unpackhi_epi16(hi, zero);
+
+      _mm_storeu_ps(dst + i, _mm_cvtepi32_ps(a));
+      _mm_storeu_ps(dst + i + 4, _mm_cvtepi32_ps(b));
+      _mm_storeu_ps(dst + i + 8, _mm_cvtepi32_ps(c));
+      _mm_storeu_ps(dst + i + 12, _mm_cvtepi32_ps(d));
+    }
+
+    convert_scalar(src + i, n - i, dst + i);
+  }
+
+  //----------------------------------------------------------------
+  // s16ToFloat_sse2
+  //
+  YAE_TARGET_SSE2 static void
+  s16ToFloat_sse2(const short int * src, std::size_t n, float * dst)
+  {
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+      __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+
+      // sign-extend:
+      __m128i a = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+      __m128i b = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+
+      _mm_storeu_ps(dst + i, _mm_cvtepi32_ps(a));
+      _mm_storeu_ps(dst + i + 4, _mm_cvtepi32_ps(b));
+    }
+
+    convert_scalar(src + i, n - i, dst + i);
+  }
+
+  //----------------------------------------------------------------
+  // s32ToFloat_sse2
+  //
+  YAE_TARGET_SSE2 static void
+  s32ToFloat_sse2(const int * src, std::size_t n, float * dst)
+  {
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+      __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+      _mm_storeu_ps(dst + i, _mm_cvtepi32_ps(v));
+    }
+
+    convert_scalar(src + i, n - i, dst + i);
+  }
+
+  //----------------------------------------------------------------
+  // f64ToFloat_sse2
+  //
+  YAE_TARGET_SSE2 static void
+  f64ToFloat_sse2(const double * src, std::size_t n, float * dst)
+  {
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+      __m128 a = _mm_cvtpd_ps(_mm_loadu_pd(src + i));
+      __m128 b = _mm_cvtpd_ps(_mm_loadu_pd(src + i + 2));
+      _mm_storeu_ps(dst + i, _mm_movelh_ps(a, b));
+    }
+
+    convert_scalar(src + i, n - i, dst + i);
+  }
+
+  //----------------------------------------------------------------
+  // floatToU8_sse2
+  //
+  YAE_TARGET_SSE2 static void
+  floatToU8_sse2(const float * src, std::size_t n, unsigned char * dst)
+  {
+    const __m128 lo = _mm_set1_ps(0.0f);
+    const __m128 hi = _mm_set1_ps(255.0f);
+
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+      __m128 a = _mm_max_ps(_mm_min_ps(_mm_loadu_ps(src + i), hi), lo);
+      __m128 b = _mm_max_ps(_mm_min_ps(_mm_loadu_ps(src + i + 4), hi), lo);
+      __m128 c = _mm_max_ps(_mm_min_ps(_mm_loadu_ps(src + i + 8), hi), lo);
+      __m128 d = _mm_max_ps(_mm_min_ps(_mm_loadu_ps(src + i + 12), hi), lo);
+
+      __m128i ab = _mm_packs_epi32(_mm_cvttps_epi32(a), _mm_cvttps_epi32(b));
+      __m128i cd = _mm_packs_epi32(_mm_cvttps_epi32(c), _mm_cvttps_epi32(d));
+      _mm_storeu_si128((__m128i *)(dst + i), _mm_packus_epi16(ab, cd));
+    }
+
+    floatToU8_scalar(src + i, n - i, dst + i);
+  }
+
+  //----------------------------------------------------------------
+  // floatToS16_sse2
+  //
+  YAE_TARGET_SSE2 static void
+  floatToS16_sse2(const float * src, std::size_t n, short int * dst)
+  {
+    const __m128 lo = _mm_set1_ps(-32768.0f);
+    const __m128 hi = _mm_set1_ps(32767.0f);
+
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+      __m128 a = _mm_max_ps(_mm_min_ps(_mm_loadu_ps(src + i), hi), lo);
+      __m128 b = _mm_max_ps(_mm_min_ps(_mm_loadu_ps(src + i + 4), hi), lo);
+
+      __m128i ab = _mm_packs_epi32(_mm_cvttps_epi32(a), _mm_cvttps_epi32(b));
+      _mm_storeu_si128((__m128i *)(dst + i), ab);
+    }
+
+    floatToS16_scalar(src + i, n - i, dst + i);
+  }
+
+  //----------------------------------------------------------------
+  // floatToS32_sse2
+  //
+  YAE_TARGET_SSE2 static void
+  floatToS32_sse2(const float * src, std::size_t n, int * dst)
+  {
+    const __m128 lo = _mm_set1_ps(-2147483648.0f);
+    const __m128 hi = _mm_set1_ps(kS32Max);
+
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+      __m128 a = _mm_max_ps(_mm_min_ps(_mm_loadu_ps(src + i), hi), lo);
+      _mm_storeu_si128((__m128i *)(dst + i), _mm_cvttps_epi32(a));
+    }
+
+    floatToS32_scalar(src + i, n - i, dst + i);
+  }
+
+  //----------------------------------------------------------------
+  // floatToF64_sse2
+  //
+  YAE_TARGET_SSE2 static void
+  floatToF64_sse2(const float * src, std::size_t n, double * dst)
+  {
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+      __m128 v = _mm_loadu_ps(src + i);
+      _mm_storeu_pd(dst + i, _mm_cvtps_pd(v));
+      _mm_storeu_pd(dst + i + 2, _mm_cvtps_pd(_mm_movehl_ps(v, v)));
+    }
+
+    convert_scalar(src + i, n - i, dst + i);
+  }
+
+  //----------------------------------------------------------------
+  // peakAbs_sse2
+  //
+  // 4 frames at a time, one channel at a time:
+  //
+  YAE_TARGET_SSE2 static void
+  peakAbs_sse2(const float * src,
+               std::size_t frames,
+               std::size_t channels,
+               float max0,
+               float * dst)
+  {
+    const __m128 vmax0 = _mm_set1_ps(max0);
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    const std::size_t c = channels;
+
+    std::size_t i = 0;
+    if (c == 2)
+    {
+      for (; i + 4 <= frames; i += 4)
+      {
+        const float * p = src + i * 2;
+        __m128 x0 = _mm_loadu_ps(p);
+        __m128 x1 = _mm_loadu_ps(p + 4);
+        __m128 l = _mm_shuffle_ps(x0, x1, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 r = _mm_shuffle_ps(x0, x1, _MM_SHUFFLE(3, 1, 3, 1));
+
+        __m128 sl = _mm_min_ps(_mm_and_ps(l, absMask), vmax0);
+        __m128 sr = _mm_min_ps(_mm_and_ps(r, absMask), vmax0);
+        __m128 m = _mm_cmplt_ps(sl, sr);
+
+        _mm_storeu_ps(dst + i, _mm_or_ps(_mm_and_ps(m, r),
+                                         _mm_andnot_ps(m, l)));
+      }
+    }
+    else
+    {
+      for (; i + 4 <= frames; i += 4)
+      {
+        const float * p = src + i * c;
+        __m128 max = _mm_setr_ps(p[0], p[c], p[2 * c], p[3 * c]);
+        __m128 s = _mm_min_ps(_mm_and_ps(max, absMask), vmax0);
+
+        for (std::size_t j = 1; j < c; j++)
+        {
+          const float * q = p + j;
+          __m128 ti = _mm_setr_ps(q[0], q[c], q[2 * c], q[3 * c]);
+          __m128 si = _mm_min_ps(_mm_and_ps(ti, absMask), vmax0);
+          __m128 m = _mm_cmplt_ps(s, si);
+
+          s = _mm_or_ps(_mm_and_ps(m, si), _mm_andnot_ps(m, s));
+          max = _mm_or_ps(_mm_and_ps(m, ti), _mm_andnot_ps(m, max));
+        }
+
+        _mm_storeu_ps(dst + i, max);
+      }
+    }
+
+    peakAbs_scalar(src + i * c, frames - i, c, max0, dst + i);
+  }
+
+  //----------------------------------------------------------------
+  // blend_sse2
+  //
+  YAE_TARGET_SSE2 static void
+  blend_sse2(const float * a,
+             const float * b,
+             const float * wa,
+             const float * wb,
+             std::size_t n,
+             float * dst)
+  {
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+      __m128 ta = _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(wa + i));
+      __m128 tb = _mm_mul_ps(_mm_loadu_ps(b + i), _mm_loadu_ps(wb + i));
+      _mm_storeu_ps(dst + i, _mm_add_ps(ta, tb));
+    }
+
+    blend_scalar(a + i, b + i, wa + i, wb + i, n - i, dst + i);
+  }
+
+  //----------------------------------------------------------------
+  // crossSpectrum_sse2
+  //
+  YAE_TARGET_SSE2 static void
+  crossSpectrum_sse2(const float * xa,
+                     const float * xb,
+                     std::size_t n,
+                     float * xc)
+  {
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+      const float * pa = xa + i * 2;
+      const float * pb = xb + i * 2;
+
+      __m128 a0 = _mm_loadu_ps(pa);
+      __m128 a1 = _mm_loadu_ps(pa + 4);
+      __m128 b0 = _mm_loadu_ps(pb);
+      __m128 b1 = _mm_loadu_ps(pb + 4);
+
+      __m128 ar = _mm_shuffle_ps(a0, a1, _MM_SHUFFLE(2, 0, 2, 0));
+      __m128 ai = _mm_shuffle_ps(a0, a1, _MM_SHUFFLE(3, 1, 3, 1));
+      __m128 br = _mm_shuffle_ps(b0, b1, _MM_SHUFFLE(2, 0, 2, 0));
+      __m128 bi = _mm_shuffle_ps(b0, b1, _MM_SHUFFLE(3, 1, 3, 1));
+
+      __m128 re = _mm_add_ps(_mm_mul_ps(ar, br), _mm_mul_ps(ai, bi));
+      __m128 im = _mm_sub_ps(_mm_mul_ps(ai, br), _mm_mul_ps(ar, bi));
+
+      _mm_storeu_ps(xc + i * 2, _mm_unpacklo_ps(re, im));
+      _mm_storeu_ps(xc + i * 2 + 4, _mm_unpackhi_ps(re, im));
+    }
+
+    crossSpectrum_scalar(xa + i * 2, xb + i * 2, n - i, xc + i * 2);
+  }
+
+  //----------------------------------------------------------------
+  // correlationPeak_sse2
+  //
+  YAE_TARGET_SSE2 static int
+  correlationPeak_sse2(const float * xc, int i0, int i1, int drift)
+  {
+    int best = -1;
+    float bestMetric = -FLT_MAX;
+
+    int i = i0;
+    if (i + 4 <= i1)
+    {
+      const __m128i four = _mm_set1_epi32(4);
+      const __m128i vdrift = _mm_set1_epi32(drift);
+      const __m128i vi0 = _mm_set1_epi32(i0);
+      const __m128i vi1 = _mm_set1_epi32(i1);
+
+      __m128i vi = _mm_setr_epi32(i0, i0 + 1, i0 + 2, i0 + 3);
+      __m128 bm = _mm_set1_ps(-FLT_MAX);
+      __m128i bi = _mm_set1_epi32(-1);
+
+      for (; i + 4 <= i1; i += 4)
+      {
+        __m128 drifti = _mm_cvtepi32_ps(_mm_add_epi32(vdrift, vi));
+        __m128 p = _mm_cvtepi32_ps(_mm_sub_epi32(vi, vi0));
+        __m128 q = _mm_cvtepi32_ps(_mm_sub_epi32(vi1, vi));
+        __m128 w = _mm_mul_ps(_mm_mul_ps(drifti, p), q);
+        __m128 metric = _mm_mul_ps(_mm_loadu_ps(xc + i), w);
+
+        __m128 m = _mm_cmpgt_ps(metric, bm);
+        __m128i mi = _mm_castps_si128(m);
+        bm = _mm_or_ps(_mm_and_ps(m, metric), _mm_andnot_ps(m, bm));
+        bi = _mm_or_si128(_mm_and_si128(mi, vi), _mm_andnot_si128(mi, bi));
+
+        vi = _mm_add_epi32(vi, four);
+      }
+
+      float metric[4];
+      int index[4];
+      _mm_storeu_ps(metric, bm);
+      _mm_storeu_si128((__m128i *)index, bi);
+      reducePeak(metric, index, 4, best, bestMetric);
+    }
+
+    return correlationPeak_scalar(xc, i, i0, i1, drift, best, bestMetric);
+  }
+
+  //----------------------------------------------------------------
+  // u8ToFloat_avx2
+  //
+  YAE_TARGET_AVX2 static void
+  u8ToFloat_avx2(const unsigned char * src, std::size_t n, float * dst)
+  {
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+      __m128i v = _mm_loadl_epi64((const __m128i *)(src + i));
+      _mm256_storeu_ps(dst + i, _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(v)));
+    }
+
+    // the compiler may turn the scalar tail into a tail call and skip
+    // the implicit vzeroupper, the SSE code that follows would then
+    // pay the AVX-SSE transition penalty on every instruction:
+    _mm256_zeroupper();
+    convert_scalar(src + i, n - i, dst + i);
+  }
+
+  //----------------------------------------------------------------
+  // s16ToFloat_avx2
+  //
+  YAE_TARGET_AVX2 static void
+  s16ToFloat_avx2(const short int * src, std::size_t n, float * dst)
+  {
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+      __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+      _mm256_storeu_ps(dst + i, _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(v)));
+    }
+
+    _mm256_zeroupper();
+    convert_scalar(src + i, n - i, dst + i);
+  }
+
+  //----------------------------------------------------------------
+  // s32ToFloat_avx2
+  //
+  YAE_TARGET_AVX2 static void
+  s32ToFloat_avx2(const int * src, std::size_t n, float * dst)
+  {
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+      __m256i v = _mm256_loadu_si256((const __m256i *)(src + i));
+      _mm256_storeu_ps(dst + i, _mm256_cvtepi32_ps(v));
+    }
+
+    _mm256_zeroupper();
+    convert_scalar(src + i, n - i, dst + i);
+  }
+
+  //----------------------------------------------------------------
+  // f64ToFloat_avx2
+  //
+  YAE_TARGET_AVX2 static void
+  f64ToFloat_avx2(const double * src, std::size_t n, float * dst)
+  {
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+      __m128 a = _mm256_cvtpd_ps(_mm256_loadu_pd(src + i));
+      __m128 b = _mm256_cvtpd_ps(_mm256_loadu_pd(src + i + 4));
+      __m256 ab = _mm256_insertf128_ps(_mm256_castps128_ps256(a), b, 1);
+      _mm256_storeu_ps(dst + i, ab);
+    }
+
+    _mm256_zeroupper();
+    convert_scalar(src + i, n - i, dst + i);
+  }
+
+  //----------------------------------------------------------------
+  // floatToS16_avx2
+  //
+  YAE_TARGET_AVX2 static void
+  floatToS16_avx2(const float * src, std::size_t n, short int * dst)
+  {
+    const __m256 lo = _mm256_set1_ps(-32768.0f);
+    const __m256 hi = _mm256_set1_ps(32767.0f);
+
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+      __m256 a = _mm256_loadu_ps(src + i);
+      __m256 b = _mm256_loadu_ps(src + i + 8);
+      a = _mm256_max_ps(_mm256_min_ps(a, hi), lo);
+      b = _mm256_max_ps(_mm256_min_ps(b, hi), lo);
+
+      // packs works within 128-bit lanes, restore the order:
+      __m256i ab = _mm256_packs_epi32(_mm256_cvttps_epi32(a),
+                                      _mm256_cvttps_epi32(b));
+      ab = _mm256_permute4x64_epi64(ab, _MM_SHUFFLE(3, 1, 2, 0));
+      _mm256_storeu_si256((__m256i *)(dst + i), ab);
+    }
+
+    _mm256_zeroupper();
+    floatToS16_scalar(src + i, n - i, dst + i);
+  }
+
+  //----------------------------------------------------------------
+  // floatToS32_avx2
+  //
+  YAE_TARGET_AVX2 static void
+  floatToS32_avx2(const float * src, std::size_t n, int * dst)
+  {
+    const __m256 lo = _mm256_set1_ps(-2147483648.0f);
+    const __m256 hi = _mm256_set1_ps(kS32Max);
+
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+      __m256 a = _mm256_loadu_ps(src + i);
+      a = _mm256_max_ps(_mm256_min_ps(a, hi), lo);
+      _mm256_storeu_si256((__m256i *)(dst + i), _mm256_cvttps_epi32(a));
+    }
+
+    _mm256_zeroupper();
+    floatToS32_scalar(src + i, n - i, dst + i);
+  }
+
+  //----------------------------------------------------------------
+  // floatToF64_avx2
+  //
+  YAE_TARGET_AVX2 static void
+  floatToF64_avx2(const float * src, std::size_t n, double * dst)
+  {
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+      _mm256_storeu_pd(dst + i, _mm256_cvtps_pd(_mm_loadu_ps(src + i)));
+      _mm256_storeu_pd(dst + i + 4,
+                       _mm256_cvtps_pd(_mm_loadu_ps(src + i + 4)));
+    }
+
+    _mm256_zeroupper();
+    convert_scalar(src + i, n - i, dst + i);
+  }
+
+  //----------------------------------------------------------------
+  // peakAbs_avx2
+  //
+  // 8 frames at a time, one channel at a time:
+  //
+  YAE_TARGET_AVX2 static void
+  peakAbs_avx2(const float * src,
+               std::size_t frames,
+               std::size_t channels,
+               float max0,
+               float * dst)
+  {
+    const __m256 vmax0 = _mm256_set1_ps(max0);
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+    const std::size_t c = channels;
+
+    std::size_t i = 0;
+    if (c == 2)
+    {
+      for (; i + 8 <= frames; i += 8)
+      {
+        const float * p = src + i * 2;
+        __m256 x0 = _mm256_loadu_ps(p);
+        __m256 x1 = _mm256_loadu_ps(p + 8);
+
+        // frames 0 1 4 5 | 2 3 6 7:
+        __m256 l = _mm256_shuffle_ps(x0, x1, _MM_SHUFFLE(2, 0, 2, 0));
+        __m256 r = _mm256_shuffle_ps(x0, x1, _MM_SHUFFLE(3, 1, 3, 1));
+
+        __m256 sl = _mm256_min_ps(_mm256_and_ps(l, absMask), vmax0);
+        __m256 sr = _mm256_min_ps(_mm256_and_ps(r, absMask), vmax0);
+        __m256 m = _mm256_cmp_ps(sl, sr, _CMP_LT_OQ);
+        __m256 max = _mm256_blendv_ps(l, r, m);
+
+        // frames 0 1 2 3 | 4 5 6 7:
+        max = _mm256_castpd_ps
+          (_mm256_permute4x64_pd(_mm256_castps_pd(max),
+                                 _MM_SHUFFLE(3, 1, 2, 0)));
+        _mm256_storeu_ps(dst + i, max);
+      }
+    }
+    else if (c > 2 && c * 7 <= 0x7FFFFFFF)
+    {
+      const __m256i offsets =
+        _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+                           _mm256_set1_epi32(int(c)));
+
+      for (; i + 8 <= frames; i += 8)
+      {
+        const float * p = src + i * c;
+        __m256 max = _mm256_i32gather_ps(p, offsets, 4);
+        __m256 s = _mm256_min_ps(_mm256_and_ps(max, absMask), vmax0);
+
+        for (std::size_t j = 1; j < c; j++)
+        {
+          __m256 ti = _mm256_i32gather_ps(p + j, offsets, 4);
+          __m256 si = _mm256_min_ps(_mm256_and_ps(ti, absMask), vmax0);
+          __m256 m = _mm256_cmp_ps(s, si, _CMP_LT_OQ);
+
+          s = _mm256_blendv_ps(s, si, m);
+          max = _mm256_blendv_ps(max, ti, m);
+        }
+
+        _mm256_storeu_ps(dst + i, max);
+      }
+    }
+
+    _mm256_zeroupper();
+    peakAbs_scalar(src + i * c, frames - i, c, max0, dst + i);
+  }
+
+  //----------------------------------------------------------------
+  // blend_avx2
+  //
+  YAE_TARGET_AVX2 static void
+  blend_avx2(const float * a,
+             const float * b,
+             const float * wa,
+             const float * wb,
+             std::size_t n,
+             float * dst)
+  {
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+      // no FMA here, the rounding must match the other kernels:
+      __m256 ta = _mm256_mul_ps(_mm256_loadu_ps(a + i),
+                                _mm256_loadu_ps(wa + i));
+      __m256 tb = _mm256_mul_ps(_mm256_loadu_ps(b + i),
+                                _mm256_loadu_ps(wb + i));
+      _mm256_storeu_ps(dst + i, _mm256_add_ps(ta, tb));
+    }
+
+    _mm256_zeroupper();
+    blend_scalar(a + i, b + i, wa + i, wb + i, n - i, dst + i);
+  }
+
+  //----------------------------------------------------------------
+  // crossSpectrum_avx2
+  //
+  YAE_TARGET_AVX2 static void
+  crossSpectrum_avx2(const float * xa,
+                     const float * xb,
+                     std::size_t n,
+                     float * xc)
+  {
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+      const float * pa = xa + i * 2;
+      const float * pb = xb + i * 2;
+
+      __m256 a0 = _mm256_loadu_ps(pa);
+      __m256 a1 = _mm256_loadu_ps(pa + 8);
+      __m256 b0 = _mm256_loadu_ps(pb);
+      __m256 b1 = _mm256_loadu_ps(pb + 8);
+
+      // shuffles and unpacks both work within 128-bit lanes,
+      // so the order of the results is the same as the order
+      // of the inputs, no cross-lane permutation is needed:
+      __m256 ar = _mm256_shuffle_ps(a0, a1, _MM_SHUFFLE(2, 0, 2, 0));
+      __m256 ai = _mm256_shuffle_ps(a0, a1, _MM_SHUFFLE(3, 1, 3, 1));
+      __m256 br = _mm256_shuffle_ps(b0, b1, _MM_SHUFFLE(2, 0, 2, 0));
+      __m256 bi = _mm256_shuffle_ps(b0, b1, _MM_SHUFFLE(3, 1, 3, 1));
+
+      __m256 re = _mm256_add_ps(_mm256_mul_ps(ar, br), _mm256_mul_ps(ai, bi));
+      __m256 im = _mm256_sub_ps(_mm256_mul_ps(ai, br), _mm256_mul_ps(ar, bi));
+
+      _mm256_storeu_ps(xc + i * 2, _mm256_unpacklo_ps(re, im));
+      _mm256_storeu_ps(xc + i * 2 + 8, _mm256_unpackhi_ps(re, im));
+    }
+
+    _mm256_zeroupper();
+    crossSpectrum_scalar(xa + i * 2, xb + i * 2, n - i, xc + i * 2);
+  }
+
+  //----------------------------------------------------------------
+  // correlationPeak_avx2
+  //
+  YAE_TARGET_AVX2 static int
+  correlationPeak_avx2(const float * xc, int i0, int i1, int drift)
+  {
+    int best = -1;
+    float bestMetric = -FLT_MAX;
+
+    int i = i0;
+    if (i + 8 <= i1)
+    {
+      const __m256i eight = _mm256_set1_epi32(8);
+      const __m256i vdrift = _mm256_set1_epi32(drift);
+      const __m256i vi0 = _mm256_set1_epi32(i0);
+      const __m256i vi1 = _mm256_set1_epi32(i1);
+
+      __m256i vi = _mm256_add_epi32(vi0, _mm256_setr_epi32(0, 1, 2, 3,
+                                                           4, 5, 6, 7));
+      __m256 bm = _mm256_set1_ps(-FLT_MAX);
+      __m256i bi = _mm256_set1_epi32(-1);
+
+      for (; i + 8 <= i1; i += 8)
+      {
+        __m256 drifti = _mm256_cvtepi32_ps(_mm256_add_epi32(vdrift, vi));
+        __m256 p = _mm256_cvtepi32_ps(_mm256_sub_epi32(vi, vi0));
+        __m256 q = _mm256_cvtepi32_ps(_mm256_sub_epi32(vi1, vi));
+        __m256 w = _mm256_mul_ps(_mm256_mul_ps(drifti, p), q);
+        __m256 metric = _mm256_mul_ps(_mm256_loadu_ps(xc + i), w);
+
+        __m256 m = _mm256_cmp_ps(metric, bm, _CMP_GT_OQ);
+        bm = _mm256_blendv_ps(bm, metric, m);
+        bi = _mm256_blendv_epi8(bi, vi, _mm256_castps_si256(m));
+
+        vi = _mm256_add_epi32(vi, eight);
+      }
+
+      float metric[8];
+      int index[8];
+      _mm256_storeu_ps(metric, bm);
+      _mm256_storeu_si256((__m256i *)index, bi);
+      _mm256_zeroupper();
+      reducePeak(metric, index, 8, best, bestMetric);
+    }
+
+    return correlationPeak_scalar(xc, i, i0, i1, drift, best, bestMetric);
+  }
+
+#endif
+
+  //----------------------------------------------------------------
+  // kKernels
+  //
+  static const TKernelsImpl kKernels[] = {
+    { &convert_scalar<unsigned char, float>,
+      &convert_scalar<short int, float>,
+      &convert_scalar<int, float>,
+      &convert_scalar<double, float>,
+      &floatToU8_scalar,
+      &floatToS16_scalar,
+      &floatToS32_scalar,
+      &convert_scalar<float, double>,
+      &peakAbs_scalar,
+      &blend_scalar,
+      &crossSpectrum_scalar,
+      &correlationPeak_scalar },
+#if YAE_AUDIO_TEMPO_X86
+    { &u8ToFloat_sse2,
+      &s16ToFloat_sse2,
+      &s32ToFloat_sse2,
+      &f64ToFloat_sse2,
+      &floatToU8_sse2,
+      &floatToS16_sse2,
+      &floatToS32_sse2,
+      &floatToF64_sse2,
+      &peakAbs_sse2,
+      &blend_sse2,
+      &crossSpectrum_sse2,
+      &correlationPeak_sse2 },
+    { &u8ToFloat_avx2,
+      &s16ToFloat_avx2,
+      &s32ToFloat_avx2,
+      &f64ToFloat_avx2,
+      &floatToU8_sse2,
+      &floatToS16_avx2,
+      &floatToS32_avx2,
+      &floatToF64_avx2,
+      &peakAbs_avx2,
+      &blend_avx2,
+      &crossSpectrum_avx2,
+      &correlationPeak_avx2 },
+#endif
+  };
+
+  //----------------------------------------------------------------
+  // detectKernels
+  //
+  static TAudioTempoKernels::TKernels
+  detectKernels()
+  {
+#if YAE_AUDIO_TEMPO_X86
+#if defined(_MSC_VER)
+    int info[4] = { 0 };
+    __cpuid(info, 0);
+    const int maxLeaf = info[0];
+
+    __cpuid(info, 1);
+    const bool sse2 = (info[3] & (1 << 26)) != 0;
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+
+    bool avx2 = false;
+    if (maxLeaf >= 7 && osxsave && avx && (_xgetbv(0) & 6) == 6)
+    {
+      __cpuidex(info, 7, 0);
+      avx2 = (info[1] & (1 << 5)) != 0;
+    }
+#else
+    __builtin_cpu_init();
+    const bool sse2 = __builtin_cpu_supports("sse2");
+    const bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+
+    if (avx2)
+    {
+      return TAudioTempoKernels::kKernelsAVX2;
+    }
+
+    if (sse2)
+    {
+      return TAudioTempoKernels::kKernelsSSE2;
+    }
+#endif
+
+    return TAudioTempoKernels::kKernelsScalar;
+  }
+
+  //----------------------------------------------------------------
+  // supported_kernels
+  //
+  static const TAudioTempoKernels::TKernels
+  supported_kernels = detectKernels();
+
+  //----------------------------------------------------------------
+  // active_kernels
+  //
+  static boost::atomic<int> active_kernels(supported_kernels);
+
+  //----------------------------------------------------------------
+  // kernels
+  //
+  static inline const TKernelsImpl &
+  kernels()
+  {
+    return kKernels[active_kernels.load(boost::memory_order_relaxed)];
+  }
+
+  //----------------------------------------------------------------
+  // kBlockSize
+  //
+  // number of samples converted to floats at a time,
+  // small enough to stay in L1 cache:
+  //
+  enum { kBlockSize = 1024 };
+
+  //----------------------------------------------------------------
+  // to_float
+  //
+  static inline void
+  to_float(const TKernelsImpl & k,
+           const unsigned char * src,
+           std::size_t n,
+           float * dst)
+  { k.u8ToFloat_(src, n, dst); }
+
+  static inline void
+  to_float(const TKernelsImpl & k,
+           const short int * src,
+           std::size_t n,
+           float * dst)
+  { k.s16ToFloat_(src, n, dst); }
+
+  static inline void
+  to_float(const TKernelsImpl & k,
+           const int * src,
+           std::size_t n,
+           float * dst)
+  { k.s32ToFloat_(src, n, dst); }
+
+  static inline void
+  to_float(const TKernelsImpl & k,
+           const double * src,
+           std::size_t n,
+           float * dst)
+  { k.f64ToFloat_(src, n, dst); }
+
+  //----------------------------------------------------------------
+  // from_float
+  //
+  static inline void
+  from_float(const TKernelsImpl & k,
+             const float * src,
+             std::size_t n,
+             unsigned char * dst)
+  { k.floatToU8_(src, n, dst); }
+
+  static inline void
+  from_float(const TKernelsImpl & k,
+             const float * src,
+             std::size_t n,
+             short int * dst)
+  { k.floatToS16_(src, n, dst); }
+
+  static inline void
+  from_float(const TKernelsImpl & k,
+             const float * src,
+             std::size_t n,
+             int * dst)
+  { k.floatToS32_(src, n, dst); }
+
+  static inline void
+  from_float(const TKernelsImpl & k,
+             const float * src,
+             std::size_t n,
+             double * dst)
+  { k.floatToF64_(src, n, dst); }
+
+  //----------------------------------------------------------------
+  // downmix
+  //
+  template <typename TSample>
+  static void
+  downmix(const TKernelsImpl & k,
+          const TSample * src,
+          std::size_t frames,
+          std::size_t channels,
+          float max0,
+          float * dst)
+  {
+    if (channels == 1)
+    {
+      to_float(k, src, frames, dst);
+      return;
+    }
+
+    float block[kBlockSize];
+    std::vector<float> wide;
+    float * tmp = block;
+
+    std::size_t step = kBlockSize / channels;
+    if (!step)
+    {
+      wide.resize(channels);
+      tmp = &wide[0];
+      step = 1;
+    }
+
+    for (std::size_t i = 0; i < frames; i += step)
+    {
+      std::size_t n = std::min<std::size_t>(step, frames - i);
+      to_float(k, src + i * channels, n * channels, tmp);
+      k.peakAbs_(tmp, n, channels, max0, dst + i);
+    }
+  }
+
+  //----------------------------------------------------------------
+  // overlapAdd
+  //
+  template <typename TSample>
+  static void
+  overlapAdd(const TKernelsImpl & k,
+             const TSample * a,
+             const TSample * b,
+             const float * wa,
+             const float * wb,
+             std::size_t n,
+             TSample * dst)
+  {
+    float ta[kBlockSize];
+    float tb[kBlockSize];
+
+    for (std::size_t i = 0; i < n; i += kBlockSize)
+    {
+      std::size_t m = std::min<std::size_t>(kBlockSize, n - i);
+      to_float(k, a + i, m, ta);
+      to_float(k, b + i, m, tb);
+      k.blend_(ta, tb, wa + i, wb + i, m, ta);
+      from_float(k, ta, m, dst + i);
+    }
+  }
+
+
+  //----------------------------------------------------------------
+  // TAudioTempoKernels::supportedKernels
+  //
+  TAudioTempoKernels::TKernels
+  TAudioTempoKernels::supportedKernels()
+  {
+    return supported_kernels;
+  }
+
+  //----------------------------------------------------------------
+  // TAudioTempoKernels::activeKernels
+  //
+  TAudioTempoKernels::TKernels
+  TAudioTempoKernels::activeKernels()
+  {
+    return TKernels(active_kernels.load());
+  }
+
+  //----------------------------------------------------------------
+  // TAudioTempoKernels::useKernels
+  //
+  bool
+  TAudioTempoKernels::useKernels(TKernels kernels)
+  {
+    if (kernels < kKernelsScalar || kernels > supported_kernels)
+    {
+      return false;
+    }
+
+    active_kernels.store(kernels);
+    return true;
+  }
+
+  //----------------------------------------------------------------
+  // TAudioTempoKernels::downmix
+  //
+  void
+  TAudioTempoKernels::downmix(const unsigned char * src,
+                              std::size_t frames,
+                              std::size_t channels,
+                              float max0,
+                              float * dst)
+  {
+    yae::downmix(kernels(), src, frames, channels, max0, dst);
+  }
+
+  //----------------------------------------------------------------
+  // TAudioTempoKernels::downmix
+  //
+  void
+  TAudioTempoKernels::downmix(const short int * src,
+                              std::size_t frames,
+                              std::size_t channels,
+                              float max0,
+                              float * dst)
+  {
+    yae::downmix(kernels(), src, frames, channels, max0, dst);
+  }
+
+  //----------------------------------------------------------------
+  // TAudioTempoKernels::downmix
+  //
+  void
+  TAudioTempoKernels::downmix(const int * src,
+                              std::size_t frames,
+                              std::size_t channels,
+                              float max0,
+                              float * dst)
+  {
+    yae::downmix(kernels(), src, frames, channels, max0, dst);
+  }
+
+  //----------------------------------------------------------------
+  // TAudioTempoKernels::downmix
+  //
+  void
+  TAudioTempoKernels::downmix(const float * src,
+                              std::size_t frames,
+                              std::size_t channels,
+                              float max0,
+                              float * dst)
+  {
+    if (channels == 1)
+    {
+      memcpy(dst, src, frames * sizeof(float));
+      return;
+    }
+
+    kernels().peakAbs_(src, frames, channels, max0, dst);
+  }
+
+  //----------------------------------------------------------------
+  // TAudioTempoKernels::downmix
+  //
+  void
+  TAudioTempoKernels::downmix(const double * src,
+                              std::size_t frames,
+                              std::size_t channels,
+                              float max0,
+                              float * dst)
+  {
+    yae::downmix(kernels(), src, frames, channels, max0, dst);
+  }
+
+  //----------------------------------------------------------------
+  // TAudioTempoKernels::overlapAdd
+  //
+  void
+  TAudioTempoKernels::overlapAdd(const unsigned char * a,
+                                 const unsigned char * b,
+                                 const float * wa,
+                                 const float * wb,
+                                 std::size_t n,
+                                 unsigned char * dst)
+  {
+    yae::overlapAdd(kernels(), a, b, wa, wb, n, dst);
+  }
+
+  //----------------------------------------------------------------
+  // TAudioTempoKernels::overlapAdd
+  //
+  void
+  TAudioTempoKernels::overlapAdd(const short int * a,
+                                 const short int * b,
+                                 const float * wa,
+                                 const float * wb,
+                                 std::size_t n,
+                                 short int * dst)
+  {
+    yae::overlapAdd(kernels(), a, b, wa, wb, n, dst);
+  }
+
+  //----------------------------------------------------------------
+  // TAudioTempoKernels::overlapAdd
+  //
+  void
+  TAudioTempoKernels::overlapAdd(const int * a,
+                                 const int * b,
+                                 const float * wa,
+                                 const float * wb,
+                                 std::size_t n,
+                                 int * dst)
+  {
+    yae::overlapAdd(kernels(), a, b, wa, wb, n, dst);
+  }
+
+  //----------------------------------------------------------------
+  // TAudioTempoKernels::overlapAdd
+  //
+  void
+  TAudioTempoKernels::overlapAdd(const float * a,
+                                 const float * b,
+                                 const float * wa,
+                                 const float * wb,
+                                 std::size_t n,
+                                 float * dst)
+  {
+    kernels().blend_(a, b, wa, wb, n, dst);
+  }
+
+  //----------------------------------------------------------------
+  // TAudioTempoKernels::overlapAdd
+  //
+  void
+  TAudioTempoKernels::overlapAdd(const double * a,
+                                 const double * b,
+                                 const float * wa,
+                                 const float * wb,
+                                 std::size_t n,
+                                 double * dst)
+  {
+    yae::overlapAdd(kernels(), a, b, wa, wb, n, dst);
+  }
+
+  //----------------------------------------------------------------
+  // TAudioTempoKernels::crossSpectrum
+  //
+  void
+  TAudioTempoKernels::crossSpectrum(const float * xa,
+                                    const float * xb,
+                                    std::size_t n,
+                                    float * xc)
+  {
+    kernels().crossSpectrum_(xa, xb, n, xc);
+  }
+
+  //----------------------------------------------------------------
+  // TAudioTempoKernels::correlationPeak
+  //
+  int
+  TAudioTempoKernels::correlationPeak(const float * xc,
+                                      int i0,
+                                      int i1,
+                                      int drift)
+  {
+    if (i1 <= i0)
+    {
+      return -1;
+    }
+
+    return kernels().correlationPeak_(xc, i0, i1, drift);
+  }
+
+}
@@ -0,0 +1,139 @@
+// -*- Mode: c++; tab-width: 8; c-basic-offset: 2; indent-tabs-mode: nil -*-
+// NOTE: the first line of this file sets up source code indentation rules
+// for Emacs; it is also a hint to anyone modifying this file.
+
+// Created   : Fri Oct 16 21:05:52 MDT 2026
+// Copyright : Pavel Koshevoy
+// License   : MIT -- http://www.opensource.org/licenses/mit-license.php
+
+#ifndef YAE_AUDIO_TEMPO_KERNELS_H_
+#define YAE_AUDIO_TEMPO_KERNELS_H_
+
+// std includes:
+#include <cstddef>
+
+// yae includes:
+#include "../api/yae_api.h"
+
+
+namespace yae
+{
+
+  //----------------------------------------------------------------
+  // TAudioTempoKernels
+  //
+  // Inner loops of the WSOLA tempo filter, see AudioTempoFilter
+  // and AudioFragment.  Every kernel set produces exactly the same
+  // results, the best one supported by the CPU is used by default.
+  //
+  // Samples are interleaved, all channels of a frame are adjacent.
+  //
+  struct YAE_API TAudioTempoKernels
+  {
+    //----------------------------------------------------------------
+    // TKernels
+    //
+    enum TKernels
+    {
+      kKernelsScalar = 0,
+      kKernelsSSE2 = 1,
+      kKernelsAVX2 = 2
+    };
+
+    static TKernels supportedKernels();
+    static TKernels activeKernels();
+
+    // for testing and benchmarking,
+    // returns false if the CPU does not support the given kernels:
+    static bool useKernels(TKernels kernels);
+
+    // downmix to mono for fragment alignment -- keep the sample with
+    // the largest amplitude (clipped to max0) from each frame,
+    // the first channel wins a tie:
+    static void downmix(const unsigned char * src,
+                        std::size_t frames,
+                        std::size_t channels,
+                        float max0,
+                        float * dst);
+
+    static void downmix(const short int * src,
+                        std::size_t frames,
+                        std::size_t channels,
+                        float max0,
+                        float * dst);
+
+    static void downmix(const int * src,
+                        std::size_t frames,
+                        std::size_t channels,
+                        float max0,
+                        float * dst);
+
+    static void downmix(const float * src,
+                        std::size_t frames,
+                        std::size_t channels,
+                        float max0,
+                        float * dst);
+
+    static void downmix(const double * src,
+                        std::size_t frames,
+                        std::size_t channels,
+                        float max0,
+                        float * dst);
+
+    // dst[i] = a[i] * wa[i] + b[i] * wb[i], for i in [0, n),
+    // the sum is evaluated in single precision, integer results
+    // are clamped to the sample range and truncated:
+    static void overlapAdd(const unsigned char * a,
+                           const unsigned char * b,
+                           const float * wa,
+                           const float * wb,
+                           std::size_t n,
+                           unsigned char * dst);
+
+    static void overlapAdd(const short int * a,
+                           const short int * b,
+                           const float * wa,
+                           const float * wb,
+                           std::size_t n,
+                           short int * dst);
+
+    static void overlapAdd(const int * a,
+                           const int * b,
+                           const float * wa,
+                           const float * wb,
+                           std::size_t n,
+                           int * dst);
+
+    static void overlapAdd(const float * a,
+                           const float * b,
+                           const float * wa,
+                           const float * wb,
+                           std::size_t n,
+                           float * dst);
+
+    static void overlapAdd(const double * a,
+                           const double * b,
+                           const float * wa,
+                           const float * wb,
+                           std::size_t n,
+                           double * dst);
+
+    // xc[k] = xa[k] * conj(xb[k]), for n interleaved (re, im) pairs:
+    static void crossSpectrum(const float * xa,
+                              const float * xb,
+                              std::size_t n,
+                              float * xc);
+
+    // find the first i in [i0, i1) that maximizes
+    //   xc[i] * ((drift + i) * (i - i0) * (i1 - i))
+    // returns -1 if no metric exceeds -FLT_MAX:
+    static int correlationPeak(const float * xc,
+                               int i0,
+                               int i1,
+                               int drift);
+  };
+
+}
+
+
+#endif // YAE_AUDIO_TEMPO_KERNELS_H_
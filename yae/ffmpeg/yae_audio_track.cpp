@@ -409,8 +409,11 @@ namespace yae
       }
 #endif
 
-      // put the decoded frame into frame queue:
-      if (!frameQueue_.push(afPtr, &terminator_))
+      // put the decoded frame into frame queue,
+      // a pooled decoder must not block its worker:
+      if (pool_ ?
+          !parkedFrames_.push(frameQueue_, afPtr) :
+          !frameQueue_.push(afPtr, &terminator_))
       {
         return;
       }
@@ -423,6 +426,35 @@ namespace yae
     return;
   }
 
+  //----------------------------------------------------------------
+  // AudioTrack::deliverParkedFrames
+  //
+  bool
+  AudioTrack::deliverParkedFrames()
+  {
+    return parkedFrames_.deliver(frameQueue_);
+  }
+
+  //----------------------------------------------------------------
+  // AudioTrack::dropParkedFrames
+  //
+  void
+  AudioTrack::dropParkedFrames()
+  {
+    parkedFrames_.clear();
+  }
+
+  //----------------------------------------------------------------
+  // AudioTrack::observeFrameQueue
+  //
+  void
+  AudioTrack::observeFrameQueue(bool enable)
+  {
+    Track * track = this;
+    frameQueue_.setRoomObserver(enable ? &Track::decoderTaskObserver : NULL,
+                                enable ? track : NULL);
+  }
+
   //----------------------------------------------------------------
   // AudioTrack::threadStop
   //
@@ -615,23 +647,21 @@ namespace yae
       return true;
     }
 
-    bool alreadyDecoding = thread_.isRunning();
+    bool alreadyDecoding = threadIsRunning();
     YAE_ASSERT(!alreadyDecoding);
 
     if (alreadyDecoding)
     {
       terminator_.stopWaiting(true);
       frameQueue_.clear();
-      thread_.stop();
-      thread_.wait();
+      decoderSuspend();
     }
 
     override_ = override;
 
     if (alreadyDecoding)
     {
-      terminator_.stopWaiting(false);
-      return thread_.run();
+      return decoderResume();
     }
 
     return true;
@@ -739,6 +769,7 @@ namespace yae
       do { frameQueue_.clear(); }
       while (!packetQueue_.waitForConsumerToBlock(1e-2));
       frameQueue_.clear();
+      parkedFrames_.clear();
     }
 
 #if YAE_DEBUG_SEEKING_AND_FRAMESTEP
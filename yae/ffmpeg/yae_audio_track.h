@@ -20,6 +20,7 @@
 #include "yae/ffmpeg/yae_ffmpeg_utils.h"
 #include "yae/ffmpeg/yae_track.h"
 #include "yae/thread/yae_queue.h"
+#include "yae/thread/yae_ring_queue.h"
 
 
 namespace yae
@@ -28,7 +29,11 @@ namespace yae
   //----------------------------------------------------------------
   // TAudioFrameQueue
   //
+#ifdef YAE_USE_RING_QUEUE
+  typedef RingQueue<TAudioFramePtr> TAudioFrameQueue;
+#else
   typedef Queue<TAudioFramePtr> TAudioFrameQueue;
+#endif
 
 
   //----------------------------------------------------------------
@@ -78,7 +83,15 @@ namespace yae
     // adjust frame duration:
     bool setTempo(double tempo);
 
+  protected:
+    // virtual: pooled decoding support, see ParkedFrames:
+    bool deliverParkedFrames();
+    void dropParkedFrames();
+    void observeFrameQueue(bool enable);
+
+  public:
     TAudioFrameQueue frameQueue_;
+    ParkedFrames<TAudioFrameQueue> parkedFrames_;
     AudioTraits override_;
     AudioTraits native_;
     AudioTraits output_;
@@ -12,11 +12,16 @@
 #include <iomanip>
 #include <iterator>
 #include <limits>
+#include <sstream>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 // yae includes:
 #include "yae_demuxer.h"
 #include "yae_pixel_format_ffmpeg.h"
+#include "../utils/yae_benchmark.h"
+#include "../utils/yae_trace.h"
 #include "../utils/yae_utils.h"
 #include "../video/yae_pixel_format_traits.h"
 
@@ -405,6 +410,34 @@ namespace yae
     return program;
   }
 
+  //----------------------------------------------------------------
+  // Demuxer::getStream
+  //
+  AVStream *
+  Demuxer::getStream(const std::string & trackId) const
+  {
+    const AVFormatContext * ctx = context_.get();
+    if (!ctx)
+    {
+      return NULL;
+    }
+
+    for (unsigned int i = 0; i < ctx->nb_streams; i++)
+    {
+      AVStream * stream = ctx->streams[i];
+      TrackPtr track = getTrack(stream->index);
+      std::string track_id =
+        track ? track->id() : make_track_id('_', to_ + stream->index);
+
+      if (track_id == trackId)
+      {
+        return stream;
+      }
+    }
+
+    return NULL;
+  }
+
   //----------------------------------------------------------------
   // Demuxer::getVideoTrackInfo
   //
@@ -477,6 +510,9 @@ namespace yae
   int
   Demuxer::demux(AvPkt & pkt)
   {
+    YAE_PROBE(probe, "Demuxer::demux");
+    YAE_TRACE_SPAN(span, "Demuxer::demux");
+
     AVPacket & packet = pkt.get();
     int err = av_read_frame(context_.get(), &packet);
 
@@ -1343,7 +1379,8 @@ namespace yae
   PacketBuffer::PacketBuffer(const TDemuxerPtr & demuxer, double buffer_sec):
     demuxer_(demuxer),
     buffer_sec_(buffer_sec),
-    gave_up_(false)
+    gave_up_(false),
+    pool_(new PacketPool())
   {
     init_program_buffers();
   }
@@ -1401,7 +1438,8 @@ namespace yae
   //
   PacketBuffer::PacketBuffer(const PacketBuffer & pb):
     buffer_sec_(pb.buffer_sec_),
-    gave_up_(false)
+    gave_up_(false),
+    pool_(new PacketPool())
   {
     if (pb.demuxer())
     {
@@ -1568,7 +1606,7 @@ namespace yae
         break;
       }
 
-      TPacketPtr packet_ptr(new AvPkt());
+      TPacketPtr packet_ptr = pool_->get();
       AvPkt & pkt = *packet_ptr;
       pkt.pbuffer_ = this;
 
@@ -2124,14 +2162,16 @@ namespace yae
   // DemuxerBuffer::DemuxerBuffer
   //
   DemuxerBuffer::DemuxerBuffer(const TDemuxerPtr & src, double buffer_sec):
-    src_(src, buffer_sec)
+    src_(src, buffer_sec),
+    keyframe_seek_(false)
   {}
 
   //----------------------------------------------------------------
   // DemuxerBuffer::DemuxerBuffer
   //
   DemuxerBuffer::DemuxerBuffer(const DemuxerBuffer & d):
-    src_(d.src_)
+    src_(d.src_),
+    keyframe_seek_(d.keyframe_seek_)
   {
     if (d.summary_)
     {
@@ -2162,11 +2202,50 @@ namespace yae
 
     if (!trackId.empty())
     {
-      // if the input format implements seeking by PTS,
-      // then convert given seekTime (referencing DTS timeline) to PTS,
       const AVFormatContext & context = src_.context();
+      const int format_flags = context.iformat->flags;
+      const bool seek_to_pts =
+        (format_flags & AVFMT_SEEK_TO_PTS) == AVFMT_SEEK_TO_PTS;
+
+      // the summary timeline knows where every keyframe is,
+      // so seek straight to the keyframe a decoder has to start from:
+      const Timeline::Track * track =
+        (keyframe_seek_ &&
+         summary_ &&
+         yae::has(summary_->trk_prog_, trackId) &&
+         (seekFlags & (AVSEEK_FLAG_BYTE |
+                       AVSEEK_FLAG_FRAME |
+                       AVSEEK_FLAG_ANY)) == 0) ?
+        &(summary_->get_track_timeline(trackId)) : NULL;
+
+      std::size_t k = 0;
+      if (track && track->find_keyframe_by_dts(dts, k))
+      {
+        const int64 pos = track->get_pos(k);
+
+        // formats without a native index (mpeg-ts, mpeg-ps) seek
+        // by timestamp with a binary search that reads packets,
+        // the recorded byte position skips all of that:
+        if (pos >= 0 &&
+            (format_flags & AVFMT_TS_DISCONT) == AVFMT_TS_DISCONT &&
+            (format_flags & AVFMT_NO_BYTE_SEEK) == 0)
+        {
+          int err = src_.seek(AVSEEK_FLAG_BYTE, TTime(pos, 1), trackId);
+          if (err >= 0)
+          {
+            return err;
+          }
+        }
 
-      if ((context.iformat->flags & AVFMT_SEEK_TO_PTS) == AVFMT_SEEK_TO_PTS)
+        // otherwise seek to the exact keyframe timestamp,
+        // so the demuxer lands on it and not on an earlier keyframe:
+        seekTime = seek_to_pts ? track->pts_[k] : track->dts_[k];
+        return src_.seek(seekFlags | AVSEEK_FLAG_BACKWARD, seekTime, trackId);
+      }
+
+      // if the input format implements seeking by PTS,
+      // then convert given seekTime (referencing DTS timeline) to PTS,
+      if (seek_to_pts)
       {
         const DemuxerSummary & summary = this->summary();
         const Timeline::Track & track = summary.get_track_timeline(trackId);
@@ -2312,10 +2391,15 @@ namespace yae
   //----------------------------------------------------------------
   // summarize
   //
-  void
+  // when resume is true the summary already holds the timeline
+  // of a previous scan of the same (since grown) source,
+  // and only the packets past the end of it are analyzed:
+  //
+  static void
   summarize(DemuxerInterface & demuxer,
             DemuxerSummary & summary,
-            double tolerance)
+            double tolerance,
+            bool resume)
   {
     // get current time position:
     TTime saved_pos;
@@ -2329,13 +2413,48 @@ namespace yae
       }
     }
 
-    // analyze from the start:
-    demuxer.seek(AVSEEK_FLAG_BACKWARD, TTime(0, 1));
+    // last known DTS per track, and where to resume from:
+    std::map<std::string, TTime> resume_after;
+    TTime resume_pos = TTime::max_flicks();
+
+    for (std::map<int, Timeline>::const_iterator
+           i = summary.timeline_.begin();
+         resume && i != summary.timeline_.end(); ++i)
+    {
+      const Timeline & timeline = i->second;
+      for (Timeline::TTracks::const_iterator
+             j = timeline.tracks_.begin(); j != timeline.tracks_.end(); ++j)
+      {
+        const Timeline::Track & track = j->second;
+        if (!track.dts_.empty())
+        {
+          resume_after[j->first] = track.dts_.back();
+          resume_pos = std::min(resume_pos, track.dts_.back());
+        }
+      }
+    }
+
+    // back off a little, packets of different tracks are not
+    // perfectly interleaved, and the seek lands on a keyframe:
+    resume = (!resume_after.empty() &&
+              demuxer.seek(AVSEEK_FLAG_BACKWARD,
+                           resume_pos - TTime(1, 1)) >= 0);
+
+    if (!resume)
+    {
+      // analyze from the start:
+      summary.streams_.clear();
+      summary.fps_.clear();
+      summary.timeline_.clear();
+      demuxer.seek(AVSEEK_FLAG_BACKWARD, TTime(0, 1));
+    }
+
     analyze_timeline(demuxer,
                      summary.streams_,
                      summary.fps_,
                      summary.timeline_,
-                     tolerance);
+                     tolerance,
+                     resume ? &resume_after : NULL);
 
     // restore previous time position:
     demuxer.seek(AVSEEK_FLAG_BACKWARD, saved_pos);
@@ -2344,13 +2463,485 @@ namespace yae
     get_rewind_info(demuxer, summary.rewind_.first, summary.rewind_.second);
   }
 
+  //----------------------------------------------------------------
+  // summarize
+  //
+  void
+  summarize(DemuxerInterface & demuxer,
+            DemuxerSummary & summary,
+            double tolerance)
+  {
+    yae::summarize(demuxer, summary, tolerance, false);
+  }
+
+
+  //----------------------------------------------------------------
+  // index_cache_mutex
+  //
+  static boost::mutex index_cache_mutex;
+
+  //----------------------------------------------------------------
+  // index_cache_folder
+  //
+  static std::string
+  index_cache_folder()
+  {
+    // disabled unless asked for:
+    const char * env = getenv("YAE_INDEX_CACHE");
+    return env ? std::string(env) : std::string();
+  }
+
+  //----------------------------------------------------------------
+  // default_demuxer_index_cache
+  //
+  std::string
+  default_demuxer_index_cache()
+  {
+    const char * env = NULL;
+
+#ifdef _WIN32
+    env = getenv("LOCALAPPDATA");
+    if (env && *env)
+    {
+      return (fs::path(env) / "yae" / "index").string();
+    }
+#else
+    env = getenv("XDG_CACHE_HOME");
+    if (env && *env)
+    {
+      return (fs::path(env) / "yae" / "index").string();
+    }
+
+    env = getenv("HOME");
+    if (env && *env)
+    {
+      return (fs::path(env) / ".cache" / "yae" / "index").string();
+    }
+#endif
+
+    return std::string();
+  }
+
+  //----------------------------------------------------------------
+  // index_cache
+  //
+  static std::string &
+  index_cache()
+  {
+    // must hold index_cache_mutex:
+    static std::string folder = index_cache_folder();
+    return folder;
+  }
+
+  //----------------------------------------------------------------
+  // set_demuxer_index_cache
+  //
+  void
+  set_demuxer_index_cache(const std::string & folder)
+  {
+    boost::lock_guard<boost::mutex> lock(index_cache_mutex);
+    index_cache() = folder;
+  }
+
+  //----------------------------------------------------------------
+  // get_demuxer_index_cache
+  //
+  std::string
+  get_demuxer_index_cache()
+  {
+    boost::lock_guard<boost::mutex> lock(index_cache_mutex);
+    return index_cache();
+  }
+
+  //----------------------------------------------------------------
+  // fnv1a
+  //
+  static uint64
+  fnv1a(const void * data,
+        std::size_t size,
+        uint64 h = UINT64_C(14695981039346656037))
+  {
+    const unsigned char * src = (const unsigned char *)data;
+    for (const unsigned char * end = src + size; src < end; ++src)
+    {
+      h ^= *src;
+      h *= UINT64_C(1099511628211);
+    }
+
+    return h;
+  }
+
+  //----------------------------------------------------------------
+  // hash_file_range
+  //
+  // hash of up to 64KB of file content starting at a given offset,
+  // used to verify that the content indexed earlier is unchanged:
+  //
+  static bool
+  hash_file_range(const std::string & path,
+                  uint64 offset,
+                  std::size_t size,
+                  uint64 & hash)
+  {
+    FILE * file = fopenUtf8(path.c_str(), "rb");
+    if (!file)
+    {
+      return false;
+    }
+
+#ifdef _WIN32
+    bool ok = (_fseeki64(file, int64(offset), SEEK_SET) == 0);
+#else
+    bool ok = (fseeko(file, off_t(offset), SEEK_SET) == 0);
+#endif
+
+    std::vector<unsigned char> data(std::min<std::size_t>(size, 65536));
+    ok = ok && (yae::read(file, &data[0], data.size()) == data.size());
+    fclose(file);
+
+    hash = ok ? fnv1a(&data[0], data.size()) : 0;
+    return ok;
+  }
+
+  //----------------------------------------------------------------
+  // kIndexMagic
+  //
+  static const char kIndexMagic[] = "yaeindex";
+
+  //----------------------------------------------------------------
+  // kIndexVersion
+  //
+  static const uint64 kIndexVersion = 2;
+
+  //----------------------------------------------------------------
+  // kIndexTailSize
+  //
+  // size of the tail of the indexed region that is re-hashed
+  // to verify that a grown file is the same file:
+  //
+  static const uint64 kIndexTailSize = 4096;
+
+  //----------------------------------------------------------------
+  // DemuxerIndex::DemuxerIndex
+  //
+  DemuxerIndex::DemuxerIndex(const std::string & path,
+                             uint64 track_offset,
+                             double tolerance,
+                             const std::string & folder):
+    path_(path),
+    track_offset_(track_offset),
+    tolerance_(int64(tolerance * 1e6)),
+    size_(0),
+    mtime_(0),
+    head_(0)
+  {
+    if (folder.empty() || path_.empty())
+    {
+      return;
+    }
+
+    boost::system::error_code ec;
+    fs::path src(path_);
+    if (!fs::is_regular_file(src, ec))
+    {
+      return;
+    }
+
+    size_ = fs::file_size(src, ec);
+    if (ec || !size_)
+    {
+      return;
+    }
+
+    mtime_ = int64(fs::last_write_time(src, ec));
+    if (ec)
+    {
+      return;
+    }
+
+    if (!hash_file_range(path_, 0, std::min<uint64>(size_, 65536), head_))
+    {
+      return;
+    }
+
+    std::string key = str(path_, track_offset_);
+    uint64 h = fnv1a(key.data(), key.size());
+
+    std::ostringstream oss;
+    oss << std::hex << std::setw(16) << std::setfill('0') << h << ".yaeidx";
+    cache_ = (fs::path(folder) / oss.str()).string();
+  }
+
+  //----------------------------------------------------------------
+  // DemuxerIndex::save_header
+  //
+  void
+  DemuxerIndex::save_header(std::ostream & os) const
+  {
+    os.write(kIndexMagic, sizeof(kIndexMagic) - 1);
+    save_uint(os, kIndexVersion);
+    save_str(os, path_);
+    save_uint(os, track_offset_);
+    save_int(os, tolerance_);
+    save_uint(os, size_);
+    save_int(os, mtime_);
+    save_uint(os, head_);
+  }
+
+  //----------------------------------------------------------------
+  // DemuxerIndex::load
+  //
+  DemuxerIndex::Match
+  DemuxerIndex::load(DemuxerSummary & summary) const
+  {
+    YAE_PROBE(probe, "DemuxerIndex::load");
+
+    if (cache_.empty())
+    {
+      return kNoMatch;
+    }
+
+    std::string data;
+    {
+      FILE * file = fopenUtf8(cache_.c_str(), "rb");
+      if (!file)
+      {
+        return kNoMatch;
+      }
+
+      data = yae::read(file);
+      fclose(file);
+    }
+
+    std::istringstream iss(data);
+
+    char magic[sizeof(kIndexMagic) - 1] = { 0 };
+    iss.read(magic, sizeof(magic));
+    if (!iss || memcmp(magic, kIndexMagic, sizeof(magic)) != 0)
+    {
+      return kNoMatch;
+    }
+
+    uint64 version = 0;
+    std::string path;
+    uint64 track_offset = 0;
+    int64 tolerance = 0;
+    uint64 size = 0;
+    int64 mtime = 0;
+    uint64 head = 0;
+    uint64 tail = 0;
+
+    if (!(load_uint(iss, version) &&
+          version == kIndexVersion &&
+          load_str(iss, path) &&
+          load_uint(iss, track_offset) &&
+          load_int(iss, tolerance) &&
+          load_uint(iss, size) &&
+          load_int(iss, mtime) &&
+          load_uint(iss, head) &&
+          load_uint(iss, tail)))
+    {
+      return kNoMatch;
+    }
+
+    if (path != path_ ||
+        track_offset != track_offset_ ||
+        tolerance != tolerance_ ||
+        head != head_ ||
+        size > size_)
+    {
+      return kNoMatch;
+    }
+
+    Match match = kExactMatch;
+    if (size != size_ || mtime != mtime_)
+    {
+      // the file has been modified since it was indexed,
+      // reuse the index only if the file has grown
+      // and the indexed content appears to be unchanged:
+      uint64 offset = (size < kIndexTailSize) ? 0 : size - kIndexTailSize;
+      uint64 actual = 0;
+
+      if (size == size_ ||
+          !hash_file_range(path_, offset, size - offset, actual) ||
+          actual != tail)
+      {
+        return kNoMatch;
+      }
+
+      match = kPrefixMatch;
+    }
+
+    std::map<int, Timeline> timeline;
+    std::map<std::string, FramerateEstimator> fps;
+
+    uint64 num_programs = 0;
+    if (!load_uint(iss, num_programs))
+    {
+      return kNoMatch;
+    }
+
+    for (uint64 i = 0; i < num_programs; i++)
+    {
+      int64 prog_id = 0;
+      if (!(load_int(iss, prog_id) &&
+            timeline[int(prog_id)].load(iss)))
+      {
+        return kNoMatch;
+      }
+    }
+
+    uint64 num_fps = 0;
+    if (!load_uint(iss, num_fps))
+    {
+      return kNoMatch;
+    }
+
+    for (uint64 i = 0; i < num_fps; i++)
+    {
+      std::string track_id;
+      if (!(load_str(iss, track_id) &&
+            fps[track_id].load(iss)))
+      {
+        return kNoMatch;
+      }
+    }
+
+    summary.timeline_.swap(timeline);
+    summary.fps_.swap(fps);
+    return match;
+  }
+
+  //----------------------------------------------------------------
+  // DemuxerIndex::save
+  //
+  bool
+  DemuxerIndex::save(const DemuxerSummary & summary) const
+  {
+    YAE_PROBE(probe, "DemuxerIndex::save");
+
+    if (cache_.empty())
+    {
+      return false;
+    }
+
+    uint64 offset = (size_ < kIndexTailSize) ? 0 : size_ - kIndexTailSize;
+    uint64 tail = 0;
+    if (!hash_file_range(path_, offset, size_ - offset, tail))
+    {
+      return false;
+    }
+
+    std::ostringstream oss;
+    save_header(oss);
+    save_uint(oss, tail);
+
+    save_uint(oss, summary.timeline_.size());
+    for (std::map<int, Timeline>::const_iterator
+           i = summary.timeline_.begin(); i != summary.timeline_.end(); ++i)
+    {
+      save_int(oss, i->first);
+      i->second.save(oss);
+    }
+
+    save_uint(oss, summary.fps_.size());
+    for (std::map<std::string, FramerateEstimator>::const_iterator
+           i = summary.fps_.begin(); i != summary.fps_.end(); ++i)
+    {
+      save_str(oss, i->first);
+      i->second.save(oss);
+    }
+
+    boost::system::error_code ec;
+    fs::create_directories(fs::path(cache_).parent_path(), ec);
+
+    // write to a temporary file first, then rename it,
+    // so that concurrent readers never see a partial index:
+    std::string tmp = str(cache_, ".tmp");
+    {
+      FILE * file = fopenUtf8(tmp.c_str(), "wb");
+      if (!file)
+      {
+        return false;
+      }
+
+      bool ok = yae::write(file, oss.str());
+      ok = (fclose(file) == 0) && ok;
+
+      if (!ok)
+      {
+        fs::remove(fs::path(tmp), ec);
+        return false;
+      }
+    }
+
+    fs::remove(fs::path(cache_), ec);
+    return renameUtf8(tmp.c_str(), cache_.c_str()) == 0;
+  }
+
+  //----------------------------------------------------------------
+  // get_indexed_streams
+  //
+  // every indexed track must still be present:
+  //
+  static bool
+  get_indexed_streams(const Demuxer & demuxer, DemuxerSummary & summary)
+  {
+    for (std::map<int, Timeline>::const_iterator
+           i = summary.timeline_.begin(); i != summary.timeline_.end(); ++i)
+    {
+      const Timeline::TTracks & tracks = i->second.tracks_;
+      for (Timeline::TTracks::const_iterator
+             j = tracks.begin(); j != tracks.end(); ++j)
+      {
+        const std::string & track_id = j->first;
+        const AVStream * stream = demuxer.getStream(track_id);
+        if (!stream)
+        {
+          return false;
+        }
+
+        summary.streams_[track_id] = stream;
+      }
+    }
+
+    return true;
+  }
+
   //----------------------------------------------------------------
   // DemuxerBuffer::summarize
   //
   void
   DemuxerBuffer::summarize(DemuxerSummary & summary, double tolerance)
   {
-    yae::summarize(*this, summary, tolerance);
+    const Demuxer & demuxer = *(src_.demuxer());
+    DemuxerIndex index(demuxer.resourcePath(),
+                       demuxer.track_offset(),
+                       tolerance);
+
+    DemuxerIndex::Match match = index.load(summary);
+    if (match != DemuxerIndex::kNoMatch &&
+        !get_indexed_streams(demuxer, summary))
+    {
+      summary.timeline_.clear();
+      summary.fps_.clear();
+      summary.streams_.clear();
+      match = DemuxerIndex::kNoMatch;
+    }
+
+    if (match == DemuxerIndex::kExactMatch)
+    {
+      // get the track id and time position of the "first" packet:
+      get_rewind_info(*this, summary.rewind_.first, summary.rewind_.second);
+    }
+    else
+    {
+      yae::summarize(*this,
+                     summary,
+                     tolerance,
+                     match == DemuxerIndex::kPrefixMatch);
+      index.save(summary);
+    }
 
     src_.get_decoders(summary.decoders_);
     src_.get_chapters(summary.chapters_);
@@ -2494,7 +3085,8 @@ namespace yae
                    std::map<std::string, const AVStream *> & streams,
                    std::map<std::string, FramerateEstimator> & fps,
                    std::map<int, Timeline> & programs,
-                   double tolerance)
+                   double tolerance,
+                   const std::map<std::string, TTime> * resume_after)
   {
     while (true)
     {
@@ -2534,6 +3126,18 @@ namespace yae
       bool ok = dts_ok || pts_ok;
       YAE_ASSERT(ok);
 
+      if (ok && resume_after)
+      {
+        std::map<std::string, TTime>::const_iterator
+          found = resume_after->find(pkt.trackId_);
+
+        if (found != resume_after->end() && !(found->second < dts))
+        {
+          // already analyzed:
+          continue;
+        }
+      }
+
       TTime dur(src->time_base.num * packet.duration,
                 src->time_base.den);
 
@@ -2556,28 +3160,31 @@ namespace yae
                             dts,
                             pts,
                             dur,
-                            tolerance);
+                            tolerance,
+                            packet.pos);
       }
     }
   }
 
   //----------------------------------------------------------------
-  // remux
+  // open_muxer
   //
-  int
-  remux(const char * output_path, DemuxerInterface & demuxer)
+  // setup output streams, programs, chapters and metadata
+  // from the demuxer summary, open the output and write the header:
+  //
+  static int
+  open_muxer(AvOutputContextPtr & muxer_ptr,
+             std::map<std::string, AVStream *> & lut,
+             const char * output_path,
+             const DemuxerSummary & summary)
   {
-    // shortcut:
-    const DemuxerSummary & summary = demuxer.summary();
-
-    AvOutputContextPtr muxer_ptr(avformat_alloc_context());
+    muxer_ptr.reset(avformat_alloc_context());
 
     // setup output format:
     AVFormatContext * muxer = muxer_ptr.get();
     muxer->oformat = av_guess_format(NULL, output_path, NULL);
 
     // setup output streams:
-    std::map<std::string, AVStream *> lut;
     for (std::map<std::string, const AVStream *>::const_iterator
            i = summary.streams_.begin(); i != summary.streams_.end(); ++i)
     {
@@ -2710,6 +3317,138 @@ namespace yae
       return err;
     }
 
+    return 0;
+  }
+
+  //----------------------------------------------------------------
+  // MuxerPacket
+  //
+  struct MuxerPacket
+  {
+    MuxerPacket(const TPacketPtr & packet_ptr = TPacketPtr(),
+                const AVStream * src = NULL):
+      packet_ptr_(packet_ptr),
+      src_(src)
+    {}
+
+    TPacketPtr packet_ptr_;
+    const AVStream * src_;
+  };
+
+  //----------------------------------------------------------------
+  // MuxerThread
+  //
+  // writes packets to the muxer in the order they were queued,
+  // a NULL packet marks the end of the input:
+  //
+  struct MuxerThread
+  {
+    MuxerThread(AVFormatContext * muxer,
+                const std::map<std::string, AVStream *> & lut,
+                const char * output_path,
+                std::size_t queue_size):
+      muxer_(muxer),
+      lut_(lut),
+      output_path_(output_path),
+      queue_(std::max<std::size_t>(1, queue_size)),
+      thread_(this)
+    {
+      queue_.open();
+    }
+
+    void threadLoop()
+    {
+      YAE_TRACE_SPAN(span, "MuxerThread::threadLoop");
+
+      while (true)
+      {
+        MuxerPacket data;
+        if (!queue_.pop(data) || !data.packet_ptr_)
+        {
+          break;
+        }
+
+        AvPkt pkt(*data.packet_ptr_);
+        AVPacket & packet = pkt.get();
+        const AVStream * src = data.src_;
+
+        AVStream * dst = get(lut_, pkt.trackId_);
+        packet.stream_index = dst->index;
+
+        packet.dts = av_rescale_q(packet.dts, src->time_base, dst->time_base);
+        packet.pts = av_rescale_q(packet.pts, src->time_base, dst->time_base);
+        packet.duration = av_rescale_q(packet.duration,
+                                       src->time_base,
+                                       dst->time_base);
+
+        int err = av_interleaved_write_frame(muxer_, &packet);
+        if (err < 0)
+        {
+          av_log(NULL, AV_LOG_ERROR,
+                 "av_interleaved_write_frame(%s) error %i: \"%s\"\n",
+                 output_path_, err, yae::av_strerr(err).c_str());
+          YAE_ASSERT(false);
+        }
+      }
+    }
+
+    AVFormatContext * muxer_;
+    const std::map<std::string, AVStream *> & lut_;
+    const char * output_path_;
+    Queue<MuxerPacket> queue_;
+    Thread<MuxerThread> thread_;
+  };
+
+  //----------------------------------------------------------------
+  // RemuxOptions::RemuxOptions
+  //
+  RemuxOptions::RemuxOptions():
+    keyframes_ext_("png"),
+    envelope_w_(0),
+    envelope_h_(0),
+    workers_(0),
+    muxer_queue_size_(256)
+  {}
+
+  //----------------------------------------------------------------
+  // remux
+  //
+  int
+  remux(DemuxerInterface & demuxer, const RemuxOptions & options)
+  {
+    YAE_PROBE(probe, "remux");
+
+    // shortcut:
+    const DemuxerSummary & summary = demuxer.summary();
+    const char * output_path = options.output_path_.c_str();
+
+    AvOutputContextPtr muxer_ptr;
+    std::map<std::string, AVStream *> lut;
+    boost::shared_ptr<MuxerThread> muxer_thread;
+
+    if (!options.output_path_.empty())
+    {
+      int err = open_muxer(muxer_ptr, lut, output_path, summary);
+      if (err < 0)
+      {
+        return err;
+      }
+
+      muxer_thread.reset(new MuxerThread(muxer_ptr.get(),
+                                         lut,
+                                         output_path,
+                                         options.muxer_queue_size_));
+      muxer_thread->thread_.run();
+    }
+
+    boost::shared_ptr<KeyframeSaver> keyframe_saver;
+    if (!options.keyframes_folder_.empty())
+    {
+      keyframe_saver.reset(new KeyframeSaver(options.workers_));
+    }
+
+    bool keyframes_failed = false;
+
     // start from the beginning:
     demuxer.seek(AVSEEK_FLAG_BACKWARD,
                  summary.rewind_.second,
@@ -2718,41 +3457,83 @@ namespace yae
     while (true)
     {
       AVStream * src = NULL;
-      TPacketPtr packet_ptr = demuxer.get(src);
+      TPacketPtr packet_ptr;
+      {
+        YAE_TRACE_SPAN(span, "remux::demux");
+        packet_ptr = demuxer.get(src);
+      }
+
       if (!packet_ptr)
       {
         break;
       }
 
-      AvPkt pkt(*packet_ptr);
-      AVPacket & packet = pkt.get();
-
-      AVStream * dst = get(lut, pkt.trackId_);
-      packet.stream_index = dst->index;
+      const AvPkt & pkt = *packet_ptr;
+      const AVPacket & packet = pkt.get();
 
-      packet.dts = av_rescale_q(packet.dts, src->time_base, dst->time_base);
-      packet.pts = av_rescale_q(packet.pts, src->time_base, dst->time_base);
-      packet.duration = av_rescale_q(packet.duration,
-                                     src->time_base,
-                                     dst->time_base);
+      TTime dts;
+      if (keyframe_saver &&
+          (packet.flags & AV_PKT_FLAG_KEY) &&
+          src->codecpar->codec_type == AVMEDIA_TYPE_VIDEO &&
+          get_dts(dts, src, packet))
+      {
+        TrackPtr track_ptr = yae::get(summary.decoders_, pkt.trackId_);
+        VideoTrackPtr decoder_ptr =
+          boost::dynamic_pointer_cast<VideoTrack, Track>(track_ptr);
+
+        std::string path = get_keyframe_path(options.keyframes_folder_,
+                                             pkt.trackId_,
+                                             dts,
+                                             options.keyframes_ext_);
+
+        if (decoder_ptr &&
+            !keyframe_saver->save(path,
+                                  decoder_ptr,
+                                  packet_ptr,
+                                  options.envelope_w_,
+                                  options.envelope_h_,
+                                  0.0,
+                                  1.0))
+        {
+          // keep remuxing, but stop saving keyframes:
+          keyframe_saver.reset();
+          keyframes_failed = true;
+        }
+      }
 
-      err = av_interleaved_write_frame(muxer, &packet);
-      if (err < 0)
+      if (muxer_thread)
       {
-        av_log(NULL, AV_LOG_ERROR,
-               "av_interleaved_write_frame(%s) error %i: \"%s\"\n",
-               output_path, err, yae::av_strerr(err).c_str());
-        YAE_ASSERT(false);
+        // the muxer thread is the only consumer, so the output
+        // packet order is the same as the demuxer packet order:
+        muxer_thread->queue_.push(MuxerPacket(packet_ptr, src));
       }
     }
 
-    err = av_write_trailer(muxer);
-    if (err < 0)
+    if (keyframe_saver && keyframe_saver->wait())
+    {
+      keyframes_failed = true;
+    }
+
+    int err = keyframes_failed ? AVERROR_UNKNOWN : 0;
+
+    if (!muxer_thread)
+    {
+      return err;
+    }
+
+    // flush the muxer thread:
+    muxer_thread->queue_.push(MuxerPacket());
+    muxer_thread->thread_.wait();
+    muxer_thread.reset();
+
+    int ret = av_write_trailer(muxer_ptr.get());
+    if (ret < 0)
     {
       av_log(NULL, AV_LOG_ERROR,
              "avformat_write_trailer(%s) error %i: \"%s\"\n",
-             output_path, err, yae::av_strerr(err).c_str());
+             output_path, ret, yae::av_strerr(ret).c_str());
       YAE_ASSERT(false);
+      err = ret;
     }
 
     muxer_ptr.reset();
@@ -2761,6 +3542,17 @@ namespace yae
     return err;
   }
 
+  //----------------------------------------------------------------
+  // remux
+  //
+  int
+  remux(const char * output_path, DemuxerInterface & demuxer)
+  {
+    RemuxOptions options;
+    options.output_path_ = output_path;
+    return remux(demuxer, options);
+  }
+
 
   //----------------------------------------------------------------
   // calc_src_start_offset
@@ -3413,6 +4205,7 @@ namespace yae
           const TTime & dts = tt.get_dts(k);
           const TTime & pts = tt.get_pts(k);
           const TTime & dur = tt.get_dur(k);
+          const int64 pos = tt.get_pos(k);
 
           if (is_subtt_track && pts < origin)
           {
@@ -3426,7 +4219,8 @@ namespace yae
                                       dts - origin,
                                       pts - origin,
                                       dur,
-                                      tolerance);
+                                      tolerance,
+                                      pos);
 
 
           if (is_video_track)
@@ -3563,56 +4357,42 @@ namespace yae
       return TVideoFramePtr();
     }
 
-    // decode the keyframe packet:
+    // decode the keyframe packet synchronously:
     VideoTrack & decoder = *decoder_ptr;
-    if (!decoder.threadIsRunning())
+    if (decoder.threadIsRunning())
     {
-      VideoTraits traits;
-      decoder.getTraits(traits);
+      decoder.threadStop();
+    }
 
-      double native_dar =
-        double(traits.visibleWidth_) / double(traits.visibleHeight_);
+    VideoTraits traits;
+    decoder.getTraits(traits);
 
-      double source_par =
-        source_dar ? (source_dar / native_dar) : 0.0;
+    double native_dar =
+      double(traits.visibleWidth_) / double(traits.visibleHeight_);
 
-      traits.pixelFormat_ = pixel_format;
-      traits.offsetTop_ = 0;
-      traits.offsetLeft_ = 0;
-      traits.visibleWidth_ = envelope_w;
-      traits.visibleHeight_ = envelope_h;
-      traits.pixelAspectRatio_ = output_par;
-      traits.cameraRotation_ = 0;
-      traits.isUpsideDown_ = false;
+    double source_par =
+      source_dar ? (source_dar / native_dar) : 0.0;
 
-      bool deint = false;
-      decoder.setTraitsOverride(traits, deint, source_par);
+    traits.pixelFormat_ = pixel_format;
+    traits.offsetTop_ = 0;
+    traits.offsetLeft_ = 0;
+    traits.visibleWidth_ = envelope_w;
+    traits.visibleHeight_ = envelope_h;
+    traits.pixelAspectRatio_ = output_par;
+    traits.cameraRotation_ = 0;
+    traits.isUpsideDown_ = false;
 
-      const pixelFormat::Traits * ptts = NULL;
-      if (!decoder.getTraitsOverride(traits) ||
-          !(ptts = pixelFormat::getTraits(traits.pixelFormat_)))
-      {
-        return TVideoFramePtr();
-      }
+    bool deint = false;
+    decoder.setTraitsOverride(traits, deint, source_par);
 
-      decoder.threadStart();
-      decoder.packetQueue_.waitIndefinitelyForConsumerToBlock();
+    const pixelFormat::Traits * ptts = NULL;
+    if (!decoder.getTraitsOverride(traits) ||
+        !(ptts = pixelFormat::getTraits(traits.pixelFormat_)))
+    {
+      return TVideoFramePtr();
     }
 
-    // feed the decoder:
-    decoder.packetQueue_.push(packet_ptr);
-
-    // flush, so we don't get stuck:
-    decoder.packetQueue_.push(TPacketPtr());
-
-    TVideoFramePtr vf_ptr;
-    decoder.frameQueue_.pop(vf_ptr);
-
-    // once the decoder is flushed it can't be used again
-    // so shut it down so it can be restarted the next time:
-    decoder.threadStop();
-    decoder.close();
-
+    TVideoFramePtr vf_ptr = decoder.decodeKeyframe(packet_ptr);
     return vf_ptr;
   }
 
@@ -3846,6 +4626,223 @@ namespace yae
     return true;
   }
 
+  //----------------------------------------------------------------
+  // KeyframeSaver::Private
+  //
+  struct KeyframeSaver::Private
+  {
+    Private(std::size_t num_workers):
+      max_pending_(0),
+      pending_(0),
+      failed_(0),
+      pool_(num_workers)
+    {
+      // enough to keep every worker busy while the demuxer
+      // finds the next keyframe, without buffering the whole GOP:
+      max_pending_ = pool_.num_workers() * 2;
+    }
+
+    // blocks while too many keyframes are pending:
+    bool enqueue(const WorkStealingPool::TaskPtr & task);
+    void finished(bool ok);
+    std::size_t wait();
+
+    boost::mutex mutex_;
+    boost::condition_variable cond_;
+    std::size_t max_pending_;
+    std::size_t pending_;
+    std::size_t failed_;
+
+    // declared last, so the workers are stopped
+    // before the mutex and the condition are destroyed:
+    WorkStealingPool pool_;
+  };
+
+  //----------------------------------------------------------------
+  // KeyframeSaver::Private::enqueue
+  //
+  bool
+  KeyframeSaver::Private::enqueue(const WorkStealingPool::TaskPtr & task)
+  {
+    {
+      boost::unique_lock<boost::mutex> lock(mutex_);
+      while (!failed_ && pending_ >= max_pending_)
+      {
+        cond_.wait(lock);
+      }
+
+      if (failed_)
+      {
+        return false;
+      }
+
+      pending_++;
+    }
+
+    pool_.submit(task);
+    return true;
+  }
+
+  //----------------------------------------------------------------
+  // KeyframeSaver::Private::finished
+  //
+  void
+  KeyframeSaver::Private::finished(bool ok)
+  {
+    // notify while holding the lock, the waiting thread
+    // may destroy this object as soon as it wakes up:
+    boost::lock_guard<boost::mutex> lock(mutex_);
+    YAE_ASSERT(pending_);
+    pending_--;
+    failed_ += ok ? 0 : 1;
+    cond_.notify_all();
+  }
+
+  //----------------------------------------------------------------
+  // KeyframeSaver::Private::wait
+  //
+  std::size_t
+  KeyframeSaver::Private::wait()
+  {
+    boost::unique_lock<boost::mutex> lock(mutex_);
+    while (pending_)
+    {
+      cond_.wait(lock);
+    }
+
+    return failed_;
+  }
+
+  //----------------------------------------------------------------
+  // KeyframeSaver::Task
+  //
+  struct KeyframeSaver::Task : public WorkStealingPool::Task
+  {
+    Task(KeyframeSaver::Private & saver,
+         const std::string & path,
+         const VideoTrackPtr & decoder_ptr,
+         const TPacketPtr & packet_ptr,
+         unsigned int envelope_w,
+         unsigned int envelope_h,
+         double source_dar,
+         double output_par):
+      saver_(saver),
+      path_(path),
+      decoder_ptr_(decoder_ptr),
+      packet_ptr_(packet_ptr),
+      envelope_w_(envelope_w),
+      envelope_h_(envelope_h),
+      source_dar_(source_dar),
+      output_par_(output_par)
+    {}
+
+    // virtual:
+    void run()
+    {
+      YAE_TRACE_SPAN(span, "KeyframeSaver::run");
+
+      // the decoder is flushed after each keyframe anyway,
+      // so a private decoder instance costs nothing extra
+      // and keyframes of the same track can be decoded in parallel:
+      const VideoTrack & src = *decoder_ptr_;
+      TrackPtr track_ptr(new Track(src.context(), src.streamPtr()));
+      VideoTrackPtr decoder_ptr(new VideoTrack(*track_ptr));
+
+      bool ok = save_keyframe(path_,
+                              decoder_ptr,
+                              packet_ptr_,
+                              envelope_w_,
+                              envelope_h_,
+                              source_dar_,
+                              output_par_);
+      decoder_ptr.reset();
+      track_ptr.reset();
+
+      saver_.finished(ok);
+    }
+
+    KeyframeSaver::Private & saver_;
+    std::string path_;
+    VideoTrackPtr decoder_ptr_;
+    TPacketPtr packet_ptr_;
+    unsigned int envelope_w_;
+    unsigned int envelope_h_;
+    double source_dar_;
+    double output_par_;
+  };
+
+  //----------------------------------------------------------------
+  // KeyframeSaver::KeyframeSaver
+  //
+  KeyframeSaver::KeyframeSaver(std::size_t num_workers):
+    private_(new Private(num_workers))
+  {}
+
+  //----------------------------------------------------------------
+  // KeyframeSaver::~KeyframeSaver
+  //
+  KeyframeSaver::~KeyframeSaver()
+  {
+    private_->wait();
+    delete private_;
+  }
+
+  //----------------------------------------------------------------
+  // KeyframeSaver::save
+  //
+  bool
+  KeyframeSaver::save(const std::string & path,
+                      const VideoTrackPtr & decoder_ptr,
+                      const TPacketPtr & packet_ptr,
+                      unsigned int envelope_w,
+                      unsigned int envelope_h,
+                      double source_dar,
+                      double output_par)
+  {
+    if (!(decoder_ptr && packet_ptr))
+    {
+      return false;
+    }
+
+    WorkStealingPool::TaskPtr task(new Task(*private_,
+                                            path,
+                                            decoder_ptr,
+                                            packet_ptr,
+                                            envelope_w,
+                                            envelope_h,
+                                            source_dar,
+                                            output_par));
+    return private_->enqueue(task);
+  }
+
+  //----------------------------------------------------------------
+  // KeyframeSaver::wait
+  //
+  std::size_t
+  KeyframeSaver::wait()
+  {
+    return private_->wait();
+  }
+
+  //----------------------------------------------------------------
+  // get_keyframe_path
+  //
+  std::string
+  get_keyframe_path(const std::string & folder,
+                    const std::string & track_id,
+                    const TTime & dts,
+                    const std::string & ext)
+  {
+    fs::path track_folder = (fs::path(folder) /
+                             boost::replace_all_copy(track_id, ":", "."));
+
+    boost::system::error_code ec;
+    fs::create_directories(track_folder, ec);
+
+    std::string fn = (dts.to_hhmmss_frac(1000, "", ".") + "." + ext);
+    return (track_folder / fn).string();
+  }
+
   //----------------------------------------------------------------
   // pull
   //
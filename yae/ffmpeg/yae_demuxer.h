@@ -119,6 +119,10 @@ namespace yae
     // lookup program by native ffmpeg stream index:
     const TProgramInfo * getProgram(int streamIndex) const;
 
+    // lookup native ffmpeg stream by global track id,
+    // including streams that have no decoder (track id prefix _):
+    AVStream * getStream(const std::string & trackId) const;
+
     void getVideoTrackInfo(std::size_t i, TTrackInfo & info) const;
     void getAudioTrackInfo(std::size_t i, TTrackInfo & info) const;
 
@@ -380,6 +384,9 @@ namespace yae
     inline double buffer_sec() const
     { return buffer_sec_; }
 
+    inline PacketPool::Stats packet_pool_stats() const
+    { return pool_->stats(); }
+
     // helpers:
     inline const AVFormatContext & context() const
     { return demuxer_->getFormatContext(); }
@@ -392,6 +399,9 @@ namespace yae
     double buffer_sec_;
     bool gave_up_;
 
+    // recycled packets for populate():
+    TPacketPoolPtr pool_;
+
     // map native ffmpeg AVProgram id to ProgramBuffer:
     std::map<int, TProgramBufferPtr> program_;
 
@@ -463,6 +473,82 @@ namespace yae
   typedef yae::shared_ptr<DemuxerSummary> TDemuxerSummaryPtr;
 
 
+  //----------------------------------------------------------------
+  // set_demuxer_index_cache
+  //
+  // DemuxerBuffer::summarize keeps a compact binary index of the
+  // timeline of every local file it scans in this folder, keyed by
+  // file path, size and modification time, so that re-opening the
+  // same file skips the scan and a file that has grown since
+  // it was indexed only has its newly appended packets scanned.
+  //
+  // the cache is opt-in so that tools and tests do not write
+  // into the home folder -- it defaults to $YAE_INDEX_CACHE if set,
+  // otherwise it is disabled; an empty folder path disables it:
+  //
+  YAE_API void set_demuxer_index_cache(const std::string & folder);
+  YAE_API std::string get_demuxer_index_cache();
+
+  //----------------------------------------------------------------
+  // default_demuxer_index_cache
+  //
+  // the per-user cache folder an application may opt in to,
+  // $XDG_CACHE_HOME/yae/index or ~/.cache/yae/index
+  // (%LOCALAPPDATA%\yae\index on windows):
+  //
+  YAE_API std::string default_demuxer_index_cache();
+
+  //----------------------------------------------------------------
+  // DemuxerIndex
+  //
+  // persistent on-disk cache of the timeline and framerate estimates
+  // of a DemuxerSummary, which are expensive to build because that
+  // requires demuxing the whole file:
+  //
+  struct YAE_API DemuxerIndex
+  {
+    enum Match
+    {
+      kNoMatch = 0,
+      kPrefixMatch = 1,
+      kExactMatch = 2
+    };
+
+    // the index is kept in the given folder,
+    // an empty folder path disables it:
+    DemuxerIndex(const std::string & path,
+                 uint64 track_offset,
+                 double tolerance,
+                 const std::string & folder = get_demuxer_index_cache());
+
+    // load the cached timeline and framerate estimates
+    // of this file, or of an earlier (shorter) version of it;
+    // summary.streams_ is left for the caller to fill in:
+    Match load(DemuxerSummary & summary) const;
+
+    // store the summary timeline and framerate estimates:
+    bool save(const DemuxerSummary & summary) const;
+
+    // cache file path, empty if the cache is disabled
+    // or the source is not a local file:
+    inline const std::string & cache_path() const
+    { return cache_; }
+
+  protected:
+    void save_header(std::ostream & os) const;
+
+    std::string cache_;
+
+    // the key:
+    std::string path_;
+    uint64 track_offset_;
+    int64 tolerance_;
+    uint64 size_;
+    int64 mtime_;
+    uint64 head_;
+  };
+
+
   //----------------------------------------------------------------
   // DemuxerInterface
   //
@@ -568,8 +654,20 @@ namespace yae
     virtual void summarize(DemuxerSummary & summary,
                            double tolerance = 0.1);
 
+    // for sizing the packet pool:
+    inline PacketPool::Stats packet_pool_stats() const
+    { return src_.packet_pool_stats(); }
+
+    // seeks with a track id may be served from the keyframe index
+    // of the summary timeline, this is off by default until it has
+    // been measured on real long-GOP content (see aeyae-decode-bench
+    // --seek, which compares both):
+    inline void set_keyframe_seek(bool enable)
+    { keyframe_seek_ = enable; }
+
   protected:
     PacketBuffer src_;
+    bool keyframe_seek_;
   };
 
   //----------------------------------------------------------------
@@ -619,12 +717,56 @@ namespace yae
   //----------------------------------------------------------------
   // analyze_timeline
   //
+  // when resuming a previous analysis, packets whose DTS
+  // is not past the last DTS already recorded for their track
+  // in resume_after are skipped:
+  //
   YAE_API void
   analyze_timeline(DemuxerInterface & demuxer,
                    std::map<std::string, const AVStream *> & streams,
                    std::map<std::string, FramerateEstimator> & fps,
                    std::map<int, Timeline> & programs,
-                   double tolerance = 0.1);
+                   double tolerance = 0.1,
+                   const std::map<std::string, TTime> * resume_after = NULL);
+
+  //----------------------------------------------------------------
+  // RemuxOptions
+  //
+  struct YAE_API RemuxOptions
+  {
+    RemuxOptions();
+
+    // muxer output, may be empty if only the keyframes are wanted:
+    std::string output_path_;
+
+    // if not empty the video keyframes are saved here,
+    // one folder per track, one image per keyframe named by its DTS:
+    std::string keyframes_folder_;
+
+    // keyframe image file extension, selects the encoder
+    // (png, jpg, pgm):
+    std::string keyframes_ext_;
+
+    // keyframe envelope, 0 preserves the original dimensions:
+    unsigned int envelope_w_;
+    unsigned int envelope_h_;
+
+    // number of keyframe decoder workers, 0 means one per CPU core:
+    std::size_t workers_;
+
+    // max number of packets buffered for the muxer thread:
+    std::size_t muxer_queue_size_;
+  };
+
+  //----------------------------------------------------------------
+  // remux
+  //
+  // packets are demuxed on the calling thread and written to the
+  // output by a dedicated muxer thread, in the same order they were
+  // demuxed.  Keyframes are decoded and saved by a pool of workers.
+  //
+  YAE_API int
+  remux(DemuxerInterface & demuxer, const RemuxOptions & options);
 
   //----------------------------------------------------------------
   // remux
@@ -840,6 +982,57 @@ namespace yae
                 double source_dar = 0.0,
                 double output_par = 1.0);
 
+  //----------------------------------------------------------------
+  // KeyframeSaver
+  //
+  // Decodes and saves keyframes on a pool of worker threads so that
+  // the caller can keep demuxing.  Every keyframe gets its own decoder
+  // instance, the decoder passed to save(...) is only used to look up
+  // the stream, so it is never used by more than one thread.
+  //
+  struct YAE_API KeyframeSaver
+  {
+    // 0 workers means one per CPU core:
+    KeyframeSaver(std::size_t num_workers = 0);
+
+    // waits for pending keyframes:
+    ~KeyframeSaver();
+
+    // blocks while too many keyframes are pending,
+    // returns false if a previously queued keyframe failed to save:
+    bool save(const std::string & path,
+              const VideoTrackPtr & decoder_ptr,
+              const TPacketPtr & packet_ptr,
+              unsigned int envelope_w = 256,
+              unsigned int envelope_h = 256,
+              double source_dar = 0.0,
+              double output_par = 1.0);
+
+    // waits for pending keyframes,
+    // returns the number of keyframes that failed to save:
+    std::size_t wait();
+
+  private:
+    KeyframeSaver(const KeyframeSaver &);
+    KeyframeSaver & operator = (const KeyframeSaver &);
+
+    struct Task;
+    struct Private;
+    Private * private_;
+  };
+
+  //----------------------------------------------------------------
+  // get_keyframe_path
+  //
+  // folder/track_id/hhmmss.mmm.ext, ':' in track_id are replaced
+  // with '.', the track folder is created if necessary:
+  //
+  YAE_API std::string
+  get_keyframe_path(const std::string & folder,
+                    const std::string & track_id,
+                    const TTime & dts,
+                    const std::string & ext = std::string("png"));
+
   //----------------------------------------------------------------
   // TVideoFrameCallback
   //
@@ -625,6 +625,55 @@ namespace yae
     return ok;
   }
 
+  //----------------------------------------------------------------
+  // DemuxerReader::readKeyframe
+  //
+  bool
+  DemuxerReader::readKeyframe(double seekTime, TVideoFramePtr & frame)
+  {
+    frame.reset();
+
+    VideoTrackPtr track = selectedVideoTrack();
+    if (!track || thread_.isRunning())
+    {
+      return false;
+    }
+
+    // keyframe at or before the given time:
+    int seekFlags = 0;
+    int err = demuxer_->seek(seekFlags, TTime(seekTime), track->id());
+    if (err < 0)
+    {
+      return false;
+    }
+
+    // skip over packets of other streams, but not forever:
+    for (int i = 0; i < 4096; i++)
+    {
+      AVStream * stream = NULL;
+      TPacketPtr packetPtr = demuxer_->get(stream);
+      if (!packetPtr)
+      {
+        break;
+      }
+
+      const AVPacket & packet = packetPtr->get();
+      if (packet.stream_index == track->streamIndex() &&
+          (packet.flags & AV_PKT_FLAG_KEY))
+      {
+        frame = track->decodeKeyframe(packetPtr);
+        break;
+      }
+    }
+
+    if (frame)
+    {
+      frame->readerId_ = readerId_;
+    }
+
+    return !!frame;
+  }
+
   //----------------------------------------------------------------
   // DemuxerReader::readAudio
   //
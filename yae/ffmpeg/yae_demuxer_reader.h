@@ -93,6 +93,8 @@ namespace yae
     virtual bool readVideo(TVideoFramePtr & frame, QueueWaitMgr * mgr = 0);
     virtual bool readAudio(TAudioFramePtr & frame, QueueWaitMgr * mgr = 0);
 
+    virtual bool readKeyframe(double t, TVideoFramePtr & frame);
+
     virtual bool blockedOnVideo() const;
     virtual bool blockedOnAudio() const;
 
@@ -13,6 +13,7 @@
 // aeyae:
 #include "yae_ffmpeg_utils.h"
 #include "yae_ffmpeg_video_filter_graph.h"
+#include "../utils/yae_benchmark.h"
 
 
 namespace yae
@@ -147,12 +148,24 @@ namespace yae
     return true;
   }
 
+  //----------------------------------------------------------------
+  // VideoFilterGraph::isPassThrough
+  //
+  bool
+  VideoFilterGraph::isPassThrough() const
+  {
+    return (graph_ &&
+            srcPixFmt_ == dstPixFmt_[0] &&
+            (filterChain_.empty() || filterChain_ == "null"));
+  }
+
   //----------------------------------------------------------------
   // VideoFilterGraph::push
   //
   bool
   VideoFilterGraph::push(AVFrame * frame)
   {
+    YAE_PROBE(probe, "VideoFilterGraph::push");
     int err = av_buffersrc_add_frame(src_, frame);
 
     YAE_ASSERT_NO_AVERROR_OR_RETURN(err, false);
@@ -165,6 +178,7 @@ namespace yae
   bool
   VideoFilterGraph::pull(AVFrame * frame, AVRational & outTimeBase)
   {
+    YAE_PROBE(probe, "VideoFilterGraph::pull");
     int err = av_buffersink_get_frame(sink_, frame);
     if (err == AVERROR(EAGAIN) || err == AVERROR_EOF)
     {
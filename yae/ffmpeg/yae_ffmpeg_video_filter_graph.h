@@ -55,6 +55,10 @@ namespace yae
     // NOTE: a filter (yadif) may change the timebase of the output frame:
     bool pull(AVFrame * out, AVRational & outTimeBase);
 
+    // true when the current setup has no filters and no pixel format
+    // conversion, so frames can bypass the graph entirely:
+    bool isPassThrough() const;
+
   protected:
     std::string filterChain_;
     int srcWidth_;
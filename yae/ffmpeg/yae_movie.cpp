@@ -9,6 +9,8 @@
 // yae includes:
 #include "yae_closed_captions.h"
 #include "yae_movie.h"
+#include "yae/utils/yae_benchmark.h"
+#include "yae/utils/yae_trace.h"
 
 
 namespace yae
@@ -554,6 +556,8 @@ namespace yae
 
           if (!err)
           {
+            YAE_PROBE(probe, "Movie::demux");
+            YAE_TRACE_SPAN(span, "Movie::demux");
             err = av_read_frame(context_, &packet);
 
             if (interruptDemuxer_)
@@ -886,9 +890,20 @@ namespace yae
     catch (...)
     {}
 
+    // if enabled (see set_decoder_pool_enabled) decode on the shared
+    // worker pool instead of a thread per track, unless the caller
+    // has already given the track a pool of its own:
+    WorkStealingPool * pool =
+      get_decoder_pool_enabled() ? &WorkStealingPool::singleton() : NULL;
+
     if (selectedVideoTrack_ < videoTracks_.size())
     {
       VideoTrackPtr t = videoTracks_[selectedVideoTrack_];
+      if (!t->workerPool())
+      {
+        t->setWorkerPool(pool);
+      }
+
       t->threadStart();
       t->packetQueue_.waitIndefinitelyForConsumerToBlock();
     }
@@ -896,6 +911,11 @@ namespace yae
     if (selectedAudioTrack_ < audioTracks_.size())
     {
       AudioTrackPtr t = audioTracks_[selectedAudioTrack_];
+      if (!t->workerPool())
+      {
+        t->setWorkerPool(pool);
+      }
+
       t->threadStart();
       t->packetQueue_.waitIndefinitelyForConsumerToBlock();
     }
@@ -1039,6 +1059,73 @@ namespace yae
     return false;
   }
 
+  //----------------------------------------------------------------
+  // Movie::decodeKeyframe
+  //
+  bool
+  Movie::decodeKeyframe(double seekTime, TVideoFramePtr & frame)
+  {
+    frame.reset();
+
+    if (!context_ ||
+        thread_.isRunning() ||
+        selectedVideoTrack_ >= videoTracks_.size())
+    {
+      return false;
+    }
+
+    VideoTrackPtr videoTrack = videoTracks_[selectedVideoTrack_];
+    int streamIndex = videoTrack->streamIndex();
+
+    if (isSeekable())
+    {
+      AVRational tb;
+      tb.num = 1;
+      tb.den = AV_TIME_BASE;
+
+      const AVStream * s = context_->streams[streamIndex];
+      int64_t ts = int64_t(seekTime * double(AV_TIME_BASE));
+      ts = av_rescale_q(ts, tb, s->time_base);
+
+      // keyframe at or before the given time, else the one after:
+      int err = avformat_seek_file(context_, streamIndex,
+                                   kMinInt64, ts, ts, 0);
+      if (err < 0)
+      {
+        err = avformat_seek_file(context_, streamIndex,
+                                 kMinInt64, ts, kMaxInt64, 0);
+      }
+
+      if (err < 0)
+      {
+        return false;
+      }
+    }
+
+    // skip over packets of other streams, and over non-key packets
+    // in case the demuxer didn't land on a keyframe, but not forever:
+    for (int i = 0; i < 4096; i++)
+    {
+      TPacketPtr packetPtr(new AvPkt());
+      AVPacket & packet = packetPtr->get();
+
+      int err = av_read_frame(context_, &packet);
+      if (err < 0)
+      {
+        break;
+      }
+
+      if (packet.stream_index == streamIndex &&
+          (packet.flags & AV_PKT_FLAG_KEY))
+      {
+        frame = videoTrack->decodeKeyframe(packetPtr);
+        break;
+      }
+    }
+
+    return !!frame;
+  }
+
   //----------------------------------------------------------------
   // Movie::seekTo
   //
@@ -85,10 +85,19 @@ namespace yae
     bool threadStart();
     bool threadStop();
 
+    // returns true if the demuxer thread exited on its own
+    // (for example at the end of the file) within the timeout:
+    inline bool threadWaitFor(unsigned int msec)
+    { return thread_.waitFor(msec); }
+
     bool isSeekable() const;
     bool hasDuration() const;
     bool requestSeekTime(double seekTime);
 
+    // synchronous, seek and decode the selected video track keyframe
+    // at or before a given time, the demuxer thread must not be running:
+    bool decodeKeyframe(double seekTime, TVideoFramePtr & frame);
+
   protected:
     int seekTo(double seekTime, bool dropPendingFrames);
 
@@ -13,10 +13,13 @@
 // boost:
 #include <boost/algorithm/string.hpp>
 #include <boost/algorithm/string/predicate.hpp>
+#include <boost/atomic.hpp>
 
 // yae includes:
 #include "yae/ffmpeg/yae_ffmpeg_utils.h"
 #include "yae/ffmpeg/yae_track.h"
+#include "yae/utils/yae_benchmark.h"
+#include "yae/utils/yae_trace.h"
 
 // namespace shortcuts:
 namespace al = boost::algorithm;
@@ -85,6 +88,120 @@ namespace yae
     return *this;
   }
 
+  //----------------------------------------------------------------
+  // AvPkt::clear
+  //
+  void
+  AvPkt::clear()
+  {
+    av_packet_unref(packet_);
+
+    pbuffer_ = NULL;
+    demuxer_ = NULL;
+    program_ = 0;
+    trackId_.clear();
+  }
+
+  //----------------------------------------------------------------
+  // PacketPool::Stats::Stats
+  //
+  PacketPool::Stats::Stats():
+    hits_(0),
+    misses_(0),
+    outstanding_(0),
+    high_water_mark_(0),
+    available_(0)
+  {}
+
+  //----------------------------------------------------------------
+  // PacketPool::PacketPool
+  //
+  PacketPool::PacketPool(std::size_t maxAvailable):
+    maxAvailable_(maxAvailable)
+  {
+    available_.reserve(maxAvailable_);
+  }
+
+  //----------------------------------------------------------------
+  // PacketPool::~PacketPool
+  //
+  PacketPool::~PacketPool()
+  {
+    for (std::vector<AvPkt *>::iterator
+           i = available_.begin(); i != available_.end(); ++i)
+    {
+      delete *i;
+    }
+  }
+
+  //----------------------------------------------------------------
+  // PacketPool::get
+  //
+  TPacketPtr
+  PacketPool::get()
+  {
+    AvPkt * pkt = NULL;
+    {
+      boost::lock_guard<boost::mutex> lock(mutex_);
+      if (available_.empty())
+      {
+        stats_.misses_++;
+      }
+      else
+      {
+        pkt = available_.back();
+        available_.pop_back();
+        stats_.hits_++;
+      }
+
+      stats_.outstanding_++;
+      stats_.high_water_mark_ = std::max(stats_.high_water_mark_,
+                                         stats_.outstanding_);
+    }
+
+    if (!pkt)
+    {
+      pkt = new AvPkt();
+    }
+
+    return TPacketPtr(pkt, Recycler(shared_from_this()));
+  }
+
+  //----------------------------------------------------------------
+  // PacketPool::stats
+  //
+  PacketPool::Stats
+  PacketPool::stats() const
+  {
+    boost::lock_guard<boost::mutex> lock(mutex_);
+    Stats stats = stats_;
+    stats.available_ = available_.size();
+    return stats;
+  }
+
+  //----------------------------------------------------------------
+  // PacketPool::recycle
+  //
+  void
+  PacketPool::recycle(AvPkt * pkt)
+  {
+    // release the payload outside the lock:
+    pkt->clear();
+
+    {
+      boost::lock_guard<boost::mutex> lock(mutex_);
+      stats_.outstanding_--;
+
+      if (available_.size() < maxAvailable_)
+      {
+        available_.push_back(pkt);
+        return;
+      }
+    }
+
+    delete pkt;
+  }
+
   //----------------------------------------------------------------
   // clone
   //
@@ -150,6 +267,59 @@ namespace yae
   }
 
 
+  //----------------------------------------------------------------
+  // decoder_threads
+  //
+  static boost::atomic<unsigned int> decoder_threads(0);
+
+  //----------------------------------------------------------------
+  // set_decoder_threads
+  //
+  void
+  set_decoder_threads(unsigned int nthreads)
+  {
+    decoder_threads.store(nthreads);
+  }
+
+  //----------------------------------------------------------------
+  // get_decoder_threads
+  //
+  unsigned int
+  get_decoder_threads()
+  {
+    unsigned int nthreads = decoder_threads.load();
+    if (!nthreads)
+    {
+      nthreads = boost::thread::hardware_concurrency();
+      nthreads = std::min<unsigned int>(16, nthreads);
+    }
+
+    return nthreads;
+  }
+
+  //----------------------------------------------------------------
+  // decoder_pool_enabled
+  //
+  static boost::atomic<bool> decoder_pool_enabled(false);
+
+  //----------------------------------------------------------------
+  // set_decoder_pool_enabled
+  //
+  void
+  set_decoder_pool_enabled(bool enabled)
+  {
+    decoder_pool_enabled.store(enabled);
+  }
+
+  //----------------------------------------------------------------
+  // get_decoder_pool_enabled
+  //
+  bool
+  get_decoder_pool_enabled()
+  {
+    return decoder_pool_enabled.load();
+  }
+
   //----------------------------------------------------------------
   // tryToOpen
   //
@@ -158,8 +328,7 @@ namespace yae
             const AVCodecParameters * params,
             AVDictionary * opts)
   {
-    unsigned int nthreads = boost::thread::hardware_concurrency();
-    nthreads = std::min<unsigned int>(16, nthreads);
+    unsigned int nthreads = get_decoder_threads();
 
     AvCodecContextPtr ctx(avcodec_alloc_context3(c));
     if (params)
@@ -225,6 +394,10 @@ namespace yae
   //
   Track::Track(AVFormatContext * context, AVStream * stream):
     thread_(this),
+    pool_(NULL),
+    taskState_(kTaskDone),
+    taskStop_(false),
+    taskStarted_(false),
     context_(context),
     stream_(stream),
     preferSoftwareDecoder_(false),
@@ -251,6 +424,10 @@ namespace yae
   //
   Track::Track(Track & track):
     thread_(this),
+    pool_(NULL),
+    taskState_(kTaskDone),
+    taskStop_(false),
+    taskStarted_(false),
     context_(NULL),
     stream_(NULL),
     preferSoftwareDecoder_(track.preferSoftwareDecoder_),
@@ -645,9 +822,40 @@ namespace yae
   bool
   Track::threadStart()
   {
-    terminator_.stopWaiting(false);
     packetQueue_.open();
-    return thread_.run();
+    return decoderResume();
+  }
+
+  //----------------------------------------------------------------
+  // Track::decoderResume
+  //
+  bool
+  Track::decoderResume()
+  {
+    terminator_.stopWaiting(false);
+
+    if (!pool_)
+    {
+      return thread_.run();
+    }
+
+    {
+      boost::lock_guard<boost::mutex> lock(taskMutex_);
+      if (taskState_ != kTaskDone)
+      {
+        // already running:
+        return true;
+      }
+
+      taskState_ = kTaskIdle;
+      taskStop_ = false;
+      taskStarted_ = false;
+    }
+
+    packetQueue_.setObserver(&Track::decoderTaskObserver, this);
+    observeFrameQueue(true);
+    scheduleDecoderTask();
+    return true;
   }
 
   //----------------------------------------------------------------
@@ -750,6 +958,9 @@ namespace yae
   void
   Track::decode(const TPacketPtr & packetPtr)
   {
+    YAE_PROBE(probe, "Track::decode");
+    YAE_TRACE_SPAN(span, "Track::decode");
+
     if (!packetPtr)
     {
       this->flush();
@@ -895,6 +1106,11 @@ namespace yae
   void
   Track::threadLoop()
   {
+    if (TTrace::enabled())
+    {
+      TTrace::set_thread_name(id_.c_str());
+    }
+
     decoderStartup();
 
     while (true)
@@ -926,10 +1142,200 @@ namespace yae
   bool
   Track::threadStop()
   {
-    terminator_.stopWaiting(true);
     packetQueue_.close();
-    thread_.stop();
-    return thread_.wait();
+    return decoderSuspend();
+  }
+
+  //----------------------------------------------------------------
+  // Track::decoderSuspend
+  //
+  bool
+  Track::decoderSuspend()
+  {
+    terminator_.stopWaiting(true);
+
+    if (!pool_)
+    {
+      thread_.stop();
+      return thread_.wait();
+    }
+
+    {
+      boost::lock_guard<boost::mutex> lock(taskMutex_);
+      taskStop_ = true;
+    }
+
+    // the task finishes as soon as it runs, schedule it if it is idle:
+    scheduleDecoderTask();
+
+    boost::unique_lock<boost::mutex> lock(taskMutex_);
+    while (taskState_ != kTaskDone)
+    {
+      taskCond_.wait(lock);
+    }
+
+    return true;
+  }
+
+  //----------------------------------------------------------------
+  // Track::threadIsRunning
+  //
+  bool
+  Track::threadIsRunning() const
+  {
+    if (thread_.isRunning())
+    {
+      return true;
+    }
+
+    boost::lock_guard<boost::mutex> lock(taskMutex_);
+    return taskState_ != kTaskDone;
+  }
+
+  //----------------------------------------------------------------
+  // Track::setWorkerPool
+  //
+  void
+  Track::setWorkerPool(WorkStealingPool * pool)
+  {
+    YAE_ASSERT(!threadIsRunning());
+    pool_ = pool;
+  }
+
+  //----------------------------------------------------------------
+  // Track::decoderTaskObserver
+  //
+  void
+  Track::decoderTaskObserver(void * context)
+  {
+    Track * track = (Track *)context;
+    track->scheduleDecoderTask();
+  }
+
+  //----------------------------------------------------------------
+  // Track::scheduleDecoderTask
+  //
+  // at most one decoder task per track is queued or running at any time:
+  //
+  void
+  Track::scheduleDecoderTask()
+  {
+    {
+      boost::lock_guard<boost::mutex> lock(taskMutex_);
+      if (taskState_ == kTaskRunning)
+      {
+        // let the running task know it should go around once more:
+        taskState_ = kTaskRerun;
+        return;
+      }
+
+      if (taskState_ != kTaskIdle)
+      {
+        return;
+      }
+
+      taskState_ = kTaskQueued;
+    }
+
+    pool_->submit(WorkStealingPool::TaskPtr(new DecoderTask(*this)));
+  }
+
+  //----------------------------------------------------------------
+  // kDecoderTaskQuantum
+  //
+  // max number of packets decoded per task invocation,
+  // so that other tracks sharing the pool get a turn:
+  //
+  static const std::size_t kDecoderTaskQuantum = 16;
+
+  //----------------------------------------------------------------
+  // Track::decoderTaskRun
+  //
+  void
+  Track::decoderTaskRun()
+  {
+    bool stop = false;
+    {
+      boost::lock_guard<boost::mutex> lock(taskMutex_);
+      YAE_ASSERT(taskState_ == kTaskQueued);
+      taskState_ = kTaskRunning;
+      stop = taskStop_;
+    }
+
+    if (!taskStarted_)
+    {
+      decoderStartup();
+      taskStarted_ = true;
+    }
+
+    bool finished = stop;
+    bool exhausted = false;
+
+    for (std::size_t i = 0; !finished && i < kDecoderTaskQuantum; i++)
+    {
+      try
+      {
+        if (!terminator_.keepWaiting())
+        {
+          finished = true;
+          break;
+        }
+
+        if (!deliverParkedFrames())
+        {
+          // the frame queue is full, its room observer
+          // will schedule this task again:
+          break;
+        }
+
+        TPacketPtr packetPtr;
+        if (!packetQueue_.popOrPark(packetPtr))
+        {
+          finished = packetQueue_.isClosed();
+          break;
+        }
+
+        decode(packetPtr);
+        exhausted = (i + 1 == kDecoderTaskQuantum);
+      }
+      catch (...)
+      {
+        finished = true;
+      }
+    }
+
+    if (!finished)
+    {
+      boost::lock_guard<boost::mutex> lock(taskMutex_);
+      finished = taskStop_;
+    }
+
+    if (finished)
+    {
+      packetQueue_.setObserver(NULL, NULL);
+      observeFrameQueue(false);
+      dropParkedFrames();
+      decoderShutdown();
+
+      // the track may be destroyed as soon as kTaskDone is observed:
+      boost::lock_guard<boost::mutex> lock(taskMutex_);
+      taskState_ = kTaskDone;
+      taskCond_.notify_all();
+      return;
+    }
+
+    {
+      boost::lock_guard<boost::mutex> lock(taskMutex_);
+      if (!exhausted && taskState_ == kTaskRunning)
+      {
+        taskState_ = kTaskIdle;
+        return;
+      }
+
+      taskState_ = kTaskQueued;
+    }
+
+    pool_->submit(WorkStealingPool::TaskPtr(new DecoderTask(*this)));
   }
 
   //----------------------------------------------------------------
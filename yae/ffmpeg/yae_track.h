@@ -14,6 +14,7 @@
 
 // boost includes:
 #ifndef Q_MOC_RUN
+#include <boost/enable_shared_from_this.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/thread.hpp>
 #endif
@@ -28,7 +29,9 @@ extern "C"
 
 // yae includes:
 #include "yae/thread/yae_queue.h"
+#include "yae/thread/yae_ring_queue.h"
 #include "yae/thread/yae_threading.h"
+#include "yae/thread/yae_work_stealing_pool.h"
 #include "yae/video/yae_video.h"
 
 
@@ -77,10 +80,11 @@ namespace yae
   // push a special frame into frame queue to resetTimeCounters
   // down the line (the renderer):
   //
-  template <typename FramePtr>
+  template <typename TFrameQueue>
   static void
-  startNewSequence(Queue<FramePtr> & frameQueue, bool dropPendingFrames)
+  startNewSequence(TFrameQueue & frameQueue, bool dropPendingFrames)
   {
+    typedef typename TFrameQueue::value_type FramePtr;
     typedef typename FramePtr::element_type Frame;
     FramePtr framePtr(new Frame());
     Frame & frame = *framePtr;
@@ -94,6 +98,73 @@ namespace yae
   }
 
 
+  //----------------------------------------------------------------
+  // ParkedFrames
+  //
+  // A decoder task running on a worker pool must not block its worker
+  // on a full frame queue.  Output frames that do not fit are parked
+  // here instead, and are delivered (in order) before the task decodes
+  // anything else.  The frame queue room observer reschedules the task.
+  //
+  template <typename TFrameQueue>
+  struct ParkedFrames
+  {
+    typedef typename TFrameQueue::value_type TFramePtr;
+
+    // returns false if the frame queue is closed:
+    bool push(TFrameQueue & frameQueue, const TFramePtr & frame)
+    {
+      boost::lock_guard<boost::mutex> lock(mutex_);
+      if (frames_.empty() && frameQueue.pushOrPark(frame))
+      {
+        return true;
+      }
+
+      if (frameQueue.isClosed())
+      {
+        frames_.clear();
+        return false;
+      }
+
+      frames_.push_back(frame);
+      return true;
+    }
+
+    // returns false if some frames are still parked:
+    bool deliver(TFrameQueue & frameQueue)
+    {
+      boost::lock_guard<boost::mutex> lock(mutex_);
+      while (!frames_.empty())
+      {
+        if (!frameQueue.pushOrPark(frames_.front()))
+        {
+          if (frameQueue.isClosed())
+          {
+            frames_.clear();
+            break;
+          }
+
+          return false;
+        }
+
+        frames_.pop_front();
+      }
+
+      return true;
+    }
+
+    void clear()
+    {
+      boost::lock_guard<boost::mutex> lock(mutex_);
+      frames_.clear();
+    }
+
+  protected:
+    boost::mutex mutex_;
+    std::list<TFramePtr> frames_;
+  };
+
+
   //----------------------------------------------------------------
   // Rational
   //
@@ -124,6 +195,10 @@ namespace yae
     inline AVPacket & get()
     { return *packet_; }
 
+    // release the payload and forget the origin,
+    // but keep the AVPacket allocation for reuse:
+    void clear();
+
   protected:
     // the packet:
     AVPacket * packet_;
@@ -144,7 +219,89 @@ namespace yae
   //----------------------------------------------------------------
   // TPacketQueue
   //
+#ifdef YAE_USE_RING_QUEUE
+  typedef RingQueue<TPacketPtr> TPacketQueue;
+#else
   typedef Queue<TPacketPtr> TPacketQueue;
+#endif
+
+  //----------------------------------------------------------------
+  // PacketPool
+  //
+  // Recycles AvPkt shells (AvPkt + AVPacket allocations) so that
+  // the demuxer doesn't have to allocate them for every packet.
+  //
+  // Packets handed out by the pool return to it when the last
+  // TPacketPtr reference is released, from whichever thread that is.
+  // The pool outlives its owner until all its packets are released.
+  //
+  struct YAE_API PacketPool : public boost::enable_shared_from_this<PacketPool>
+  {
+    //----------------------------------------------------------------
+    // Stats
+    //
+    struct YAE_API Stats
+    {
+      Stats();
+
+      // number of get() calls served from the free list:
+      uint64_t hits_;
+
+      // number of get() calls that had to allocate a new packet:
+      uint64_t misses_;
+
+      // packets currently handed out:
+      std::size_t outstanding_;
+
+      // max number of packets handed out at the same time:
+      std::size_t high_water_mark_;
+
+      // packets on the free list:
+      std::size_t available_;
+    };
+
+    // maxAvailable limits the size of the free list:
+    PacketPool(std::size_t maxAvailable = 512);
+    ~PacketPool();
+
+    // NOTE: the pool must be owned by a boost::shared_ptr:
+    TPacketPtr get();
+
+    Stats stats() const;
+
+  protected:
+    void recycle(AvPkt * pkt);
+
+    //----------------------------------------------------------------
+    // Recycler
+    //
+    struct Recycler
+    {
+      Recycler(const boost::shared_ptr<PacketPool> & pool):
+        pool_(pool)
+      {}
+
+      inline void operator()(AvPkt * pkt) const
+      { pool_->recycle(pkt); }
+
+      boost::shared_ptr<PacketPool> pool_;
+    };
+
+    mutable boost::mutex mutex_;
+    std::vector<AvPkt *> available_;
+    std::size_t maxAvailable_;
+    Stats stats_;
+
+  private:
+    // intentionally disabled:
+    PacketPool(const PacketPool &);
+    PacketPool & operator = (const PacketPool &);
+  };
+
+  //----------------------------------------------------------------
+  // TPacketPoolPtr
+  //
+  typedef boost::shared_ptr<PacketPool> TPacketPoolPtr;
 
   //----------------------------------------------------------------
   // clone
@@ -191,6 +348,29 @@ namespace yae
   };
 
 
+  //----------------------------------------------------------------
+  // set_decoder_threads
+  //
+  // number of threads passed to avcodec_open2 by tryToOpen,
+  // 0 (default) means one per core, up to 16:
+  //
+  YAE_API void set_decoder_threads(unsigned int nthreads);
+  YAE_API unsigned int get_decoder_threads();
+
+  //----------------------------------------------------------------
+  // set_decoder_pool_enabled
+  //
+  // when enabled Movie decodes the selected audio and video tracks
+  // on WorkStealingPool::singleton() instead of starting a dedicated
+  // decoder thread per track; takes effect the next time the movie
+  // decoders are started.
+  //
+  // disabled by default, until the pooled decoder path
+  // has seen more real-world playback:
+  //
+  YAE_API void set_decoder_pool_enabled(bool enabled);
+  YAE_API bool get_decoder_pool_enabled();
+
   //----------------------------------------------------------------
   // tryToOpen
   //
@@ -294,8 +474,25 @@ namespace yae
     virtual bool threadStop();
 
     // helper:
-    inline bool threadIsRunning() const
-    { return thread_.isRunning(); }
+    bool threadIsRunning() const;
+
+    // stop/restart decoding without closing the packet queue,
+    // works the same with or without a worker pool:
+    bool decoderSuspend();
+    bool decoderResume();
+
+    // when a worker pool is set (before threadStart) the track does not
+    // start its own thread, packets are decoded by a cooperative task
+    // that is scheduled on the pool whenever the packet queue has data
+    // and the frame queue has room -- output frames that do not fit
+    // are parked rather than blocking a pool worker.
+    //
+    // NOTE: this bypasses threadLoop, so it is only appropriate
+    // for tracks that do not override it:
+    void setWorkerPool(WorkStealingPool * pool);
+
+    inline WorkStealingPool * workerPool() const
+    { return pool_; }
 
     // adjust frame duration:
     virtual bool setTempo(double tempo);
@@ -304,6 +501,12 @@ namespace yae
     inline const AVStream & stream() const
     { return *stream_; }
 
+    inline AVFormatContext * context() const
+    { return context_; }
+
+    inline AVStream * streamPtr() const
+    { return stream_; }
+
   private:
     // intentionally disabled:
     Track(const Track &);
@@ -314,19 +517,78 @@ namespace yae
     int decode(AVCodecContext * ctx, const AvPkt & pkt);
 
   public:
-    void decode(const TPacketPtr & packetPtr);
+    virtual void decode(const TPacketPtr & packetPtr);
     void flush();
 
   protected:
     bool switchDecoder();
     void tryToSwitchDecoder(const std::string & name);
 
+    //----------------------------------------------------------------
+    // DecoderTask
+    //
+    struct DecoderTask : public WorkStealingPool::Task
+    {
+      DecoderTask(Track & track):
+        track_(track)
+      {}
+
+      // virtual:
+      void run()
+      { track_.decoderTaskRun(); }
+
+      Track & track_;
+    };
+
+    //----------------------------------------------------------------
+    // TaskState
+    //
+    enum TaskState
+    {
+      kTaskIdle,
+      kTaskQueued,
+      kTaskRunning,
+      kTaskRerun,
+      kTaskDone
+    };
+
+    // cooperative equivalent of threadLoop,
+    // decodes a bounded number of packets per call:
+    void decoderTaskRun();
+    void scheduleDecoderTask();
+
+    // packet queue (data) and frame queue (room) observer callback,
+    // context is the Track:
+    static void decoderTaskObserver(void * context);
+
+    // audio/video tracks park the output frames of a pooled decoder
+    // that do not fit into the frame queue (see ParkedFrames),
+    // returns false if frames are still parked:
+    virtual bool deliverParkedFrames()
+    { return true; }
+
+    virtual void dropParkedFrames()
+    {}
+
+    // register (or unregister) decoderTaskObserver
+    // as the frame queue room observer:
+    virtual void observeFrameQueue(bool enable)
+    { (void)enable; }
+
     // global track id:
     std::string id_;
 
     // worker thread:
     Thread<Track> thread_;
 
+    // cooperative decoding on a shared worker pool, instead of thread_:
+    WorkStealingPool * pool_;
+    mutable boost::mutex taskMutex_;
+    boost::condition_variable taskCond_;
+    TaskState taskState_;
+    bool taskStop_;
+    bool taskStarted_;
+
     // deadlock avoidance mechanism:
     QueueWaitMgr terminator_;
 
@@ -6,6 +6,9 @@
 // Copyright : Pavel Koshevoy
 // License   : MIT -- http://www.opensource.org/licenses/mit-license.php
 
+// standard:
+#include <cstdlib>
+
 // boost library:
 #include <boost/algorithm/string.hpp>
 
@@ -14,6 +17,7 @@
 #include "yae/ffmpeg/yae_ffmpeg_utils.h"
 #include "yae/ffmpeg/yae_pixel_format_ffmpeg.h"
 #include "yae/ffmpeg/yae_video_track.h"
+#include "yae/utils/yae_trace.h"
 #include "yae/utils/yae_utils.h"
 #include "yae/video/yae_pixel_format_traits.h"
 
@@ -24,6 +28,75 @@ namespace al = boost::algorithm;
 namespace yae
 {
 
+  //----------------------------------------------------------------
+  // gop_cache_budget
+  //
+  // enough for a few seconds of 1080p around the playhead:
+  //
+  static boost::atomic<std::size_t> gop_cache_budget(256 << 20);
+
+  //----------------------------------------------------------------
+  // set_gop_cache_budget
+  //
+  void
+  set_gop_cache_budget(std::size_t bytes)
+  {
+    gop_cache_budget.store(bytes);
+  }
+
+  //----------------------------------------------------------------
+  // get_gop_cache_budget
+  //
+  std::size_t
+  get_gop_cache_budget()
+  {
+    return gop_cache_budget.load();
+  }
+
+  //----------------------------------------------------------------
+  // kGopCacheWindow
+  //
+  // how many GOPs following a seek are cached, scrubbing
+  // and frame stepping rarely stray farther than that:
+  //
+  static const std::size_t kGopCacheWindow = 4;
+
+  //----------------------------------------------------------------
+  // gop_cost
+  //
+  static std::size_t
+  gop_cost(const TVideoGopPtr & gop)
+  {
+    return gop ? gop->bytes_ : 0;
+  }
+
+  //----------------------------------------------------------------
+  // frame_bytes
+  //
+  // memory held by a reference counted frame:
+  //
+  static std::size_t
+  frame_bytes(const AVFrame & frame)
+  {
+    std::size_t bytes = 0;
+    for (int i = 0; i < AV_NUM_DATA_POINTERS && frame.buf[i]; i++)
+    {
+      bytes += frame.buf[i]->size;
+    }
+
+    // not reference counted, it will be copied, so estimate:
+    if (!bytes)
+    {
+      for (int i = 0; i < AV_NUM_DATA_POINTERS && frame.data[i]; i++)
+      {
+        bytes += std::abs(frame.linesize[i]) * frame.height;
+      }
+    }
+
+    return bytes;
+  }
+
+
   //----------------------------------------------------------------
   // TAVFrameBuffer::TAVFrameBuffer
   //
@@ -94,6 +167,27 @@ namespace yae
     return ta > tb;
   }
 
+  //----------------------------------------------------------------
+  // VideoTrack::FrameStats::FrameStats
+  //
+  VideoTrack::FrameStats::FrameStats():
+    decoded_(0),
+    produced_(0),
+    passedThrough_(0),
+    filtered_(0),
+    replayed_(0)
+  {}
+
+  //----------------------------------------------------------------
+  // VideoTrack::FrameStats::passThroughRate
+  //
+  double
+  VideoTrack::FrameStats::passThroughRate() const
+  {
+    uint64 total = passedThrough_ + filtered_;
+    return total ? double(passedThrough_) / double(total) : 0.0;
+  }
+
   //----------------------------------------------------------------
   // VideoTrack::VideoTrack
   //
@@ -106,7 +200,17 @@ namespace yae
     hasPrevPTS_(false),
     framesDecoded_(0),
     framesProduced_(0),
-    subs_(NULL)
+    framesPassedThrough_(0),
+    framesFiltered_(0),
+    framesReplayed_(0),
+    subs_(NULL),
+    gops_(get_gop_cache_budget(), 1, &gop_cost),
+    gopsInvalid_(false),
+    gopsArmed_(false),
+    gopsToCache_(0),
+    replaying_(false),
+    hasReplayed_(false),
+    capture_(NULL)
   {
     YAE_ASSERT(stream_->codecpar->codec_type == AVMEDIA_TYPE_VIDEO);
 
@@ -169,6 +273,11 @@ namespace yae
   void
   VideoTrack::skipLoopFilter(bool skip)
   {
+    if (skipLoopFilter_ != skip)
+    {
+      purgeGopCache();
+    }
+
     skipLoopFilter_ = skip;
 
     if (codecContext_)
@@ -192,6 +301,11 @@ namespace yae
   void
   VideoTrack::skipNonReferenceFrames(bool skip)
   {
+    if (skipNonReferenceFrames_ != skip)
+    {
+      purgeGopCache();
+    }
+
     skipNonReferenceFrames_ = skip;
 
     if (codecContext_)
@@ -348,10 +462,18 @@ namespace yae
 
     framesDecoded_ = 0;
     framesProduced_ = 0;
+    framesPassedThrough_ = 0;
+    framesFiltered_ = 0;
+    framesReplayed_ = 0;
 #ifndef NDEBUG
     this->t0_ = boost::chrono::steady_clock::now();
 #endif
 
+    gops_.set_capacity(get_gop_cache_budget());
+    building_.clear();
+    replaying_ = false;
+    hasReplayed_ = false;
+
     startTime_ = stream_->start_time;
     if (startTime_ == AV_NOPTS_VALUE)
     {
@@ -451,6 +573,8 @@ namespace yae
   void
   VideoTrack::handle(const AvFrm & decodedFrame)
   {
+    YAE_TRACE_SPAN(span, "VideoTrack::handle");
+
     try
     {
       AvFrm decodedFrameCopy(decodedFrame);
@@ -466,11 +590,11 @@ namespace yae
           boost::chrono::duration_cast<boost::chrono::microseconds>(t1 - t0_).
           count();
 
-        double fps = double(framesDecoded_) / (1e-6 * double(dt));
+        double fps = double(framesDecoded_.load()) / (1e-6 * double(dt));
 
         std::cerr
           << codecContext_->codec->name
-          << ", frames decoded: " << framesDecoded_
+          << ", frames decoded: " << framesDecoded_.load()
           << ", elapsed time: " << dt << " usec, decoder fps: " << fps
           << std::endl;
       }
@@ -691,8 +815,10 @@ namespace yae
           {
             std::cerr
               << "\nNOTE: detected large PTS jump: " << std::endl
-              << "frame\t:" << framesDecoded_ - 2 << " - " << ta << std::endl
-              << "frame\t:" << framesDecoded_ - 1 << " - " << tb << std::endl
+              << "frame\t:" << framesDecoded_.load() - 2 << " - " << ta
+              << std::endl
+              << "frame\t:" << framesDecoded_.load() - 1 << " - " << tb
+              << std::endl
               << "difference " << dt << " seconds, equivalent to "
               << dt / fd << " frames" << std::endl
               << std::endl;
@@ -713,9 +839,34 @@ namespace yae
         }
       }
 
+      // every keyframe starts a new GOP:
+      if (decoded.key_frame && gotPTS)
+      {
+        gopStart(decoded.pts);
+      }
+
       // decode CEA-608 packets, if there are any:
       cc_.decode(stream_->time_base, decoded, &terminator_);
 
+      // when there is nothing to filter or convert hand the decoded
+      // (reference counted) frame to the renderer as is.
+      //
+      // upside-down frames are excluded because pushFrame flips
+      // them in place, and that would corrupt the decoder reference:
+      if (filterGraph_.isPassThrough() && decoded.linesize[0] >= 0)
+      {
+        // count only the frames that were actually queued:
+        uint64 produced = framesProduced_.load();
+        pushFrame(decoded, stream_->time_base);
+
+        if (framesProduced_.load() != produced)
+        {
+          framesPassedThrough_++;
+        }
+
+        return;
+      }
+
       if (!filterGraph_.push(&decoded))
       {
         YAE_ASSERT(false);
@@ -733,165 +884,520 @@ namespace yae
           break;
         }
 
-        TVideoFramePtr vfPtr(new TVideoFrame());
-        TVideoFrame & vf = *vfPtr;
+        uint64 produced = framesProduced_.load();
+        bool ok = pushFrame(output, filterGraphOutputTimeBase);
 
-        vf.time_.base_ = filterGraphOutputTimeBase.den;
-        vf.time_.time_ = filterGraphOutputTimeBase.num * output.pts;
-        vf.trackId_ = Track::id();
+        if (framesProduced_.load() != produced)
+        {
+          framesFiltered_++;
+        }
 
-        // make sure the frame is in the in/out interval:
-        if (playbackEnabled_)
+        if (!ok)
         {
-          double t = vf.time_.sec();
-          double dt = 1.0 / double(output_.frameRate_);
-          if (t > timeOut_ || (t + dt) < timeIn_)
-          {
-            if (t > timeOut_)
-            {
-              discarded_++;
-            }
+          return;
+        }
+      }
+    }
+    catch (...)
+    {}
+  }
 
-#if 0
-            std::cerr << "discarding video frame: " << t
-                      << ", expecting [" << timeIn_ << ", " << timeOut_ << ")"
-                      << std::endl;
-#endif
-            return;
-          }
+  //----------------------------------------------------------------
+  // VideoTrack::pushFrame
+  //
+  bool
+  VideoTrack::pushFrame(AVFrame & output, const AVRational & timeBase)
+  {
+    TVideoFramePtr vfPtr(new TVideoFrame());
+    TVideoFrame & vf = *vfPtr;
 
-          discarded_ = 0;
-        }
+    vf.time_.base_ = timeBase.den;
+    vf.time_.time_ = timeBase.num * output.pts;
+    vf.trackId_ = Track::id();
 
-        YAE_ASSERT(output_.initAbcToRgbMatrix_);
-        vf.traits_ = output_;
+    if (hasReplayed_ && vf.time_ < replayedUntil_)
+    {
+      // this one was already served from the GOP cache:
+      return true;
+    }
 
-        if (output.linesize[0] < 0)
+    // frames outside of the in/out interval are not needed,
+    // unless they complete a GOP that is being cached:
+    bool caching = !building_.empty() && gopCacheEnabled();
+    if (playbackEnabled_ && !caching)
+    {
+      double t = vf.time_.sec();
+      double dt = 1.0 / double(output_.frameRate_);
+      if (t > timeOut_ || (t + dt) < timeIn_)
+      {
+        if (t > timeOut_)
         {
-          // upside-down frame, actually flip it around (unlike vflip):
-          const pixelFormat::Traits * ptts =
-            pixelFormat::getTraits(output_.pixelFormat_);
+          discarded_++;
+        }
 
-          unsigned char stride[4] = { 0 };
-          std::size_t numSamplePlanes = ptts->getPlanes(stride);
+        return false;
+      }
+    }
 
-          std::size_t lumaPlane =
-            (ptts->flags_ & pixelFormat::kPlanar) ? 0 : numSamplePlanes;
+    YAE_ASSERT(output_.initAbcToRgbMatrix_);
+    vf.traits_ = output_;
 
-          std::size_t alphaPlane =
-            ((ptts->flags_ & pixelFormat::kAlpha) &&
-             (ptts->flags_ & pixelFormat::kPlanar)) ?
-            numSamplePlanes - 1 : numSamplePlanes;
+    if (output.linesize[0] < 0)
+    {
+      // upside-down frame, actually flip it around (unlike vflip):
+      const pixelFormat::Traits * ptts =
+        pixelFormat::getTraits(output_.pixelFormat_);
 
-          for (unsigned char i = 0; i < numSamplePlanes; i++)
-          {
-            std::size_t rows = output.height;
-            if (i != lumaPlane && i != alphaPlane)
-            {
-              rows /= ptts->chromaBoxH_;
-            }
-
-            int rowBytes = -output.linesize[i];
-            if (rowBytes <= 0)
-            {
-              continue;
-            }
-
-            temp_.resize(rowBytes);
-            unsigned char * temp = &temp_[0];
-            unsigned char * tail = output.data[i];
-            unsigned char * head = tail + output.linesize[i] * (rows - 1);
-
-            output.data[i] = head;
-            output.linesize[i] = rowBytes;
-
-            while (head < tail)
-            {
-              memcpy(temp, head, rowBytes);
-              memcpy(head, tail, rowBytes);
-              memcpy(tail, temp, rowBytes);
-
-              head += rowBytes;
-              tail -= rowBytes;
-            }
-          }
-        }
+      unsigned char stride[4] = { 0 };
+      std::size_t numSamplePlanes = ptts->getPlanes(stride);
+
+      std::size_t lumaPlane =
+        (ptts->flags_ & pixelFormat::kPlanar) ? 0 : numSamplePlanes;
 
-        // use AVFrame directly:
-        TIPlanarBufferPtr sampleBuffer(new TAVFrameBuffer(&output),
-                                       &IPlanarBuffer::deallocator);
-        vf.traits_.visibleWidth_ = output.width;
-        vf.traits_.visibleHeight_ = output.height;
-        vf.traits_.encodedWidth_ = vf.traits_.visibleWidth_;
-        vf.traits_.encodedHeight_ = vf.traits_.visibleHeight_;
-        vf.data_ = sampleBuffer;
+      std::size_t alphaPlane =
+        ((ptts->flags_ & pixelFormat::kAlpha) &&
+         (ptts->flags_ & pixelFormat::kPlanar)) ?
+        numSamplePlanes - 1 : numSamplePlanes;
 
-        // don't forget about tempo scaling:
+      for (unsigned char i = 0; i < numSamplePlanes; i++)
+      {
+        std::size_t rows = output.height;
+        if (i != lumaPlane && i != alphaPlane)
         {
-          boost::lock_guard<boost::mutex> lock(tempoMutex_);
-          vf.tempo_ = tempo_;
+          rows /= ptts->chromaBoxH_;
         }
 
-        // check for applicable subtitles:
+        int rowBytes = -output.linesize[i];
+        if (rowBytes <= 0)
         {
-          double v0 = vf.time_.sec();
-          double v1 = v0 + (vf.traits_.frameRate_ ?
-                            1.0 / vf.traits_.frameRate_ :
-                            0.042);
+          continue;
+        }
 
-          std::size_t nsubs = subs_ ? subs_->size() : 0;
-          for (std::size_t i = 0; i < nsubs; i++)
-          {
-            SubtitlesTrack & subTrack = *((*subs_)[i]);
-            gatherApplicableSubtitles(vf.subs_, v0, v1, subTrack, terminator_);
-          }
+        temp_.resize(rowBytes);
+        unsigned char * temp = &temp_[0];
+        unsigned char * tail = output.data[i];
+        unsigned char * head = tail + output.linesize[i] * (rows - 1);
 
-          // and closed captions also:
-          SubtitlesTrack * cc = cc_.captions();
-          if (cc)
-          {
-            gatherApplicableSubtitles(vf.subs_, v0, v1, *cc, terminator_);
-          }
+        output.data[i] = head;
+        output.linesize[i] = rowBytes;
+
+        while (head < tail)
+        {
+          memcpy(temp, head, rowBytes);
+          memcpy(head, tail, rowBytes);
+          memcpy(tail, temp, rowBytes);
+
+          head += rowBytes;
+          tail -= rowBytes;
         }
+      }
+    }
 
-#if 0 // ndef NDEBUG
+    // use AVFrame directly:
+    TIPlanarBufferPtr sampleBuffer(new TAVFrameBuffer(&output),
+                                   &IPlanarBuffer::deallocator);
+    vf.traits_.visibleWidth_ = output.width;
+    vf.traits_.visibleHeight_ = output.height;
+    vf.traits_.encodedWidth_ = vf.traits_.visibleWidth_;
+    vf.traits_.encodedHeight_ = vf.traits_.visibleHeight_;
+    vf.data_ = sampleBuffer;
+
+    if (caching)
+    {
+      // keep a copy, the queued frame is handed off to the renderer:
+      TVideoFramePtr cached(new TVideoFrame(vf));
+      gopAdd(cached, frame_bytes(output));
+    }
+
+    return queueFrame(vfPtr);
+  }
+
+  //----------------------------------------------------------------
+  // VideoTrack::queueFrame
+  //
+  bool
+  VideoTrack::queueFrame(const TVideoFramePtr & vfPtr)
+  {
+    TVideoFrame & vf = *vfPtr;
+
+    // make sure the frame is in the in/out interval:
+    if (playbackEnabled_)
+    {
+      double t = vf.time_.sec();
+      double dt = 1.0 / double(output_.frameRate_);
+      if (t > timeOut_ || (t + dt) < timeIn_)
       {
-        boost::chrono::steady_clock::time_point
-          t1 = boost::chrono::steady_clock::now();
+        if (t > timeOut_)
+        {
+          discarded_++;
+        }
 
-        uint64 dt =
-          boost::chrono::duration_cast<boost::chrono::microseconds>(t1 - t0_).
-          count();
+#if 0
+        std::cerr << "discarding video frame: " << t
+                  << ", expecting [" << timeIn_ << ", " << timeOut_ << ")"
+                  << std::endl;
+#endif
+        return false;
+      }
 
-        framesProduced_++;
-        double fps = double(framesProduced_) / (1e-6 * double(dt));
+      discarded_ = 0;
+    }
 
-        std::cerr
-          << Track::id_
-          << ", frames produced: " << framesProduced_
-          << ", elapsed time: " << dt << " usec, fps: " << fps
-          << std::endl;
+    // don't forget about tempo scaling:
+    {
+      boost::lock_guard<boost::mutex> lock(tempoMutex_);
+      vf.tempo_ = tempo_;
+    }
+
+    if (capture_)
+    {
+      // decodeKeyframe only wants the keyframe:
+      if (!*capture_)
+      {
+        *capture_ = vfPtr;
+      }
+
+      return true;
+    }
+
+    // check for applicable subtitles:
+    {
+      double v0 = vf.time_.sec();
+      double v1 = v0 + (vf.traits_.frameRate_ ?
+                        1.0 / vf.traits_.frameRate_ :
+                        0.042);
+
+      std::size_t nsubs = subs_ ? subs_->size() : 0;
+      for (std::size_t i = 0; i < nsubs; i++)
+      {
+        SubtitlesTrack & subTrack = *((*subs_)[i]);
+        gatherApplicableSubtitles(vf.subs_, v0, v1, subTrack, terminator_);
       }
+
+      // and closed captions also:
+      SubtitlesTrack * cc = cc_.captions();
+      if (cc)
+      {
+        gatherApplicableSubtitles(vf.subs_, v0, v1, *cc, terminator_);
+      }
+    }
+
+#if 0 // ndef NDEBUG
+  {
+    boost::chrono::steady_clock::time_point
+      t1 = boost::chrono::steady_clock::now();
+
+    uint64 dt =
+      boost::chrono::duration_cast<boost::chrono::microseconds>(t1 - t0_).
+      count();
+
+    double fps = double(framesProduced_.load()) / (1e-6 * double(dt));
+
+    std::cerr
+      << Track::id_
+      << ", frames produced: " << framesProduced_
+      << ", elapsed time: " << dt << " usec, fps: " << fps
+      << std::endl;
+  }
 #endif
 
 #if YAE_DEBUG_SEEKING_AND_FRAMESTEP
-        {
-          std::string ts = to_hhmmss_ms(vfPtr);
-          std::cerr << "push video frame: " << ts << std::endl;
-        }
+    {
+      std::string ts = to_hhmmss_ms(vfPtr);
+      std::cerr << "push video frame: " << ts << std::endl;
+    }
 #endif
 
-        // put the output frame into frame queue:
-        if (!frameQueue_.push(vfPtr, &terminator_))
+    // put the output frame into frame queue,
+    // a pooled decoder must not block its worker:
+    if (pool_ ?
+        !parkedFrames_.push(frameQueue_, vfPtr) :
+        !frameQueue_.push(vfPtr, &terminator_))
+    {
+      return false;
+    }
+
+    framesProduced_++;
+
+    // std::cerr << "V: " << vf.time_.sec() << std::endl;
+    return true;
+  }
+
+  //----------------------------------------------------------------
+  // VideoTrack::decode
+  //
+  void
+  VideoTrack::decode(const TPacketPtr & packetPtr)
+  {
+    if (!packetPtr)
+    {
+      // end of stream, flush out buffered frames:
+      replaying_ = false;
+      Track::decode(packetPtr);
+      gopFinish();
+      return;
+    }
+
+    const AVPacket & packet = packetPtr->get();
+    if ((packet.flags & AV_PKT_FLAG_KEY) &&
+        packet.pts != AV_NOPTS_VALUE &&
+        gopCacheEnabled())
+    {
+      TVideoGopCache::TRefPtr ref = gops_.get(packet.pts);
+      if (ref)
+      {
+        if (!replaying_)
         {
-          return;
+          // finish up the frames that precede the cached GOP;
+          // GOPs still being built may be missing frames that
+          // depend on the packets that will now be skipped,
+          // so they are not cached:
+          Track::flush();
+          building_.clear();
+          replaying_ = true;
         }
 
-        // std::cerr << "V: " << vf.time_.sec() << std::endl;
+        gopReplay(*(ref->value()));
+        return;
       }
+
+      // resume decoding with this keyframe:
+      replaying_ = false;
     }
-    catch (...)
-    {}
+
+    if (replaying_)
+    {
+      // this packet belongs to a GOP that was replayed:
+      return;
+    }
+
+    Track::decode(packetPtr);
+  }
+
+  //----------------------------------------------------------------
+  // VideoTrack::purgeGopCache
+  //
+  void
+  VideoTrack::purgeGopCache()
+  {
+    gopsInvalid_.store(true);
+    gops_.purge_unreferenced_entries();
+  }
+
+  //----------------------------------------------------------------
+  // VideoTrack::gopCacheEnabled
+  //
+  bool
+  VideoTrack::gopCacheEnabled() const
+  {
+    // with non-reference frames skipped the GOPs would be incomplete,
+    // and keyframes decoded by decodeKeyframe are not GOPs at all:
+    return (gops_.capacity() > 0 &&
+            !skipNonReferenceFrames_ &&
+            !capture_);
+  }
+
+  //----------------------------------------------------------------
+  // VideoTrack::gopStart
+  //
+  void
+  VideoTrack::gopStart(int64_t pts)
+  {
+    if (gopsInvalid_.exchange(false))
+    {
+      building_.clear();
+    }
+
+    if (!gopCacheEnabled())
+    {
+      building_.clear();
+      return;
+    }
+
+    if (gopsArmed_.exchange(false))
+    {
+      gopsToCache_ = kGopCacheWindow;
+    }
+
+    if (!gopsToCache_ && building_.empty())
+    {
+      return;
+    }
+
+    TTime t0(stream_->time_base.num * pts, stream_->time_base.den);
+    TVideoGopPtr gop(new VideoGop(pts, t0));
+
+    if (gopsToCache_)
+    {
+      gopsToCache_--;
+    }
+    else
+    {
+      // not cached, but the GOPs still being built
+      // need to know where they end:
+      gop->dropped_ = true;
+    }
+
+    building_.push_back(gop);
+  }
+
+  //----------------------------------------------------------------
+  // VideoTrack::gopAdd
+  //
+  // frames come out in presentation order, so once a frame
+  // of the next GOP shows up the previous GOP is complete:
+  //
+  void
+  VideoTrack::gopAdd(const TVideoFramePtr & vfPtr, std::size_t bytes)
+  {
+    if (gopsInvalid_.exchange(false))
+    {
+      building_.clear();
+      return;
+    }
+
+    const TTime & t = vfPtr->time_;
+    double dt = 1.0 / double(output_.frameRate_);
+
+    // find the GOP this frame belongs to:
+    std::list<TVideoGopPtr>::reverse_iterator found = building_.rbegin();
+    while (found != building_.rend() && t < (*found)->t0_)
+    {
+      ++found;
+    }
+
+    if (found == building_.rend())
+    {
+      // precedes the first keyframe since the last seek:
+      return;
+    }
+
+    VideoGop & gop = *(*found);
+    gop.t1_ = std::max(gop.t1_, t + TTime(dt));
+
+    if (!gop.dropped_ && gop.bytes_ + bytes > gops_.capacity())
+    {
+      // the cache would evict it right away, don't pin its frames:
+      std::vector<TVideoFramePtr>().swap(gop.frames_);
+      gop.bytes_ = 0;
+      gop.dropped_ = true;
+    }
+
+    if (!gop.dropped_)
+    {
+      gop.frames_.push_back(vfPtr);
+      gop.bytes_ += bytes;
+    }
+
+    while (building_.size() > 1)
+    {
+      std::list<TVideoGopPtr>::iterator next = ++(building_.begin());
+      if (t < (*next)->t0_)
+      {
+        break;
+      }
+
+      TVideoGopPtr done = building_.front();
+      building_.pop_front();
+
+      if (!done->frames_.empty())
+      {
+        done->t1_ = (*next)->t0_;
+        gops_.put(done->pts_, done);
+      }
+    }
+
+    if (building_.size() == 1 && building_.front()->dropped_)
+    {
+      // nothing left to cache until the next seek:
+      building_.clear();
+    }
+  }
+
+  //----------------------------------------------------------------
+  // VideoTrack::gopFinish
+  //
+  // end of stream, the last GOP is complete:
+  //
+  void
+  VideoTrack::gopFinish()
+  {
+    if (gopsInvalid_.exchange(false) || building_.empty())
+    {
+      building_.clear();
+      return;
+    }
+
+    // only the last one can be complete, the others
+    // would have been cached by gopAdd already:
+    TVideoGopPtr done = building_.back();
+    building_.clear();
+
+    if (!done->frames_.empty())
+    {
+      gops_.put(done->pts_, done);
+    }
+  }
+
+  //----------------------------------------------------------------
+  // VideoTrack::gopReplay
+  //
+  void
+  VideoTrack::gopReplay(const VideoGop & gop)
+  {
+    YAE_TRACE_SPAN(span, "VideoTrack::gopReplay");
+
+    for (std::size_t i = 0, n = gop.frames_.size(); i < n; i++)
+    {
+      if (!terminator_.keepWaiting())
+      {
+        break;
+      }
+
+      // subtitles and tempo are applied when the frame is queued:
+      TVideoFramePtr vfPtr(new TVideoFrame(*(gop.frames_[i])));
+      vfPtr->subs_.clear();
+
+      if (queueFrame(vfPtr))
+      {
+        framesReplayed_++;
+      }
+    }
+
+    // when decoding resumes it may produce frames
+    // that precede the next keyframe (open GOP),
+    // those have just been replayed:
+    hasReplayed_ = true;
+    replayedUntil_ = gop.t1_;
+  }
+
+  //----------------------------------------------------------------
+  // VideoTrack::deliverParkedFrames
+  //
+  bool
+  VideoTrack::deliverParkedFrames()
+  {
+    return parkedFrames_.deliver(frameQueue_);
+  }
+
+  //----------------------------------------------------------------
+  // VideoTrack::dropParkedFrames
+  //
+  void
+  VideoTrack::dropParkedFrames()
+  {
+    parkedFrames_.clear();
+  }
+
+  //----------------------------------------------------------------
+  // VideoTrack::observeFrameQueue
+  //
+  void
+  VideoTrack::observeFrameQueue(bool enable)
+  {
+    Track * track = this;
+    frameQueue_.setRoomObserver(enable ? &Track::decoderTaskObserver : NULL,
+                                enable ? track : NULL);
   }
 
   //----------------------------------------------------------------
@@ -1052,7 +1558,7 @@ namespace yae
       return true;
     }
 
-    bool alreadyDecoding = thread_.isRunning();
+    bool alreadyDecoding = threadIsRunning();
     YAE_ASSERT(sameTraits || !alreadyDecoding);
 
     if (alreadyDecoding && !sameTraits)
@@ -1063,18 +1569,19 @@ namespace yae
 
       terminator_.stopWaiting(true);
       frameQueue_.clear();
-      thread_.stop();
-      thread_.wait();
+      decoderSuspend();
     }
 
     override_ = traits;
     deinterlace_ = deint;
     overrideSourcePAR_ = sourcePixelAspectRatio;
 
+    // cached frames were made for the previous output traits:
+    purgeGopCache();
+
     if (alreadyDecoding && !sameTraits)
     {
-      terminator_.stopWaiting(false);
-      return thread_.run();
+      return decoderResume();
     }
 
     return true;
@@ -1090,6 +1597,21 @@ namespace yae
     return true;
   }
 
+  //----------------------------------------------------------------
+  // VideoTrack::frameStats
+  //
+  VideoTrack::FrameStats
+  VideoTrack::frameStats() const
+  {
+    FrameStats stats;
+    stats.decoded_ = framesDecoded_.load();
+    stats.produced_ = framesProduced_.load();
+    stats.passedThrough_ = framesPassedThrough_.load();
+    stats.filtered_ = framesFiltered_.load();
+    stats.replayed_ = framesReplayed_.load();
+    return stats;
+  }
+
   //----------------------------------------------------------------
   // VideoTrack::getNextFrame
   //
@@ -1135,6 +1657,111 @@ namespace yae
     return ok;
   }
 
+  //----------------------------------------------------------------
+  // choose_lowres
+  //
+  // largest lowres factor that still decodes at least as many
+  // pixels as the scaled output needs:
+  //
+  static int
+  choose_lowres(const AVCodec * codec,
+                const VideoTraits & native,
+                const VideoTraits & output)
+  {
+    if (!codec->max_lowres || native.offsetTop_ || native.offsetLeft_)
+    {
+      // the crop filter expects full resolution frames:
+      return 0;
+    }
+
+    // output is scaled before it is transposed:
+    bool transpose = (output.cameraRotation_ - native.cameraRotation_) % 180;
+    unsigned int w = transpose ? output.visibleHeight_ : output.visibleWidth_;
+    unsigned int h = transpose ? output.visibleWidth_ : output.visibleHeight_;
+
+    int lowres = 0;
+    while (lowres < codec->max_lowres &&
+           (native.visibleWidth_ >> (lowres + 1)) >= w &&
+           (native.visibleHeight_ >> (lowres + 1)) >= h)
+    {
+      lowres++;
+    }
+
+    return lowres;
+  }
+
+  //----------------------------------------------------------------
+  // VideoTrack::decodeKeyframe
+  //
+  TVideoFramePtr
+  VideoTrack::decodeKeyframe(const TPacketPtr & packetPtr)
+  {
+    TVideoFramePtr vf;
+
+    if (threadIsRunning() || !packetPtr)
+    {
+      YAE_ASSERT(false);
+      return vf;
+    }
+
+    const AVPacket & packet = packetPtr->get();
+    if (!(packet.flags & AV_PKT_FLAG_KEY))
+    {
+      return vf;
+    }
+
+    // refresh native traits, reset counters and timestamps:
+    decoderStartup();
+
+    const AVCodecParameters & params = *(stream_->codecpar);
+    const AVCodec * codec = avcodec_find_decoder(params.codec_id);
+    if (!codec)
+    {
+      return vf;
+    }
+
+    AvCodecContextPtr ctxPtr(avcodec_alloc_context3(codec));
+    AVCodecContext * ctx = ctxPtr.get();
+    avcodec_parameters_to_context(ctx, &params);
+
+    // one frame, decoder threads would only add latency:
+    ctx->thread_count = 1;
+    ctx->lowres = choose_lowres(codec, native_, output_);
+    ctx->skip_loop_filter = AVDISCARD_ALL;
+    ctx->flags2 |= AV_CODEC_FLAG2_FAST;
+
+    if (avcodec_open2(ctx, codec, NULL) < 0)
+    {
+      return vf;
+    }
+
+    ctx->pkt_timebase = stream_->time_base;
+
+    close();
+    codecContext_ = ctxPtr;
+
+    // no in/out interval while capturing:
+    bool playbackEnabled = playbackEnabled_;
+    playbackEnabled_ = false;
+    capture_ = &vf;
+
+    Track::decode(packetPtr);
+    if (!vf)
+    {
+      // flush out the buffered frame:
+      Track::flush();
+    }
+
+    capture_ = NULL;
+    playbackEnabled_ = playbackEnabled;
+    building_.clear();
+
+    // the next open() should get a regular decoder:
+    close();
+
+    return vf;
+  }
+
   //----------------------------------------------------------------
   // VideoTrack::setPlaybackInterval
   //
@@ -1171,6 +1798,7 @@ namespace yae
       do { frameQueue_.clear(); }
       while (!packetQueue_.waitForConsumerToBlock(1e-2));
       frameQueue_.clear();
+      parkedFrames_.clear();
     }
 
 #if YAE_DEBUG_SEEKING_AND_FRAMESTEP
@@ -1185,6 +1813,15 @@ namespace yae
     // force the closed captions decoder to be re-created on demand:
     cc_.reset();
 
+    // decoding restarts from a keyframe, GOPs that were not
+    // finished are incomplete, cached GOPs remain valid:
+    building_.clear();
+    replaying_ = false;
+    hasReplayed_ = false;
+
+    // the user may come back here, cache what follows:
+    gopsArmed_.store(true);
+
     // push a special frame into frame queue to resetTimeCounters
     // down the line (the renderer):
     startNewSequence(frameQueue_, dropPendingFrames);
@@ -1209,6 +1846,9 @@ namespace yae
     hasPrevPTS_ = false;
     framesDecoded_ = 0;
     framesProduced_ = 0;
+    framesPassedThrough_ = 0;
+    framesFiltered_ = 0;
+    framesReplayed_ = 0;
 #ifndef NDEBUG
     this->t0_ = boost::chrono::steady_clock::now();
 #endif
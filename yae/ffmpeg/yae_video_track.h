@@ -11,16 +11,22 @@
 
 // boost library:
 #ifndef Q_MOC_RUN
+#include <boost/atomic.hpp>
 #include <boost/chrono/chrono.hpp>
 #include <boost/shared_ptr.hpp>
 #endif
 
+// standard:
+#include <list>
+#include <vector>
+
 // yae includes:
 #include "yae/ffmpeg/yae_closed_captions.h"
 #include "yae/ffmpeg/yae_ffmpeg_video_filter_graph.h"
 #include "yae/ffmpeg/yae_subtitles_track.h"
 #include "yae/ffmpeg/yae_track.h"
 #include "yae/thread/yae_queue.h"
+#include "yae/utils/yae_lru_cache.h"
 
 
 namespace yae
@@ -29,6 +35,9 @@ namespace yae
   //----------------------------------------------------------------
   // TVideoFrameQueue
   //
+  // frames are kept sorted by pts (decode order is not presentation
+  // order), so this stays a yae::Queue even with YAE_USE_RING_QUEUE:
+  //
   typedef Queue<TVideoFramePtr> TVideoFrameQueue;
 
 
@@ -55,11 +64,95 @@ namespace yae
   };
 
 
+  //----------------------------------------------------------------
+  // set_gop_cache_budget
+  //
+  // video tracks keep the output frames of the GOPs decoded right
+  // after a seek (or a loop rewind) around, so that seeking back and
+  // forth over them (scrubbing, frame stepping) does not have to decode
+  // them again.  Plain forward playback does not populate the cache.
+  //
+  // the budget is in bytes per video track, 0 disables the cache:
+  //
+  YAE_API void set_gop_cache_budget(std::size_t bytes);
+  YAE_API std::size_t get_gop_cache_budget();
+
+
+  //----------------------------------------------------------------
+  // VideoGop
+  //
+  // output frames of one GOP, in presentation order:
+  //
+  struct YAE_API VideoGop
+  {
+    VideoGop(int64_t pts, const TTime & t0):
+      pts_(pts),
+      t0_(t0),
+      t1_(t0),
+      bytes_(0),
+      dropped_(false)
+    {}
+
+    // keyframe PTS, in stream time base:
+    int64_t pts_;
+
+    // presentation timespan [t0, t1), up to the next keyframe:
+    TTime t0_;
+    TTime t1_;
+
+    std::vector<TVideoFramePtr> frames_;
+
+    // memory held by the frames:
+    std::size_t bytes_;
+
+    // the GOP does not fit in the cache budget, its frames
+    // are released and no more are kept:
+    bool dropped_;
+  };
+
+  //----------------------------------------------------------------
+  // TVideoGopPtr
+  //
+  typedef boost::shared_ptr<VideoGop> TVideoGopPtr;
+
+  //----------------------------------------------------------------
+  // TVideoGopCache
+  //
+  // complete GOPs indexed by keyframe PTS, budgeted in bytes:
+  //
+  typedef ShardedLRUCache<int64_t, TVideoGopPtr> TVideoGopCache;
+
+
   //----------------------------------------------------------------
   // VideoTrack
   //
   struct YAE_API VideoTrack : public Track
   {
+    //----------------------------------------------------------------
+    // FrameStats
+    //
+    struct YAE_API FrameStats
+    {
+      FrameStats();
+
+      // pass-through frames as a fraction of all output frames:
+      double passThroughRate() const;
+
+      uint64 decoded_;
+
+      // frames queued for the renderer, including replayed frames:
+      uint64 produced_;
+
+      // frames queued for the renderer without going through
+      // the filter graph (zero-copy) vs. frames pulled from it,
+      // frames that were discarded after all are not counted:
+      uint64 passedThrough_;
+      uint64 filtered_;
+
+      // frames served from the GOP cache instead of the decoder:
+      uint64 replayed_;
+    };
+
     VideoTrack(Track & track);
 
     // virtual:
@@ -84,6 +177,36 @@ namespace yae
     // virtual:
     void handle(const AvFrm & decodedFrame);
 
+    // virtual: packets of cached GOPs are not decoded,
+    // the cached frames are put in the frame queue instead:
+    void decode(const TPacketPtr & packetPtr);
+
+    // discard cached GOPs, must be called whenever the output frames
+    // would no longer look the same (traits, decoder shortcuts):
+    void purgeGopCache();
+
+  protected:
+    // wrap a decoded (or filtered) frame and put it in the frame queue,
+    // returns false if the caller should stop producing frames:
+    bool pushFrame(AVFrame & output, const AVRational & timeBase);
+
+    // put a frame in the frame queue, if it is in the in/out interval:
+    bool queueFrame(const TVideoFramePtr & vfPtr);
+
+    // GOP cache helpers, these run on the decoding thread:
+    bool gopCacheEnabled() const;
+    void gopStart(int64_t pts);
+    void gopAdd(const TVideoFramePtr & vfPtr, std::size_t bytes);
+    void gopFinish();
+    void gopReplay(const VideoGop & gop);
+
+    // virtual: pooled decoding support, see ParkedFrames:
+    bool deliverParkedFrames();
+    void dropParkedFrames();
+    void observeFrameQueue(bool enable);
+
+  public:
+
     // virtual:
     bool threadStop();
 
@@ -103,6 +226,23 @@ namespace yae
     // retrieve a decoded/converted frame from the queue:
     bool getNextFrame(TVideoFramePtr & frame, QueueWaitMgr * terminator);
 
+    // frame counters since the decoder was started or the last seek.
+    //
+    // NOTE: the counters are atomic, but they are read one at a time,
+    // so while decoding is in progress they may be off by a frame
+    // relative to each other:
+    FrameStats frameStats() const;
+
+    // decode a keyframe packet on the calling thread and return
+    // the converted frame, bypassing the decoder thread and the queues.
+    //
+    // a single-threaded decoder is opened for this, it skips the loop
+    // filter and decodes at reduced resolution (lowres) when the codec
+    // supports it and the output is small enough; it is closed afterwards.
+    //
+    // NOTE: the decoder thread must not be running:
+    TVideoFramePtr decodeKeyframe(const TPacketPtr & packetPtr);
+
     // adjust playback interval (used when seeking or looping):
     void setPlaybackInterval(double timeIn, double timeOut, bool enabled);
 
@@ -133,6 +273,7 @@ namespace yae
     double overrideSourcePAR_;
 
     TVideoFrameQueue frameQueue_;
+    ParkedFrames<TVideoFrameQueue> parkedFrames_;
     VideoTraits override_;
     VideoTraits native_;
     VideoTraits output_;
@@ -142,8 +283,13 @@ namespace yae
     TTime prevPTS_;
     bool hasPrevPTS_;
 
-    uint64 framesDecoded_;
-    uint64 framesProduced_;
+    // see FrameStats, updated by the decoding thread
+    // and read by frameStats from any thread:
+    boost::atomic<uint64> framesDecoded_;
+    boost::atomic<uint64> framesProduced_;
+    boost::atomic<uint64> framesPassedThrough_;
+    boost::atomic<uint64> framesFiltered_;
+    boost::atomic<uint64> framesReplayed_;
 
     // CEA-608 closed captions decoder:
     CaptionsDecoder cc_;
@@ -153,8 +299,35 @@ namespace yae
 
     VideoFilterGraph filterGraph_;
 
+    // recently decoded GOPs:
+    TVideoGopCache gops_;
+
+    // GOPs that are still being decoded, oldest first:
+    std::list<TVideoGopPtr> building_;
+
+    // set when the cached frames no longer match the output:
+    boost::atomic<bool> gopsInvalid_;
+
+    // set by resetTimeCounters, a seek is a hint the user may seek back,
+    // the next few GOPs are cached; gopsToCache_ counts them down:
+    boost::atomic<bool> gopsArmed_;
+    std::size_t gopsToCache_;
+
+    // while replaying cached GOPs packets are not decoded,
+    // until a keyframe of a GOP that is not cached comes along:
+    bool replaying_;
+
+    // decoded frames that precede this time point
+    // have already been replayed from the cache:
+    bool hasReplayed_;
+    TTime replayedUntil_;
+
     std::vector<unsigned char> temp_;
 
+    // set by decodeKeyframe, the first output frame is stored here
+    // instead of being put in the frame queue:
+    TVideoFramePtr * capture_;
+
 #ifndef NDEBUG
     // for estimating decoder fps and output fps:
     boost::chrono::steady_clock::time_point t0_;
@@ -133,16 +133,23 @@ namespace yae
   struct Queue
   {
     typedef Queue<TData> TSelf;
+    typedef TData value_type;
     typedef bool(*TSortFunc)(const TData &, const TData &);
+    typedef void(*TObserver)(void *);
     typedef std::list<TData> TSequence;
 
     Queue(std::size_t maxSize = 1):
       closed_(true),
       producerIsBlocked_(false),
+      producerIsParked_(false),
       consumerIsBlocked_(false),
       size_(0),
       maxSize_(maxSize),
-      sortFunc_(0)
+      sortFunc_(0),
+      observer_(0),
+      observerContext_(NULL),
+      roomObserver_(0),
+      roomObserverContext_(NULL)
     {}
 
     ~Queue()
@@ -159,6 +166,32 @@ namespace yae
       sortFunc_ = sortFunc;
     }
 
+    // the observer is called (outside the queue lock) after data
+    // is pushed and when the queue is closed, so that a cooperative
+    // consumer (see popOrPark) can be scheduled instead of blocking
+    // in pop.
+    //
+    // NOTE: observers are called while holding observerMutex_,
+    // so once setObserver returns the previous observer is not running
+    // and will not be called again -- its context may be destroyed:
+    void setObserver(TObserver observer, void * context)
+    {
+      boost::lock_guard<boost::mutex> lock(observerMutex_);
+      observer_ = observer;
+      observerContext_ = context;
+    }
+
+    // the room observer is called (outside the queue lock) once there
+    // is room in the queue after pushOrPark found it full, or when
+    // the queue is closed, so that a cooperative producer can be
+    // scheduled instead of blocking in push; same NOTE as setObserver:
+    void setRoomObserver(TObserver observer, void * context)
+    {
+      boost::lock_guard<boost::mutex> lock(observerMutex_);
+      roomObserver_ = observer;
+      roomObserverContext_ = context;
+    }
+
     void setMaxSizeUnlimited()
     {
       // change max queue size:
@@ -168,6 +201,7 @@ namespace yae
       }
 
       cond_.notify_all();
+      notifyRoomObserver();
     }
 
     void setMaxSize(std::size_t maxSize)
@@ -185,6 +219,7 @@ namespace yae
       }
 
       cond_.notify_all();
+      notifyRoomObserver();
     }
 
     std::size_t getMaxSize() const
@@ -227,6 +262,8 @@ namespace yae
       }
 
       cond_.notify_all();
+      notifyObserver();
+      notifyRoomObserver();
       return true;
     }
 
@@ -251,6 +288,7 @@ namespace yae
       }
 
       cond_.notify_all();
+      notifyRoomObserver();
       return true;
     }
 
@@ -267,6 +305,7 @@ namespace yae
         }
 
         cond_.notify_all();
+        notifyRoomObserver();
         return true;
       }
       catch (...)
@@ -308,6 +347,41 @@ namespace yae
         }
 
         cond_.notify_all();
+        notifyObserver();
+        return true;
+      }
+      catch (...)
+      {}
+
+      return false;
+    }
+
+    // non-blocking push for cooperative producers that are scheduled
+    // by the room observer instead of waiting in push; returns false
+    // if the queue is full or closed, the data is not queued then:
+    bool pushOrPark(const TData & newData)
+    {
+      try
+      {
+        {
+          boost::lock_guard<boost::mutex> lock(mutex_);
+          if (closed_)
+          {
+            return false;
+          }
+
+          if (size_ >= maxSize_)
+          {
+            producerIsParked_ = true;
+            return false;
+          }
+
+          insert(newData);
+          size_++;
+        }
+
+        cond_.notify_all();
+        notifyObserver();
         return true;
       }
       catch (...)
@@ -347,27 +421,50 @@ namespace yae
             return false;
           }
 
-          while (sequences_.front().empty())
+          take(data);
+
+#if 0 // ndef NDEBUG
+          std::cerr << this << " pop done, size " << std::endl;
+#endif
+        }
+
+        cond_.notify_all();
+        notifyRoomObserver();
+        return true;
+      }
+      catch (...)
+      {}
+
+      return false;
+    }
+
+    // non-blocking pop for cooperative consumers that are scheduled
+    // by the observer instead of waiting in pop; when the queue is empty
+    // the consumer is considered blocked until its next popOrPark call:
+    bool popOrPark(TData & data)
+    {
+      try
+      {
+        {
+          boost::lock_guard<boost::mutex> lock(mutex_);
+          if (closed_)
           {
-            sequences_.pop_front();
+            return false;
           }
 
-          TSequence & sequence = sequences_.front();
-          data = sequence.back();
-          sequence.pop_back();
-          size_--;
-
-          if (sequence.empty())
+          if (!size_)
           {
-            sequences_.pop_front();
+            consumerIsBlocked_ = true;
+            cond_.notify_all();
+            return false;
           }
 
-#if 0 // ndef NDEBUG
-          std::cerr << this << " pop done, size " << std::endl;
-#endif
+          consumerIsBlocked_ = false;
+          take(data);
         }
 
         cond_.notify_all();
+        notifyRoomObserver();
         return true;
       }
       catch (...)
@@ -422,6 +519,7 @@ namespace yae
         }
 
         cond_.notify_all();
+        notifyRoomObserver();
         return true;
       }
       catch (...)
@@ -515,21 +613,75 @@ namespace yae
 
     void startNewSequence(const TData & sequenceEndData)
     {
-      boost::lock_guard<boost::mutex> lock(mutex_);
-      if (sequences_.empty())
       {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        if (sequences_.empty())
+        {
+          sequences_.push_back(TSequence());
+        }
+
+        TSequence & sequence = sequences_.back();
+        sequence.push_front(sequenceEndData);
+        size_++;
         sequences_.push_back(TSequence());
+        cond_.notify_all();
       }
 
-      TSequence & sequence = sequences_.back();
-      sequence.push_front(sequenceEndData);
-      size_++;
-      sequences_.push_back(TSequence());
-      cond_.notify_all();
+      notifyObserver();
     }
 
   protected:
 
+    // call the observer, if any, without holding the queue lock:
+    void notifyObserver()
+    {
+      boost::lock_guard<boost::mutex> lock(observerMutex_);
+      if (observer_)
+      {
+        observer_(observerContext_);
+      }
+    }
+
+    // call the room observer, if any, if pushOrPark found the queue full
+    // since the last time it was called, without holding the queue lock:
+    void notifyRoomObserver()
+    {
+      {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        if (!producerIsParked_)
+        {
+          return;
+        }
+
+        producerIsParked_ = false;
+      }
+
+      boost::lock_guard<boost::mutex> lock(observerMutex_);
+      if (roomObserver_)
+      {
+        roomObserver_(roomObserverContext_);
+      }
+    }
+
+    // remove the oldest item, must hold the lock and size_ must be > 0:
+    void take(TData & data)
+    {
+      while (sequences_.front().empty())
+      {
+        sequences_.pop_front();
+      }
+
+      TSequence & sequence = sequences_.front();
+      data = sequence.back();
+      sequence.pop_back();
+      size_--;
+
+      if (sequence.empty())
+      {
+        sequences_.pop_front();
+      }
+    }
+
     // push data into the queue:
     void insert(const TData & newData)
     {
@@ -561,12 +713,20 @@ namespace yae
 
     bool closed_;
     bool producerIsBlocked_;
+    bool producerIsParked_;
     bool consumerIsBlocked_;
     std::list<TSequence> sequences_;
     std::size_t size_;
     std::size_t maxSize_;
     TSortFunc sortFunc_;
 
+    // protected by observerMutex_:
+    boost::mutex observerMutex_;
+    TObserver observer_;
+    void * observerContext_;
+    TObserver roomObserver_;
+    void * roomObserverContext_;
+
   public:
     mutable boost::mutex mutex_;
     mutable boost::condition_variable cond_;
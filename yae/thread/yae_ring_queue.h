@@ -0,0 +1,631 @@
+// -*- Mode: c++; tab-width: 8; c-basic-offset: 2; indent-tabs-mode: nil -*-
+// NOTE: the first line of this file sets up source code indentation rules
+// for Emacs; it is also a hint to anyone modifying this file.
+
+// Created   : Fri Oct 16 10:12:44 MDT 2026
+// Copyright : Pavel Koshevoy
+// License   : MIT -- http://www.opensource.org/licenses/mit-license.php
+
+#ifndef YAE_RING_QUEUE_H_
+#define YAE_RING_QUEUE_H_
+
+// system includes:
+#include <algorithm>
+#include <vector>
+
+// boost includes:
+#ifndef Q_MOC_RUN
+#include <boost/atomic.hpp>
+#include <boost/thread.hpp>
+#endif
+
+// yae includes:
+#include "yae/thread/yae_queue.h"
+
+
+namespace yae
+{
+
+  //----------------------------------------------------------------
+  // kCacheLineSize
+  //
+  enum { kCacheLineSize = 64 };
+
+  //----------------------------------------------------------------
+  // kRingQueueMinCapacity
+  //
+  enum { kRingQueueMinCapacity = 64 };
+
+
+  //----------------------------------------------------------------
+  // SpinFlag
+  //
+  // Uncontended in the normal single-producer/single-consumer case,
+  // it only serializes the occasional control call (clear, open)
+  // from a third thread with the consumer side of the ring.
+  //
+  struct SpinFlag
+  {
+    SpinFlag():
+      busy_(false)
+    {}
+
+    inline void lock()
+    {
+      while (busy_.exchange(true, boost::memory_order_acquire))
+      {
+        boost::this_thread::yield();
+      }
+    }
+
+    inline void unlock()
+    {
+      busy_.store(false, boost::memory_order_release);
+    }
+
+    struct Lock
+    {
+      Lock(SpinFlag & flag):
+        flag_(flag)
+      { flag_.lock(); }
+
+      ~Lock()
+      { flag_.unlock(); }
+
+    private:
+      Lock(const Lock &);
+      Lock & operator = (const Lock &);
+
+      SpinFlag & flag_;
+    };
+
+  private:
+    SpinFlag(const SpinFlag &);
+    SpinFlag & operator = (const SpinFlag &);
+
+    boost::atomic<bool> busy_;
+  };
+
+
+  //----------------------------------------------------------------
+  // RingQueue
+  //
+  // Bounded single-producer/single-consumer queue with the same
+  // open/close/clear/push/pop semantics as yae::Queue, including
+  // QueueWaitMgr termination of blocking calls.
+  //
+  // push/pop do not allocate and do not take a mutex unless
+  // the ring is full/empty and the caller has to block.
+  //
+  // Differences from yae::Queue:
+  // - capacity is fixed at construction, setMaxSize is clamped to it,
+  // - items are delivered in FIFO order, there is no setSortFunc,
+  //   so queues that must be kept sorted can not use it,
+  // - there is no get(predicate) support.
+  //
+  template <typename TData>
+  struct RingQueue
+  {
+    typedef RingQueue<TData> TSelf;
+    typedef TData value_type;
+    typedef void(*TObserver)(void *);
+
+    RingQueue(std::size_t maxSize = 1, std::size_t capacity = 0):
+      closed_(true),
+      observed_(false),
+      producerIsBlocked_(false),
+      consumerIsBlocked_(false),
+      observer_(0),
+      observerContext_(NULL),
+      roomObserver_(0),
+      roomObserverContext_(NULL),
+      waiting_(0),
+      producerParked_(false),
+      head_(0),
+      parked_(false),
+      tail_(0)
+    {
+      std::size_t n = std::max<std::size_t>(capacity, maxSize * 2);
+      std::size_t c = kRingQueueMinCapacity;
+      while (c < n)
+      {
+        c <<= 1;
+      }
+
+      ring_.resize(c);
+      mask_ = c - 1;
+      maxSize_.store(std::min(maxSize, c));
+    }
+
+    ~RingQueue()
+    {
+      ring_.clear();
+    }
+
+    // same as yae::Queue::setObserver:
+    void setObserver(TObserver observer, void * context)
+    {
+      boost::lock_guard<boost::mutex> lock(observerMutex_);
+      observer_ = observer;
+      observerContext_ = context;
+      observed_.store(observer != NULL);
+    }
+
+    // same as yae::Queue::setRoomObserver:
+    void setRoomObserver(TObserver observer, void * context)
+    {
+      boost::lock_guard<boost::mutex> lock(observerMutex_);
+      roomObserver_ = observer;
+      roomObserverContext_ = context;
+    }
+
+    inline std::size_t capacity() const
+    { return ring_.size(); }
+
+    void setMaxSizeUnlimited()
+    {
+      setMaxSize(ring_.size());
+    }
+
+    void setMaxSize(std::size_t maxSize)
+    {
+      maxSize = std::min(maxSize, ring_.size());
+      if (maxSize_.exchange(maxSize) != maxSize)
+      {
+        notify(true);
+        notifyRoomObserver();
+      }
+    }
+
+    std::size_t getMaxSize() const
+    {
+      return maxSize_.load();
+    }
+
+    inline std::size_t size() const
+    {
+      return tail_.load() - head_.load();
+    }
+
+    // check whether the queue is empty:
+    bool isEmpty() const
+    {
+      return !size();
+    }
+
+    // check whether the queue is closed:
+    bool isClosed() const
+    {
+      return closed_.load();
+    }
+
+    // close the queue, abort any pending push/pop/etc... calls:
+    bool close()
+    {
+      if (!closed_.exchange(true))
+      {
+        notify(true);
+      }
+
+      notifyObserver();
+      notifyRoomObserver();
+      return true;
+    }
+
+    // open the queue allowing push/pop/etc... calls:
+    bool open()
+    {
+      if (!closed_.load())
+      {
+        // already open:
+        return true;
+      }
+
+      {
+        SpinFlag::Lock lock(consumer_);
+        discard();
+        closed_.store(false);
+      }
+
+      notify(true);
+      notifyRoomObserver();
+      return true;
+    }
+
+    // remove all data from the queue:
+    bool clear()
+    {
+      {
+        SpinFlag::Lock lock(consumer_);
+        discard();
+      }
+
+      notify();
+      notifyRoomObserver();
+      return true;
+    }
+
+    // push data into the queue:
+    bool push(const TData & newData, QueueWaitMgr * waitMgr = NULL)
+    {
+      try
+      {
+        QueueWaitTerminator terminator(waitMgr, &cond_);
+
+        while (true)
+        {
+          if (tryPush(newData, maxSize_.load()))
+          {
+            notify();
+            notifyObserver();
+            return true;
+          }
+
+          boost::unique_lock<boost::mutex> lock(mutex_);
+          Waiting waiting(waiting_);
+
+          if (closed_.load() || !terminator.keepWaiting())
+          {
+            return false;
+          }
+
+          if (size() >= maxSize_.load())
+          {
+            TemporaryValueOverride<bool> temp(producerIsBlocked_, true);
+            cond_.wait(lock);
+          }
+        }
+      }
+      catch (...)
+      {}
+
+      return false;
+    }
+
+    // same as yae::Queue::pushOrPark, producer side only:
+    bool pushOrPark(const TData & newData)
+    {
+      if (closed_.load())
+      {
+        return false;
+      }
+
+      if (!tryPush(newData, maxSize_.load()))
+      {
+        // the consumer may have made room just before the flag was set,
+        // so try once more, one of the two will see the other:
+        producerParked_.store(true);
+
+        if (!tryPush(newData, maxSize_.load()))
+        {
+          return false;
+        }
+
+        producerParked_.store(false);
+      }
+
+      notify();
+      notifyObserver();
+      return true;
+    }
+
+    // remove data from the queue:
+    bool pop(TData & data,
+             QueueWaitMgr * waitMgr = NULL,
+             bool waitForData = true)
+    {
+      try
+      {
+        QueueWaitTerminator terminator(waitMgr, &cond_);
+
+        while (true)
+        {
+          if (tryPop(data))
+          {
+            notify();
+            notifyRoomObserver();
+            return true;
+          }
+
+          if (!waitForData)
+          {
+            return false;
+          }
+
+          boost::unique_lock<boost::mutex> lock(mutex_);
+          Waiting waiting(waiting_);
+
+          if (closed_.load() || !terminator.keepWaiting())
+          {
+            return false;
+          }
+
+          if (!size())
+          {
+            TemporaryValueOverride<bool> temp(consumerIsBlocked_, true);
+            cond_.notify_all();
+            cond_.wait(lock);
+          }
+        }
+      }
+      catch (...)
+      {}
+
+      return false;
+    }
+
+    // same as yae::Queue::popOrPark, consumer side only:
+    bool popOrPark(TData & data)
+    {
+      if (closed_.load())
+      {
+        return false;
+      }
+
+      if (parked_)
+      {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        consumerIsBlocked_ = false;
+        parked_ = false;
+      }
+
+      if (tryPop(data))
+      {
+        notify();
+        notifyRoomObserver();
+        return true;
+      }
+
+      boost::lock_guard<boost::mutex> lock(mutex_);
+      consumerIsBlocked_ = true;
+      parked_ = true;
+      cond_.notify_all();
+      return false;
+    }
+
+    // take a peek at the head of the queue:
+    bool peek(TData & data, QueueWaitMgr * = NULL)
+    {
+      SpinFlag::Lock lock(consumer_);
+      std::size_t head = head_.load(boost::memory_order_relaxed);
+      if (closed_.load() || head == tail_.load(boost::memory_order_acquire))
+      {
+        return false;
+      }
+
+      data = ring_[head & mask_];
+      return true;
+    }
+
+    bool waitIndefinitelyForConsumerToBlock(QueueWaitMgr * waitMgr = NULL)
+    {
+      QueueWaitTerminator terminator(waitMgr, &cond_);
+
+      boost::unique_lock<boost::mutex> lock(mutex_);
+      Waiting waiting(waiting_);
+
+      while (!closed_.load() && !(consumerIsBlocked_ && !size()) &&
+             terminator.keepWaiting())
+      {
+        cond_.wait(lock);
+      }
+
+      return consumerIsBlocked_;
+    }
+
+    bool waitForConsumerToBlock(double secToWait)
+    {
+      boost::system_time whenToGiveUp(boost::get_system_time());
+      whenToGiveUp += boost::posix_time::microseconds(long(secToWait * 1e+6));
+
+      boost::unique_lock<boost::mutex> lock(mutex_);
+      Waiting waiting(waiting_);
+
+      while (!closed_.load() && !(consumerIsBlocked_ && !size()))
+      {
+        if (!cond_.timed_wait(lock, whenToGiveUp))
+        {
+          boost::system_time now(boost::get_system_time());
+          if (whenToGiveUp <= now)
+          {
+            break;
+          }
+        }
+      }
+
+      return consumerIsBlocked_ || closed_.load();
+    }
+
+    bool producerIsBlocked() const
+    {
+      boost::unique_lock<boost::mutex> lock(mutex_);
+      return producerIsBlocked_;
+    }
+
+    bool consumerIsBlocked() const
+    {
+      boost::unique_lock<boost::mutex> lock(mutex_);
+      return consumerIsBlocked_;
+    }
+
+    // sequence end marker is pushed regardless of max queue size,
+    // it only waits if the ring itself is full:
+    void startNewSequence(const TData & sequenceEndData)
+    {
+      while (!tryPush(sequenceEndData, ring_.size()))
+      {
+        boost::unique_lock<boost::mutex> lock(mutex_);
+        Waiting waiting(waiting_);
+
+        if (closed_.load())
+        {
+          return;
+        }
+
+        if (size() >= ring_.size())
+        {
+          cond_.wait(lock);
+        }
+      }
+
+      notify();
+      notifyObserver();
+    }
+
+  protected:
+
+    //----------------------------------------------------------------
+    // Waiting
+    //
+    // must be instantiated while holding mutex_,
+    // lets the other side know it has to signal cond_:
+    //
+    struct Waiting
+    {
+      Waiting(boost::atomic<std::size_t> & waiting):
+        waiting_(waiting)
+      { waiting_.fetch_add(1); }
+
+      ~Waiting()
+      { waiting_.fetch_sub(1); }
+
+      boost::atomic<std::size_t> & waiting_;
+    };
+
+    // producer side:
+    bool tryPush(const TData & newData, std::size_t maxSize)
+    {
+      SpinFlag::Lock lock(producer_);
+      std::size_t tail = tail_.load(boost::memory_order_relaxed);
+      std::size_t head = head_.load(boost::memory_order_acquire);
+      if (tail - head >= maxSize)
+      {
+        return false;
+      }
+
+      ring_[tail & mask_] = newData;
+      tail_.store(tail + 1);
+      return true;
+    }
+
+    // consumer side:
+    bool tryPop(TData & data)
+    {
+      SpinFlag::Lock lock(consumer_);
+      std::size_t head = head_.load(boost::memory_order_relaxed);
+      std::size_t tail = tail_.load(boost::memory_order_acquire);
+      if (head == tail)
+      {
+        return false;
+      }
+
+      TData & slot = ring_[head & mask_];
+      data = slot;
+      slot = TData();
+      head_.store(head + 1);
+      return true;
+    }
+
+    // consumer side, must hold the consumer_ flag:
+    void discard()
+    {
+      std::size_t head = head_.load(boost::memory_order_relaxed);
+      std::size_t tail = tail_.load(boost::memory_order_acquire);
+      for (; head != tail; ++head)
+      {
+        ring_[head & mask_] = TData();
+      }
+
+      head_.store(head);
+    }
+
+    // wake up anyone blocked on cond_, but only pay for the mutex
+    // if someone is actually waiting:
+    void notify(bool force = false)
+    {
+      if (force || waiting_.load())
+      {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        cond_.notify_all();
+      }
+    }
+
+    // call the observer, if any, without holding the lock:
+    void notifyObserver()
+    {
+      if (!observed_.load())
+      {
+        return;
+      }
+
+      boost::lock_guard<boost::mutex> lock(observerMutex_);
+      if (observer_)
+      {
+        observer_(observerContext_);
+      }
+    }
+
+    // call the room observer, if any, if pushOrPark found the ring full
+    // since the last time it was called, without holding the lock:
+    void notifyRoomObserver()
+    {
+      if (!producerParked_.load() || !producerParked_.exchange(false))
+      {
+        return;
+      }
+
+      boost::lock_guard<boost::mutex> lock(observerMutex_);
+      if (roomObserver_)
+      {
+        roomObserver_(roomObserverContext_);
+      }
+    }
+
+    // shared state:
+    boost::atomic<bool> closed_;
+    boost::atomic<bool> observed_;
+    boost::atomic<std::size_t> maxSize_;
+    std::vector<TData> ring_;
+    std::size_t mask_;
+
+    // protected by mutex_:
+    bool producerIsBlocked_;
+    bool consumerIsBlocked_;
+
+    // protected by observerMutex_, which is held while an observer
+    // is called, see yae::Queue::setObserver:
+    boost::mutex observerMutex_;
+    TObserver observer_;
+    void * observerContext_;
+    TObserver roomObserver_;
+    void * roomObserverContext_;
+
+    // number of threads blocked (or about to block) on cond_:
+    boost::atomic<std::size_t> waiting_;
+
+    // set when pushOrPark found the ring full:
+    boost::atomic<bool> producerParked_;
+
+    // keep producer and consumer indices on separate cache lines:
+    char pad0_[kCacheLineSize];
+    SpinFlag consumer_;
+    boost::atomic<std::size_t> head_;
+
+    // consumer only, set when popOrPark found the ring empty:
+    bool parked_;
+
+    char pad1_[kCacheLineSize];
+    SpinFlag producer_;
+    boost::atomic<std::size_t> tail_;
+
+    char pad2_[kCacheLineSize];
+
+  public:
+    mutable boost::mutex mutex_;
+    mutable boost::condition_variable cond_;
+  };
+
+}
+
+
+#endif // YAE_RING_QUEUE_H_
@@ -162,6 +162,34 @@ namespace yae
       return false;
     }
 
+    // returns true if the thread has exited and was joined
+    // within the given timeout:
+    bool waitFor(unsigned int msec)
+    {
+      try
+      {
+        if (thread_ &&
+            !thread_->try_join_for(boost::chrono::milliseconds(msec)))
+        {
+          return false;
+        }
+
+        delete thread_;
+        thread_ = NULL;
+        return true;
+      }
+      catch (const std::exception & e)
+      {
+        std::cerr << "Thread::waitFor: " << e.what() << std::endl;
+      }
+      catch (...)
+      {
+        std::cerr << "Thread::waitFor: unexpected exception" << std::endl;
+      }
+
+      return false;
+    }
+
     bool isRunning() const
     {
       return thread_ && thread_->joinable();
@@ -0,0 +1,338 @@
+// -*- Mode: c++; tab-width: 8; c-basic-offset: 2; indent-tabs-mode: nil -*-
+// NOTE: the first line of this file sets up source code indentation rules
+// for Emacs; it is also a hint to anyone modifying this file.
+
+// Created   : Fri Oct 16 13:20:51 MDT 2026
+// Copyright : Pavel Koshevoy
+// License   : MIT -- http://www.opensource.org/licenses/mit-license.php
+
+// system includes:
+#include <deque>
+#include <iostream>
+#include <vector>
+
+// boost libraries:
+#include <boost/atomic.hpp>
+#include <boost/thread.hpp>
+#include <boost/thread/tss.hpp>
+
+// aeyae:
+#include "yae_threading.h"
+#include "yae_work_stealing_pool.h"
+
+
+namespace yae
+{
+
+  //----------------------------------------------------------------
+  // TTask
+  //
+  typedef WorkStealingPool::TaskPtr TTask;
+
+  //----------------------------------------------------------------
+  // WorkStealingPool::Private
+  //
+  struct WorkStealingPool::Private
+  {
+    //----------------------------------------------------------------
+    // Worker
+    //
+    struct Worker
+    {
+      Worker(Private & pool, std::size_t index):
+        pool_(pool),
+        index_(index)
+      {
+        thread_.setContext(this);
+      }
+
+      void threadLoop()
+      {
+        pool_.threadLoop(*this);
+      }
+
+      Private & pool_;
+      std::size_t index_;
+
+      boost::mutex mutex_;
+      std::deque<TTask> tasks_;
+
+      Thread<Worker> thread_;
+    };
+
+    Private(std::size_t num_workers);
+    ~Private();
+
+    void submit(const TTask & task);
+    bool take(Worker & self, TTask & task);
+    void threadLoop(Worker & self);
+
+    static void noop(Worker *) {}
+
+    std::vector<Worker *> workers_;
+
+    // identifies the worker (if any) running on the current thread:
+    boost::thread_specific_ptr<Worker> current_;
+
+    // round-robin index for tasks submitted by non-worker threads:
+    boost::atomic<std::size_t> next_;
+
+    // number of tasks sitting in the deques, only changes
+    // while holding the mutex of the deque that changes:
+    boost::atomic<std::size_t> pending_;
+
+    // idle workers sleep here:
+    boost::mutex mutex_;
+    boost::condition_variable cond_;
+    boost::atomic<std::size_t> sleeping_;
+    bool stop_;
+
+    boost::atomic<uint64_t> submitted_;
+    boost::atomic<uint64_t> executed_;
+    boost::atomic<uint64_t> stolen_;
+  };
+
+  //----------------------------------------------------------------
+  // WorkStealingPool::Private::Private
+  //
+  WorkStealingPool::Private::Private(std::size_t num_workers):
+    current_(&WorkStealingPool::Private::noop),
+    next_(0),
+    pending_(0),
+    sleeping_(0),
+    stop_(false),
+    submitted_(0),
+    executed_(0),
+    stolen_(0)
+  {
+    if (!num_workers)
+    {
+      num_workers = std::max<std::size_t>
+        (1, boost::thread::hardware_concurrency());
+    }
+
+    for (std::size_t i = 0; i < num_workers; i++)
+    {
+      workers_.push_back(new Worker(*this, i));
+    }
+
+    for (std::size_t i = 0; i < num_workers; i++)
+    {
+      workers_[i]->thread_.run();
+    }
+  }
+
+  //----------------------------------------------------------------
+  // WorkStealingPool::Private::~Private
+  //
+  WorkStealingPool::Private::~Private()
+  {
+    {
+      boost::lock_guard<boost::mutex> lock(mutex_);
+      stop_ = true;
+      cond_.notify_all();
+    }
+
+    for (std::size_t i = 0; i < workers_.size(); i++)
+    {
+      Worker * worker = workers_[i];
+      worker->thread_.wait();
+    }
+
+    for (std::size_t i = 0; i < workers_.size(); i++)
+    {
+      delete workers_[i];
+    }
+  }
+
+  //----------------------------------------------------------------
+  // WorkStealingPool::Private::submit
+  //
+  void
+  WorkStealingPool::Private::submit(const TTask & task)
+  {
+    Worker * worker = current_.get();
+    if (!worker || &(worker->pool_) != this)
+    {
+      std::size_t i = next_.fetch_add(1) % workers_.size();
+      worker = workers_[i];
+    }
+
+    submitted_.fetch_add(1);
+
+    // pending_ counts only tasks that can actually be taken,
+    // otherwise idle workers would spin instead of sleeping:
+    {
+      boost::lock_guard<boost::mutex> lock(worker->mutex_);
+      worker->tasks_.push_back(task);
+      pending_.fetch_add(1);
+    }
+
+    if (sleeping_.load())
+    {
+      boost::lock_guard<boost::mutex> lock(mutex_);
+      cond_.notify_one();
+    }
+  }
+
+  //----------------------------------------------------------------
+  // WorkStealingPool::Private::take
+  //
+  bool
+  WorkStealingPool::Private::take(Worker & self, TTask & task)
+  {
+    // own deque first, newest task first:
+    {
+      boost::lock_guard<boost::mutex> lock(self.mutex_);
+      if (!self.tasks_.empty())
+      {
+        task = self.tasks_.back();
+        self.tasks_.pop_back();
+        pending_.fetch_sub(1);
+        return true;
+      }
+    }
+
+    // steal the oldest task from someone else; the deque locks
+    // are held only briefly, so wait for them rather than skip a victim
+    // -- a skipped victim would leave pending_ > 0 and the caller
+    // would spin instead of sleeping:
+    const std::size_t n = workers_.size();
+    for (std::size_t i = 1; i < n; i++)
+    {
+      Worker & victim = *(workers_[(self.index_ + i) % n]);
+
+      boost::lock_guard<boost::mutex> lock(victim.mutex_);
+      if (victim.tasks_.empty())
+      {
+        continue;
+      }
+
+      task = victim.tasks_.front();
+      victim.tasks_.pop_front();
+      pending_.fetch_sub(1);
+      stolen_.fetch_add(1);
+      return true;
+    }
+
+    return false;
+  }
+
+  //----------------------------------------------------------------
+  // WorkStealingPool::Private::threadLoop
+  //
+  void
+  WorkStealingPool::Private::threadLoop(Worker & self)
+  {
+    current_.reset(&self);
+
+    while (true)
+    {
+      TTask task;
+      if (take(self, task))
+      {
+        try
+        {
+          task->run();
+        }
+        catch (const std::exception & e)
+        {
+          std::cerr
+            << "WorkStealingPool task exception: " << e.what()
+            << std::endl;
+          YAE_ASSERT(false);
+        }
+        catch (...)
+        {
+          std::cerr
+            << "WorkStealingPool, unknown task exception"
+            << std::endl;
+          YAE_ASSERT(false);
+        }
+
+        executed_.fetch_add(1);
+        continue;
+      }
+
+      // a task may have been submitted since the deques were checked,
+      // so only sleep if there really is nothing pending:
+      boost::unique_lock<boost::mutex> lock(mutex_);
+      sleeping_.fetch_add(1);
+
+      while (!stop_ && !pending_.load())
+      {
+        cond_.wait(lock);
+      }
+
+      sleeping_.fetch_sub(1);
+
+      if (stop_)
+      {
+        break;
+      }
+    }
+
+    current_.reset();
+  }
+
+
+  //----------------------------------------------------------------
+  // WorkStealingPool::singleton
+  //
+  WorkStealingPool &
+  WorkStealingPool::singleton()
+  {
+    static WorkStealingPool pool;
+    return pool;
+  }
+
+  //----------------------------------------------------------------
+  // WorkStealingPool::WorkStealingPool
+  //
+  WorkStealingPool::WorkStealingPool(std::size_t num_workers):
+    private_(new Private(num_workers))
+  {}
+
+  //----------------------------------------------------------------
+  // WorkStealingPool::~WorkStealingPool
+  //
+  WorkStealingPool::~WorkStealingPool()
+  {
+    delete private_;
+  }
+
+  //----------------------------------------------------------------
+  // WorkStealingPool::num_workers
+  //
+  std::size_t
+  WorkStealingPool::num_workers() const
+  {
+    return private_->workers_.size();
+  }
+
+  //----------------------------------------------------------------
+  // WorkStealingPool::submit
+  //
+  void
+  WorkStealingPool::submit(const TaskPtr & task)
+  {
+    if (task)
+    {
+      private_->submit(task);
+    }
+  }
+
+  //----------------------------------------------------------------
+  // WorkStealingPool::stats
+  //
+  WorkStealingPool::Stats
+  WorkStealingPool::stats() const
+  {
+    Stats stats;
+    stats.submitted_ = private_->submitted_.load();
+    stats.executed_ = private_->executed_.load();
+    stats.stolen_ = private_->stolen_.load();
+    return stats;
+  }
+
+}
@@ -0,0 +1,90 @@
+// -*- Mode: c++; tab-width: 8; c-basic-offset: 2; indent-tabs-mode: nil -*-
+// NOTE: the first line of this file sets up source code indentation rules
+// for Emacs; it is also a hint to anyone modifying this file.
+
+// Created   : Fri Oct 16 13:20:51 MDT 2026
+// Copyright : Pavel Koshevoy
+// License   : MIT -- http://www.opensource.org/licenses/mit-license.php
+
+#ifndef YAE_WORK_STEALING_POOL_H_
+#define YAE_WORK_STEALING_POOL_H_
+
+// aeyae:
+#include "yae/api/yae_api.h"
+#include "yae/api/yae_shared_ptr.h"
+
+
+namespace yae
+{
+
+  //----------------------------------------------------------------
+  // WorkStealingPool
+  //
+  // A fixed set of worker threads, each with its own task deque.
+  //
+  // Tasks submitted from a worker thread go to the back of that
+  // worker's deque and are picked up LIFO (cache-warm), tasks submitted
+  // from any other thread are distributed round-robin.  An idle worker
+  // steals from the front of the other deques before going to sleep.
+  //
+  // Tasks should not block for long, long-running work should be
+  // split into short steps that re-submit themselves.
+  //
+  struct YAE_API WorkStealingPool
+  {
+    //----------------------------------------------------------------
+    // Task
+    //
+    struct YAE_API Task
+    {
+      virtual ~Task() {}
+      virtual void run() = 0;
+    };
+
+    //----------------------------------------------------------------
+    // TaskPtr
+    //
+    typedef yae::shared_ptr<Task> TaskPtr;
+
+    //----------------------------------------------------------------
+    // Stats
+    //
+    struct YAE_API Stats
+    {
+      Stats():
+        submitted_(0),
+        executed_(0),
+        stolen_(0)
+      {}
+
+      uint64_t submitted_;
+      uint64_t executed_;
+      uint64_t stolen_;
+    };
+
+    // a process-wide pool with one worker per core:
+    static WorkStealingPool & singleton();
+
+    // 0 workers means one worker per core:
+    WorkStealingPool(std::size_t num_workers = 0);
+    ~WorkStealingPool();
+
+    std::size_t num_workers() const;
+
+    void submit(const TaskPtr & task);
+
+    Stats stats() const;
+
+  private:
+    // intentionally disabled:
+    WorkStealingPool(const WorkStealingPool &);
+    WorkStealingPool & operator = (const WorkStealingPool &);
+
+    struct Private;
+    Private * private_;
+  };
+
+}
+
+
+#endif // YAE_WORK_STEALING_POOL_H_
@@ -7,16 +7,23 @@
 // License   : MIT -- http://www.opensource.org/licenses/mit-license.php
 
 // standard C++ library:
+#include <algorithm>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
 #include <iomanip>
+#include <limits>
+#include <list>
 #include <map>
 #include <string>
 #include <sstream>
+#include <vector>
 
 // boost library:
+#include <boost/atomic.hpp>
 #include <boost/chrono/chrono.hpp>
 #include <boost/thread.hpp>
+#include <boost/thread/tss.hpp>
 
 // aeyae:
 #include "yae_benchmark.h"
@@ -572,6 +579,452 @@ namespace yae
   }
 
 
+  //----------------------------------------------------------------
+  // ProbeSlot
+  //
+  // measurements of one probe site on one thread; written only
+  // by the owner thread, read by whoever takes a snapshot:
+  //
+  struct ProbeSlot
+  {
+    // 2 bins per power of 2 nanoseconds:
+    enum { kBins = 128 };
+
+    ProbeSlot()
+    {
+      epoch_.store(0);
+      reset();
+    }
+
+    void reset()
+    {
+      n_.store(0, boost::memory_order_relaxed);
+      t_.store(0, boost::memory_order_relaxed);
+      min_.store(std::numeric_limits<uint64>::max(),
+                 boost::memory_order_relaxed);
+      max_.store(0, boost::memory_order_relaxed);
+
+      for (std::size_t i = 0; i < kBins; i++)
+      {
+        hist_[i].store(0, boost::memory_order_relaxed);
+      }
+    }
+
+    static std::size_t bin(uint64 nsec)
+    {
+      if (nsec < 2)
+      {
+        return 0;
+      }
+
+      std::size_t octave = 0;
+      while (nsec >> (octave + 1))
+      {
+        octave++;
+      }
+
+      std::size_t half = (nsec >> (octave - 1)) & 1;
+      return octave * 2 + half;
+    }
+
+    // midpoint of a histogram bin, in nanoseconds:
+    static double bin_midpoint(std::size_t bin)
+    {
+      std::size_t octave = bin / 2;
+      std::size_t half = bin % 2;
+      double base = double(uint64(1) << octave);
+      return base + base * (0.5 * double(half) + 0.25);
+    }
+
+    // single writer, so no read-modify-write atomics are needed:
+    inline void add(boost::atomic<uint64> & v, uint64 dv)
+    {
+      v.store(v.load(boost::memory_order_relaxed) + dv,
+              boost::memory_order_relaxed);
+    }
+
+    void record(uint64 nsec)
+    {
+      add(n_, 1);
+      add(t_, nsec);
+
+      if (nsec < min_.load(boost::memory_order_relaxed))
+      {
+        min_.store(nsec, boost::memory_order_relaxed);
+      }
+
+      if (max_.load(boost::memory_order_relaxed) < nsec)
+      {
+        max_.store(nsec, boost::memory_order_relaxed);
+      }
+
+      add(hist_[bin(nsec)], 1);
+    }
+
+    boost::atomic<uint64> epoch_;
+    boost::atomic<uint64> n_;
+    boost::atomic<uint64> t_;
+    boost::atomic<uint64> min_;
+    boost::atomic<uint64> max_;
+    boost::atomic<uint64> hist_[kBins];
+  };
+
+  //----------------------------------------------------------------
+  // ProbeAccum
+  //
+  struct ProbeAccum
+  {
+    ProbeAccum():
+      n_(0),
+      t_(0),
+      min_(std::numeric_limits<uint64>::max()),
+      max_(0)
+    {
+      memset(hist_, 0, sizeof(hist_));
+    }
+
+    void add(const ProbeSlot & slot)
+    {
+      n_ += slot.n_.load(boost::memory_order_relaxed);
+      t_ += slot.t_.load(boost::memory_order_relaxed);
+      min_ = std::min(min_, slot.min_.load(boost::memory_order_relaxed));
+      max_ = std::max(max_, slot.max_.load(boost::memory_order_relaxed));
+
+      for (std::size_t i = 0; i < ProbeSlot::kBins; i++)
+      {
+        hist_[i] += slot.hist_[i].load(boost::memory_order_relaxed);
+      }
+    }
+
+    void add(const ProbeAccum & accum)
+    {
+      n_ += accum.n_;
+      t_ += accum.t_;
+      min_ = std::min(min_, accum.min_);
+      max_ = std::max(max_, accum.max_);
+
+      for (std::size_t i = 0; i < ProbeSlot::kBins; i++)
+      {
+        hist_[i] += accum.hist_[i];
+      }
+    }
+
+    // in microseconds:
+    double percentile(double q) const
+    {
+      uint64 target = uint64(q * double(n_));
+      uint64 seen = 0;
+
+      for (std::size_t i = 0; i < ProbeSlot::kBins; i++)
+      {
+        seen += hist_[i];
+        if (seen > target)
+        {
+          double nsec = ProbeSlot::bin_midpoint(i);
+          nsec = std::max(nsec, double(min_));
+          nsec = std::min(nsec, double(max_));
+          return nsec * 1e-3;
+        }
+      }
+
+      return double(max_) * 1e-3;
+    }
+
+    uint64 n_;
+    uint64 t_;
+    uint64 min_;
+    uint64 max_;
+    uint64 hist_[ProbeSlot::kBins];
+  };
+
+  //----------------------------------------------------------------
+  // ProbeThread
+  //
+  struct ProbeThread
+  {
+    ProbeThread()
+    {
+      for (std::size_t i = 0; i < TProbe::kMaxProbes; i++)
+      {
+        slots_[i].store(NULL);
+      }
+    }
+
+    ~ProbeThread()
+    {
+      for (std::size_t i = 0; i < TProbe::kMaxProbes; i++)
+      {
+        delete slots_[i].load();
+      }
+    }
+
+    boost::atomic<ProbeSlot *> slots_[TProbe::kMaxProbes];
+  };
+
+  //----------------------------------------------------------------
+  // ProbeRegistry
+  //
+  struct ProbeRegistry
+  {
+    // intentionally leaked, threads may exit after static destructors:
+    static ProbeRegistry & singleton()
+    {
+      static ProbeRegistry * registry = new ProbeRegistry();
+      return *registry;
+    }
+
+    ProbeRegistry():
+      tss_(&ProbeRegistry::retire),
+      count_(0),
+      epoch_(1)
+    {
+      names_.resize(TProbe::kMaxProbes);
+      retired_.resize(TProbe::kMaxProbes);
+    }
+
+    std::size_t add(const char * name)
+    {
+      boost::lock_guard<boost::mutex> lock(mutex_);
+      std::size_t index = count_.load();
+      if (index < TProbe::kMaxProbes)
+      {
+        names_[index] = name;
+        count_.store(index + 1);
+      }
+      else
+      {
+        YAE_ASSERT(false);
+      }
+
+      return index;
+    }
+
+    ProbeThread & thread()
+    {
+      ProbeThread * thread = tss_.get();
+      if (!thread)
+      {
+        thread = new ProbeThread();
+
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        threads_.push_back(thread);
+        tss_.reset(thread);
+      }
+
+      return *thread;
+    }
+
+    // thread exit cleanup, fold the measurements into retired_:
+    static void retire(ProbeThread * thread)
+    {
+      ProbeRegistry & registry = ProbeRegistry::singleton();
+      boost::lock_guard<boost::mutex> lock(registry.mutex_);
+      registry.collect(*thread, registry.retired_);
+      registry.threads_.remove(thread);
+      delete thread;
+    }
+
+    // must hold the lock:
+    void collect(const ProbeThread & thread, std::vector<ProbeAccum> & out)
+    {
+      const uint64 epoch = epoch_.load();
+      const std::size_t n = count_.load();
+
+      for (std::size_t i = 0; i < n; i++)
+      {
+        const ProbeSlot * slot = thread.slots_[i].load();
+        if (slot && slot->epoch_.load() == epoch)
+        {
+          out[i].add(*slot);
+        }
+      }
+    }
+
+    boost::mutex mutex_;
+    boost::thread_specific_ptr<ProbeThread> tss_;
+    std::vector<const char *> names_;
+    boost::atomic<std::size_t> count_;
+
+    // incremented to reset all counters, each thread resets
+    // its own slot when it notices the epoch has changed:
+    boost::atomic<uint64> epoch_;
+
+    std::list<ProbeThread *> threads_;
+    std::vector<ProbeAccum> retired_;
+  };
+
+  //----------------------------------------------------------------
+  // probes_enabled_by_default
+  //
+  static bool
+  probes_enabled_by_default()
+  {
+    const char * env = getenv("YAE_PROBES");
+    return env && *env && strcmp(env, "0") != 0;
+  }
+
+  //----------------------------------------------------------------
+  // TProbe::enabled_
+  //
+  boost::atomic<bool> TProbe::enabled_(probes_enabled_by_default());
+
+  //----------------------------------------------------------------
+  // TProbe::Stats::Stats
+  //
+  TProbe::Stats::Stats():
+    n_(0),
+    total_(0.0),
+    min_(0.0),
+    max_(0.0),
+    p50_(0.0),
+    p90_(0.0),
+    p99_(0.0)
+  {}
+
+  //----------------------------------------------------------------
+  // TProbe::TProbe
+  //
+  TProbe::TProbe(const char * name):
+    name_(name),
+    index_(ProbeRegistry::singleton().add(name))
+  {}
+
+  //----------------------------------------------------------------
+  // TProbe::enable
+  //
+  void
+  TProbe::enable(bool enable)
+  {
+    enabled_.store(enable);
+  }
+
+  //----------------------------------------------------------------
+  // TProbe::record
+  //
+  void
+  TProbe::record(uint64 nsec) const
+  {
+    if (index_ >= kMaxProbes)
+    {
+      return;
+    }
+
+    ProbeRegistry & registry = ProbeRegistry::singleton();
+    ProbeThread & thread = registry.thread();
+
+    ProbeSlot * slot = thread.slots_[index_].load(boost::memory_order_relaxed);
+    if (!slot)
+    {
+      slot = new ProbeSlot();
+      slot->epoch_.store(registry.epoch_.load());
+      thread.slots_[index_].store(slot, boost::memory_order_release);
+    }
+
+    uint64 epoch = registry.epoch_.load(boost::memory_order_relaxed);
+    if (slot->epoch_.load(boost::memory_order_relaxed) != epoch)
+    {
+      slot->reset();
+      slot->epoch_.store(epoch, boost::memory_order_release);
+    }
+
+    slot->record(nsec);
+  }
+
+  //----------------------------------------------------------------
+  // TProbe::snapshot
+  //
+  void
+  TProbe::snapshot(std::vector<Stats> & stats, bool reset)
+  {
+    ProbeRegistry & registry = ProbeRegistry::singleton();
+    boost::lock_guard<boost::mutex> lock(registry.mutex_);
+
+    std::vector<ProbeAccum> accum(registry.retired_);
+    for (std::list<ProbeThread *>::const_iterator
+           i = registry.threads_.begin(); i != registry.threads_.end(); ++i)
+    {
+      registry.collect(**i, accum);
+    }
+
+    stats.clear();
+    const std::size_t n = registry.count_.load();
+    for (std::size_t i = 0; i < n; i++)
+    {
+      const ProbeAccum & a = accum[i];
+      if (!a.n_)
+      {
+        continue;
+      }
+
+      stats.push_back(Stats());
+      Stats & s = stats.back();
+      s.name_ = registry.names_[i];
+      s.n_ = a.n_;
+      s.total_ = double(a.t_) * 1e-3;
+      s.min_ = double(a.min_) * 1e-3;
+      s.max_ = double(a.max_) * 1e-3;
+      s.p50_ = a.percentile(0.50);
+      s.p90_ = a.percentile(0.90);
+      s.p99_ = a.percentile(0.99);
+    }
+
+    if (reset)
+    {
+      registry.epoch_.fetch_add(1);
+      registry.retired_.assign(kMaxProbes, ProbeAccum());
+    }
+  }
+
+  //----------------------------------------------------------------
+  // TProbe::show
+  //
+  void
+  TProbe::show(std::ostream & os)
+  {
+    std::vector<Stats> stats;
+    snapshot(stats);
+
+    std::ostringstream oss;
+    oss << "\nProbes, all threads, usec:\n";
+
+    for (std::vector<Stats>::const_iterator
+           i = stats.begin(); i != stats.end(); ++i)
+    {
+      const Stats & s = *i;
+      oss
+        << "  "
+        << std::left << std::setw(40) << std::setfill(' ')
+        << s.name_
+        << " : "
+
+        << std::right << std::setw(8) << std::setfill(' ')
+        << s.n_
+        << " calls, "
+
+        << std::fixed << std::setprecision(3)
+        << std::setw(13) << s.total_ * 1e-3 << " msec total, "
+        << std::setw(10) << s.total_ / double(s.n_) << " avg, "
+        << std::setw(10) << s.min_ << " min, "
+        << std::setw(10) << s.p50_ << " p50, "
+        << std::setw(10) << s.p90_ << " p90, "
+        << std::setw(10) << s.p99_ << " p99, "
+        << std::setw(10) << s.max_ << " max\n";
+    }
+
+    os << oss.str().c_str() << std::endl;
+  }
+
+  //----------------------------------------------------------------
+  // TProbe::clear
+  //
+  void
+  TProbe::clear()
+  {
+    std::vector<Stats> stats;
+    snapshot(stats, true);
+  }
+
+
   //----------------------------------------------------------------
   // operator <<
   //
@@ -18,6 +18,13 @@
 #include <list>
 #include <string>
 #include <typeinfo>
+#include <vector>
+
+// boost:
+#ifndef Q_MOC_RUN
+#include <boost/atomic.hpp>
+#include <boost/chrono/chrono.hpp>
+#endif
 
 // aeyae:
 #include "../api/yae_api.h"
@@ -126,6 +133,130 @@ namespace yae
 #endif
 
 
+namespace yae
+{
+
+  //----------------------------------------------------------------
+  // TProbe
+  //
+  // A named probe site for release builds.  Unlike TBenchmark
+  // it does not take a lock per measurement -- each thread accumulates
+  // into its own slots, which are only read when a snapshot is taken.
+  //
+  // Probes are disabled by default, set YAE_PROBES=1 in the environment
+  // or call TProbe::enable(true) at runtime.  A disabled probe costs
+  // one relaxed atomic load.
+  //
+  // Probe sites are expected to be static (see YAE_PROBE), there is
+  // a fixed limit on the number of distinct probe sites per process.
+  //
+  struct YAE_API TProbe
+  {
+    enum { kMaxProbes = 256 };
+
+    TProbe(const char * name);
+
+    inline const char * name() const
+    { return name_; }
+
+    inline static bool enabled()
+    { return enabled_.load(boost::memory_order_relaxed); }
+
+    static void enable(bool enable);
+
+    // record one measurement, in nanoseconds:
+    void record(uint64 nsec) const;
+
+    //----------------------------------------------------------------
+    // Stats
+    //
+    // aggregated over all threads, durations in microseconds,
+    // percentiles are estimated from a log-scale histogram:
+    //
+    struct YAE_API Stats
+    {
+      Stats();
+
+      std::string name_;
+      uint64 n_;
+      double total_;
+      double min_;
+      double max_;
+      double p50_;
+      double p90_;
+      double p99_;
+    };
+
+    // aggregate every probe site that recorded anything,
+    // optionally reset the counters afterwards (periodic snapshots):
+    static void snapshot(std::vector<Stats> & stats, bool reset = false);
+
+    static void show(std::ostream & os);
+    static void clear();
+
+  private:
+    TProbe(const TProbe &);
+    TProbe & operator = (const TProbe &);
+
+    static boost::atomic<bool> enabled_;
+
+    const char * name_;
+    std::size_t index_;
+  };
+
+  //----------------------------------------------------------------
+  // TProbeTimer
+  //
+  struct YAE_API TProbeTimer
+  {
+    inline TProbeTimer(const TProbe & probe):
+      probe_(TProbe::enabled() ? &probe : NULL)
+    {
+      if (probe_)
+      {
+        t0_ = boost::chrono::steady_clock::now();
+      }
+    }
+
+    inline ~TProbeTimer()
+    {
+      if (probe_)
+      {
+        boost::chrono::steady_clock::time_point
+          t1 = boost::chrono::steady_clock::now();
+        probe_->record(boost::chrono::duration_cast
+                       <boost::chrono::nanoseconds>(t1 - t0_).count());
+      }
+    }
+
+  private:
+    TProbeTimer(const TProbeTimer &);
+    TProbeTimer & operator = (const TProbeTimer &);
+
+    const TProbe * probe_;
+    boost::chrono::steady_clock::time_point t0_;
+  };
+}
+
+#ifndef YAE_PROBE
+# ifndef YAE_DISABLE_PROBES
+#  define YAE_PROBE(varname, name)                      \
+  static const yae::TProbe varname##_probe(name);       \
+  yae::TProbeTimer varname(varname##_probe)
+# else
+#  define YAE_PROBE(varname, name)
+# endif
+#endif
+
+#ifndef YAE_PROBE_SHOW
+# ifndef YAE_DISABLE_PROBES
+#  define YAE_PROBE_SHOW(ostream) yae::TProbe::show(ostream)
+# else
+#  define YAE_PROBE_SHOW(ostream)
+# endif
+#endif
+
+
 //----------------------------------------------------------------
 // YAE_ENABLE_MEMORY_FOOTPRINT_ANALYSIS
 //
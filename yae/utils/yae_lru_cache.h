@@ -13,12 +13,15 @@
 #include <algorithm>
 #include <list>
 #include <map>
+#include <vector>
 
 // boost:
 #ifndef Q_MOC_RUN
 #include <boost/cstdint.hpp>
+#include <boost/functional/hash.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/thread.hpp>
+#include <boost/unordered_map.hpp>
 #endif
 
 // aeyae:
@@ -362,6 +365,524 @@ namespace yae
     std::map<uint64_t, TKey> lru_;
   };
 
+
+  //----------------------------------------------------------------
+  // ShardedLRUCache
+  //
+  // a thread safe cache for values shared by many threads at once.
+  //
+  // Keys are hashed to one of several shards, each shard has its own
+  // mutex, hash table and an intrusive LRU list of unreferenced entries,
+  // so touch and eviction are O(1) and unrelated keys rarely contend.
+  //
+  // Differences from LRUCache:
+  // - there is one cached value per key, shared by all references,
+  // - get/put never wait, when every entry in a shard is referenced
+  //   the shard temporarily exceeds its capacity,
+  // - capacity is measured in cost units, by default every value
+  //   costs 1 (an item count), but a cost function can be supplied
+  //   to budget by bytes instead.
+  //
+  template <typename TKey,
+            typename TValue,
+            typename THash = boost::hash<TKey> >
+  struct ShardedLRUCache
+  {
+
+    //----------------------------------------------------------------
+    // TCache
+    //
+    typedef ShardedLRUCache<TKey, TValue, THash> TCache;
+
+    //----------------------------------------------------------------
+    // TCostFunc
+    //
+    typedef std::size_t(*TCostFunc)(const TValue &);
+
+    //----------------------------------------------------------------
+    // TFactoryCallback
+    //
+    typedef bool(*TFactoryCallback)(void *, const TKey &, TValue &);
+
+    //----------------------------------------------------------------
+    // Stats
+    //
+    struct Stats
+    {
+      Stats():
+        hits_(0),
+        misses_(0),
+        evicted_(0),
+        entries_(0),
+        cost_(0)
+      {}
+
+      boost::uint64_t hits_;
+      boost::uint64_t misses_;
+      boost::uint64_t evicted_;
+      std::size_t entries_;
+      std::size_t cost_;
+    };
+
+  protected:
+    struct Shard;
+
+    //----------------------------------------------------------------
+    // Entry
+    //
+    struct Entry
+    {
+      Entry(const TKey & key, std::size_t cost):
+        key_(key),
+        cost_(cost),
+        refs_(0),
+        detached_(false),
+        prev_(NULL),
+        next_(NULL)
+      {}
+
+      TKey key_;
+      TValue value_;
+      std::size_t cost_;
+      std::size_t refs_;
+
+      // set when the entry was replaced or purged while referenced,
+      // it will be deleted when the last reference is released:
+      bool detached_;
+
+      // intrusive LRU list links, used only while unreferenced:
+      Entry * prev_;
+      Entry * next_;
+    };
+
+  public:
+
+    //----------------------------------------------------------------
+    // Ref
+    //
+    struct Ref
+    {
+      friend struct ShardedLRUCache;
+      friend struct TCache::Shard;
+
+      ~Ref()
+      {
+        shard_.release(entry_);
+      }
+
+      inline const TKey & key() const
+      { return entry_->key_; }
+
+      inline const TValue & value() const
+      { return entry_->value_; }
+
+    private:
+      Ref(Shard & shard, Entry * entry):
+        shard_(shard),
+        entry_(entry)
+      {}
+
+      // intentionally disabled:
+      Ref(const Ref &);
+      Ref & operator = (const Ref &);
+
+      Shard & shard_;
+      Entry * entry_;
+    };
+
+    //----------------------------------------------------------------
+    // TRefPtr
+    //
+    typedef boost::shared_ptr<Ref> TRefPtr;
+
+    //----------------------------------------------------------------
+    // ShardedLRUCache
+    //
+    // 0 shards means 4 shards per core:
+    //
+    ShardedLRUCache(std::size_t capacity = 0,
+                    std::size_t num_shards = 0,
+                    TCostFunc cost = NULL):
+      capacity_(capacity),
+      cost_(cost)
+    {
+      if (!num_shards)
+      {
+        num_shards = 4 * std::max<std::size_t>
+          (1, boost::thread::hardware_concurrency());
+      }
+
+      for (std::size_t i = 0; i < num_shards; i++)
+      {
+        shards_.push_back(new Shard(*this));
+      }
+
+      set_capacity(capacity);
+    }
+
+    ~ShardedLRUCache()
+    {
+      for (std::size_t i = 0; i < shards_.size(); i++)
+      {
+        delete shards_[i];
+      }
+    }
+
+    //----------------------------------------------------------------
+    // capacity
+    //
+    inline std::size_t capacity() const
+    {
+      return capacity_;
+    }
+
+    //----------------------------------------------------------------
+    // num_shards
+    //
+    inline std::size_t num_shards() const
+    {
+      return shards_.size();
+    }
+
+    //----------------------------------------------------------------
+    // set_capacity
+    //
+    // capacity is split evenly between the shards:
+    //
+    void
+    set_capacity(std::size_t capacity)
+    {
+      capacity_ = capacity;
+
+      const std::size_t n = shards_.size();
+      const std::size_t per_shard = (capacity + n - 1) / n;
+
+      for (std::size_t i = 0; i < n; i++)
+      {
+        shards_[i]->set_capacity(per_shard);
+      }
+    }
+
+    //----------------------------------------------------------------
+    // get
+    //
+    // Return a reference to the cached value, or create
+    // a new cached value on demand via the supplied callback.
+    //
+    // NOTE: the callback is called while holding the shard lock,
+    // so concurrent lookups of the same key wait for it instead
+    // of creating duplicate values.
+    //
+    TRefPtr
+    get(const TKey & key, TFactoryCallback assign = NULL, void * ctx = NULL)
+    {
+      return shard_for(key).get(key, assign, ctx);
+    }
+
+    //----------------------------------------------------------------
+    // put
+    //
+    // add or replace a cached value, existing references
+    // to a replaced value remain valid:
+    //
+    TRefPtr
+    put(const TKey & key, const TValue & value)
+    {
+      return shard_for(key).put(key, value);
+    }
+
+    //----------------------------------------------------------------
+    // purge_unreferenced_entries
+    //
+    void purge_unreferenced_entries()
+    {
+      for (std::size_t i = 0; i < shards_.size(); i++)
+      {
+        shards_[i]->purge(0);
+      }
+    }
+
+    //----------------------------------------------------------------
+    // stats
+    //
+    Stats stats() const
+    {
+      Stats stats;
+      for (std::size_t i = 0; i < shards_.size(); i++)
+      {
+        shards_[i]->add_to(stats);
+      }
+
+      return stats;
+    }
+
+  protected:
+
+    //----------------------------------------------------------------
+    // Shard
+    //
+    struct Shard
+    {
+      typedef boost::unordered_map<TKey, Entry *, THash> TEntries;
+
+      Shard(TCache & cache):
+        cache_(cache),
+        capacity_(0),
+        cost_(0),
+        head_(NULL),
+        tail_(NULL),
+        hits_(0),
+        misses_(0),
+        evicted_(0)
+      {}
+
+      ~Shard()
+      {
+        for (typename TEntries::iterator
+               i = entries_.begin(); i != entries_.end(); ++i)
+        {
+          Entry * entry = i->second;
+          YAE_ASSERT(!entry->refs_);
+          delete entry;
+        }
+      }
+
+      void set_capacity(std::size_t capacity)
+      {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        capacity_ = capacity;
+        evict(capacity_);
+      }
+
+      void purge(std::size_t budget)
+      {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        evict(budget);
+      }
+
+      TRefPtr get(const TKey & key, TFactoryCallback assign, void * ctx)
+      {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+
+        typename TEntries::iterator found = entries_.find(key);
+        if (found != entries_.end())
+        {
+          hits_++;
+          return ref(found->second);
+        }
+
+        misses_++;
+        if (!assign)
+        {
+          return TRefPtr();
+        }
+
+        Entry * entry = new Entry(key, 0);
+        try
+        {
+          if (!assign(ctx, key, entry->value_))
+          {
+            delete entry;
+            return TRefPtr();
+          }
+        }
+        catch (...)
+        {
+          delete entry;
+          throw;
+        }
+
+        return insert(entry);
+      }
+
+      TRefPtr put(const TKey & key, const TValue & value)
+      {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+
+        typename TEntries::iterator found = entries_.find(key);
+        if (found != entries_.end())
+        {
+          remove(found->second);
+        }
+
+        Entry * entry = new Entry(key, 0);
+        entry->value_ = value;
+        return insert(entry);
+      }
+
+      void release(Entry * entry)
+      {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        YAE_ASSERT(entry->refs_);
+
+        entry->refs_--;
+        if (entry->refs_)
+        {
+          return;
+        }
+
+        if (entry->detached_)
+        {
+          delete entry;
+          return;
+        }
+
+        link(entry);
+        evict(capacity_);
+      }
+
+      void add_to(Stats & stats) const
+      {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        stats.hits_ += hits_;
+        stats.misses_ += misses_;
+        stats.evicted_ += evicted_;
+        stats.entries_ += entries_.size();
+        stats.cost_ += cost_;
+      }
+
+    protected:
+      // must hold the lock for all of the following:
+
+      TRefPtr ref(Entry * entry)
+      {
+        if (!entry->refs_)
+        {
+          unlink(entry);
+        }
+
+        entry->refs_++;
+        return TRefPtr(new Ref(*this, entry));
+      }
+
+      TRefPtr insert(Entry * entry)
+      {
+        entry->cost_ = cache_.cost_ ? cache_.cost_(entry->value_) : 1;
+        entries_[entry->key_] = entry;
+        cost_ += entry->cost_;
+
+        // new entries start out referenced, not on the LRU list:
+        entry->refs_ = 1;
+        TRefPtr r(new Ref(*this, entry));
+        evict(capacity_);
+        return r;
+      }
+
+      // remove an entry from the shard, delete it unless referenced:
+      void remove(Entry * entry)
+      {
+        entries_.erase(entry->key_);
+        cost_ -= entry->cost_;
+
+        if (entry->refs_)
+        {
+          entry->detached_ = true;
+        }
+        else
+        {
+          unlink(entry);
+          delete entry;
+        }
+      }
+
+      // evict least recently used unreferenced entries
+      // until the total cost fits within the budget:
+      void evict(std::size_t budget)
+      {
+        while (budget < cost_ && head_)
+        {
+          remove(head_);
+          evicted_++;
+        }
+      }
+
+      // append to the tail (most recently used end) of the LRU list:
+      void link(Entry * entry)
+      {
+        entry->prev_ = tail_;
+        entry->next_ = NULL;
+
+        if (tail_)
+        {
+          tail_->next_ = entry;
+        }
+        else
+        {
+          head_ = entry;
+        }
+
+        tail_ = entry;
+      }
+
+      void unlink(Entry * entry)
+      {
+        if (entry->prev_)
+        {
+          entry->prev_->next_ = entry->next_;
+        }
+        else
+        {
+          head_ = entry->next_;
+        }
+
+        if (entry->next_)
+        {
+          entry->next_->prev_ = entry->prev_;
+        }
+        else
+        {
+          tail_ = entry->prev_;
+        }
+
+        entry->prev_ = NULL;
+        entry->next_ = NULL;
+      }
+
+      // intentionally disabled:
+      Shard(const Shard &);
+      Shard & operator = (const Shard &);
+
+      TCache & cache_;
+      mutable boost::mutex mutex_;
+      TEntries entries_;
+
+      // capacity and total cost of the cached values, in cost units:
+      std::size_t capacity_;
+      std::size_t cost_;
+
+      // unreferenced entries, least recently used first:
+      Entry * head_;
+      Entry * tail_;
+
+      boost::uint64_t hits_;
+      boost::uint64_t misses_;
+      boost::uint64_t evicted_;
+    };
+
+    friend struct Shard;
+
+    inline Shard & shard_for(const TKey & key)
+    {
+      std::size_t h = THash()(key);
+
+      // boost::hash of an integer is the integer itself,
+      // mix the bits so that strided keys spread across shards:
+      h ^= (h >> 16);
+      h *= 0x45d9f3b;
+      h ^= (h >> 16);
+
+      return *(shards_[h % shards_.size()]);
+    }
+
+    // intentionally disabled:
+    ShardedLRUCache(const ShardedLRUCache &);
+    ShardedLRUCache & operator = (const ShardedLRUCache &);
+
+    std::size_t capacity_;
+    TCostFunc cost_;
+    std::vector<Shard *> shards_;
+  };
+
 }
 
 
@@ -1300,6 +1300,38 @@ namespace yae
     return dts < end;
   }
 
+  //----------------------------------------------------------------
+  // Timeline::Track::find_keyframe_by_dts
+  //
+  bool
+  Timeline::Track::find_keyframe_by_dts(const TTime & dts,
+                                        std::size_t & index) const
+  {
+    if (keyframes_.empty())
+    {
+      return false;
+    }
+
+    // the sample spanning the given DTS, clamped to the timeline:
+    std::vector<TTime>::const_iterator found =
+      std::upper_bound(dts_.begin(), dts_.end(), dts);
+
+    std::size_t i =
+      (found == dts_.begin()) ? 0 :
+      std::size_t(found - dts_.begin()) - 1;
+
+    std::set<std::size_t>::const_iterator k = keyframes_.upper_bound(i);
+    if (k == keyframes_.begin())
+    {
+      // there is no keyframe at or before the sample:
+      return false;
+    }
+
+    --k;
+    index = *k;
+    return true;
+  }
+
 
   //----------------------------------------------------------------
   // Timeline::add_frame
@@ -1311,7 +1343,8 @@ namespace yae
                        const TTime & dts,
                        const TTime & pts,
                        const TTime & dur,
-                       double tolerance)
+                       double tolerance,
+                       int64 pos)
   {
     Track & track = tracks_[track_id];
 
@@ -1324,6 +1357,7 @@ namespace yae
     track.dts_.push_back(dts);
     track.pts_.push_back(pts);
     track.dur_.push_back(dur);
+    track.pos_.push_back(pos);
 
     Timespan s(dts, dts + dur);
     if (!yae::extend(track.dts_span_, s, tolerance))
@@ -1452,6 +1486,9 @@ namespace yae
       // append additional packet sizes:
       dst.size_.insert(dst.size_.end(), src.size_.begin(), src.size_.end());
 
+      // byte positions refer to a different source:
+      dst.pos_.resize(dst.size_.size(), -1);
+
       // update DTS timeline:
       for (std::list<Timespan>::const_iterator
              j = src.dts_span_.begin(); j != src.dts_span_.end(); ++j)
@@ -1561,6 +1598,290 @@ namespace yae
     return oss.str();
   }
 
+  //----------------------------------------------------------------
+  // save_time
+  //
+  // time values are stored as a delta from the previous value,
+  // consecutive timestamps of a track usually share the time base
+  // and differ by a small amount, so this packs into a few bytes:
+  //
+  static void
+  save_time(std::ostream & os, const TTime & t, TTime & prev)
+  {
+    save_int(os, int64(t.base_ - prev.base_));
+    save_int(os, t.time_ - prev.time_);
+    prev = t;
+  }
+
+  //----------------------------------------------------------------
+  // load_time
+  //
+  static bool
+  load_time(std::istream & is, TTime & t, TTime & prev)
+  {
+    int64 base = 0;
+    int64 time = 0;
+    if (!(load_int(is, base) && load_int(is, time)))
+    {
+      return false;
+    }
+
+    t.base_ = prev.base_ + uint64(base);
+    t.time_ = prev.time_ + time;
+    prev = t;
+    return t.base_ != 0;
+  }
+
+  //----------------------------------------------------------------
+  // save
+  //
+  static void
+  save(std::ostream & os, const std::vector<TTime> & tt)
+  {
+    save_uint(os, tt.size());
+
+    TTime prev(0, 1);
+    for (std::vector<TTime>::const_iterator i = tt.begin(); i != tt.end(); ++i)
+    {
+      save_time(os, *i, prev);
+    }
+  }
+
+  //----------------------------------------------------------------
+  // load
+  //
+  static bool
+  load(std::istream & is, std::vector<TTime> & tt, std::size_t expected)
+  {
+    uint64 n = 0;
+    if (!load_uint(is, n) || n != expected)
+    {
+      return false;
+    }
+
+    tt.resize(std::size_t(n));
+
+    TTime prev(0, 1);
+    for (std::size_t i = 0; i < expected; i++)
+    {
+      if (!load_time(is, tt[i], prev))
+      {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  //----------------------------------------------------------------
+  // save
+  //
+  static void
+  save(std::ostream & os, const std::list<Timespan> & spans)
+  {
+    save_uint(os, spans.size());
+
+    TTime prev(0, 1);
+    for (std::list<Timespan>::const_iterator
+           i = spans.begin(); i != spans.end(); ++i)
+    {
+      save_time(os, i->t0_, prev);
+      save_time(os, i->t1_, prev);
+    }
+  }
+
+  //----------------------------------------------------------------
+  // load
+  //
+  static bool
+  load(std::istream & is, std::list<Timespan> & spans)
+  {
+    uint64 n = 0;
+    if (!load_uint(is, n))
+    {
+      return false;
+    }
+
+    TTime prev(0, 1);
+    for (uint64 i = 0; i < n; i++)
+    {
+      Timespan span;
+      if (!(load_time(is, span.t0_, prev) &&
+            load_time(is, span.t1_, prev)))
+      {
+        return false;
+      }
+
+      spans.push_back(span);
+    }
+
+    return true;
+  }
+
+  //----------------------------------------------------------------
+  // Timeline::save
+  //
+  void
+  Timeline::save(std::ostream & os) const
+  {
+    TTime prev(0, 1);
+    save_time(os, bbox_dts_.t0_, prev);
+    save_time(os, bbox_dts_.t1_, prev);
+    save_time(os, bbox_pts_.t0_, prev);
+    save_time(os, bbox_pts_.t1_, prev);
+
+    save_uint(os, tracks_.size());
+    for (TTracks::const_iterator i = tracks_.begin(); i != tracks_.end(); ++i)
+    {
+      const std::string & track_id = i->first;
+      const Track & track = i->second;
+      save_str(os, track_id);
+
+      yae::save(os, track.dts_span_);
+      yae::save(os, track.pts_span_);
+
+      save_uint(os, track.size_.size());
+      for (std::vector<std::size_t>::const_iterator
+             j = track.size_.begin(); j != track.size_.end(); ++j)
+      {
+        save_uint(os, *j);
+      }
+
+      yae::save(os, track.dts_);
+      yae::save(os, track.pts_);
+      yae::save(os, track.dur_);
+
+      // keyframe sample indices are stored as deltas:
+      save_uint(os, track.keyframes_.size());
+      std::size_t prev_index = 0;
+      for (std::set<std::size_t>::const_iterator
+             j = track.keyframes_.begin(); j != track.keyframes_.end(); ++j)
+      {
+        save_uint(os, *j - prev_index);
+        prev_index = *j;
+      }
+
+      // byte positions are stored as deltas too,
+      // one per sample:
+      int64 prev_pos = 0;
+      for (std::size_t j = 0, n = track.size_.size(); j < n; j++)
+      {
+        int64 pos = track.get_pos(j);
+        save_int(os, pos - prev_pos);
+        prev_pos = pos;
+      }
+    }
+  }
+
+  //----------------------------------------------------------------
+  // Timeline::load
+  //
+  bool
+  Timeline::load(std::istream & is)
+  {
+    Timeline timeline;
+
+    TTime prev(0, 1);
+    if (!(load_time(is, timeline.bbox_dts_.t0_, prev) &&
+          load_time(is, timeline.bbox_dts_.t1_, prev) &&
+          load_time(is, timeline.bbox_pts_.t0_, prev) &&
+          load_time(is, timeline.bbox_pts_.t1_, prev)))
+    {
+      return false;
+    }
+
+    uint64 num_tracks = 0;
+    if (!load_uint(is, num_tracks))
+    {
+      return false;
+    }
+
+    for (uint64 i = 0; i < num_tracks; i++)
+    {
+      std::string track_id;
+      if (!load_str(is, track_id))
+      {
+        return false;
+      }
+
+      Track & track = timeline.tracks_[track_id];
+      if (!(yae::load(is, track.dts_span_) &&
+            yae::load(is, track.pts_span_)))
+      {
+        return false;
+      }
+
+      uint64 num_samples = 0;
+      if (!load_uint(is, num_samples))
+      {
+        return false;
+      }
+
+      const std::size_t n = std::size_t(num_samples);
+      track.size_.resize(n);
+      for (std::size_t j = 0; j < n; j++)
+      {
+        uint64 size = 0;
+        if (!load_uint(is, size))
+        {
+          return false;
+        }
+
+        track.size_[j] = std::size_t(size);
+      }
+
+      if (!(yae::load(is, track.dts_, n) &&
+            yae::load(is, track.pts_, n) &&
+            yae::load(is, track.dur_, n)))
+      {
+        return false;
+      }
+
+      uint64 num_keyframes = 0;
+      if (!load_uint(is, num_keyframes) || num_keyframes > n)
+      {
+        return false;
+      }
+
+      std::size_t index = 0;
+      for (uint64 j = 0; j < num_keyframes; j++)
+      {
+        uint64 delta = 0;
+        if (!load_uint(is, delta))
+        {
+          return false;
+        }
+
+        index += std::size_t(delta);
+        if (index >= n)
+        {
+          return false;
+        }
+
+        track.keyframes_.insert(track.keyframes_.end(), index);
+      }
+
+      track.pos_.resize(n);
+      int64 pos = 0;
+      for (std::size_t j = 0; j < n; j++)
+      {
+        int64 delta = 0;
+        if (!load_int(is, delta))
+        {
+          return false;
+        }
+
+        pos += delta;
+        track.pos_[j] = pos;
+      }
+    }
+
+    bbox_dts_ = timeline.bbox_dts_;
+    bbox_pts_ = timeline.bbox_pts_;
+    tracks_.swap(timeline.tracks_);
+    return true;
+  }
+
   //----------------------------------------------------------------
   // operator
   //
@@ -1836,6 +2157,101 @@ namespace yae
     }
   }
 
+  //----------------------------------------------------------------
+  // FramerateEstimator::save
+  //
+  void
+  FramerateEstimator::save(std::ostream & os) const
+  {
+    save_uint(os, max_);
+
+    save_uint(os, dts_.size());
+    TTime prev(0, 1);
+    for (std::list<TTime>::const_iterator
+           i = dts_.begin(); i != dts_.end(); ++i)
+    {
+      save_time(os, *i, prev);
+    }
+
+    save_uint(os, dur_.size());
+    prev = TTime(0, 1);
+    for (std::map<TTime, uint64>::const_iterator
+           i = dur_.begin(); i != dur_.end(); ++i)
+    {
+      const TTime & msec = i->first;
+      save_time(os, msec, prev);
+      save_uint(os, i->second);
+
+      TTime sum_prev(0, 1);
+      save_time(os, yae::get(sum_, msec, TTime(0, 1)), sum_prev);
+    }
+  }
+
+  //----------------------------------------------------------------
+  // FramerateEstimator::load
+  //
+  bool
+  FramerateEstimator::load(std::istream & is)
+  {
+    FramerateEstimator estimator;
+
+    uint64 max_size = 0;
+    uint64 num_dts = 0;
+    if (!(load_uint(is, max_size) &&
+          load_uint(is, num_dts)) ||
+        num_dts > max_size)
+    {
+      return false;
+    }
+
+    estimator.max_ = std::size_t(max_size);
+    estimator.num_ = std::size_t(num_dts);
+
+    TTime prev(0, 1);
+    for (uint64 i = 0; i < num_dts; i++)
+    {
+      TTime dts;
+      if (!load_time(is, dts, prev))
+      {
+        return false;
+      }
+
+      estimator.dts_.push_back(dts);
+    }
+
+    uint64 num_dur = 0;
+    if (!load_uint(is, num_dur))
+    {
+      return false;
+    }
+
+    prev = TTime(0, 1);
+    for (uint64 i = 0; i < num_dur; i++)
+    {
+      TTime msec;
+      uint64 num = 0;
+      TTime sum;
+      TTime sum_prev(0, 1);
+
+      if (!(load_time(is, msec, prev) &&
+            load_uint(is, num) &&
+            load_time(is, sum, sum_prev)))
+      {
+        return false;
+      }
+
+      estimator.dur_[msec] = num;
+      estimator.sum_[msec] = sum;
+    }
+
+    max_ = estimator.max_;
+    num_ = estimator.num_;
+    dts_.swap(estimator.dts_);
+    dur_.swap(estimator.dur_);
+    sum_.swap(estimator.sum_);
+    return true;
+  }
+
   //----------------------------------------------------------------
   // FramerateEstimator::window_avg
   //
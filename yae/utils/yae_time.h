@@ -411,9 +411,16 @@ namespace yae
         return i < n ? size_[i] : 0;
       }
 
+      inline int64 get_pos(std::size_t i) const
+      { return i < pos_.size() ? pos_[i] : -1; }
+
       // find sample index of the sample that spans a given DTS time point:
       bool find_sample_by_dts(const TTime & dts, std::size_t & index) const;
 
+      // find sample index of the keyframe that a decoder has to start
+      // from in order to reach the sample spanning a given DTS time point:
+      bool find_keyframe_by_dts(const TTime & dts, std::size_t & index) const;
+
       // timespan built-up in [dts, dts + dur) increments,
       // should be quick due to monotonically increasing dts:
       std::list<Timespan> dts_span_;
@@ -428,6 +435,9 @@ namespace yae
       std::vector<TTime> pts_;
       std::vector<TTime> dur_;
 
+      // packet byte position in the source, -1 if unknown:
+      std::vector<int64> pos_;
+
       // sample indices of keyframes:
       std::set<std::size_t> keyframes_;
     };
@@ -444,13 +454,16 @@ namespace yae
                     const TTime & dts,
                     const TTime & pts,
                     const TTime & dur,
-                    double tolerance);
+                    double tolerance,
+                    int64 pos = -1);
 
     // translate this timeline by a given offset:
     Timeline & operator += (const TTime & offset);
 
     // extend this timeline via a union with
-    // a given timeline translated by a given offset:
+    // a given timeline translated by a given offset;
+    // byte positions of the appended packets are not carried over
+    // because they refer to a different source:
     void extend(const Timeline & timeline,
                 const TTime & offset,
                 double tolerace);
@@ -459,6 +472,12 @@ namespace yae
     Timespan bbox_dts(const std::string & track_id) const;
     Timespan bbox_pts(const std::string & track_id) const;
 
+    // compact binary serialization, for persistent index caches;
+    // load returns false (and leaves this timeline unchanged)
+    // if the input is truncated or malformed:
+    void save(std::ostream & os) const;
+    bool load(std::istream & is);
+
     // bounding box for all tracks:
     Timespan bbox_dts_;
     Timespan bbox_pts_;
@@ -550,6 +569,11 @@ namespace yae
     inline const std::list<TTime> & dts() const
     { return dts_; }
 
+    // compact binary serialization of the complete estimator state,
+    // so that a restored estimator can continue accepting push(dts):
+    void save(std::ostream & os) const;
+    bool load(std::istream & is);
+
   protected:
     // a sliding window, for calculating a window average:
     std::list<TTime> dts_;
@@ -0,0 +1,403 @@
+// -*- Mode: c++; tab-width: 8; c-basic-offset: 2; indent-tabs-mode: nil -*-
+// NOTE: the first line of this file sets up source code indentation rules
+// for Emacs; it is also a hint to anyone modifying this file.
+
+// Created   : Fri Oct 16 16:41:09 MDT 2026
+// Copyright : Pavel Koshevoy
+// License   : MIT -- http://www.opensource.org/licenses/mit-license.php
+
+// standard:
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <list>
+#include <sstream>
+#include <string>
+
+// boost:
+#include <boost/chrono/chrono.hpp>
+#include <boost/thread.hpp>
+#include <boost/thread/tss.hpp>
+
+// aeyae:
+#include "yae_trace.h"
+
+
+namespace yae
+{
+
+  //----------------------------------------------------------------
+  // kInstant
+  //
+  // duration value that marks an instant event:
+  //
+  static const boost::uint64_t kInstant = ~boost::uint64_t(0);
+
+  //----------------------------------------------------------------
+  // TraceEvent
+  //
+  // written by the owner thread, read by whoever saves the trace;
+  // seq_ is a sequence lock that lets the reader detect an event
+  // that was overwritten while it was being copied:
+  //
+  struct TraceEvent
+  {
+    TraceEvent():
+      seq_(0),
+      name_(NULL),
+      ts_(0),
+      dur_(0)
+    {}
+
+    boost::atomic<boost::uint64_t> seq_;
+    boost::atomic<const char *> name_;
+    boost::atomic<boost::uint64_t> ts_;
+    boost::atomic<boost::uint64_t> dur_;
+  };
+
+  //----------------------------------------------------------------
+  // TraceThread
+  //
+  struct TraceThread
+  {
+    TraceThread(std::size_t tid, std::size_t capacity):
+      tid_(tid),
+      capacity_(capacity),
+      ring_(new TraceEvent[capacity]),
+      next_(0)
+    {}
+
+    ~TraceThread()
+    {
+      delete [] ring_;
+    }
+
+    void add(const char * name, boost::uint64_t ts, boost::uint64_t dur)
+    {
+      boost::uint64_t i = next_.load(boost::memory_order_relaxed);
+      TraceEvent & event = ring_[i % capacity_];
+
+      event.seq_.store(0, boost::memory_order_relaxed);
+      boost::atomic_thread_fence(boost::memory_order_release);
+
+      event.name_.store(name, boost::memory_order_relaxed);
+      event.ts_.store(ts, boost::memory_order_relaxed);
+      event.dur_.store(dur, boost::memory_order_relaxed);
+      event.seq_.store(i + 1, boost::memory_order_release);
+
+      next_.store(i + 1, boost::memory_order_release);
+    }
+
+    // returns false if the event was being overwritten:
+    bool get(std::size_t i,
+             const char *& name,
+             boost::uint64_t & ts,
+             boost::uint64_t & dur) const
+    {
+      const TraceEvent & event = ring_[i % capacity_];
+
+      boost::uint64_t s0 = event.seq_.load(boost::memory_order_acquire);
+      name = event.name_.load(boost::memory_order_relaxed);
+      ts = event.ts_.load(boost::memory_order_relaxed);
+      dur = event.dur_.load(boost::memory_order_relaxed);
+      boost::atomic_thread_fence(boost::memory_order_acquire);
+      boost::uint64_t s1 = event.seq_.load(boost::memory_order_relaxed);
+
+      return s0 == i + 1 && s0 == s1 && name;
+    }
+
+    const std::size_t tid_;
+    const std::size_t capacity_;
+    TraceEvent * ring_;
+    boost::atomic<boost::uint64_t> next_;
+
+    // protected by the registry mutex:
+    std::string name_;
+
+  private:
+    TraceThread(const TraceThread &);
+    TraceThread & operator = (const TraceThread &);
+  };
+
+  //----------------------------------------------------------------
+  // TraceRegistry
+  //
+  struct TraceRegistry
+  {
+    // keep the rings of at most this many exited threads:
+    enum { kMaxRetired = 64 };
+
+    // intentionally leaked, threads may exit after static destructors:
+    static TraceRegistry & singleton()
+    {
+      static TraceRegistry * registry = new TraceRegistry();
+      return *registry;
+    }
+
+    TraceRegistry():
+      t0_(boost::chrono::steady_clock::now()),
+      tss_(&TraceRegistry::retire),
+      capacity_(4096),
+      tid_(0),
+      cutoff_(0)
+    {}
+
+    TraceThread & thread()
+    {
+      TraceThread * thread = tss_.get();
+      if (!thread)
+      {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        thread = new TraceThread(++tid_, capacity_);
+        threads_.push_back(thread);
+        tss_.reset(thread);
+      }
+
+      return *thread;
+    }
+
+    static void retire(TraceThread * thread)
+    {
+      TraceRegistry & registry = TraceRegistry::singleton();
+      boost::lock_guard<boost::mutex> lock(registry.mutex_);
+      registry.threads_.remove(thread);
+      registry.retired_.push_back(thread);
+
+      if (registry.retired_.size() > kMaxRetired)
+      {
+        delete registry.retired_.front();
+        registry.retired_.pop_front();
+      }
+    }
+
+    // must hold the lock:
+    void write(std::ostream & os, const TraceThread & thread, bool & first)
+    {
+      const boost::uint64_t cutoff = cutoff_.load();
+
+      if (!thread.name_.empty())
+      {
+        os << (first ? "\n" : ",\n")
+           << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+           << thread.tid_ << ",\"args\":{\"name\":\"";
+        escape(os, thread.name_.c_str());
+        os << "\"}}";
+        first = false;
+      }
+
+      boost::uint64_t i1 = thread.next_.load(boost::memory_order_acquire);
+      boost::uint64_t i0 = (i1 > thread.capacity_) ? i1 - thread.capacity_ : 0;
+
+      for (boost::uint64_t i = i0; i < i1; i++)
+      {
+        const char * name = NULL;
+        boost::uint64_t ts = 0;
+        boost::uint64_t dur = 0;
+
+        if (!thread.get(i, name, ts, dur) || ts < cutoff)
+        {
+          continue;
+        }
+
+        os << (first ? "\n" : ",\n") << "{\"name\":\"";
+        escape(os, name);
+        os << "\",\"pid\":1,\"tid\":" << thread.tid_
+           << ",\"ts\":" << double(ts) * 1e-3;
+
+        if (dur == kInstant)
+        {
+          os << ",\"ph\":\"i\",\"s\":\"t\"}";
+        }
+        else
+        {
+          os << ",\"ph\":\"X\",\"dur\":" << double(dur) * 1e-3 << "}";
+        }
+
+        first = false;
+      }
+    }
+
+    static void escape(std::ostream & os, const char * text)
+    {
+      for (const char * c = text; *c; ++c)
+      {
+        if (*c == '"' || *c == '\\')
+        {
+          os << '\\' << *c;
+        }
+        else if ((unsigned char)(*c) < 0x20)
+        {
+          os << ' ';
+        }
+        else
+        {
+          os << *c;
+        }
+      }
+    }
+
+    const boost::chrono::steady_clock::time_point t0_;
+
+    boost::mutex mutex_;
+    boost::thread_specific_ptr<TraceThread> tss_;
+    std::size_t capacity_;
+    std::size_t tid_;
+    std::list<TraceThread *> threads_;
+    std::list<TraceThread *> retired_;
+
+    // events older than this are considered cleared:
+    boost::atomic<boost::uint64_t> cutoff_;
+  };
+
+  //----------------------------------------------------------------
+  // trace_enabled_by_default
+  //
+  static bool
+  trace_enabled_by_default()
+  {
+    const char * env = getenv("YAE_TRACE");
+    return env && *env && strcmp(env, "0") != 0;
+  }
+
+  //----------------------------------------------------------------
+  // TTrace::enabled_
+  //
+  boost::atomic<bool> TTrace::enabled_(trace_enabled_by_default());
+
+  //----------------------------------------------------------------
+  // TTrace::enable
+  //
+  void
+  TTrace::enable(bool enable)
+  {
+    enabled_.store(enable);
+  }
+
+  //----------------------------------------------------------------
+  // TTrace::set_capacity
+  //
+  void
+  TTrace::set_capacity(std::size_t events_per_thread)
+  {
+    TraceRegistry & registry = TraceRegistry::singleton();
+    boost::lock_guard<boost::mutex> lock(registry.mutex_);
+    registry.capacity_ = std::max<std::size_t>(1, events_per_thread);
+  }
+
+  //----------------------------------------------------------------
+  // TTrace::set_thread_name
+  //
+  void
+  TTrace::set_thread_name(const char * name)
+  {
+    TraceRegistry & registry = TraceRegistry::singleton();
+    TraceThread & thread = registry.thread();
+
+    boost::lock_guard<boost::mutex> lock(registry.mutex_);
+    thread.name_.assign(name ? name : "");
+  }
+
+  //----------------------------------------------------------------
+  // TTrace::now
+  //
+  boost::uint64_t
+  TTrace::now()
+  {
+    TraceRegistry & registry = TraceRegistry::singleton();
+    boost::chrono::steady_clock::time_point
+      t = boost::chrono::steady_clock::now();
+
+    return boost::chrono::duration_cast<boost::chrono::nanoseconds>
+      (t - registry.t0_).count();
+  }
+
+  //----------------------------------------------------------------
+  // TTrace::span
+  //
+  void
+  TTrace::span(const char * name, boost::uint64_t t0, boost::uint64_t t1)
+  {
+    TraceRegistry & registry = TraceRegistry::singleton();
+    TraceThread & thread = registry.thread();
+    thread.add(name, t0, t1 > t0 ? t1 - t0 : 0);
+  }
+
+  //----------------------------------------------------------------
+  // TTrace::instant
+  //
+  void
+  TTrace::instant(const char * name)
+  {
+    TraceRegistry & registry = TraceRegistry::singleton();
+    TraceThread & thread = registry.thread();
+    thread.add(name, now(), kInstant);
+  }
+
+  //----------------------------------------------------------------
+  // TTrace::write
+  //
+  void
+  TTrace::write(std::ostream & os)
+  {
+    TraceRegistry & registry = TraceRegistry::singleton();
+
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(3) << "{\"traceEvents\":[";
+    bool first = true;
+    {
+      boost::lock_guard<boost::mutex> lock(registry.mutex_);
+
+      for (std::list<TraceThread *>::const_iterator
+             i = registry.retired_.begin(); i != registry.retired_.end(); ++i)
+      {
+        registry.write(oss, **i, first);
+      }
+
+      for (std::list<TraceThread *>::const_iterator
+             i = registry.threads_.begin(); i != registry.threads_.end(); ++i)
+      {
+        registry.write(oss, **i, first);
+      }
+    }
+
+    oss << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    os << oss.str();
+  }
+
+  //----------------------------------------------------------------
+  // TTrace::save
+  //
+  bool
+  TTrace::save(const char * path)
+  {
+    std::ofstream ofs(path, std::ios::out | std::ios::binary);
+    if (!ofs.is_open())
+    {
+      return false;
+    }
+
+    write(ofs);
+    ofs.close();
+    return !ofs.fail();
+  }
+
+  //----------------------------------------------------------------
+  // TTrace::clear
+  //
+  void
+  TTrace::clear()
+  {
+    TraceRegistry & registry = TraceRegistry::singleton();
+    registry.cutoff_.store(now());
+
+    boost::lock_guard<boost::mutex> lock(registry.mutex_);
+    while (!registry.retired_.empty())
+    {
+      delete registry.retired_.front();
+      registry.retired_.pop_front();
+    }
+  }
+
+}
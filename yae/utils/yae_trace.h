@@ -0,0 +1,120 @@
+// -*- Mode: c++; tab-width: 8; c-basic-offset: 2; indent-tabs-mode: nil -*-
+// NOTE: the first line of this file sets up source code indentation rules
+// for Emacs; it is also a hint to anyone modifying this file.
+
+// Created   : Fri Oct 16 16:41:09 MDT 2026
+// Copyright : Pavel Koshevoy
+// License   : MIT -- http://www.opensource.org/licenses/mit-license.php
+
+#ifndef YAE_TRACE_H_
+#define YAE_TRACE_H_
+
+// standard:
+#include <iostream>
+
+// boost:
+#ifndef Q_MOC_RUN
+#include <boost/atomic.hpp>
+#include <boost/cstdint.hpp>
+#endif
+
+// aeyae:
+#include "yae/api/yae_api.h"
+
+
+namespace yae
+{
+
+  //----------------------------------------------------------------
+  // TTrace
+  //
+  // Records a timeline of spans and instant events per thread
+  // and writes it out as Chrome trace-event JSON, which can be loaded
+  // in chrome://tracing or ui.perfetto.dev
+  //
+  // Each thread records into its own fixed size ring buffer, the oldest
+  // events are overwritten, so tracing can stay enabled indefinitely.
+  //
+  // Tracing is disabled by default, set YAE_TRACE=1 in the environment
+  // or call TTrace::enable(true) at runtime.
+  //
+  // NOTE: event names are not copied, they must be string literals
+  // (or otherwise outlive the trace).
+  //
+  struct YAE_API TTrace
+  {
+    inline static bool enabled()
+    { return enabled_.load(boost::memory_order_relaxed); }
+
+    static void enable(bool enable);
+
+    // number of events retained per thread, applies to threads
+    // that start recording after this call:
+    static void set_capacity(std::size_t events_per_thread);
+
+    // label the calling thread in the trace viewer:
+    static void set_thread_name(const char * name);
+
+    // timestamps are nanoseconds since the trace epoch:
+    static boost::uint64_t now();
+
+    // record a complete span:
+    static void span(const char * name,
+                     boost::uint64_t t0,
+                     boost::uint64_t t1);
+
+    // record an instant event:
+    static void instant(const char * name);
+
+    // write the currently retained events as Chrome trace JSON:
+    static void write(std::ostream & os);
+    static bool save(const char * path);
+
+    // discard all retained events:
+    static void clear();
+
+  private:
+    static boost::atomic<bool> enabled_;
+  };
+
+  //----------------------------------------------------------------
+  // TTraceSpan
+  //
+  struct YAE_API TTraceSpan
+  {
+    inline TTraceSpan(const char * name):
+      name_(TTrace::enabled() ? name : NULL),
+      t0_(name_ ? TTrace::now() : 0)
+    {}
+
+    inline ~TTraceSpan()
+    {
+      if (name_)
+      {
+        TTrace::span(name_, t0_, TTrace::now());
+      }
+    }
+
+  private:
+    TTraceSpan(const TTraceSpan &);
+    TTraceSpan & operator = (const TTraceSpan &);
+
+    const char * name_;
+    boost::uint64_t t0_;
+  };
+
+}
+
+#ifndef YAE_TRACE_SPAN
+# ifndef YAE_DISABLE_TRACE
+#  define YAE_TRACE_SPAN(varname, name) yae::TTraceSpan varname(name)
+#  define YAE_TRACE_INSTANT(name)               \
+  if (yae::TTrace::enabled()) yae::TTrace::instant(name)
+# else
+#  define YAE_TRACE_SPAN(varname, name)
+#  define YAE_TRACE_INSTANT(name)
+# endif
+#endif
+
+
+#endif // YAE_TRACE_H_
@@ -813,6 +813,111 @@ namespace yae
   }
 
 
+  //----------------------------------------------------------------
+  // save_uint
+  //
+  void
+  save_uint(std::ostream & os, uint64 v)
+  {
+    unsigned char buf[10];
+    std::size_t n = 0;
+
+    do
+    {
+      unsigned char byte = (unsigned char)(v & 0x7F);
+      v >>= 7;
+      buf[n++] = v ? (byte | 0x80) : byte;
+    }
+    while (v);
+
+    os.write((const char *)buf, n);
+  }
+
+  //----------------------------------------------------------------
+  // load_uint
+  //
+  bool
+  load_uint(std::istream & is, uint64 & v)
+  {
+    v = 0;
+
+    for (unsigned int shift = 0; shift < 64; shift += 7)
+    {
+      int c = is.get();
+      if (c == std::char_traits<char>::eof())
+      {
+        return false;
+      }
+
+      v |= uint64(c & 0x7F) << shift;
+      if (!(c & 0x80))
+      {
+        return true;
+      }
+    }
+
+    // too many continuation bytes:
+    return false;
+  }
+
+  //----------------------------------------------------------------
+  // save_int
+  //
+  void
+  save_int(std::ostream & os, int64 v)
+  {
+    uint64 u = (uint64(v) << 1) ^ uint64(v >> 63);
+    save_uint(os, u);
+  }
+
+  //----------------------------------------------------------------
+  // load_int
+  //
+  bool
+  load_int(std::istream & is, int64 & v)
+  {
+    uint64 u = 0;
+    if (!load_uint(is, u))
+    {
+      return false;
+    }
+
+    v = int64(u >> 1) ^ -int64(u & 1);
+    return true;
+  }
+
+  //----------------------------------------------------------------
+  // save_str
+  //
+  void
+  save_str(std::ostream & os, const std::string & s)
+  {
+    save_uint(os, s.size());
+    os.write(s.data(), s.size());
+  }
+
+  //----------------------------------------------------------------
+  // load_str
+  //
+  bool
+  load_str(std::istream & is, std::string & s)
+  {
+    uint64 n = 0;
+    if (!load_uint(is, n) || n > (uint64(1) << 24))
+    {
+      return false;
+    }
+
+    s.resize(std::size_t(n));
+    if (n && !is.read(&s[0], std::streamsize(n)))
+    {
+      return false;
+    }
+
+    return true;
+  }
+
+
   //----------------------------------------------------------------
   // TOpenFile::TOpenFile
   //
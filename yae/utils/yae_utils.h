@@ -283,6 +283,25 @@ namespace yae
   write(FILE * file, const char * text);
 
 
+  //----------------------------------------------------------------
+  // save_uint
+  //
+  // compact binary serialization helpers: unsigned integers are
+  // stored as LEB128 varints, signed integers are zigzag encoded
+  // first, strings are stored as a varint length followed by bytes.
+  //
+  // load_* return false on truncated or malformed input.
+  //
+  YAE_API void save_uint(std::ostream & os, uint64 v);
+  YAE_API bool load_uint(std::istream & is, uint64 & v);
+
+  YAE_API void save_int(std::ostream & os, int64 v);
+  YAE_API bool load_int(std::istream & is, int64 & v);
+
+  YAE_API void save_str(std::ostream & os, const std::string & s);
+  YAE_API bool load_str(std::istream & is, std::string & s);
+
+
   //----------------------------------------------------------------
   // TOpenFile
   //
@@ -18,6 +18,8 @@
 
 // yae includes:
 #include "yae_audio_renderer_input.h"
+#include "../utils/yae_benchmark.h"
+#include "../utils/yae_trace.h"
 
 
 //----------------------------------------------------------------
@@ -299,6 +301,8 @@ namespace yae
     }
 
     boost::this_thread::interruption_point();
+    YAE_PROBE(probe, "AudioRendererInput::getData");
+    YAE_TRACE_SPAN(span, "AudioRendererInput::getData");
 
     unsigned char * dstBuf = (unsigned char *)output;
     unsigned char ** dst = dstPlanar ? (unsigned char **)output : &dstBuf;
@@ -7,12 +7,36 @@
 // License   : MIT -- http://www.opensource.org/licenses/mit-license.php
 
 // system includes:
+#include <algorithm>
 #include <iostream>
-#include <map>
+#include <vector>
 
 // boost includes:
+#include <boost/atomic.hpp>
 #include <boost/thread.hpp>
 
+// SIMD kernels are compiled for x86 regardless of the compiler flags,
+// the best set supported by the CPU is selected at runtime:
+#if defined(__x86_64__) || defined(__i386__) || \
+    defined(_M_X64) || defined(_M_IX86)
+#define YAE_AUTO_CROP_X86 1
+#include <emmintrin.h>
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#else
+#define YAE_AUTO_CROP_X86 0
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define YAE_TARGET_SSE2 __attribute__((target("sse2")))
+#define YAE_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define YAE_TARGET_SSE2
+#define YAE_TARGET_AVX2
+#endif
+
 // yae includes:
 #include "yae_video.h"
 #include "yae_auto_crop.h"
@@ -25,572 +49,848 @@ namespace yae
 {
 
   //----------------------------------------------------------------
-  // TFiFo
+  // TKernelsImpl
+  //
+  // Luma samples are processed as unsigned integers, so that
+  // the sliding window sums are exact regardless of the kernels used:
   //
-  template <typename TScalar, int maxSize>
-  struct TFiFo
+  struct TKernelsImpl
   {
-    TFiFo():
-      size_(0),
-      head_(0),
-      tail_(0),
-      sum_(0)
-    {}
+    // dst[i] = (src[i] >> rshift) & mask, 8-bit samples:
+    void (*widen8_)(const unsigned char * src,
+                    std::size_t n,
+                    unsigned int rshift,
+                    unsigned int mask,
+                    unsigned int * dst);
+
+    // same as above, little-endian 16-bit samples:
+    void (*widen16_)(const unsigned char * src,
+                     std::size_t n,
+                     unsigned int rshift,
+                     unsigned int mask,
+                     unsigned int * dst);
+
+    // dst[i] = src[i] + src[i + k], for i in [0, n - k),
+    // dst may be the same as src:
+    void (*addShifted_)(const unsigned int * src,
+                        std::size_t n,
+                        std::size_t k,
+                        unsigned int * dst);
+  };
 
-    enum { kSize = maxSize };
+  //----------------------------------------------------------------
+  // widen8_scalar
+  //
+  static void
+  widen8_scalar(const unsigned char * src,
+                std::size_t n,
+                unsigned int rshift,
+                unsigned int mask,
+                unsigned int * dst)
+  {
+    for (std::size_t i = 0; i < n; i++)
+    {
+      dst[i] = (src[i] >> rshift) & mask;
+    }
+  }
+
+  //----------------------------------------------------------------
+  // widen16_scalar
+  //
+  static void
+  widen16_scalar(const unsigned char * src,
+                 std::size_t n,
+                 unsigned int rshift,
+                 unsigned int mask,
+                 unsigned int * dst)
+  {
+    for (std::size_t i = 0; i < n; i++, src += 2)
+    {
+      unsigned int v = ((unsigned int)(src[1]) << 8) | src[0];
+      dst[i] = (v >> rshift) & mask;
+    }
+  }
 
-    inline const int & size() const
-    { return size_; }
+  //----------------------------------------------------------------
+  // addShifted_scalar
+  //
+  static void
+  addShifted_scalar(const unsigned int * src,
+                    std::size_t n,
+                    std::size_t k,
+                    unsigned int * dst)
+  {
+    for (std::size_t i = 0; i + k < n; i++)
+    {
+      dst[i] = src[i] + src[i + k];
+    }
+  }
 
-    inline bool isFull() const
-    { return size_ == maxSize; }
+#if YAE_AUTO_CROP_X86
 
-    inline bool isEmpty() const
-    { return !size_; }
+  //----------------------------------------------------------------
+  // widen8_sse2
+  //
+  YAE_TARGET_SSE2 static void
+  widen8_sse2(const unsigned char * src,
+              std::size_t n,
+              unsigned int rshift,
+              unsigned int mask,
+              unsigned int * dst)
+  {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i vmask = _mm_set1_epi32(mask);
+    const __m128i shift = _mm_cvtsi32_si128(rshift);
 
-    inline const TScalar & first() const
-    { YAE_ASSERT(size_); return data_[head_]; }
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+      __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+      __m128i lo = _mm_unpacklo_epi8(v, zero);
+      __m128i hi = _mm_unpackhi_epi8(v, zero);
+
+      __m128i a = _mm_unpacklo_epi16(lo, zero);
+      __m128i b = _mm_unpackhi_epi16(lo, zero);
+      __m128i c = _mm_unpacklo_epi16(hi, zero);
+      __m128i d = _mm_unpackhi_epi16(hi, zero);
+
+      a = _mm_and_si128(_mm_srl_epi32(a, shift), vmask);
+      b = _mm_and_si128(_mm_srl_epi32(b, shift), vmask);
+      c = _mm_and_si128(_mm_srl_epi32(c, shift), vmask);
+      d = _mm_and_si128(_mm_srl_epi32(d, shift), vmask);
+
+      _mm_storeu_si128((__m128i *)(dst + i), a);
+      _mm_storeu_si128((__m128i *)(dst + i + 4), b);
+      _mm_storeu_si128((__m128i *)(dst + i + 8), c);
+      _mm_storeu_si128((__m128i *)(dst + i + 12), d);
+    }
 
-    inline const TScalar & last() const
-    { YAE_ASSERT(size_); return data_[tail_ - 1]; }
+    widen8_scalar(src + i, n - i, rshift, mask, dst + i);
+  }
 
-    inline TScalar mean() const
-    { YAE_ASSERT(size_); return sum_ / (TScalar)size_; }
+  //----------------------------------------------------------------
+  // widen16_sse2
+  //
+  YAE_TARGET_SSE2 static void
+  widen16_sse2(const unsigned char * src,
+               std::size_t n,
+               unsigned int rshift,
+               unsigned int mask,
+               unsigned int * dst)
+  {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i vmask = _mm_set1_epi32(mask);
+    const __m128i shift = _mm_cvtsi32_si128(rshift);
 
-    TScalar push(const TScalar & d)
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
     {
-      TScalar prev = 0;
+      __m128i v = _mm_loadu_si128((const __m128i *)(src + i * 2));
+      __m128i a = _mm_unpacklo_epi16(v, zero);
+      __m128i b = _mm_unpackhi_epi16(v, zero);
 
-      if (size_ == maxSize)
-      {
-        prev = first();
-        head_ = (head_ + 1) % maxSize;
-        sum_ -= prev;
-      }
-      else
-      {
-        size_++;
-      }
-
-      data_[tail_] = d;
-      tail_ = (tail_ + 1) % maxSize;
-      sum_ += d;
+      a = _mm_and_si128(_mm_srl_epi32(a, shift), vmask);
+      b = _mm_and_si128(_mm_srl_epi32(b, shift), vmask);
 
-      return prev;
+      _mm_storeu_si128((__m128i *)(dst + i), a);
+      _mm_storeu_si128((__m128i *)(dst + i + 4), b);
     }
 
-    void push(const TScalar & d, TFiFo & next)
+    widen16_scalar(src + i * 2, n - i, rshift, mask, dst + i);
+  }
+
+  //----------------------------------------------------------------
+  // addShifted_sse2
+  //
+  YAE_TARGET_SSE2 static void
+  addShifted_sse2(const unsigned int * src,
+                  std::size_t n,
+                  std::size_t k,
+                  unsigned int * dst)
+  {
+    if (n <= k)
     {
-      if (size_ == maxSize)
-      {
-        TScalar prev = push(d);
-        next.push(prev);
-      }
-      else
-      {
-        push(d);
-      }
+      return;
     }
 
-    void push(TFiFo & next)
+    // both operands are loaded before the store,
+    // so this works in-place too:
+    const std::size_t m = n - k;
+    std::size_t i = 0;
+    for (; i + 4 <= m; i += 4)
     {
-      if (size_)
-      {
-        next.push(first());
-        head_ = (head_ + 1) % maxSize;
-        size_--;
-      }
+      __m128i a = _mm_loadu_si128((const __m128i *)(src + i));
+      __m128i b = _mm_loadu_si128((const __m128i *)(src + i + k));
+      _mm_storeu_si128((__m128i *)(dst + i), _mm_add_epi32(a, b));
     }
 
-    TScalar data_[maxSize];
-    int size_;
-    int head_;
-    int tail_;
-    TScalar sum_;
-  };
+    for (; i < m; i++)
+    {
+      dst[i] = src[i] + src[i + k];
+    }
+  }
 
   //----------------------------------------------------------------
-  // TBin
+  // widen8_avx2
   //
-  struct TBin
+  YAE_TARGET_AVX2 static void
+  widen8_avx2(const unsigned char * src,
+              std::size_t n,
+              unsigned int rshift,
+              unsigned int mask,
+              unsigned int * dst)
   {
-    TBin():
-      size_(0),
-      sum_(0)
-    {}
+    const __m256i vmask = _mm256_set1_epi32(mask);
+    const __m128i shift = _mm_cvtsi32_si128(rshift);
 
-    unsigned int size_;
-    int sum_;
-  };
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+      __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+      __m256i a = _mm256_cvtepu8_epi32(v);
+      __m256i b = _mm256_cvtepu8_epi32(_mm_srli_si128(v, 8));
 
-  //----------------------------------------------------------------
-  // updateBin
-  //
-  inline static void
-  updateBin(TBin & bin, int offset, unsigned int weight = 1)
-  {
-    bin.sum_ += offset * weight;
-    bin.size_ += weight;
+      a = _mm256_and_si256(_mm256_srl_epi32(a, shift), vmask);
+      b = _mm256_and_si256(_mm256_srl_epi32(b, shift), vmask);
+
+      _mm256_storeu_si256((__m256i *)(dst + i), a);
+      _mm256_storeu_si256((__m256i *)(dst + i + 8), b);
+    }
+
+    widen8_scalar(src + i, n - i, rshift, mask, dst + i);
   }
 
   //----------------------------------------------------------------
-  // updateHistogram
+  // widen16_avx2
   //
-  inline static void
-  updateHistogram(std::map<int, TBin> & bins, int offset)
+  YAE_TARGET_AVX2 static void
+  widen16_avx2(const unsigned char * src,
+               std::size_t n,
+               unsigned int rshift,
+               unsigned int mask,
+               unsigned int * dst)
   {
-    static const int kGranularity = 2;
+    const __m256i vmask = _mm256_set1_epi32(mask);
+    const __m128i shift = _mm_cvtsi32_si128(rshift);
+
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+      __m128i v = _mm_loadu_si128((const __m128i *)(src + i * 2));
+      __m256i a = _mm256_cvtepu16_epi32(v);
+      a = _mm256_and_si256(_mm256_srl_epi32(a, shift), vmask);
+      _mm256_storeu_si256((__m256i *)(dst + i), a);
+    }
 
-    int i = offset / kGranularity;
-    updateBin(bins[i - 1], offset);
-    updateBin(bins[i], offset, 2);
-    updateBin(bins[i + 1], offset);
+    widen16_scalar(src + i * 2, n - i, rshift, mask, dst + i);
   }
 
   //----------------------------------------------------------------
-  // analyze
+  // addShifted_avx2
   //
-  static bool
-  analyze(const TVideoFramePtr & frame, TCropFrame & crop)
+  YAE_TARGET_AVX2 static void
+  addShifted_avx2(const unsigned int * src,
+                  std::size_t n,
+                  std::size_t k,
+                  unsigned int * dst)
   {
-    // video traits shortcut:
-    const VideoTraits & vtts = frame->traits_;
+    if (n <= k)
+    {
+      return;
+    }
 
-    // pixel format shortcut:
-    const pixelFormat::Traits * ptts =
-      pixelFormat::getTraits(vtts.pixelFormat_);
+    const std::size_t m = n - k;
+    std::size_t i = 0;
+    for (; i + 8 <= m; i += 8)
+    {
+      __m256i a = _mm256_loadu_si256((const __m256i *)(src + i));
+      __m256i b = _mm256_loadu_si256((const __m256i *)(src + i + k));
+      _mm256_storeu_si256((__m256i *)(dst + i), _mm256_add_epi32(a, b));
+    }
 
-    if (!ptts)
+    for (; i < m; i++)
     {
-      // don't know how to handle this pixel format:
-      return false;
+      dst[i] = src[i] + src[i + k];
     }
+  }
 
-    const unsigned char * data = frame->data_->data(0);
-    const std::size_t rowBytes = frame->data_->rowBytes(0);
+#endif
 
-    const unsigned int w = vtts.visibleWidth_;
-    const unsigned int h = vtts.visibleHeight_;
-    const unsigned int x0 = vtts.offsetLeft_;
-    const unsigned int y0 = vtts.offsetTop_;
+  //----------------------------------------------------------------
+  // kKernels
+  //
+  static const TKernelsImpl kKernels[] = {
+    { &widen8_scalar, &widen16_scalar, &addShifted_scalar },
+#if YAE_AUTO_CROP_X86
+    { &widen8_sse2, &widen16_sse2, &addShifted_sse2 },
+    { &widen8_avx2, &widen16_avx2, &addShifted_avx2 },
+#endif
+  };
 
-#if 0
-    std::vector<unsigned char> img(w * h);
-    for (unsigned int y = 0; y < h; y++)
+  //----------------------------------------------------------------
+  // detectKernels
+  //
+  static TAutoCropDetect::TKernels
+  detectKernels()
+  {
+#if YAE_AUTO_CROP_X86
+#if defined(_MSC_VER)
+    int info[4] = { 0 };
+    __cpuid(info, 0);
+    const int maxLeaf = info[0];
+
+    __cpuid(info, 1);
+    const bool sse2 = (info[3] & (1 << 26)) != 0;
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+
+    bool avx2 = false;
+    if (maxLeaf >= 7 && osxsave && avx && (_xgetbv(0) & 6) == 6)
     {
-      for (unsigned int x = 0; x < w; x++)
-      {
-        double t = 255.0 * pixelIntensity(x0 + x, y0 + y,
-                                          data, rowBytes, *ptts);
-        YAE_ASSERT(t <= 255.0 && t >= 0.0);
-        img[y * w + x] = (unsigned char)t;
-      }
+      __cpuidex(info, 7, 0);
+      avx2 = (info[1] & (1 << 5)) != 0;
     }
+#else
+    __builtin_cpu_init();
+    const bool sse2 = __builtin_cpu_supports("sse2");
+    const bool avx2 = __builtin_cpu_supports("avx2");
+#endif
 
-    static int findex = 0;
-    std::string fn = std::string("/tmp/") + toText(++findex) + ".pgm";
-    std::cerr << "SAVING " << fn << ", original was " << ptts->name_
-              << std::endl;
-    std::FILE * fout = fopenUtf8(fn.c_str(), "wb");
-    std::string header;
-    header += "P5\n";
-    header += toText(w) + ' '  + toText(h) + '\n';
-    header += "255\n";
-    fwrite(header.c_str(), 1, header.size(), fout);
-    fwrite(&img[0], 1, img.size(), fout);
-    fclose(fout);
+    if (avx2)
+    {
+      return TAutoCropDetect::kKernelsAVX2;
+    }
+
+    if (sse2)
+    {
+      return TAutoCropDetect::kKernelsSSE2;
+    }
 #endif
 
-    unsigned int step = std::min<unsigned int>(w / 32, h / 32);
-    step = std::max<unsigned int>(1, step);
+    return TAutoCropDetect::kKernelsScalar;
+  }
 
-    const std::size_t ny = (h + step - 1) / step;
-    const std::size_t nx = (w + step - 1) / step;
+  //----------------------------------------------------------------
+  // supported_kernels
+  //
+  static const TAutoCropDetect::TKernels supported_kernels = detectKernels();
 
-    std::vector<double> responseLeft(ny);
-    std::vector<double> responseRight(ny);
-    std::vector<double> responseTop(nx);
-    std::vector<double> responseBottom(nx);
+  //----------------------------------------------------------------
+  // active_kernels
+  //
+  static boost::atomic<int> active_kernels(supported_kernels);
 
-    std::vector<unsigned int> offsetLeft(ny);
-    std::vector<unsigned int> offsetRight(ny);
-    std::vector<unsigned int> offsetTop(nx);
-    std::vector<unsigned int> offsetBottom(nx);
 
-    double epsilon = 1.0 / 256.0;
-    double backgnd = 24.0 * epsilon;
+  //----------------------------------------------------------------
+  // TLumaReader
+  //
+  // Extracts luma (or RGB average) samples as unsigned integers,
+  // multiply by scale_ to get the intensity in [0, 1] range.
+  //
+  // Common formats with 8 or 16 bit luma samples are read directly,
+  // everything else goes through pixelIntensity.
+  //
+  struct TLumaReader
+  {
+    TLumaReader(const TKernelsImpl & kernels,
+                const unsigned char * data,
+                std::size_t rowBytes,
+                const pixelFormat::Traits & ptts):
+      kernels_(kernels),
+      data_(data),
+      rowBytes_(rowBytes),
+      ptts_(ptts),
+      bytes_(0),
+      littleEndian_((ptts.flags_ & pixelFormat::kLE) != 0),
+      rshift_(0),
+      mask_(0xFFFF),
+      scale_(1.0 / 65535.0)
+    {
+      const unsigned int stride = ptts.stride_[0];
+      const unsigned int depth = ptts.depth_[0];
+      const unsigned int lshift = ptts.lshift_[0];
+
+      if (!(ptts.flags_ & (pixelFormat::kRGB | pixelFormat::kPaletted)) &&
+          ptts.samples_[0] == 1 &&
+          (stride == 8 || stride == 16) &&
+          depth && lshift + depth <= stride)
+      {
+        bytes_ = stride / 8;
+        rshift_ = stride - lshift - depth;
+        mask_ = (1u << depth) - 1;
+        scale_ = 1.0 / double(mask_);
+      }
+    }
 
-    for (unsigned int y = 0; y < h; y += step)
+    inline unsigned int get(unsigned int x, unsigned int y) const
     {
-      unsigned int sampleIndex = y / step;
-      YAE_ASSERT(sampleIndex < ny);
+      if (bytes_ == 1)
+      {
+        const unsigned char * src = data_ + y * rowBytes_ + x;
+        return (src[0] >> rshift_) & mask_;
+      }
 
-      // left-side edge:
+      if (bytes_ == 2)
       {
-        TFiFo<double, 16> negative;
-        TFiFo<double, 16> positive;
-        positive.push(backgnd);
+        const unsigned char * src = data_ + y * rowBytes_ + x * 2;
+        unsigned int v = littleEndian_ ?
+          (((unsigned int)(src[1]) << 8) | src[0]) :
+          (((unsigned int)(src[0]) << 8) | src[1]);
+        return (v >> rshift_) & mask_;
+      }
 
-        double & best = responseLeft[sampleIndex];
-        best = 0.0;
+      double t = pixelIntensity(x, y, data_, rowBytes_, ptts_);
+      return (unsigned int)(t * 65535.0 + 0.5);
+    }
 
-        unsigned int & offset = offsetLeft[sampleIndex];
-        offset = 0;
+    // n samples starting at (x, y) going right:
+    void row(unsigned int x, unsigned int y,
+             std::size_t n,
+             unsigned int * dst) const
+    {
+      const unsigned char * src = data_ + y * rowBytes_ + x * bytes_;
 
-        for (unsigned int x = 0; x < w / 2; x++)
+      if (bytes_ == 1)
+      {
+        kernels_.widen8_(src, n, rshift_, mask_, dst);
+      }
+      else if (bytes_ == 2 && littleEndian_ &&
+               int(pixelFormat::kNativeEndian) == int(pixelFormat::kLE))
+      {
+        kernels_.widen16_(src, n, rshift_, mask_, dst);
+      }
+      else
+      {
+        for (std::size_t i = 0; i < n; i++)
         {
-          double t = pixelIntensity(x0 + x, y0 + y,
-                                    data, rowBytes, *ptts);
-          positive.push(t, negative);
-
-          double mn = negative.isEmpty() ? 0.0 : negative.mean();
-          if (mn <= 0.0)
-          {
-            continue;
-          }
-
-          double mp = positive.mean();
-          double response = (mp + 0.1) / (mn + 0.1);
-          double improved = (response + epsilon) / (best + epsilon);
-#if 0
-          std::cerr << std::setw(4) << y << ", left offset "
-                    << std::setw(3) << x + 1 - positive.size()
-                    << ", " << std::setw(11) << mp
-                    << " / " << std::setw(11) << mn
-                    << ", r = " << std::setw(11) << response
-                    << ", q = " << std::setw(11) << improved
-                    << ", max = " << best << " @ " << offset
-                    << std::endl;
-#endif
-          if (best < response)
-          {
-            best = response;
-            offset = x + 1 - positive.size();
-          }
-          else if (best > 1.124 && negative.isFull() && response < 1.0 &&
-                   improved < 1.0)
-          {
-            break;
-          }
+          dst[i] = get(x + i, y);
         }
       }
+    }
 
-      // right-side edge:
+    // n samples starting at (x, y) going up (dy < 0) or down:
+    void column(unsigned int x, unsigned int y, int dy,
+                std::size_t n,
+                unsigned int * dst) const
+    {
+      for (std::size_t i = 0; i < n; i++, y += dy)
       {
-        TFiFo<double, 16> negative;
-        TFiFo<double, 16> positive;
-        positive.push(backgnd);
+        dst[i] = get(x, y);
+      }
+    }
 
-        double & best = responseRight[sampleIndex];
-        best = 0.0;
+    const TKernelsImpl & kernels_;
+    const unsigned char * data_;
+    const std::size_t rowBytes_;
+    const pixelFormat::Traits & ptts_;
+
+    // bytes per sample, 0 if pixelIntensity must be used:
+    unsigned int bytes_;
+    bool littleEndian_;
+    unsigned int rshift_;
+    unsigned int mask_;
+    double scale_;
+  };
 
-        unsigned int & offset = offsetRight[sampleIndex];
-        offset = 0;
 
-        for (unsigned int x = 0; x < w / 2; x++)
-        {
-          double t = pixelIntensity(x0 + w - 1 - x, y0 + y,
-                                    data, rowBytes, *ptts);
-          positive.push(t, negative);
+  //----------------------------------------------------------------
+  // kWindow
+  //
+  // number of samples averaged on either side of an edge:
+  //
+  enum { kWindow = 16 };
 
-          double mn = negative.isEmpty() ? 0.0 : negative.mean();
-          if (mn <= 0.0)
-          {
-            continue;
-          }
+  //----------------------------------------------------------------
+  // kBlock
+  //
+  // samples are fetched in blocks, so that the scan can stop early
+  // without having read the whole line:
+  //
+  enum { kBlock = 64 };
 
-          double mp = positive.mean();
-          double response = (mp + 0.1) / (mn + 0.1);
-          double improved = (response + epsilon) / (best + epsilon);
-#if 0
-          std::cerr << std::setw(4) << y << ", right offset "
-                    << std::setw(3) << x + 1 - positive.size()
-                    << ", " << std::setw(11) << mp
-                    << " / " << std::setw(11) << mn
-                    << ", r = " << std::setw(11) << response
-                    << ", q = " << std::setw(11) << improved
-                    << ", max = " << best << " @ " << offset
-                    << std::endl;
-#endif
-          if (best < response)
-          {
-            best = response;
-            offset = x + 1 - positive.size();
-          }
-          else if (best > 1.124 && negative.isFull() && response < 1.0 &&
-                   improved < 1.0)
-          {
-            break;
-          }
-        }
-      }
+  //----------------------------------------------------------------
+  // windowSums
+  //
+  // dst[i] = src[i] + ... + src[i + kWindow - 1], for i in [0, n - kWindow]
+  //
+  // dst values past n - kWindow are clobbered:
+  //
+  static void
+  windowSums(const TKernelsImpl & kernels,
+             const unsigned int * src,
+             std::size_t n,
+             unsigned int * dst)
+  {
+    kernels.addShifted_(src, n, 1, dst);
+    kernels.addShifted_(dst, n - 1, 2, dst);
+    kernels.addShifted_(dst, n - 3, 4, dst);
+    kernels.addShifted_(dst, n - 7, 8, dst);
+  }
+
+  //----------------------------------------------------------------
+  // TRowFetch
+  //
+  struct TRowFetch
+  {
+    TRowFetch(const TLumaReader & luma, unsigned int x, unsigned int y):
+      luma_(luma),
+      x_(x),
+      y_(y)
+    {}
+
+    inline void operator()(std::size_t i,
+                           std::size_t n,
+                           unsigned int * dst) const
+    {
+      luma_.row(x_ + i, y_, n, dst);
     }
 
-    for (unsigned int x = 0; x < w; x += step)
+    const TLumaReader & luma_;
+    const unsigned int x_;
+    const unsigned int y_;
+  };
+
+  //----------------------------------------------------------------
+  // TRowReversedFetch
+  //
+  // right-to-left, starting just before x:
+  //
+  struct TRowReversedFetch
+  {
+    TRowReversedFetch(const TLumaReader & luma,
+                      unsigned int x,
+                      unsigned int y):
+      luma_(luma),
+      x_(x),
+      y_(y)
+    {}
+
+    inline void operator()(std::size_t i,
+                           std::size_t n,
+                           unsigned int * dst) const
     {
-      unsigned int sampleIndex = x / step;
-      YAE_ASSERT(sampleIndex < nx);
+      luma_.row(x_ - i - n, y_, n, dst);
+      std::reverse(dst, dst + n);
+    }
 
-      // top-side edge:
-      {
-        TFiFo<double, 16> negative;
-        TFiFo<double, 16> positive;
-        positive.push(backgnd);
+    const TLumaReader & luma_;
+    const unsigned int x_;
+    const unsigned int y_;
+  };
 
-        double & best = responseTop[sampleIndex];
-        best = 0.0;
+  //----------------------------------------------------------------
+  // TColumnFetch
+  //
+  struct TColumnFetch
+  {
+    TColumnFetch(const TLumaReader & luma,
+                 unsigned int x,
+                 unsigned int y,
+                 int dy):
+      luma_(luma),
+      x_(x),
+      y_(y),
+      dy_(dy)
+    {}
 
-        unsigned int & offset = offsetTop[sampleIndex];
-        offset = 0;
+    inline void operator()(std::size_t i,
+                           std::size_t n,
+                           unsigned int * dst) const
+    {
+      luma_.column(x_, (unsigned int)(int(y_) + dy_ * int(i)), dy_, n, dst);
+    }
 
-        for (unsigned int y = 0; y < h / 2; y++)
-        {
-          double t = pixelIntensity(x0 + x, y0 + y, data, rowBytes, *ptts);
-          positive.push(t, negative);
+    const TLumaReader & luma_;
+    const unsigned int x_;
+    const unsigned int y_;
+    const int dy_;
+  };
 
-          double mn = negative.isEmpty() ? 0.0 : negative.mean();
-          if (mn <= 0.0)
-          {
-            continue;
-          }
+  //----------------------------------------------------------------
+  // findEdge
+  //
+  // samples are ordered from the frame edge inward.  Slide a pair
+  // of adjacent windows along the line, the outer one is expected
+  // to be dark (border) and the inner one bright (picture),
+  // and return the offset where the brightness ratio peaks.
+  //
+  // The outer window starts out seeded with a dim background sample,
+  // so that a picture without any border can still produce
+  // a response at the frame edge.
+  //
+  // samples and sums are scratch buffers of at least n elements:
+  //
+  template <typename TFetch>
+  static unsigned int
+  findEdge(const TKernelsImpl & kernels,
+           const TFetch & fetch,
+           std::size_t n,
+           double scale,
+           unsigned int * samples,
+           unsigned int * sums,
+           double & best)
+  {
+    static const double epsilon = 1.0 / 256.0;
+    static const double backgnd = 24.0 * epsilon;
 
-          double mp = positive.mean();
-          double response = (mp + 0.1) / (mn + 0.1);
-          double improved = (response + epsilon) / (best + epsilon);
-#if 0
-          std::cerr << std::setw(4) << x << ", top offset "
-                    << std::setw(3) << y + 1 - positive.size()
-                    << ", " << std::setw(11) << mp
-                    << " / " << std::setw(11) << mn
-                    << ", r = " << std::setw(11) << response
-                    << ", q = " << std::setw(11) << improved
-                    << ", max = " << best << " @ " << offset
-                    << std::endl;
-#endif
-          if (best < response)
-          {
-            best = response;
-            offset = y + 1 - positive.size();
-          }
-          else if (best > 1.124 && negative.isFull() && response < 1.0 &&
-                   improved < 1.0)
-          {
-            break;
-          }
-        }
-      }
+    best = 0.0;
+    unsigned int offset = 0;
 
-      // bottom-side edge:
-      {
-        TFiFo<double, 16> negative;
-        TFiFo<double, 16> positive;
-        positive.push(backgnd);
+    // sum of the background sample and the samples that have left
+    // the inner window, until the outer window fills up:
+    double outerHead = backgnd;
 
-        double & best = responseBottom[sampleIndex];
-        best = 0.0;
+    // samples[0, fetched) are available:
+    std::size_t fetched = 0;
 
-        unsigned int & offset = offsetBottom[sampleIndex];
-        offset = 0;
+    for (std::size_t x = kWindow - 1; x < n; x++)
+    {
+      if (x >= fetched)
+      {
+        std::size_t i0 = fetched;
+        std::size_t i1 = std::min<std::size_t>(n, i0 + kBlock);
+        fetch(i0, i1 - i0, samples + i0);
+        fetched = i1;
+
+        // the first inner window that ends in this block
+        // starts kWindow - 1 samples before it:
+        std::size_t s = (i0 < kWindow) ? 0 : i0 + 1 - kWindow;
+        windowSums(kernels, samples + s, i1 - s, sums + s);
+      }
+
+      // the inner window is [i, x]:
+      const std::size_t i = x + 1 - kWindow;
 
-        for (unsigned int y = 0; y < h / 2; y++)
+      double mn = 0.0;
+      if (i < kWindow)
+      {
+        // the outer window is [-1, i), where -1 is the background:
+        if (i)
         {
-          double t = pixelIntensity(x0 + x, y0 + h - 1 - y,
-                                    data, rowBytes, *ptts);
-          positive.push(t, negative);
+          outerHead += double(samples[i - 1]) * scale;
+        }
 
-          double mn = negative.isEmpty() ? 0.0 : negative.mean();
-          if (mn <= 0.0)
-          {
-            continue;
-          }
+        mn = outerHead / double(i + 1);
+      }
+      else
+      {
+        mn = double(sums[i - kWindow]) * scale / double(kWindow);
+      }
 
-          double mp = positive.mean();
-          double response = (mp + 0.1) / (mn + 0.1);
-          double improved = (response + epsilon) / (best + epsilon);
-#if 0
-          std::cerr << std::setw(4) << x << ", bottom offset "
-                    << std::setw(3) << y + 1 - positive.size()
-                    << ", " << std::setw(11) << mp
-                    << " / " << std::setw(11) << mn
-                    << ", r = " << std::setw(11) << response
-                    << ", q = " << std::setw(11) << improved
-                    << ", max = " << best << " @ " << offset
-                    << std::endl;
-#endif
-          if (best < response)
-          {
-            best = response;
-            offset = y + 1 - positive.size();
-          }
-          else if (best > 1.124 && negative.isFull() && response < 1.0 &&
-                   improved < 1.0)
-          {
-            break;
-          }
-        }
+      if (mn <= 0.0)
+      {
+        continue;
       }
-    }
 
-#if 0
-    std::cerr << "\nLEFT EDGE:" << std::endl;
-    for (std::size_t i = 0; i < ny; i++)
-    {
-      unsigned int y = y0 + i * step;
-      std::cerr << "response(" << offsetLeft[i] << ", " << y << ") = "
-                << responseLeft[i] << std::endl;
-    }
-#endif
+      double mp = double(sums[i]) * scale / double(kWindow);
+      double response = (mp + 0.1) / (mn + 0.1);
+      double improved = (response + epsilon) / (best + epsilon);
 
-#if 0
-    std::cerr << "\nRIGHT EDGE:" << std::endl;
-    for (std::size_t i = 0; i < ny; i++)
-    {
-      unsigned int y = y0 + i * step;
-      std::cerr << "response(" << offsetRight[i] << ", " << y << ") = "
-                << responseRight[i] << std::endl;
+      if (best < response)
+      {
+        best = response;
+        offset = (unsigned int)i;
+      }
+      else if (best > 1.124 && i + 1 >= kWindow && response < 1.0 &&
+               improved < 1.0)
+      {
+        break;
+      }
     }
-#endif
 
-#if 0
-    std::cerr << "\nTOP EDGE:" << std::endl;
-    for (std::size_t i = 0; i < nx; i++)
-    {
-      unsigned int x = x0 + i * step;
-      std::cerr << "response(" << x << ", " << offsetTop[i] << ") = "
-                << responseTop[i] << std::endl;
-    }
-#endif
+    return offset;
+  }
 
-#if 0
-    std::cerr << "\nBOTTOM EDGE:" << std::endl;
-    for (std::size_t i = 0; i < nx; i++)
-    {
-      unsigned int x = x0 + i * step;
-      std::cerr << "response(" << x << ", " << offsetBottom[i] << ") = "
-                << responseBottom[i] << std::endl;
-    }
-#endif
+  //----------------------------------------------------------------
+  // TBin
+  //
+  struct TBin
+  {
+    TBin():
+      size_(0),
+      sum_(0)
+    {}
+
+    unsigned int size_;
+    int sum_;
+  };
+
+  //----------------------------------------------------------------
+  // THistogram
+  //
+  // Each offset contributes to its own bin and the two neighboring
+  // bins, the bin with the largest weight wins.
+  //
+  struct THistogram
+  {
+    enum { kGranularity = 2 };
 
-    std::map<int, TBin> leftHistogram;
-    std::map<int, TBin> rightHistogram;
-    std::map<int, TBin> topHistogram;
-    std::map<int, TBin> bottomHistogram;
+    // offsets are expected to be in [0, maxOffset] range:
+    THistogram(std::size_t maxOffset):
+      bins_(maxOffset / kGranularity + 3),
+      used_(0)
+    {}
 
-    for (std::size_t i = 0; i < ny; i++)
+    inline void update(int offset)
     {
-      updateHistogram(leftHistogram, offsetLeft[i]);
-      updateHistogram(rightHistogram, offsetRight[i]);
+      // bins_[0] corresponds to bin -1:
+      std::size_t i = offset / kGranularity + 1;
+      YAE_ASSERT(i + 1 < bins_.size());
+
+      updateBin(bins_[i - 1], offset, 1);
+      updateBin(bins_[i], offset, 2);
+      updateBin(bins_[i + 1], offset, 1);
     }
 
-    for (std::size_t i = 0; i < nx; i++)
+    inline void updateBin(TBin & bin, int offset, unsigned int weight)
     {
-      updateHistogram(topHistogram, offsetTop[i]);
-      updateHistogram(bottomHistogram, offsetBottom[i]);
+      used_ += bin.size_ ? 0 : 1;
+      bin.sum_ += offset * weight;
+      bin.size_ += weight;
     }
 
-    TBin lbest;
-    for (std::map<int, TBin>::const_iterator i = leftHistogram.begin();
-         i != leftHistogram.end(); ++i)
+    // first of the heaviest bins:
+    TBin best() const
     {
-      const TBin & bin = i->second;
-#if 0
-      std::cerr << "left(" << i->first << "): "
-                << double(bin.sum_) / double(bin.size_)
-                << " -> " << bin.size_ << std::endl;
-#endif
-      if (lbest.size_ < bin.size_)
+      TBin best;
+      for (std::size_t i = 0; i < bins_.size(); i++)
       {
-        lbest = bin;
+        const TBin & bin = bins_[i];
+        if (best.size_ < bin.size_)
+        {
+          best = bin;
+        }
       }
+
+      return best;
     }
 
-    TBin rbest;
-    for (std::map<int, TBin>::const_iterator i = rightHistogram.begin();
-         i != rightHistogram.end(); ++i)
+    // the average offset of the heaviest bin, or 0 if the offsets
+    // are too scattered to be trusted (n is the number of samples):
+    double consensus(std::size_t n) const
     {
-      const TBin & bin = i->second;
-#if 0
-      std::cerr << "right(" << i->first << "): "
-                << double(bin.sum_) / double(bin.size_)
-                << " -> " << bin.size_ << std::endl;
-#endif
-      if (rbest.size_ < bin.size_)
-      {
-        rbest = bin;
-      }
+      TBin bin = best();
+      return (used_ < n * 2 && bin.size_ > n / 3) ?
+        double(bin.sum_) / double(bin.size_) :
+        0.0;
     }
 
-    TBin tbest;
-    for (std::map<int, TBin>::const_iterator i = topHistogram.begin();
-         i != topHistogram.end(); ++i)
+    std::vector<TBin> bins_;
+
+    // number of non-empty bins:
+    std::size_t used_;
+  };
+
+  //----------------------------------------------------------------
+  // analyze
+  //
+  static bool
+  analyze(const TVideoFramePtr & frame, TCropFrame & crop)
+  {
+    // video traits shortcut:
+    const VideoTraits & vtts = frame->traits_;
+
+    // pixel format shortcut:
+    const pixelFormat::Traits * ptts =
+      pixelFormat::getTraits(vtts.pixelFormat_);
+
+    if (!ptts)
     {
-      const TBin & bin = i->second;
-#if 0
-      std::cerr << "top(" << i->first << "): "
-                << double(bin.sum_) / double(bin.size_)
-                << " -> " << bin.size_ << std::endl;
-#endif
-      if (tbest.size_ < bin.size_)
-      {
-        tbest = bin;
-      }
+      // don't know how to handle this pixel format:
+      return false;
     }
 
-    TBin bbest;
-    for (std::map<int, TBin>::const_iterator i = bottomHistogram.begin();
-         i != bottomHistogram.end(); ++i)
+    const TKernelsImpl & kernels = kKernels[active_kernels.load()];
+    const TLumaReader luma(kernels,
+                           frame->data_->data(0),
+                           frame->data_->rowBytes(0),
+                           *ptts);
+
+    const unsigned int w = vtts.visibleWidth_;
+    const unsigned int h = vtts.visibleHeight_;
+    const unsigned int x0 = vtts.offsetLeft_;
+    const unsigned int y0 = vtts.offsetTop_;
+
+    if (w < 2 || h < 2)
     {
-      const TBin & bin = i->second;
-#if 0
-      std::cerr << "bottom(" << i->first << "): "
-                << double(bin.sum_) / double(bin.size_)
-                << " -> " << bin.size_ << std::endl;
-#endif
-      if (bbest.size_ < bin.size_)
-      {
-        bbest = bin;
-      }
+      // too small to have any borders, nothing to crop:
+      crop.x_ = int(x0);
+      crop.y_ = int(y0);
+      crop.w_ = int(w) - int(x0);
+      crop.h_ = int(h) - int(y0);
+      return true;
     }
 
-    double lOffset =
-      leftHistogram.size() < (ny * 2) && lbest.size_ > (ny / 3) ?
-      double(lbest.sum_) / double(lbest.size_) :
-      0.0;
+    unsigned int step = std::min<unsigned int>(w / 32, h / 32);
+    step = std::max<unsigned int>(1, step);
+
+    const std::size_t ny = (h + step - 1) / step;
+    const std::size_t nx = (w + step - 1) / step;
+
+    // scratch buffers:
+    const std::size_t n = std::max(w, h) / 2 + 1;
+    std::vector<unsigned int> samples(n);
+    std::vector<unsigned int> sums(n);
+    double response = 0.0;
 
-    double rOffset =
-      rightHistogram.size() < (ny * 2) && rbest.size_ > (ny / 3) ?
-      double(rbest.sum_) / double(rbest.size_) :
-      0.0;
+    THistogram leftHistogram(w / 2);
+    THistogram rightHistogram(w / 2);
+    THistogram topHistogram(h / 2);
+    THistogram bottomHistogram(h / 2);
 
-    double tOffset =
-      topHistogram.size() < (nx * 2) && tbest.size_ > (nx / 3) ?
-      double(tbest.sum_) / double(tbest.size_) :
-      0.0;
+    for (unsigned int y = 0; y < h; y += step)
+    {
+      // left-side edge:
+      leftHistogram.update(findEdge(kernels,
+                                    TRowFetch(luma, x0, y0 + y),
+                                    w / 2,
+                                    luma.scale_,
+                                    &samples[0],
+                                    &sums[0],
+                                    response));
+
+      // right-side edge:
+      rightHistogram.update(findEdge(kernels,
+                                     TRowReversedFetch(luma, x0 + w, y0 + y),
+                                     w / 2,
+                                     luma.scale_,
+                                     &samples[0],
+                                     &sums[0],
+                                     response));
+    }
+
+    for (unsigned int x = 0; x < w; x += step)
+    {
+      // top-side edge:
+      topHistogram.update(findEdge(kernels,
+                                   TColumnFetch(luma, x0 + x, y0, 1),
+                                   h / 2,
+                                   luma.scale_,
+                                   &samples[0],
+                                   &sums[0],
+                                   response));
+
+      // bottom-side edge:
+      bottomHistogram.update(findEdge(kernels,
+                                      TColumnFetch(luma, x0 + x,
+                                                   y0 + h - 1, -1),
+                                      h / 2,
+                                      luma.scale_,
+                                      &samples[0],
+                                      &sums[0],
+                                      response));
+    }
 
-    double bOffset =
-      bottomHistogram.size() < (nx * 2) && bbest.size_ > (nx / 3) ?
-      double(bbest.sum_) / double(bbest.size_) :
-      0.0;
+    double lOffset = leftHistogram.consensus(ny);
+    double rOffset = rightHistogram.consensus(ny);
+    double tOffset = topHistogram.consensus(nx);
+    double bOffset = bottomHistogram.consensus(nx);
 
     crop.x_ = (int)(x0 + lOffset + 0.5);
     crop.y_ = (int)(y0 + tOffset + 0.5);
     crop.w_ = (int)(w - x0 - rOffset - lOffset + 0.5);
     crop.h_ = (int)(h - y0 - bOffset - tOffset + 0.5);
 
-#if 0
-    std::cerr
-      << "\ncrop margins:\n"
-      << "  left " << lOffset
-      << " group(" << lbest.size_ << "), " << leftHistogram.size() << "\n"
-      << " right " << rOffset
-      << " group(" << rbest.size_ << "), " << rightHistogram.size() << "\n"
-      << "   top " << tOffset
-      << " group(" << tbest.size_ << "), " << topHistogram.size() << "\n"
-      << "bottom " << bOffset
-      << " group(" << bbest.size_ << "), " << bottomHistogram.size() << "\n"
-      << std::endl;
-#endif
-
     return true;
   }
 
@@ -764,6 +1064,39 @@ namespace yae
     delete private_;
   }
 
+  //----------------------------------------------------------------
+  // TAutoCropDetect::supportedKernels
+  //
+  TAutoCropDetect::TKernels
+  TAutoCropDetect::supportedKernels()
+  {
+    return supported_kernels;
+  }
+
+  //----------------------------------------------------------------
+  // TAutoCropDetect::useKernels
+  //
+  bool
+  TAutoCropDetect::useKernels(TKernels kernels)
+  {
+    if (kernels < kKernelsScalar || kernels > supported_kernels)
+    {
+      return false;
+    }
+
+    active_kernels.store(kernels);
+    return true;
+  }
+
+  //----------------------------------------------------------------
+  // TAutoCropDetect::analyze
+  //
+  bool
+  TAutoCropDetect::analyze(const TVideoFramePtr & frame, TCropFrame & crop)
+  {
+    return yae::analyze(frame, crop);
+  }
+
   //----------------------------------------------------------------
   // TAutoCropDetect::reset
   //
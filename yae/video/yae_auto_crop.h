@@ -67,6 +67,28 @@ namespace yae
   //
   struct YAE_API TAutoCropDetect
   {
+    //----------------------------------------------------------------
+    // TKernels
+    //
+    // instruction sets used to extract and filter luma samples,
+    // the best one supported by the CPU is used by default:
+    //
+    enum TKernels
+    {
+      kKernelsScalar = 0,
+      kKernelsSSE2 = 1,
+      kKernelsAVX2 = 2
+    };
+
+    static TKernels supportedKernels();
+
+    // for testing and benchmarking,
+    // returns false if the CPU does not support the given kernels:
+    static bool useKernels(TKernels kernels);
+
+    // detect crop margins of a single frame, synchronously:
+    static bool analyze(const TVideoFramePtr & frame, TCropFrame & crop);
+
     TAutoCropDetect();
     ~TAutoCropDetect();
 
@@ -84,6 +84,13 @@ namespace yae
     virtual bool readVideo(TVideoFramePtr & frame, QueueWaitMgr * mgr) = 0;
     virtual bool readAudio(TAudioFramePtr & frame, QueueWaitMgr * mgr) = 0;
 
+    //! A synchronous alternative to seek + readVideo, for thumbnails:
+    //! decode the selected video track keyframe at (or nearest before)
+    //! a given time on the calling thread, converted according to
+    //! the video traits override, at reduced resolution when possible.
+    //! This must not be used while the reader threads are running.
+    virtual bool readKeyframe(double t, TVideoFramePtr & frame) = 0;
+
     //! when blocked on video -- read video to unblock and break the deadlock:
     virtual bool blockedOnVideo() const = 0;
 
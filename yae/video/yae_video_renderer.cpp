@@ -16,6 +16,8 @@
 // yae includes:
 #include "yae_video_renderer.h"
 #include "../thread/yae_threading.h"
+#include "../utils/yae_benchmark.h"
+#include "../utils/yae_trace.h"
 
 //----------------------------------------------------------------
 // YAE_DEBUG_VIDEO_RENDERER
@@ -189,6 +191,11 @@ namespace yae
   void
   VideoRenderer::TPrivate::threadLoop()
   {
+    if (TTrace::enabled())
+    {
+      TTrace::set_thread_name("VideoRenderer");
+    }
+
     TTime t0;
 
     frame_a_ = TVideoFramePtr();
@@ -508,6 +515,8 @@ namespace yae
           << "RENDER VIDEO @ " << to_hhmmss_ms(frame_a_)
           << std::endl;
 #endif
+        YAE_PROBE(probe, "VideoRenderer canvas render");
+        YAE_TRACE_SPAN(span, "VideoRenderer::render");
         canvas_->render(frame_a_);
       }
     }
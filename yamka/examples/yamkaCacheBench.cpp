@@ -0,0 +1,347 @@
+// -*- Mode: c++; tab-width: 8; c-basic-offset: 2; indent-tabs-mode: nil -*-
+// NOTE: the first line of this file sets up source code indentation rules
+// for Emacs; it is also a hint to anyone modifying this file.
+
+// Created   : Sun Oct 18 09:27:14 MDT 2026
+// Copyright : Pavel Koshevoy
+// License   : MIT -- http://www.opensource.org/licenses/mit-license.php
+
+// yamka includes:
+#include <yamkaCache.h>
+#include <yamkaFile.h>
+#include <yamkaMappedFileStorage.h>
+#include <yamkaStdInt.h>
+
+// boost includes:
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+// system includes:
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+// namespace access:
+using namespace Yamka;
+
+//----------------------------------------------------------------
+// usage
+//
+static void
+usage(char ** argv, const char * message = NULL)
+{
+  std::cerr << "USAGE: " << argv[0]
+            << " [-m megabytes] [-l lines] [-s lineSize]"
+            << " [-r readAheadLines] [-w writeBehindLines]"
+            << std::endl
+            << "writes a file in small pieces (going back to patch"
+            << " some of them along the way) and then reads it back"
+            << " in small pieces, first with a synchronous TCache and"
+            << " then with read-ahead and write-behind, verifies the"
+            << " contents and compares the time and cache counters"
+            << " (default 128 MB, 16 lines of 64 KB, 8 lines ahead,"
+            << " 8 lines behind)"
+            << std::endl;
+
+  if (message != NULL)
+  {
+    std::cerr << "ERROR: " << message << std::endl;
+  }
+
+  ::exit(1);
+}
+
+//----------------------------------------------------------------
+// TConfig
+//
+struct TConfig
+{
+  std::size_t lines_;
+  std::size_t lineSize_;
+  std::size_t readAhead_;
+  std::size_t writeBehind_;
+};
+
+//----------------------------------------------------------------
+// TResult
+//
+struct TResult
+{
+  double writeSec_;
+  double readSec_;
+  TCache::TStats writeStats_;
+  TCache::TStats readStats_;
+};
+
+//----------------------------------------------------------------
+// Random
+//
+struct Random
+{
+  Random(): seed_(1) {}
+
+  inline std::size_t operator()(std::size_t range)
+  {
+    seed_ = seed_ * 1103515245 + 12345;
+    return (std::size_t)(seed_ >> 8) % range;
+  }
+
+  unsigned int seed_;
+};
+
+//----------------------------------------------------------------
+// secondsSince
+//
+static double
+secondsSince(const boost::posix_time::ptime & t0)
+{
+  boost::posix_time::ptime t1 =
+    boost::posix_time::microsec_clock::universal_time();
+
+  return double((t1 - t0).total_microseconds()) * 1e-6;
+}
+
+//----------------------------------------------------------------
+// configure
+//
+static void
+configure(File & file, const TConfig & config)
+{
+  TCache * cache = file.cache();
+  cache->resize(config.lines_, config.lineSize_);
+  cache->setReadAhead(config.readAhead_);
+  cache->setWriteBehind(config.writeBehind_);
+}
+
+//----------------------------------------------------------------
+// write
+//
+// mostly small writes, the way elements are saved, going back
+// now and then to patch a few bytes written earlier, the way
+// element references are rewritten:
+//
+static bool
+write(const std::string & path,
+      const std::vector<unsigned char> & model,
+      const TConfig & config,
+      TResult & result)
+{
+  File file(path, File::kReadWrite);
+  if (!file.isOpen())
+  {
+    return false;
+  }
+
+  file.setSize(0);
+  configure(file, config);
+  file.cache()->resetStats();
+
+  boost::posix_time::ptime t0 =
+    boost::posix_time::microsec_clock::universal_time();
+
+  Random random;
+  const std::size_t total = model.size();
+  std::size_t done = 0;
+  bool ok = true;
+
+  while (ok && done < total)
+  {
+    std::size_t size = random(16) ? 1 + random(300) : 1 + random(65536);
+    size = std::min(size, total - done);
+    ok = file.save(&model[done], size);
+    done += size;
+
+    if (!random(64))
+    {
+      // patch a few bytes up to 1 MB back:
+      std::size_t back = std::min<std::size_t>(done, random(1 << 20));
+      std::size_t addr = done - back;
+      std::size_t n = std::min<std::size_t>(8, back);
+      ok = ok && file.seekTo(addr) && file.save(&model[addr], n);
+      ok = ok && file.seekTo(done);
+    }
+  }
+
+  result.writeStats_ = file.cache()->stats();
+  file.close();
+  result.writeSec_ = secondsSince(t0);
+
+  MappedFile mapped(path);
+  return (ok &&
+          mapped.isOpen() &&
+          mapped.size() == model.size() &&
+          memcmp(mapped.data(), &model[0], model.size()) == 0);
+}
+
+//----------------------------------------------------------------
+// read
+//
+// mostly small sequential reads, skipping over some data now and then,
+// the way payloads are skipped over while loading:
+//
+static bool
+read(const std::string & path,
+     const std::vector<unsigned char> & model,
+     const TConfig & config,
+     TResult & result)
+{
+  File file(path, File::kReadOnly);
+  if (!file.isOpen())
+  {
+    return false;
+  }
+
+  configure(file, config);
+  file.cache()->resetStats();
+
+  boost::posix_time::ptime t0 =
+    boost::posix_time::microsec_clock::universal_time();
+
+  Random random;
+  std::vector<unsigned char> buffer(65536);
+  const std::size_t total = model.size();
+  std::size_t done = 0;
+  bool ok = true;
+
+  while (ok && done < total)
+  {
+    std::size_t size = random(16) ? 1 + random(300) : 1 + random(65536);
+    size = std::min(size, total - done);
+    ok = (file.load(&buffer[0], size) &&
+          memcmp(&buffer[0], &model[done], size) == 0);
+    done += size;
+
+    if (!random(16))
+    {
+      // skip over some data:
+      done = std::min(total, done + random(32768));
+      ok = ok && file.seekTo(done);
+    }
+  }
+
+  result.readStats_ = file.cache()->stats();
+  result.readSec_ = secondsSince(t0);
+  return ok;
+}
+
+//----------------------------------------------------------------
+// report
+//
+static void
+report(const char * label, double sec, const TCache::TStats & stats)
+{
+  std::cout << std::setw(12) << label << ": "
+            << std::fixed << std::setprecision(3) << sec << " sec"
+            << ", hits " << stats.hits_
+            << ", misses " << stats.misses_
+            << ", prefetched " << stats.prefetched_
+            << " (" << stats.prefetchUseful_ << " useful)"
+            << ", lines written " << stats.linesWritten_
+            << " in " << stats.writes_ << " writes"
+            << std::endl;
+}
+
+//----------------------------------------------------------------
+// main
+//
+int
+main(int argc, char ** argv)
+{
+#ifdef _WIN32
+  get_main_args_utf8(argc, argv);
+#endif
+
+  std::size_t megabytes = 128;
+  TConfig background;
+  background.lines_ = 16;
+  background.lineSize_ = 65536;
+  background.readAhead_ = 8;
+  background.writeBehind_ = 8;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-m") == 0)
+    {
+      if ((argc - i) <= 1) usage(argv, "could not parse -m parameter");
+      i++;
+      megabytes = std::max<int>(1, atoi(argv[i]));
+    }
+    else if (strcmp(argv[i], "-l") == 0)
+    {
+      if ((argc - i) <= 1) usage(argv, "could not parse -l parameter");
+      i++;
+      background.lines_ = std::max<int>(1, atoi(argv[i]));
+    }
+    else if (strcmp(argv[i], "-s") == 0)
+    {
+      if ((argc - i) <= 1) usage(argv, "could not parse -s parameter");
+      i++;
+      background.lineSize_ = std::max<int>(512, atoi(argv[i]));
+    }
+    else if (strcmp(argv[i], "-r") == 0)
+    {
+      if ((argc - i) <= 1) usage(argv, "could not parse -r parameter");
+      i++;
+      background.readAhead_ = std::max<int>(0, atoi(argv[i]));
+    }
+    else if (strcmp(argv[i], "-w") == 0)
+    {
+      if ((argc - i) <= 1) usage(argv, "could not parse -w parameter");
+      i++;
+      background.writeBehind_ = std::max<int>(0, atoi(argv[i]));
+    }
+    else
+    {
+      usage(argv, (std::string("unknown option: ") +
+                   std::string(argv[i])).c_str());
+    }
+  }
+
+  TConfig synchronous = background;
+  synchronous.readAhead_ = 0;
+  synchronous.writeBehind_ = 0;
+
+  std::vector<unsigned char> model(megabytes << 20);
+  Random random;
+  for (std::size_t i = 0; i < model.size(); i++)
+  {
+    model[i] = (unsigned char)(random(256));
+  }
+
+  const std::string path("yamkaCacheBench.dat");
+  const TConfig * configs[] = { &synchronous, &background };
+  TResult results[2];
+
+  for (int i = 0; i < 2; i++)
+  {
+    if (!write(path, model, *configs[i], results[i]))
+    {
+      std::cerr << "ERROR: written file contents are wrong" << std::endl;
+      return 1;
+    }
+
+    if (!read(path, model, *configs[i], results[i]))
+    {
+      std::cerr << "ERROR: file contents were read wrong" << std::endl;
+      return 1;
+    }
+  }
+
+  File::remove(path.c_str());
+
+  std::cout << megabytes << " MB, "
+            << background.lines_ << " lines of "
+            << background.lineSize_ << " bytes, read-ahead "
+            << background.readAhead_ << " lines, write-behind "
+            << background.writeBehind_ << " lines:" << std::endl;
+
+  report("write sync", results[0].writeSec_, results[0].writeStats_);
+  report("write async", results[1].writeSec_, results[1].writeStats_);
+  report("read sync", results[0].readSec_, results[0].readStats_);
+  report("read async", results[1].readSec_, results[1].readStats_);
+
+  return 0;
+}
@@ -0,0 +1,273 @@
+// -*- Mode: c++; tab-width: 8; c-basic-offset: 2; indent-tabs-mode: nil -*-
+// NOTE: the first line of this file sets up source code indentation rules
+// for Emacs; it is also a hint to anyone modifying this file.
+
+// Created   : Sat Oct 17 10:41:07 MDT 2026
+// Copyright : Pavel Koshevoy
+// License   : MIT -- http://www.opensource.org/licenses/mit-license.php
+
+// yamka includes:
+#include <yamkaCrc32.h>
+#include <yamkaStdInt.h>
+
+// boost includes:
+#include <boost/crc.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+// system includes:
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+// namespace access:
+using namespace Yamka;
+
+//----------------------------------------------------------------
+// usage
+//
+static void
+usage(char ** argv, const char * message = NULL)
+{
+  std::cerr << "USAGE: " << argv[0]
+            << " [-m megabytes] [-n iterations]"
+            << std::endl
+            << "verifies every CRC-32 engine against boost::crc_32_type"
+            << " and measures its throughput (default 64 MB, best of 5)"
+            << std::endl;
+
+  if (message != NULL)
+  {
+    std::cerr << "ERROR: " << message << std::endl;
+  }
+
+  ::exit(1);
+}
+
+//----------------------------------------------------------------
+// kEngines
+//
+static const Crc32::Engine kEngines[] = {
+  Crc32::kBytewise,
+  Crc32::kSliceBy8,
+  Crc32::kPclmul
+};
+
+//----------------------------------------------------------------
+// kEngineNames
+//
+static const char * kEngineNames[] = {
+  "bytewise",
+  "slice-by-8",
+  "pclmul"
+};
+
+//----------------------------------------------------------------
+// kNumEngines
+//
+static const std::size_t kNumEngines =
+  sizeof(kEngines) / sizeof(kEngines[0]);
+
+//----------------------------------------------------------------
+// reference
+//
+static unsigned int
+reference(const unsigned char * data, std::size_t size)
+{
+  boost::crc_32_type crc;
+  crc.process_bytes(data, size);
+  return crc.checksum();
+}
+
+//----------------------------------------------------------------
+// verify
+//
+// compare against boost at every size and alignment that matters
+// to the block algorithms, and when fed in arbitrary pieces:
+//
+static bool
+verify(Crc32::Engine engine, const std::vector<unsigned char> & buffer)
+{
+  const unsigned char * data = &buffer[0];
+
+  for (std::size_t offset = 0; offset < 16; offset++)
+  {
+    for (std::size_t size = 0; size <= 1024; size++)
+    {
+      Crc32 crc(engine);
+      crc.compute(data + offset, size);
+
+      if (crc.checksum() != reference(data + offset, size))
+      {
+        std::cerr << "ERROR: " << kEngineNames[engine - 1]
+                  << " mismatch, offset " << offset
+                  << ", size " << size << std::endl;
+        return false;
+      }
+    }
+  }
+
+  std::size_t size = std::min<std::size_t>(buffer.size(), 1 << 20);
+  unsigned int expected = reference(data, size);
+  unsigned int seed = 1;
+
+  for (int pass = 0; pass < 16; pass++)
+  {
+    Crc32 crc(engine);
+    std::size_t done = 0;
+
+    while (done < size)
+    {
+      seed = seed * 1103515245 + 12345;
+      std::size_t piece = std::min<std::size_t>((seed >> 16) % 5000,
+                                                size - done);
+      crc.compute(data + done, piece);
+      done += piece;
+    }
+
+    if (crc.checksum() != expected)
+    {
+      std::cerr << "ERROR: " << kEngineNames[engine - 1]
+                << " mismatch when computed piece-wise" << std::endl;
+      return false;
+    }
+  }
+
+  return true;
+}
+
+//----------------------------------------------------------------
+// measure
+//
+// returns the best throughput in GB/s:
+//
+static double
+measure(Crc32::Engine engine,
+        const std::vector<unsigned char> & buffer,
+        int iterations,
+        unsigned int & checksum)
+{
+  double best = 0.0;
+
+  for (int i = 0; i < iterations; i++)
+  {
+    boost::posix_time::ptime t0 =
+      boost::posix_time::microsec_clock::universal_time();
+
+    Crc32 crc(engine);
+    crc.compute(buffer);
+    checksum = crc.checksum();
+
+    boost::posix_time::ptime t1 =
+      boost::posix_time::microsec_clock::universal_time();
+
+    double sec = double((t1 - t0).total_microseconds()) * 1e-6;
+    double gbps = double(buffer.size()) / (std::max(sec, 1e-6) * 1e+9);
+    best = std::max(best, gbps);
+  }
+
+  return best;
+}
+
+//----------------------------------------------------------------
+// main
+//
+int
+main(int argc, char ** argv)
+{
+  std::size_t megabytes = 64;
+  int iterations = 5;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-m") == 0)
+    {
+      if ((argc - i) <= 1) usage(argv, "could not parse -m parameter");
+      i++;
+      megabytes = std::max<int>(1, atoi(argv[i]));
+    }
+    else if (strcmp(argv[i], "-n") == 0)
+    {
+      if ((argc - i) <= 1) usage(argv, "could not parse -n parameter");
+      i++;
+      iterations = std::max<int>(1, atoi(argv[i]));
+    }
+    else
+    {
+      usage(argv, (std::string("unknown option: ") +
+                   std::string(argv[i])).c_str());
+    }
+  }
+
+  std::vector<unsigned char> buffer(megabytes << 20);
+  unsigned int seed = 1;
+  for (std::size_t i = 0; i < buffer.size(); i++)
+  {
+    seed = seed * 1103515245 + 12345;
+    buffer[i] = (unsigned char)(seed >> 16);
+  }
+
+  bool ok = true;
+  unsigned int expected = 0;
+  double boostGbps = 0.0;
+
+  // boost::crc_32_type baseline:
+  for (int i = 0; i < iterations; i++)
+  {
+    boost::posix_time::ptime t0 =
+      boost::posix_time::microsec_clock::universal_time();
+
+    expected = reference(&buffer[0], buffer.size());
+
+    boost::posix_time::ptime t1 =
+      boost::posix_time::microsec_clock::universal_time();
+
+    double sec = double((t1 - t0).total_microseconds()) * 1e-6;
+    double gbps = double(buffer.size()) / (std::max(sec, 1e-6) * 1e+9);
+    boostGbps = std::max(boostGbps, gbps);
+  }
+
+  std::cout << std::fixed << std::setprecision(3)
+            << "CRC-32 of " << megabytes << " MB, best of "
+            << iterations << ", fastest engine: "
+            << kEngineNames[Crc32::fastest() - 1] << std::endl
+            << std::setw(12) << "boost" << ": "
+            << boostGbps << " GB/s" << std::endl;
+
+  for (std::size_t i = 0; i < kNumEngines; i++)
+  {
+    Crc32::Engine engine = kEngines[i];
+    if (!Crc32::supported(engine))
+    {
+      std::cout << std::setw(12) << kEngineNames[i]
+                << ": not supported" << std::endl;
+      continue;
+    }
+
+    if (!verify(engine, buffer))
+    {
+      ok = false;
+      continue;
+    }
+
+    unsigned int checksum = 0;
+    double gbps = measure(engine, buffer, iterations, checksum);
+
+    if (checksum != expected)
+    {
+      std::cerr << "ERROR: " << kEngineNames[i]
+                << " checksum mismatch" << std::endl;
+      ok = false;
+      continue;
+    }
+
+    std::cout << std::setw(12) << kEngineNames[i] << ": "
+              << gbps << " GB/s, "
+              << gbps / boostGbps << "x" << std::endl;
+  }
+
+  return ok ? 0 : 1;
+}
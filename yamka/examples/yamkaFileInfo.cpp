@@ -11,6 +11,7 @@
 #include <yamkaPayload.h>
 #include <yamkaStdInt.h>
 #include <yamkaFileStorage.h>
+#include <yamkaMappedFileStorage.h>
 #include <yamkaEBML.h>
 #include <yamkaMatroska.h>
 
@@ -31,8 +32,12 @@ static void
 usage(char ** argv, const char * message = NULL)
 {
   std::cerr << "USAGE: " << argv[0]
-            << " [-q] [--readEverything] [--skipClusters]"
+            << " [-q] [--viaSeekHead] [--skipClusters] [--noMmap]"
             << " -i source.mkv"
+            << std::endl
+            << "by default the file is read front to back, one Cluster"
+            << " at a time; --viaSeekHead loads the whole file into"
+            << " memory following the SeekHead(s)"
             << std::endl;
 
   if (message != NULL)
@@ -85,47 +90,56 @@ struct Examiner : public IElementCrawler
     clusterTime_(0)
   {}
 
-  // virtual:
-  bool eval(IElement & elt)
+  // print the element ID, position, name and size:
+  void header(IElement & elt, bool showSize = true)
   {
     IStorage::IReceiptPtr storageReceipt = elt.storageReceipt();
     IStorage::IReceiptPtr payloadReceipt = elt.payloadReceipt();
-    IStorage::IReceiptPtr crc32Receipt = elt.crc32Receipt();
 
-    uint64 eltId = elt.getId();
-    IPayload & payload = elt.getPayload();
+    std::cout
+      << indent(indentation_)
+      << std::setw(8) << uintEncode(elt.getId());
 
-    if (storageReceipt)
+    if (verbosity_ == kShowFileOffsets)
     {
       std::cout
-        << indent(indentation_)
-        << std::setw(8) << uintEncode(eltId);
-
-      if (verbosity_ == kShowFileOffsets)
-      {
-        std::cout
-          << " @ "
-          << std::hex << "0x"
-          << storageReceipt->position()
-          << std::dec
-          << " ("
-          << storageReceipt->position()
-          << ")";
-      }
+        << " @ "
+        << std::hex << "0x"
+        << storageReceipt->position()
+        << std::dec
+        << " ("
+        << storageReceipt->position()
+        << ")";
+    }
 
-      std::cout << " -- " << elt.getName();
+    std::cout << " -- " << elt.getName();
 
-      if (verbosity_ == kShowFileOffsets)
-      {
-        std::cout << ", " << storageReceipt->numBytes() << " bytes";
-      }
+    if (showSize && verbosity_ == kShowFileOffsets)
+    {
+      std::cout << ", " << storageReceipt->numBytes() << " bytes";
 
-      if (payloadReceipt && verbosity_ == kShowFileOffsets)
+      if (payloadReceipt)
       {
         std::cout << " (" << payloadReceipt->numBytes() << " payload)";
       }
+    }
 
-      std::cout << std::endl;
+    std::cout << std::endl;
+  }
+
+  // virtual:
+  bool eval(IElement & elt)
+  {
+    IStorage::IReceiptPtr storageReceipt = elt.storageReceipt();
+    IStorage::IReceiptPtr payloadReceipt = elt.payloadReceipt();
+    IStorage::IReceiptPtr crc32Receipt = elt.crc32Receipt();
+
+    uint64 eltId = elt.getId();
+    IPayload & payload = elt.getPayload();
+
+    if (storageReceipt)
+    {
+      header(elt);
 
       if (crc32Receipt)
       {
@@ -369,6 +383,67 @@ struct Examiner : public IElementCrawler
 };
 
 
+//----------------------------------------------------------------
+// StreamExaminer
+//
+// Examine the level-1 elements as they are loaded,
+// so that only one Cluster is in memory at a time.
+//
+struct StreamExaminer : public MatroskaDoc::IStreamVisitor
+{
+  StreamExaminer(MatroskaDoc & doc, Examiner & examiner):
+    doc_(doc),
+    examiner_(examiner),
+    numSegments_(0)
+  {}
+
+  // virtual:
+  bool beginSegment(MatroskaDoc::TSegment & segment)
+  {
+    if (!numSegments_)
+    {
+      // the EBML header is loaded by now:
+      examiner_.eval(doc_.head_);
+    }
+
+    numSegments_++;
+
+    // the segment size is not known until it is loaded:
+    examiner_.header(segment, false);
+    examiner_.indentation_++;
+    return true;
+  }
+
+  // virtual:
+  bool element(MatroskaDoc::TSegment & segment, IElement & elt)
+  {
+    (void)segment;
+    examiner_.eval(elt);
+    return true;
+  }
+
+  // virtual:
+  bool cluster(MatroskaDoc::TSegment & segment, Segment::TCluster & cluster)
+  {
+    (void)segment;
+    examiner_.eval(cluster);
+    return true;
+  }
+
+  // virtual:
+  bool endSegment(MatroskaDoc::TSegment & segment)
+  {
+    (void)segment;
+    examiner_.indentation_--;
+    return true;
+  }
+
+  MatroskaDoc & doc_;
+  Examiner & examiner_;
+  std::size_t numSegments_;
+};
+
+
 //----------------------------------------------------------------
 // main
 //
@@ -382,7 +457,8 @@ main(int argc, char ** argv)
   Examiner::Verbosity verbosity = Examiner::kShowFileOffsets;
   std::string srcPath;
   bool skipClusters = false;
-  bool useSeekHead = true;
+  bool useSeekHead = false;
+  bool useMapping = true;
 
   for (int i = 1; i < argc; i++)
   {
@@ -400,10 +476,19 @@ main(int argc, char ** argv)
     {
       skipClusters = true;
     }
+    else if (strcmp(argv[i], "--viaSeekHead") == 0)
+    {
+      useSeekHead = true;
+    }
     else if (strcmp(argv[i], "--readEverything") == 0)
     {
+      // this is the default now:
       useSeekHead = false;
     }
+    else if (strcmp(argv[i], "--noMmap") == 0)
+    {
+      useMapping = false;
+    }
     else
     {
       usage(argv, (std::string("unknown option: ") +
@@ -411,20 +496,23 @@ main(int argc, char ** argv)
     }
   }
 
-  FileStorage src(srcPath, File::kReadOnly);
-  if (!src.file_.isOpen())
+  // memory map the source file, if possible:
+  uint64 srcSize = 0;
+  IStoragePtr srcPtr = openReadOnlyStorage(srcPath, srcSize, useMapping);
+  if (!srcPtr)
   {
     usage(argv, (std::string("failed to open ") +
                  srcPath +
                  std::string(" for reading")).c_str());
   }
 
-  uint64 srcSize = src.file_.size();
+  IStorage & src = *srcPtr;
   MatroskaDoc doc;
 
   PartialReader fastLoader;
   IDelegateLoad * loader = skipClusters ? &fastLoader : NULL;
 
+  Examiner examiner(verbosity);
   uint64 bytesRead = 0;
 
   if (useSeekHead)
@@ -436,10 +524,16 @@ main(int argc, char ** argv)
     {
       bytesRead = srcSize;
     }
+
+    if (bytesRead && !doc.segments_.empty())
+    {
+      doc.eval(examiner);
+    }
   }
   else
   {
-    bytesRead = doc.loadAndKeepReceipts(src, srcSize, loader);
+    StreamExaminer streamExaminer(doc, examiner);
+    bytesRead = doc.loadStreaming(src, srcSize, streamExaminer, loader);
   }
 
   if (!bytesRead || doc.segments_.empty())
@@ -447,12 +541,9 @@ main(int argc, char ** argv)
     usage(argv, (std::string("source file has no matroska segments").c_str()));
   }
 
-  Examiner examiner(verbosity);
-  doc.eval(examiner);
-
   // close open file handles:
   doc = MatroskaDoc();
-  src = FileStorage();
+  srcPtr.setToNull();
 
   return 0;
 }
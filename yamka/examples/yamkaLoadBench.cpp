@@ -0,0 +1,337 @@
+// -*- Mode: c++; tab-width: 8; c-basic-offset: 2; indent-tabs-mode: nil -*-
+// NOTE: the first line of this file sets up source code indentation rules
+// for Emacs; it is also a hint to anyone modifying this file.
+
+// Created   : Fri Oct 16 23:12:40 MDT 2026
+// Copyright : Pavel Koshevoy
+// License   : MIT -- http://www.opensource.org/licenses/mit-license.php
+
+// yamka includes:
+#include <yamkaElt.h>
+#include <yamkaPayload.h>
+#include <yamkaStdInt.h>
+#include <yamkaFileStorage.h>
+#include <yamkaMappedFileStorage.h>
+#include <yamkaEBML.h>
+#include <yamkaMatroska.h>
+
+// boost includes:
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+// system includes:
+#include <iomanip>
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+// namespace access:
+using namespace Yamka;
+
+//----------------------------------------------------------------
+// usage
+//
+static void
+usage(char ** argv, const char * message = NULL)
+{
+  std::cerr << "USAGE: " << argv[0]
+            << " [-i source.mkv] [-n iterations] [--generate megabytes]"
+            << std::endl
+            << "compares full-file MatroskaDoc load time via FileStorage"
+            << " and MappedFileStorage; without -i a synthetic file is"
+            << " generated (default 256 MB) and removed afterwards"
+            << std::endl;
+
+  if (message != NULL)
+  {
+    std::cerr << "ERROR: " << message << std::endl;
+  }
+
+  ::exit(1);
+}
+
+//----------------------------------------------------------------
+// generate
+//
+// one video track, 1 second clusters of 25 SimpleBlocks each,
+// with small incompressible frames so that the load time
+// is dominated by the number of elements rather than their size:
+//
+static bool
+generate(const std::string & path, uint64 megabytes)
+{
+  static const std::size_t frameSize = 2048;
+  static const std::size_t framesPerCluster = 25;
+
+  MatroskaDoc doc;
+  doc.segments_.push_back(MatroskaDoc::TSegment());
+  Segment & segment = doc.segments_.back().payload_;
+  segment.info_.payload_.timecodeScale_.payload_.set(1000000);
+
+  segment.tracks_.payload_.tracks_.push_back(Tracks::TTrack());
+  Track & track = segment.tracks_.payload_.tracks_.back().payload_;
+  track.trackNumber_.payload_.set(1);
+  track.trackUID_.payload_.set(1);
+  track.trackType_.payload_.set(Track::kTrackTypeVideo);
+  track.codecID_.payload_.set(std::string("V_UNCOMPRESSED"));
+
+  const uint64 numFrames = (megabytes << 20) / frameSize;
+  std::vector<unsigned char> block(4 + frameSize);
+  unsigned int seed = 1;
+
+  for (uint64 i = 0; i < numFrames; i++)
+  {
+    std::size_t j = (std::size_t)(i % framesPerCluster);
+    if (!j)
+    {
+      segment.clusters_.push_back(Segment::TCluster());
+      Cluster & cluster = segment.clusters_.back().payload_;
+      cluster.timecode_.payload_.set((i / framesPerCluster) * 1000);
+    }
+
+    // track number, relative timecode, flags:
+    block[0] = 0x81;
+    block[1] = (unsigned char)((j * 40) >> 8);
+    block[2] = (unsigned char)((j * 40) & 0xFF);
+    block[3] = j ? 0x00 : 0x80;
+
+    for (std::size_t k = 4; k < block.size(); k++)
+    {
+      seed = seed * 1103515245 + 12345;
+      block[k] = (unsigned char)(seed >> 16);
+    }
+
+    Cluster::TSimpleBlock simpleBlock;
+    simpleBlock.payload_.set(&block[0],
+                             block.size(),
+                             HodgePodgeStorage::Instance);
+
+    Cluster & cluster = segment.clusters_.back().payload_;
+    cluster.blocks_.push_back(simpleBlock);
+  }
+
+  FileStorage dst(path, File::kReadWrite);
+  if (!dst.file_.isOpen())
+  {
+    return false;
+  }
+
+  dst.file_.setSize(0);
+  return !!doc.save(dst);
+}
+
+//----------------------------------------------------------------
+// TLoadStats
+//
+struct TLoadStats
+{
+  TLoadStats():
+    parseSec_(0.0),
+    readSec_(0.0),
+    clusters_(0),
+    blocks_(0),
+    checksum_(0)
+  {}
+
+  double parseSec_;
+  double readSec_;
+  std::size_t clusters_;
+  std::size_t blocks_;
+  uint64 checksum_;
+};
+
+//----------------------------------------------------------------
+// secondsSince
+//
+static double
+secondsSince(const boost::posix_time::ptime & t0)
+{
+  boost::posix_time::ptime t1 =
+    boost::posix_time::microsec_clock::universal_time();
+
+  return double((t1 - t0).total_microseconds()) * 1e-6;
+}
+
+//----------------------------------------------------------------
+// load
+//
+// parse the whole file, then read every block via its storage receipt:
+//
+static bool
+load(const std::string & path, bool useMapping, TLoadStats & stats)
+{
+  boost::posix_time::ptime t0 =
+    boost::posix_time::microsec_clock::universal_time();
+
+  uint64 srcSize = 0;
+  IStoragePtr src = openReadOnlyStorage(path, srcSize, useMapping);
+  if (!src)
+  {
+    return false;
+  }
+
+  MatroskaDoc doc;
+  if (doc.loadAndKeepReceipts(*src, srcSize) != srcSize)
+  {
+    return false;
+  }
+
+  stats.parseSec_ = secondsSince(t0);
+  t0 = boost::posix_time::microsec_clock::universal_time();
+
+  uint64 checksum = 0;
+  std::vector<unsigned char> buffer;
+
+  for (std::list<MatroskaDoc::TSegment>::const_iterator
+         i = doc.segments_.begin(); i != doc.segments_.end(); ++i)
+  {
+    const Segment & segment = i->payload_;
+    for (std::list<Segment::TCluster>::const_iterator
+           j = segment.clusters_.begin(); j != segment.clusters_.end(); ++j)
+    {
+      const std::list<IElement *> & blocks = j->payload_.blocks_.elts();
+      stats.clusters_++;
+
+      for (std::list<IElement *>::const_iterator
+             k = blocks.begin(); k != blocks.end(); ++k)
+      {
+        IStorage::IReceiptPtr receipt = (*k)->payloadReceipt();
+        std::size_t numBytes = (std::size_t)(receipt->numBytes());
+
+        // zero-copy, if the storage allows it:
+        const unsigned char * data = receipt->data();
+        if (!data)
+        {
+          buffer.resize(numBytes);
+          if (numBytes && !receipt->load(&buffer[0]))
+          {
+            return false;
+          }
+
+          data = numBytes ? &buffer[0] : NULL;
+        }
+
+        for (std::size_t n = 0; n < numBytes; n++)
+        {
+          checksum += data[n];
+        }
+
+        stats.blocks_++;
+      }
+    }
+  }
+
+  stats.readSec_ = secondsSince(t0);
+  stats.checksum_ = checksum;
+  return true;
+}
+
+
+//----------------------------------------------------------------
+// main
+//
+int
+main(int argc, char ** argv)
+{
+#ifdef _WIN32
+  get_main_args_utf8(argc, argv);
+#endif
+
+  std::string srcPath;
+  uint64 megabytes = 256;
+  int iterations = 3;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-i") == 0)
+    {
+      if ((argc - i) <= 1) usage(argv, "could not parse -i parameter");
+      i++;
+      srcPath.assign(argv[i]);
+    }
+    else if (strcmp(argv[i], "-n") == 0)
+    {
+      if ((argc - i) <= 1) usage(argv, "could not parse -n parameter");
+      i++;
+      iterations = std::max<int>(1, atoi(argv[i]));
+    }
+    else if (strcmp(argv[i], "--generate") == 0)
+    {
+      if ((argc - i) <= 1) usage(argv, "could not parse --generate");
+      i++;
+      megabytes = std::max<int>(1, atoi(argv[i]));
+    }
+    else
+    {
+      usage(argv, (std::string("unknown option: ") +
+                   std::string(argv[i])).c_str());
+    }
+  }
+
+  bool generated = false;
+  if (srcPath.empty())
+  {
+    srcPath = "yamkaLoadBench.mkv";
+    std::cout << "generating " << megabytes << " MB " << srcPath
+              << std::endl;
+
+    if (!generate(srcPath, megabytes))
+    {
+      usage(argv, "failed to generate the test file");
+    }
+
+    generated = true;
+  }
+
+  static const char * backends[] = { "FileStorage", "MappedFileStorage" };
+  TLoadStats best[2];
+
+  for (int backend = 0; backend < 2; backend++)
+  {
+    for (int i = 0; i < iterations; i++)
+    {
+      TLoadStats stats;
+      if (!load(srcPath, backend == 1, stats))
+      {
+        usage(argv, (std::string("failed to load ") + srcPath).c_str());
+      }
+
+      if (!i || stats.parseSec_ + stats.readSec_ <
+          best[backend].parseSec_ + best[backend].readSec_)
+      {
+        best[backend] = stats;
+      }
+    }
+  }
+
+  if (best[0].checksum_ != best[1].checksum_ ||
+      best[0].blocks_ != best[1].blocks_)
+  {
+    std::cerr << "ERROR: backends loaded different data" << std::endl;
+    return 1;
+  }
+
+  std::cout << best[0].clusters_ << " clusters, "
+            << best[0].blocks_ << " blocks, "
+            << "best of " << iterations << ":" << std::endl;
+
+  for (int backend = 0; backend < 2; backend++)
+  {
+    const TLoadStats & stats = best[backend];
+    std::cout
+      << std::setw(18) << backends[backend]
+      << std::fixed << std::setprecision(3)
+      << ", parse " << stats.parseSec_ << " sec"
+      << ", read blocks " << stats.readSec_ << " sec"
+      << ", total " << stats.parseSec_ + stats.readSec_ << " sec"
+      << std::endl;
+  }
+
+  if (generated)
+  {
+    File::remove(srcPath.c_str());
+  }
+
+  return 0;
+}
@@ -246,6 +246,43 @@ struct LoaderSkipClusterPayload : public LoadWithProgress
   }
 };
 
+//----------------------------------------------------------------
+// LoaderSkipAllButClusters
+//
+// Skip the payload of every level-1 element except the Clusters,
+// used when streaming the Clusters of an already loaded segment.
+//
+struct LoaderSkipAllButClusters : public LoadWithProgress
+{
+  LoaderSkipAllButClusters(uint64 srcSize):
+    LoadWithProgress(srcSize)
+  {}
+
+  // virtual:
+  uint64 load(IStorage & storage,
+              uint64 payloadBytesToRead,
+              uint64 eltId,
+              IPayload & payload)
+  {
+    LoadWithProgress::load(storage, payloadBytesToRead, eltId, payload);
+
+    if (eltId == TSeekHead::kId ||
+        eltId == TSegInfo::kId ||
+        eltId == TTracks::kId ||
+        eltId == TCues::kId ||
+        eltId == TChapters::kId ||
+        eltId == TAttachment::kId ||
+        eltId == TTags::kId)
+    {
+      storage.skip(payloadBytesToRead);
+      return payloadBytesToRead;
+    }
+
+    // let the generic load mechanism handle the actual loading:
+    return 0;
+  }
+};
+
 //----------------------------------------------------------------
 // TTrackMap
 //
@@ -623,7 +660,8 @@ struct TCue
 //----------------------------------------------------------------
 // TRemuxer
 //
-struct TRemuxer : public LoadWithProgress
+struct TRemuxer : public LoadWithProgress,
+                  public MatroskaDoc::IStreamVisitor
 {
   TRemuxer(const std::map<uint64, double> & tsOffset,
            const TTrackMap & trackSrcDst,
@@ -653,6 +691,18 @@ struct TRemuxer : public LoadWithProgress
   // lace together BlockGroups, SimpleBlocks, EncryptedBlocks, SilentTracks:
   TBlockInfo * push(uint64 clusterTime, const IElement * elt);
 
+  // push SilentTracks once per source cluster, as a cluster delimiter:
+  void pushSilentTracks(const TCluster & clusterElt);
+
+  // push a BlockGroup/SimpleBlock/EncryptedBlock, and mux:
+  void pushBlock(uint64 clusterTime, const IElement * elt);
+
+  // virtual: the copy path streams source Clusters one block at a time:
+  bool block(TSegment & segment, TCluster & clusterElt, IElement & blockElt);
+
+  // virtual:
+  bool cluster(TSegment & segment, TCluster & clusterElt);
+
   void mux(std::size_t minLaceSize = 150);
   void startNextCluster(TBlockInfo * binfo);
   void finishCurrentCluster();
@@ -680,11 +730,13 @@ struct TRemuxer : public LoadWithProgress
   TDataTable<uint64> seekTable_;
   TDataTable<TCue> cueTable_;
   TCluster clusterElt_;
+  uint64 srcClusterPosition_;
   uint64 t0_;
   uint64 t1_;
   bool extractTimeSegment_;
   bool extractFromKeyframe_;
   bool foundFirstKeyframe_;
+  bool fixKeyFlag_;
 };
 
 //----------------------------------------------------------------
@@ -712,11 +764,13 @@ TRemuxer::TRemuxer(const std::map<uint64, double> & tsOffset,
   segmentPayloadPosition_(dstSeg.payloadReceipt()->position()),
   clusterRelativePosition_(0),
   clusterPayloadPosition_(uintMax[8]),
+  srcClusterPosition_(uintMax[8]),
   t0_(0),
   t1_(0),
   extractTimeSegment_(false),
   extractFromKeyframe_(false),
-  foundFirstKeyframe_(false)
+  foundFirstKeyframe_(false),
+  fixKeyFlag_(false)
 {
   TTracks & tracksElt = dstSeg_.payload_.tracks_;
   std::deque<TTrack> & tracks = tracksElt.payload_.tracks_;
@@ -1210,8 +1264,27 @@ TRemuxer::remux(const EbmlHead & ebmlHead,
   extractTimeSegment_ = (t0_ < t1_);
   extractFromKeyframe_ = (extractTimeSegment_ && extractFromKeyframe);
   foundFirstKeyframe_ = false;
+  fixKeyFlag_ = fixKeyFlag;
 
-  if (extractTimeSegment_)
+  if (!extractTimeSegment_)
+  {
+    // copy everything, the source Clusters are not in memory,
+    // stream them one block at a time instead:
+    IStorage::IReceiptPtr srcSegReceipt = srcSeg_.storageReceipt();
+    uint64 srcSegPosition = srcSegReceipt->position();
+    uint64 srcSize = src_.file_.size();
+
+    // the segment header elements are loaded already, skip them:
+    LoaderSkipAllButClusters skipHeaders(srcSize);
+    StreamLoader streamLoader(*this, &skipHeaders);
+    TSegment segmentElt;
+
+    src_.seekTo(srcSegPosition);
+    streamLoader.loadSegment(segmentElt, src_, srcSize - srcSegPosition);
+
+    clusterIter = clusters.end();
+  }
+  else
   {
     // use CuePoints to find the closest Cluster:
     const std::list<Cues::TCuePoint> & cuePoints =
@@ -1345,33 +1418,14 @@ TRemuxer::remux(const EbmlHead & ebmlHead,
     }
 
     // use SilentTracks as a cluster delimiter:
-    if (cluster.silent_.mustSave())
-    {
-      push(clusterTime, &cluster.silent_);
-    }
+    pushSilentTracks(clusterElt);
 
     // iterate through simple blocks and push them into a lace:
     const std::list<IElement *> & blocks = cluster.blocks_.elts();
     for (std::list<IElement *>::const_iterator i = blocks.begin();
          i != blocks.end(); ++i)
     {
-      TBlockInfo * binfo = push(clusterTime, *i);
-      if (!binfo)
-      {
-        continue;
-      }
-
-      if (fixKeyFlag)
-      {
-        if (lace_.codecID_[(std::size_t)binfo->trackNo_] == "V_MPEG4/ISO/AVC")
-        {
-          HodgePodge blockFrames;
-          blockFrames.set(binfo->frames_);
-          binfo->keyframe_ = isH264Keyframe(&blockFrames);
-        }
-      }
-
-      mux();
+      pushBlock(clusterTime, *i);
     }
   }
 
@@ -1709,6 +1763,84 @@ TRemuxer::push(uint64 clusterTime, const IElement * elt)
   return info;
 }
 
+//----------------------------------------------------------------
+// TRemuxer::pushSilentTracks
+//
+void
+TRemuxer::pushSilentTracks(const TCluster & clusterElt)
+{
+  uint64 position = clusterElt.storageReceipt()->position();
+  if (position == srcClusterPosition_)
+  {
+    return;
+  }
+
+  srcClusterPosition_ = position;
+
+  const Cluster & cluster = clusterElt.payload_;
+  if (cluster.silent_.mustSave())
+  {
+    uint64 clusterTime = cluster.timecode_.payload_.get();
+    push(clusterTime, &cluster.silent_);
+  }
+}
+
+//----------------------------------------------------------------
+// TRemuxer::pushBlock
+//
+void
+TRemuxer::pushBlock(uint64 clusterTime, const IElement * elt)
+{
+  TBlockInfo * binfo = push(clusterTime, elt);
+  if (!binfo)
+  {
+    return;
+  }
+
+  if (fixKeyFlag_)
+  {
+    if (lace_.codecID_[(std::size_t)binfo->trackNo_] == "V_MPEG4/ISO/AVC")
+    {
+      HodgePodge blockFrames;
+      blockFrames.set(binfo->frames_);
+      binfo->keyframe_ = isH264Keyframe(&blockFrames);
+    }
+  }
+
+  mux();
+}
+
+//----------------------------------------------------------------
+// TRemuxer::block
+//
+bool
+TRemuxer::block(TSegment & segment, TCluster & clusterElt, IElement & blockElt)
+{
+  (void)segment;
+
+  // SilentTracks, if any, precede the blocks:
+  pushSilentTracks(clusterElt);
+
+  uint64 clusterTime = clusterElt.payload_.timecode_.payload_.get();
+  pushBlock(clusterTime, &blockElt);
+
+  // the block has been copied into the lace, discard it:
+  return true;
+}
+
+//----------------------------------------------------------------
+// TRemuxer::cluster
+//
+bool
+TRemuxer::cluster(TSegment & segment, TCluster & clusterElt)
+{
+  (void)segment;
+
+  // a Cluster without any blocks may still have SilentTracks:
+  pushSilentTracks(clusterElt);
+  return true;
+}
+
 //----------------------------------------------------------------
 // TRemuxer::mux
 //
@@ -2921,6 +3053,10 @@ main(int argc, char ** argv)
                  std::string(" for reading")).c_str());
   }
 
+  // the source is mostly scanned sequentially:
+  src.file_.cache()->resize(16, 65536);
+  src.file_.cache()->setReadAhead(8);
+
   printCurrentTime("start");
 
   bool extractViaChapters =
@@ -2937,13 +3073,16 @@ main(int argc, char ** argv)
   printCurrentTime("doc.loadSeekHead");
   bool ok = doc.loadSeekHead(src, srcSize);
 
+  // Clusters are only needed up front for finding the time segment,
+  // otherwise they are streamed from the source one at a time:
   if (ok)
   {
     printCurrentTime("doc.loadViaSeekHead");
-    ok = doc.loadViaSeekHead(src, &skipClusters, true);
+    ok = doc.loadViaSeekHead(src, &skipClusters, extractTimeSegment);
   }
 
-  if (!ok || (!doc.segments_.empty() &&
+  if (!ok || (extractTimeSegment &&
+              !doc.segments_.empty() &&
               doc.segments_.front().payload_.clusters_.empty()))
   {
     std::cout << "failed to find Clusters via SeekHead, "
@@ -2953,8 +3092,18 @@ main(int argc, char ** argv)
     doc = MatroskaDoc();
     src.seekTo(0);
 
-    printCurrentTime("doc.loadAndKeepReceipts");
-    doc.loadAndKeepReceipts(src, srcSize, &skipClusters);
+    if (extractTimeSegment)
+    {
+      printCurrentTime("doc.loadAndKeepReceipts");
+      doc.loadAndKeepReceipts(src, srcSize, &skipClusters);
+    }
+    else
+    {
+      // skip the Cluster payloads, and don't keep the Clusters:
+      printCurrentTime("doc.loadStreaming");
+      MatroskaDoc::IStreamVisitor skipEverything;
+      doc.loadStreaming(src, srcSize, skipEverything, &skipClusters);
+    }
   }
 
   printCurrentTime("doc.load... finished");
@@ -3048,6 +3197,10 @@ main(int argc, char ** argv)
                  std::string(" for writing")).c_str());
   }
 
+  // the output is mostly written sequentially:
+  dst.file_.cache()->resize(16, 65536);
+  dst.file_.cache()->setWriteBehind(8);
+
   HodgePodgeStorage tmp;
   MatroskaDoc out;
 
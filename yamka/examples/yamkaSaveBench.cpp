@@ -0,0 +1,319 @@
+// -*- Mode: c++; tab-width: 8; c-basic-offset: 2; indent-tabs-mode: nil -*-
+// NOTE: the first line of this file sets up source code indentation rules
+// for Emacs; it is also a hint to anyone modifying this file.
+
+// Created   : Sat Oct 17 14:05:31 MDT 2026
+// Copyright : Pavel Koshevoy
+// License   : MIT -- http://www.opensource.org/licenses/mit-license.php
+
+// yamka includes:
+#include <yamkaElt.h>
+#include <yamkaPayload.h>
+#include <yamkaStdInt.h>
+#include <yamkaFileStorage.h>
+#include <yamkaMappedFileStorage.h>
+#include <yamkaEBML.h>
+#include <yamkaMatroska.h>
+#include <yamkaThread.h>
+
+// boost includes:
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+// system includes:
+#include <iomanip>
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+// namespace access:
+using namespace Yamka;
+
+//----------------------------------------------------------------
+// usage
+//
+static void
+usage(char ** argv, const char * message = NULL)
+{
+  std::cerr << "USAGE: " << argv[0]
+            << " [-i source.mkv] [-t threads] [-n iterations]"
+            << " [--generate megabytes] [--crc]"
+            << std::endl
+            << "saves a MatroskaDoc with 1 thread and with the given number"
+            << " of threads (default: number of CPU cores), verifies that"
+            << " the output is byte-identical and compares the save time;"
+            << " without -i a synthetic document is generated in memory"
+            << " (default 256 MB)"
+            << std::endl;
+
+  if (message != NULL)
+  {
+    std::cerr << "ERROR: " << message << std::endl;
+  }
+
+  ::exit(1);
+}
+
+//----------------------------------------------------------------
+// generate
+//
+// one video track, 1 second clusters of 25 SimpleBlocks each,
+// block data is kept in HodgePodgeStorage:
+//
+static void
+generate(MatroskaDoc & doc, uint64 megabytes)
+{
+  static const std::size_t frameSize = 32768;
+  static const std::size_t framesPerCluster = 25;
+
+  doc.segments_.push_back(MatroskaDoc::TSegment());
+  MatroskaDoc::TSegment & segmentElt = doc.segments_.back();
+  Segment & segment = segmentElt.payload_;
+  segment.info_.payload_.timecodeScale_.payload_.set(1000000);
+
+  segment.tracks_.payload_.tracks_.push_back(Tracks::TTrack());
+  Track & track = segment.tracks_.payload_.tracks_.back().payload_;
+  track.trackNumber_.payload_.set(1);
+  track.trackUID_.payload_.set(1);
+  track.trackType_.payload_.set(Track::kTrackTypeVideo);
+  track.codecID_.payload_.set(std::string("V_UNCOMPRESSED"));
+
+  const uint64 numFrames = (megabytes << 20) / frameSize;
+  std::vector<unsigned char> block(4 + frameSize);
+  unsigned int seed = 1;
+
+  for (uint64 i = 0; i < numFrames; i++)
+  {
+    std::size_t j = (std::size_t)(i % framesPerCluster);
+    if (!j)
+    {
+      segment.clusters_.push_back(Segment::TCluster());
+      Segment::TCluster & clusterElt = segment.clusters_.back();
+      Cluster & cluster = clusterElt.payload_;
+      cluster.timecode_.payload_.set((i / framesPerCluster) * 1000);
+      cluster.position_.payload_.setOrigin(&segmentElt);
+      cluster.position_.payload_.setElt(&clusterElt);
+    }
+
+    // track number, relative timecode, flags:
+    block[0] = 0x81;
+    block[1] = (unsigned char)((j * 40) >> 8);
+    block[2] = (unsigned char)((j * 40) & 0xFF);
+    block[3] = j ? 0x00 : 0x80;
+
+    for (std::size_t k = 4; k < block.size(); k++)
+    {
+      seed = seed * 1103515245 + 12345;
+      block[k] = (unsigned char)(seed >> 16);
+    }
+
+    Cluster::TSimpleBlock simpleBlock;
+    simpleBlock.payload_.set(&block[0],
+                             block.size(),
+                             HodgePodgeStorage::Instance);
+
+    Segment::TCluster & clusterElt = segment.clusters_.back();
+    Cluster & cluster = clusterElt.payload_;
+    cluster.blocks_.push_back(simpleBlock);
+
+    if (!j)
+    {
+      // index every keyframe, so that there are Cues
+      // with references into the clusters to rewrite:
+      segment.cues_.payload_.points_.push_back(Cues::TCuePoint());
+      CuePoint & point = segment.cues_.payload_.points_.back().payload_;
+      point.time_.payload_.set((i / framesPerCluster) * 1000);
+
+      point.trkPosns_.push_back(CuePoint::TCueTrkPos());
+      CueTrackPositions & pos = point.trkPosns_.back().payload_;
+      pos.track_.payload_.set(1);
+      pos.cluster_.payload_.setOrigin(&segmentElt);
+      pos.cluster_.payload_.setElt(&clusterElt);
+      pos.relPos_.payload_.setOrigin(&clusterElt);
+      pos.relPos_.payload_.setElt(cluster.blocks_.elts().back());
+    }
+  }
+}
+
+//----------------------------------------------------------------
+// secondsSince
+//
+static double
+secondsSince(const boost::posix_time::ptime & t0)
+{
+  boost::posix_time::ptime t1 =
+    boost::posix_time::microsec_clock::universal_time();
+
+  return double((t1 - t0).total_microseconds()) * 1e-6;
+}
+
+//----------------------------------------------------------------
+// save
+//
+// returns the save time in seconds, or a negative number on failure:
+//
+static double
+save(MatroskaDoc & doc, const std::string & path)
+{
+  FileStorage dst(path, File::kReadWrite);
+  if (!dst.file_.isOpen())
+  {
+    return -1.0;
+  }
+
+  dst.file_.setSize(0);
+
+  boost::posix_time::ptime t0 =
+    boost::posix_time::microsec_clock::universal_time();
+
+  bool ok = !!doc.save(dst);
+  double sec = secondsSince(t0);
+
+  // element storage receipts keep the file open,
+  // make sure everything is flushed before comparing:
+  doc.discardReceipts();
+  dst.file_.close();
+
+  return ok ? sec : -1.0;
+}
+
+//----------------------------------------------------------------
+// sameContents
+//
+static bool
+sameContents(const std::string & pathA, const std::string & pathB)
+{
+  MappedFile a(pathA);
+  MappedFile b(pathB);
+
+  return (a.isOpen() &&
+          b.isOpen() &&
+          a.size() == b.size() &&
+          memcmp(a.data(), b.data(), (std::size_t)a.size()) == 0);
+}
+
+//----------------------------------------------------------------
+// main
+//
+int
+main(int argc, char ** argv)
+{
+#ifdef _WIN32
+  get_main_args_utf8(argc, argv);
+#endif
+
+  std::string srcPath;
+  uint64 megabytes = 256;
+  std::size_t numThreads = Thread::hardwareConcurrency();
+  int iterations = 3;
+  bool crc32 = false;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-i") == 0)
+    {
+      if ((argc - i) <= 1) usage(argv, "could not parse -i parameter");
+      i++;
+      srcPath.assign(argv[i]);
+    }
+    else if (strcmp(argv[i], "-t") == 0)
+    {
+      if ((argc - i) <= 1) usage(argv, "could not parse -t parameter");
+      i++;
+      numThreads = std::max<int>(1, atoi(argv[i]));
+    }
+    else if (strcmp(argv[i], "-n") == 0)
+    {
+      if ((argc - i) <= 1) usage(argv, "could not parse -n parameter");
+      i++;
+      iterations = std::max<int>(1, atoi(argv[i]));
+    }
+    else if (strcmp(argv[i], "--generate") == 0)
+    {
+      if ((argc - i) <= 1) usage(argv, "could not parse --generate");
+      i++;
+      megabytes = std::max<int>(1, atoi(argv[i]));
+    }
+    else if (strcmp(argv[i], "--crc") == 0)
+    {
+      crc32 = true;
+    }
+    else
+    {
+      usage(argv, (std::string("unknown option: ") +
+                   std::string(argv[i])).c_str());
+    }
+  }
+
+  // block data must be directly addressable to be saved concurrently,
+  // so the source file is memory mapped:
+  MatroskaDoc doc;
+  IStoragePtr src;
+
+  if (srcPath.empty())
+  {
+    std::cout << "generating " << megabytes << " MB in memory" << std::endl;
+    generate(doc, megabytes);
+  }
+  else
+  {
+    uint64 srcSize = 0;
+    src = openReadOnlyStorage(srcPath, srcSize);
+    if (!src || doc.loadAndKeepReceipts(*src, srcSize) != srcSize)
+    {
+      usage(argv, (std::string("failed to load ") + srcPath).c_str());
+    }
+
+    doc.resolveReferences();
+  }
+
+  doc.setCrc32(crc32);
+
+  const std::string serialPath("yamkaSaveBench-serial.mkv");
+  const std::string parallelPath("yamkaSaveBench-parallel.mkv");
+  double best[2] = { 0.0, 0.0 };
+  bool ok = true;
+
+  for (int i = 0; ok && i < iterations; i++)
+  {
+    doc.setSaveThreads(1);
+    double serialSec = save(doc, serialPath);
+
+    doc.setSaveThreads(numThreads);
+    double parallelSec = save(doc, parallelPath);
+
+    if (serialSec < 0.0 || parallelSec < 0.0)
+    {
+      std::cerr << "ERROR: failed to save" << std::endl;
+      ok = false;
+    }
+    else if (!sameContents(serialPath, parallelPath))
+    {
+      std::cerr << "ERROR: " << serialPath << " and " << parallelPath
+                << " are different" << std::endl;
+      ok = false;
+    }
+
+    best[0] = i ? std::min(best[0], serialSec) : serialSec;
+    best[1] = i ? std::min(best[1], parallelSec) : parallelSec;
+  }
+
+  if (ok)
+  {
+    std::cout << "outputs are identical, "
+              << (crc32 ? "with" : "without") << " CRC-32, best of "
+              << iterations << ":" << std::endl
+              << std::fixed << std::setprecision(3)
+              << std::setw(12) << "1 thread" << ": "
+              << best[0] << " sec" << std::endl
+              << std::setw(4) << numThreads << " threads" << ": "
+              << best[1] << " sec, "
+              << best[0] / std::max(best[1], 1e-6) << "x" << std::endl;
+
+    File::remove(serialPath.c_str());
+    File::remove(parallelPath.c_str());
+  }
+
+  return ok ? 0 : 1;
+}
@@ -8,10 +8,14 @@
 
 // yamka includes:
 #include <yamkaCache.h>
+#include <yamkaThread.h>
 
 // system includes:
+#include <algorithm>
 #include <assert.h>
 #include <iostream>
+#include <list>
+#include <map>
 #include <string.h>
 #include <vector>
 
@@ -61,6 +65,434 @@ namespace Yamka
   };
 
 
+  //----------------------------------------------------------------
+  // TCache::TAsync
+  //
+  // Background thread shared by the read-ahead and the write-behind.
+  // Everything here is guarded by mutex_, except the data provider
+  // which is guarded by io_ (because the provider is not thread safe,
+  // the cache must also hold io_ whenever it calls the provider while
+  // the background thread exists).
+  //
+  struct TCache::TAsync
+  {
+
+    //----------------------------------------------------------------
+    // TRequest
+    //
+    // a line to prefetch or to write out:
+    //
+    struct TRequest
+    {
+      TRequest(uint64 addr):
+        addr_(addr),
+        size_(0),
+        busy_(false),
+        done_(false),
+        ok_(false),
+        cancelled_(false)
+      {}
+
+      // line head and size:
+      uint64 addr_;
+      std::size_t size_;
+      std::vector<unsigned char> data_;
+
+      // prefetch progress:
+      bool busy_;
+      bool done_;
+      bool ok_;
+
+      // set when a busy prefetch is no longer wanted,
+      // the background thread deletes it when done:
+      bool cancelled_;
+    };
+
+    //----------------------------------------------------------------
+    // TRequestList
+    //
+    typedef std::list<TRequest *> TRequestList;
+
+    //----------------------------------------------------------------
+    // IoLock
+    //
+    // scoped lock on the data provider, does nothing without TAsync:
+    //
+    struct IoLock
+    {
+      IoLock(TAsync * async):
+        async_(async)
+      {
+        if (async_)
+        {
+          async_->io_.lock();
+        }
+      }
+
+      ~IoLock()
+      {
+        if (async_)
+        {
+          async_->io_.unlock();
+        }
+      }
+
+    private:
+      IoLock(const IoLock &);
+      IoLock & operator = (const IoLock &);
+
+      TAsync * async_;
+    };
+
+    //----------------------------------------------------------------
+    // TAsync
+    //
+    TAsync(ICacheDataProvider * provider):
+      provider_(provider),
+      stop_(false),
+      writeFailed_(false),
+      linesWritten_(0),
+      writes_(0)
+    {
+      thread_.start(&TAsync::threadLoop, this);
+    }
+
+    //----------------------------------------------------------------
+    // ~TAsync
+    //
+    ~TAsync()
+    {
+      cancelPrefetch(kEverything);
+
+      mutex_.lock();
+      stop_ = true;
+      wake_.notifyAll();
+      mutex_.unlock();
+
+      thread_.join();
+
+      while (!spare_.empty())
+      {
+        delete spare_.front();
+        spare_.pop_front();
+      }
+    }
+
+    //----------------------------------------------------------------
+    // threadLoop
+    //
+    static void threadLoop(void * context)
+    {
+      TAsync * async = (TAsync *)context;
+      async->work();
+    }
+
+    //----------------------------------------------------------------
+    // work
+    //
+    // queued writes take priority over prefetching, because the cache
+    // may be blocked waiting for the write queue to make room:
+    //
+    void work()
+    {
+      mutex_.lock();
+
+      while (true)
+      {
+        if (!writeQueue_.empty())
+        {
+          writing_.swap(writeQueue_);
+          mutex_.unlock();
+
+          uint64 numLines = 0;
+          uint64 numWrites = 0;
+          bool ok = writeOut(numLines, numWrites);
+
+          mutex_.lock();
+          linesWritten_ += numLines;
+          writes_ += numWrites;
+          writeFailed_ = writeFailed_ || !ok;
+
+          // recycle the line buffers:
+          for (TRequestList::iterator i = writing_.begin();
+               i != writing_.end(); ++i)
+          {
+            spare_.push_back(*i);
+          }
+
+          writing_.clear();
+          done_.notifyAll();
+          continue;
+        }
+
+        if (!readQueue_.empty())
+        {
+          TRequest * req = readQueue_.front();
+          readQueue_.pop_front();
+          req->busy_ = true;
+          mutex_.unlock();
+
+          std::size_t size = req->data_.size();
+          bool ok = false;
+          {
+            IoLock io(this);
+            ok = provider_->load(req->addr_, &size, &(req->data_[0]));
+          }
+
+          mutex_.lock();
+          req->busy_ = false;
+          req->done_ = true;
+          req->ok_ = ok;
+          req->size_ = ok ? size : 0;
+
+          if (req->cancelled_)
+          {
+            delete req;
+          }
+
+          done_.notifyAll();
+          continue;
+        }
+
+        if (stop_)
+        {
+          break;
+        }
+
+        wake_.wait(mutex_);
+      }
+
+      mutex_.unlock();
+    }
+
+    //----------------------------------------------------------------
+    // writeOut
+    //
+    // write out the lines being written, one provider call
+    // per run of adjacent lines; called without holding mutex_,
+    // the writing_ list is not modified by anyone else meanwhile:
+    //
+    bool writeOut(uint64 & numLines, uint64 & numWrites)
+    {
+      std::vector<TRequest *> reqs(writing_.begin(), writing_.end());
+      std::sort(reqs.begin(), reqs.end(), &TAsync::lessThan);
+
+      bool ok = true;
+      const std::size_t n = reqs.size();
+      std::size_t i = 0;
+
+      while (i < n)
+      {
+        // find a run of adjacent lines:
+        std::size_t j = i + 1;
+        std::size_t runSize = reqs[i]->size_;
+        while (j < n &&
+               reqs[j - 1]->size_ == reqs[j - 1]->data_.size() &&
+               reqs[j]->addr_ == reqs[j - 1]->addr_ + reqs[j - 1]->size_)
+        {
+          runSize += reqs[j]->size_;
+          j++;
+        }
+
+        const unsigned char * src = &(reqs[i]->data_[0]);
+        if (j - i > 1)
+        {
+          staging_.resize(runSize);
+          unsigned char * dst = &(staging_[0]);
+
+          for (std::size_t k = i; k < j; k++)
+          {
+            memcpy(dst, &(reqs[k]->data_[0]), reqs[k]->size_);
+            dst += reqs[k]->size_;
+          }
+
+          src = &(staging_[0]);
+        }
+
+        IoLock io(this);
+        ok = provider_->save(reqs[i]->addr_, runSize, src) && ok;
+        numLines += (j - i);
+        numWrites++;
+        i = j;
+      }
+
+      return ok;
+    }
+
+    //----------------------------------------------------------------
+    // lessThan
+    //
+    static bool lessThan(const TRequest * a, const TRequest * b)
+    { return a->addr_ < b->addr_; }
+
+    //----------------------------------------------------------------
+    // pendingWrite
+    //
+    // check whether a queued or in-flight write overlaps a line,
+    // mutex_ must be locked:
+    //
+    bool pendingWrite(uint64 head, std::size_t lineSize) const
+    {
+      const TRequestList * lists[] = { &writeQueue_, &writing_ };
+      for (std::size_t j = 0; j < 2; j++)
+      {
+        const TRequestList & reqs = *lists[j];
+        for (TRequestList::const_iterator i = reqs.begin();
+             i != reqs.end(); ++i)
+        {
+          const TRequest * req = *i;
+          if (req->addr_ < head + lineSize &&
+              head < req->addr_ + req->size_)
+          {
+            return true;
+          }
+        }
+      }
+
+      return false;
+    }
+
+    //----------------------------------------------------------------
+    // waitForWrites
+    //
+    // mutex_ must be locked:
+    //
+    void waitForWrites()
+    {
+      while (!writeQueue_.empty() || !writing_.empty())
+      {
+        done_.wait(mutex_);
+      }
+    }
+
+    //----------------------------------------------------------------
+    // discard
+    //
+    // drop a prefetch request that has been removed from prefetch_,
+    // mutex_ must be locked:
+    //
+    void discard(TRequest * req)
+    {
+      if (req->busy_)
+      {
+        req->cancelled_ = true;
+        return;
+      }
+
+      if (!req->done_)
+      {
+        readQueue_.remove(req);
+      }
+
+      delete req;
+    }
+
+    //----------------------------------------------------------------
+    // cancelPrefetch
+    //
+    // drop prefetched lines that start before the given address,
+    // returns the number of lines dropped:
+    //
+    std::size_t cancelPrefetch(uint64 addr)
+    {
+      Mutex::Lock lock(mutex_);
+      std::size_t numDropped = 0;
+
+      std::map<uint64, TRequest *>::iterator i = prefetch_.begin();
+      while (i != prefetch_.end() && i->first < addr)
+      {
+        discard(i->second);
+        prefetch_.erase(i++);
+        numDropped++;
+      }
+
+      return numDropped;
+    }
+
+    //----------------------------------------------------------------
+    // newRequest
+    //
+    // mutex_ must be locked:
+    //
+    TRequest * newRequest(uint64 addr, std::size_t lineSize)
+    {
+      TRequest * req = NULL;
+      if (spare_.empty())
+      {
+        req = new TRequest(addr);
+      }
+      else
+      {
+        // reuse the line buffer:
+        req = spare_.front();
+        spare_.pop_front();
+
+        req->addr_ = addr;
+        req->size_ = 0;
+        req->busy_ = false;
+        req->done_ = false;
+        req->ok_ = false;
+        req->cancelled_ = false;
+      }
+
+      req->data_.resize(lineSize);
+      return req;
+    }
+
+    // cancelPrefetch address that drops all prefetched lines:
+    static const uint64 kEverything = ~uint64(0);
+
+    ICacheDataProvider * provider_;
+    Thread thread_;
+
+    // guards everything except the provider:
+    Mutex mutex_;
+
+    // guards the provider:
+    Mutex io_;
+
+    // wakes up the background thread:
+    Condition wake_;
+
+    // signals completion of a prefetch or a batch of writes:
+    Condition done_;
+
+    bool stop_;
+
+    // prefetch requests keyed by line head, whether queued,
+    // busy or done; queued requests are also in readQueue_:
+    std::map<uint64, TRequest *> prefetch_;
+    TRequestList readQueue_;
+
+    // dirty lines waiting to be written out, and being written out:
+    TRequestList writeQueue_;
+    TRequestList writing_;
+
+    // written out requests, kept to recycle their line buffers:
+    TRequestList spare_;
+
+    // buffer for coalescing adjacent lines:
+    std::vector<unsigned char> staging_;
+
+    bool writeFailed_;
+    uint64 linesWritten_;
+    uint64 writes_;
+  };
+
+
+  //----------------------------------------------------------------
+  // TCache::TStats::TStats
+  //
+  TCache::TStats::TStats():
+    hits_(0),
+    misses_(0),
+    prefetched_(0),
+    prefetchUseful_(0),
+    linesWritten_(0),
+    writes_(0)
+  {}
+
+
   //----------------------------------------------------------------
   // TCache::TCache
   //
@@ -70,7 +502,12 @@ namespace Yamka
     provider_(provider),
     lineSize_(lineSize),
     numLines_(0),
-    age_(0)
+    age_(0),
+    async_(NULL),
+    readAhead_(0),
+    writeBehind_(0),
+    window_(1),
+    lastHead_(~uint64(0))
   {
     lines_.assign(maxLines, NULL);
   }
@@ -81,6 +518,7 @@ namespace Yamka
   TCache::~TCache()
   {
     clear();
+    delete async_;
   }
 
   //----------------------------------------------------------------
@@ -100,6 +538,10 @@ namespace Yamka
 
     numLines_ = 0;
     age_ = 0;
+
+    bool ok = drain();
+    assert(ok);
+    (void)ok;
   }
 
   //----------------------------------------------------------------
@@ -129,6 +571,10 @@ namespace Yamka
   void
   TCache::truncate(uint64 addr)
   {
+    // let the queued writes land before the data provider is truncated,
+    // and make sure nothing past the new end is being prefetched:
+    drain();
+
     // must properly align the address:
     uint64 head = addr - addr % lineSize_;
 
@@ -161,13 +607,26 @@ namespace Yamka
       return true;
     }
 
+    if (writeBehind_)
+    {
+      writeBehind(line);
+      return true;
+    }
+
     // must flush the line:
     const unsigned char * src = &(line->data_[0]);
     std::size_t numBytes = (std::size_t)(line->tail_ - line->head_);
 
+    TAsync::IoLock io(async_);
     bool ok = provider_->save(line->head_, numBytes, src);
     line->dirty_ = !ok;
 
+    if (ok)
+    {
+      stats_.linesWritten_++;
+      stats_.writes_++;
+    }
+
     assert(ok);
     return ok;
   }
@@ -246,21 +705,44 @@ namespace Yamka
   TCache::getLine(uint64 addr)
   {
     TLine * line = lookup(addr);
-    if (!line)
+    if (line)
+    {
+      stats_.hits_++;
+    }
+    else
     {
+      stats_.misses_++;
       line = addLine(addr);
     }
 
-    if (line && !line->ready_)
+    if (line && !line->ready_ && !takePrefetched(line))
     {
       // must properly align the address:
       uint64 head = addr - addr % lineSize_;
+
+      if (async_)
+      {
+        // don't read around a write that hasn't landed yet:
+        Mutex::Lock lock(async_->mutex_);
+        if (async_->pendingWrite(head, lineSize_))
+        {
+          async_->waitForWrites();
+        }
+      }
+
       std::size_t numBytes = lineSize_;
       unsigned char * dst = &(line->data_[0]);
+
+      TAsync::IoLock io(async_);
       line->ready_ = provider_->load(head, &numBytes, dst);
       line->tail_ = head + numBytes;
     }
 
+    if (line && readAhead_)
+    {
+      readAhead(line);
+    }
+
     return line;
   }
 
@@ -386,4 +868,288 @@ namespace Yamka
     resize(lines_.size(), z);
   }
 
+  //----------------------------------------------------------------
+  // TCache::setReadAhead
+  //
+  void
+  TCache::setReadAhead(std::size_t maxLines)
+  {
+    if (async_)
+    {
+      async_->cancelPrefetch(TAsync::kEverything);
+    }
+
+    readAhead_ = maxLines;
+    window_ = 1;
+    lastHead_ = ~uint64(0);
+
+    if (readAhead_ && !async_)
+    {
+      async_ = new TAsync(provider_);
+
+      if (!async_->thread_.isRunning())
+      {
+        delete async_;
+        async_ = NULL;
+        readAhead_ = 0;
+      }
+    }
+    else if (!readAhead_ && !writeBehind_ && async_)
+    {
+      drain();
+      delete async_;
+      async_ = NULL;
+    }
+  }
+
+  //----------------------------------------------------------------
+  // TCache::setWriteBehind
+  //
+  void
+  TCache::setWriteBehind(std::size_t maxLines)
+  {
+    drain();
+    writeBehind_ = maxLines;
+
+    if (writeBehind_ && !async_)
+    {
+      async_ = new TAsync(provider_);
+
+      if (!async_->thread_.isRunning())
+      {
+        delete async_;
+        async_ = NULL;
+        writeBehind_ = 0;
+      }
+    }
+    else if (!readAhead_ && !writeBehind_ && async_)
+    {
+      delete async_;
+      async_ = NULL;
+    }
+  }
+
+  //----------------------------------------------------------------
+  // TCache::stats
+  //
+  TCache::TStats
+  TCache::stats() const
+  {
+    TStats stats = stats_;
+
+    if (async_)
+    {
+      Mutex::Lock lock(async_->mutex_);
+      stats.linesWritten_ += async_->linesWritten_;
+      stats.writes_ += async_->writes_;
+    }
+
+    return stats;
+  }
+
+  //----------------------------------------------------------------
+  // TCache::resetStats
+  //
+  void
+  TCache::resetStats()
+  {
+    stats_ = TStats();
+
+    if (async_)
+    {
+      Mutex::Lock lock(async_->mutex_);
+      async_->linesWritten_ = 0;
+      async_->writes_ = 0;
+    }
+  }
+
+  //----------------------------------------------------------------
+  // TCache::cached
+  //
+  // same as lookup, but without touching the line age:
+  //
+  bool
+  TCache::cached(uint64 head) const
+  {
+    for (std::size_t i = 0; i < numLines_; i++)
+    {
+      if (lines_[i]->head_ == head)
+      {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  //----------------------------------------------------------------
+  // TCache::takePrefetched
+  //
+  // fill the line with prefetched data, if there is any,
+  // waiting for the prefetch to finish if necessary:
+  //
+  bool
+  TCache::takePrefetched(TLine * line)
+  {
+    if (!async_ || !readAhead_)
+    {
+      return false;
+    }
+
+    Mutex::Lock lock(async_->mutex_);
+
+    typedef std::map<uint64, TAsync::TRequest *>::iterator TIter;
+    TIter found = async_->prefetch_.find(line->head_);
+    if (found == async_->prefetch_.end())
+    {
+      return false;
+    }
+
+    TAsync::TRequest * req = found->second;
+    if (!req->busy_ && !req->done_)
+    {
+      // still queued, it's quicker to load it directly:
+      async_->prefetch_.erase(found);
+      async_->discard(req);
+      return false;
+    }
+
+    while (!req->done_)
+    {
+      async_->done_.wait(async_->mutex_);
+    }
+
+    async_->prefetch_.erase(found);
+
+    if (!req->ok_ || req->data_.size() != line->data_.size())
+    {
+      delete req;
+      return false;
+    }
+
+    line->data_.swap(req->data_);
+    line->tail_ = line->head_ + req->size_;
+    line->ready_ = true;
+    async_->spare_.push_back(req);
+
+    stats_.prefetchUseful_++;
+    window_ = std::min(readAhead_, window_ * 2);
+    return true;
+  }
+
+  //----------------------------------------------------------------
+  // TCache::readAhead
+  //
+  // detect a sequential access pattern and prefetch the lines
+  // that follow the given line:
+  //
+  void
+  TCache::readAhead(const TLine * line)
+  {
+    uint64 head = line->head_;
+    if (head == lastHead_)
+    {
+      return;
+    }
+
+    // moving forward by no more than the read-ahead window
+    // (skipping over some data) still counts as sequential:
+    bool sequential =
+      lastHead_ != ~uint64(0) &&
+      lastHead_ < head &&
+      head <= lastHead_ + lineSize_ * (window_ + 1);
+
+    lastHead_ = head;
+
+    // the lines prefetched for another position were wasted:
+    uint64 keep = sequential ? head : TAsync::kEverything;
+    if (async_->cancelPrefetch(keep))
+    {
+      window_ = std::max<std::size_t>(1, window_ / 2);
+    }
+
+    // don't read past the end of data:
+    if (!sequential || line->tail_ < head + lineSize_)
+    {
+      return;
+    }
+
+    Mutex::Lock lock(async_->mutex_);
+    bool queued = false;
+
+    for (std::size_t i = 1;
+         i <= window_ && async_->prefetch_.size() < readAhead_;
+         i++)
+    {
+      uint64 next = head + lineSize_ * i;
+      if (cached(next) ||
+          async_->prefetch_.find(next) != async_->prefetch_.end() ||
+          async_->pendingWrite(next, lineSize_))
+      {
+        continue;
+      }
+
+      TAsync::TRequest * req = async_->newRequest(next, lineSize_);
+      async_->prefetch_[next] = req;
+      async_->readQueue_.push_back(req);
+      stats_.prefetched_++;
+      queued = true;
+    }
+
+    if (queued)
+    {
+      async_->wake_.notifyAll();
+    }
+  }
+
+  //----------------------------------------------------------------
+  // TCache::writeBehind
+  //
+  // hand the dirty line data over to the background thread,
+  // waiting if too many lines are already queued:
+  //
+  void
+  TCache::writeBehind(TLine * line)
+  {
+    Mutex::Lock lock(async_->mutex_);
+
+    while (async_->writeQueue_.size() >= writeBehind_)
+    {
+      async_->done_.wait(async_->mutex_);
+    }
+
+    TAsync::TRequest * req = async_->newRequest(line->head_, lineSize_);
+    req->size_ = (std::size_t)(line->tail_ - line->head_);
+    req->data_.swap(line->data_);
+    line->dirty_ = false;
+
+    async_->writeQueue_.push_back(req);
+    async_->wake_.notifyAll();
+  }
+
+  //----------------------------------------------------------------
+  // TCache::drain
+  //
+  // drop all prefetched lines and wait for the queued writes to land,
+  // returns false if any of the queued writes failed:
+  //
+  bool
+  TCache::drain()
+  {
+    if (!async_)
+    {
+      return true;
+    }
+
+    async_->cancelPrefetch(TAsync::kEverything);
+    lastHead_ = ~uint64(0);
+
+    Mutex::Lock lock(async_->mutex_);
+    async_->waitForWrites();
+
+    bool ok = !async_->writeFailed_;
+    async_->writeFailed_ = false;
+    return ok;
+  }
+
 }
@@ -43,6 +43,11 @@ namespace Yamka
   //----------------------------------------------------------------
   // TCache
   //
+  // Line cache over an ICacheDataProvider.  Optionally a background
+  // thread can read ahead of a sequential access pattern and write
+  // evicted dirty lines behind the caller.  The cache itself is not
+  // thread safe, it must be used from one thread at a time.
+  //
   class TCache
   {
     // intentionally disabled:
@@ -71,14 +76,76 @@ namespace Yamka
     std::size_t load(uint64 addr, std::size_t size, unsigned char * dst);
     std::size_t save(uint64 addr, std::size_t size, const unsigned char * src);
 
+    // prefetch up to maxLines lines past a sequential access pattern
+    // on a background thread, the read-ahead window grows while
+    // the prefetched lines are being used and shrinks when they are not;
+    // 0 disables read-ahead:
+    void setReadAhead(std::size_t maxLines);
+
+    // queue up to maxLines evicted dirty lines for a background thread
+    // to write out, adjacent lines are coalesced into one write;
+    // 0 disables write-behind:
+    void setWriteBehind(std::size_t maxLines);
+
+    //----------------------------------------------------------------
+    // TStats
+    //
+    struct TStats
+    {
+      TStats();
+
+      // line lookups satisfied by the cache:
+      uint64 hits_;
+
+      // line lookups that were not, including those
+      // satisfied by the read-ahead:
+      uint64 misses_;
+
+      // lines requested by the read-ahead,
+      // and how many of those were actually used:
+      uint64 prefetched_;
+      uint64 prefetchUseful_;
+
+      // dirty lines written out, and the number of
+      // data provider save calls it took (fewer when coalesced):
+      uint64 linesWritten_;
+      uint64 writes_;
+    };
+
+    TStats stats() const;
+    void resetStats();
+
   protected:
     void adjustLineSize(std::size_t requestSize);
 
+    struct TAsync;
+
+    // read-ahead and write-behind helpers:
+    bool cached(uint64 head) const;
+    bool takePrefetched(TLine * line);
+    void readAhead(const TLine * line);
+    void writeBehind(TLine * line);
+    bool drain();
+
     ICacheDataProvider * provider_;
     std::size_t lineSize_;
     std::size_t numLines_;
     std::vector<TLine *> lines_;
     uint64 age_;
+
+    // background thread state, NULL unless
+    // read-ahead or write-behind is enabled:
+    TAsync * async_;
+    std::size_t readAhead_;
+    std::size_t writeBehind_;
+
+    // current read-ahead window, in lines:
+    std::size_t window_;
+
+    // line head of the most recent access:
+    uint64 lastHead_;
+
+    TStats stats_;
   };
 }
 
@@ -10,26 +10,403 @@
 #include <yamkaCrc32.h>
 
 // boost includes:
-#include <boost/crc.hpp>
+#include <boost/cstdint.hpp>
+
+// PCLMULQDQ folding is only available on x86, and requires a compiler
+// that can build SSE 4.1 + PCLMUL code without global -m flags:
+#if (defined(__x86_64__) || defined(__i386__) ||                     \
+     defined(_M_X64) || defined(_M_IX86)) &&                          \
+  (defined(_MSC_VER) || defined(__clang__) ||                         \
+   (defined(__GNUC__) &&                                              \
+    (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#define YAMKA_CRC32_PCLMUL 1
+#endif
+
+// system includes:
+#ifdef YAMKA_CRC32_PCLMUL
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#include <emmintrin.h>
+#include <smmintrin.h>
+#include <wmmintrin.h>
+#endif
+
+#if defined(YAMKA_CRC32_PCLMUL) && !defined(_MSC_VER)
+#define YAMKA_TARGET_PCLMUL __attribute__((target("pclmul,sse4.1")))
+#else
+#define YAMKA_TARGET_PCLMUL
+#endif
 
 
 namespace Yamka
 {
 
+  //----------------------------------------------------------------
+  // TCrc32Update
+  //
+  // update a pre-conditioned (inverted) CRC-32 register:
+  //
+  typedef boost::uint32_t(*TCrc32Update)(boost::uint32_t crc,
+                                         const unsigned char * data,
+                                         std::size_t size);
+
+  //----------------------------------------------------------------
+  // TCrc32Tables
+  //
+  // lookup tables for the reflected CRC-32 polynomial 0xEDB88320,
+  // same as boost::crc_32_type and zlib:
+  //
+  struct TCrc32Tables
+  {
+    TCrc32Tables()
+    {
+      for (boost::uint32_t i = 0; i < 256; i++)
+      {
+        boost::uint32_t crc = i;
+        for (int j = 0; j < 8; j++)
+        {
+          crc = (crc & 1) ? ((crc >> 1) ^ 0xEDB88320) : (crc >> 1);
+        }
+
+        table_[0][i] = crc;
+      }
+
+      for (int k = 1; k < 8; k++)
+      {
+        for (int i = 0; i < 256; i++)
+        {
+          boost::uint32_t crc = table_[k - 1][i];
+          table_[k][i] = (crc >> 8) ^ table_[0][crc & 0xFF];
+        }
+      }
+    }
+
+    // table_[k][i] is the CRC of byte i followed by k zero bytes:
+    boost::uint32_t table_[8][256];
+  };
+
+  //----------------------------------------------------------------
+  // crc32Tables
+  //
+  static const TCrc32Tables &
+  crc32Tables()
+  {
+    static const TCrc32Tables tables;
+    return tables;
+  }
+
+  // make sure the tables are built before main starts
+  // and any other threads get a chance to race for them:
+  static const TCrc32Tables & crc32TablesInit = crc32Tables();
+
+  //----------------------------------------------------------------
+  // crc32Bytewise
+  //
+  static boost::uint32_t
+  crc32Bytewise(boost::uint32_t crc,
+                const unsigned char * data,
+                std::size_t size)
+  {
+    const boost::uint32_t * t = crc32Tables().table_[0];
+    const unsigned char * end = data + size;
+
+    for (; data < end; ++data)
+    {
+      crc = (crc >> 8) ^ t[(crc ^ *data) & 0xFF];
+    }
+
+    return crc;
+  }
+
+  //----------------------------------------------------------------
+  // load32
+  //
+  // little-endian load, endian neutral and alignment neutral,
+  // compilers turn this into a single load where they can:
+  //
+  static inline boost::uint32_t
+  load32(const unsigned char * p)
+  {
+    return (boost::uint32_t(p[0]) |
+            boost::uint32_t(p[1]) << 8 |
+            boost::uint32_t(p[2]) << 16 |
+            boost::uint32_t(p[3]) << 24);
+  }
+
+  //----------------------------------------------------------------
+  // crc32SliceBy8
+  //
+  static boost::uint32_t
+  crc32SliceBy8(boost::uint32_t crc,
+                const unsigned char * data,
+                std::size_t size)
+  {
+    const TCrc32Tables & tables = crc32Tables();
+    const boost::uint32_t (*t)[256] = tables.table_;
+
+    for (; size >= 8; size -= 8, data += 8)
+    {
+      boost::uint32_t one = crc ^ load32(data);
+      boost::uint32_t two = load32(data + 4);
+
+      crc = (t[7][one & 0xFF] ^
+             t[6][(one >> 8) & 0xFF] ^
+             t[5][(one >> 16) & 0xFF] ^
+             t[4][one >> 24] ^
+             t[3][two & 0xFF] ^
+             t[2][(two >> 8) & 0xFF] ^
+             t[1][(two >> 16) & 0xFF] ^
+             t[0][two >> 24]);
+    }
+
+    return crc32Bytewise(crc, data, size);
+  }
+
+#ifdef YAMKA_CRC32_PCLMUL
+  //----------------------------------------------------------------
+  // cpuHasPclmul
+  //
+  static bool
+  cpuHasPclmul()
+  {
+    unsigned int ecx = 0;
+
+#ifdef _MSC_VER
+    int info[4] = { 0 };
+    __cpuid(info, 1);
+    ecx = (unsigned int)(info[2]);
+#else
+    unsigned int eax = 0;
+    unsigned int ebx = 0;
+    unsigned int edx = 0;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+    {
+      return false;
+    }
+#endif
+
+    // CPUID.1:ECX bit 1 is PCLMULQDQ, bit 19 is SSE 4.1:
+    return (ecx & (1 << 1)) && (ecx & (1 << 19));
+  }
+
+  //----------------------------------------------------------------
+  // crc32Fold64
+  //
+  // Fold 64 byte blocks with carry-less multiplication,
+  // then reduce to 32 bits with Barrett reduction, see
+  // "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ
+  // Instruction", V. Gopal et al, Intel 2009.
+  //
+  // size must be a multiple of 16, and at least 64:
+  //
+  YAMKA_TARGET_PCLMUL
+  static boost::uint32_t
+  crc32Fold64(boost::uint32_t crc,
+              const unsigned char * data,
+              std::size_t size)
+  {
+    // x^(4*128+32) mod P, x^(4*128-32) mod P (bit reflected):
+    const __m128i k1k2 = _mm_set_epi32(0x00000001, 0xC6E41596,
+                                       0x00000001, 0x54442BD4);
+
+    // x^(128+32) mod P, x^(128-32) mod P:
+    const __m128i k3k4 = _mm_set_epi32(0x00000000, 0xCCAA009E,
+                                       0x00000001, 0x751997D0);
+
+    // x^64 mod P:
+    const __m128i k5k0 = _mm_set_epi32(0x00000000, 0x00000000,
+                                       0x00000001, 0x63CD6124);
+
+    // P and floor(x^64 / P):
+    const __m128i poly = _mm_set_epi32(0x00000001, 0xF7011641,
+                                       0x00000001, 0xDB710641);
+
+    const __m128i mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+
+    __m128i x1 = _mm_loadu_si128((const __m128i *)(data + 0x00));
+    __m128i x2 = _mm_loadu_si128((const __m128i *)(data + 0x10));
+    __m128i x3 = _mm_loadu_si128((const __m128i *)(data + 0x20));
+    __m128i x4 = _mm_loadu_si128((const __m128i *)(data + 0x30));
+    __m128i x5;
+
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int)crc));
+    data += 64;
+    size -= 64;
+
+    // fold 4 x 128 bits in parallel:
+    while (size >= 64)
+    {
+      __m128i x6, x7, x8;
+
+      x5 = _mm_clmulepi64_si128(x1, k1k2, 0x00);
+      x6 = _mm_clmulepi64_si128(x2, k1k2, 0x00);
+      x7 = _mm_clmulepi64_si128(x3, k1k2, 0x00);
+      x8 = _mm_clmulepi64_si128(x4, k1k2, 0x00);
+
+      x1 = _mm_clmulepi64_si128(x1, k1k2, 0x11);
+      x2 = _mm_clmulepi64_si128(x2, k1k2, 0x11);
+      x3 = _mm_clmulepi64_si128(x3, k1k2, 0x11);
+      x4 = _mm_clmulepi64_si128(x4, k1k2, 0x11);
+
+      x1 = _mm_xor_si128(_mm_xor_si128(x1, x5),
+                         _mm_loadu_si128((const __m128i *)(data + 0x00)));
+      x2 = _mm_xor_si128(_mm_xor_si128(x2, x6),
+                         _mm_loadu_si128((const __m128i *)(data + 0x10)));
+      x3 = _mm_xor_si128(_mm_xor_si128(x3, x7),
+                         _mm_loadu_si128((const __m128i *)(data + 0x20)));
+      x4 = _mm_xor_si128(_mm_xor_si128(x4, x8),
+                         _mm_loadu_si128((const __m128i *)(data + 0x30)));
+
+      data += 64;
+      size -= 64;
+    }
+
+    // fold 4 x 128 bits into 128 bits:
+    x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+    x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+
+    x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+    // fold the remaining 128 bit blocks, one at a time:
+    while (size >= 16)
+    {
+      x2 = _mm_loadu_si128((const __m128i *)data);
+
+      x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+      x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+      x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+      data += 16;
+      size -= 16;
+    }
+
+    // fold 128 bits into 64 bits:
+    x2 = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+    x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_and_si128(x1, mask32);
+    x1 = _mm_clmulepi64_si128(x1, k5k0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    // Barrett reduction to 32 bits:
+    x2 = _mm_and_si128(x1, mask32);
+    x2 = _mm_clmulepi64_si128(x2, poly, 0x10);
+    x2 = _mm_and_si128(x2, mask32);
+    x2 = _mm_clmulepi64_si128(x2, poly, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    return (boost::uint32_t)_mm_extract_epi32(x1, 1);
+  }
+
+  //----------------------------------------------------------------
+  // crc32Pclmul
+  //
+  static boost::uint32_t
+  crc32Pclmul(boost::uint32_t crc,
+              const unsigned char * data,
+              std::size_t size)
+  {
+    if (size >= 64)
+    {
+      std::size_t folded = size & ~std::size_t(15);
+      crc = crc32Fold64(crc, data, folded);
+      data += folded;
+      size -= folded;
+    }
+
+    return crc32SliceBy8(crc, data, size);
+  }
+#endif
+
+  //----------------------------------------------------------------
+  // crc32Update
+  //
+  static TCrc32Update
+  crc32Update(Crc32::Engine engine)
+  {
+    if (engine == Crc32::kAuto || !Crc32::supported(engine))
+    {
+      engine = Crc32::fastest();
+    }
+
+#ifdef YAMKA_CRC32_PCLMUL
+    if (engine == Crc32::kPclmul)
+    {
+      return &crc32Pclmul;
+    }
+#endif
+
+    if (engine == Crc32::kBytewise)
+    {
+      return &crc32Bytewise;
+    }
+
+    return &crc32SliceBy8;
+  }
+
+
+  //----------------------------------------------------------------
+  // Crc32::supported
+  //
+  bool
+  Crc32::supported(Crc32::Engine engine)
+  {
+    if (engine == kPclmul)
+    {
+#ifdef YAMKA_CRC32_PCLMUL
+      static const bool hasPclmul = cpuHasPclmul();
+      return hasPclmul;
+#else
+      return false;
+#endif
+    }
+
+    return true;
+  }
+
+  //----------------------------------------------------------------
+  // Crc32::fastest
+  //
+  Crc32::Engine
+  Crc32::fastest()
+  {
+    return supported(kPclmul) ? kPclmul : kSliceBy8;
+  }
+
+  // make sure CPU detection happens before main starts:
+  static const Crc32::Engine crc32FastestInit = Crc32::fastest();
+
   //----------------------------------------------------------------
   // Crc32::Private
   //
   class Crc32::Private
   {
   public:
-    boost::crc_32_type checksum_;
+    Private(Crc32::Engine engine):
+      update_(crc32Update(engine)),
+      crc_(0xFFFFFFFF)
+    {}
+
+    TCrc32Update update_;
+    boost::uint32_t crc_;
   };
 
   //----------------------------------------------------------------
   // Crc32::Crc32
   //
-  Crc32::Crc32():
-    private_(new Crc32::Private)
+  Crc32::Crc32(Crc32::Engine engine):
+    private_(new Crc32::Private(engine))
   {}
 
   //----------------------------------------------------------------
@@ -46,7 +423,9 @@ namespace Yamka
   void
   Crc32::compute(const void * bytes, std::size_t numBytes)
   {
-    private_->checksum_.process_bytes(bytes, numBytes);
+    private_->crc_ = private_->update_(private_->crc_,
+                                       (const unsigned char *)bytes,
+                                       numBytes);
   }
 
   //----------------------------------------------------------------
@@ -55,7 +434,7 @@ namespace Yamka
   unsigned int
   Crc32::checksum() const
   {
-    unsigned int crc32 = private_->checksum_.checksum();
+    unsigned int crc32 = private_->crc_ ^ 0xFFFFFFFF;
     return crc32;
   }
 }
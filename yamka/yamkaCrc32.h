@@ -21,7 +21,35 @@ namespace Yamka
   //
   struct Crc32
   {
-    Crc32();
+    //----------------------------------------------------------------
+    // Engine
+    //
+    // CRC-32 implementation, all produce identical checksums:
+    //
+    enum Engine
+    {
+      // pick the fastest engine supported by the CPU:
+      kAuto = 0,
+
+      // classic table lookup, 1 byte per step:
+      kBytewise = 1,
+
+      // 8 lookup tables, 8 bytes per step:
+      kSliceBy8 = 2,
+
+      // carry-less multiplication folding (x86 PCLMULQDQ, SSE 4.1),
+      // 64 bytes per step, with slice-by-8 for the leftovers:
+      kPclmul = 3
+    };
+
+    // check whether a given engine can run on this CPU:
+    static bool supported(Engine engine);
+
+    // the engine kAuto resolves to:
+    static Engine fastest();
+
+    // unsupported engines fall back to kAuto:
+    Crc32(Engine engine = kAuto);
     ~Crc32();
 
     // process data to compute the checksum:
@@ -316,6 +316,10 @@ namespace Yamka
     //
     bool setSize(TFileOffset size)
     {
+      // truncate the cache first, so that any writes it queued
+      // in the background land before the file is truncated:
+      cache_->truncate(size);
+
       int fd = fileno(file_);
       int error = ftruncate(fd, size);
 
@@ -330,7 +334,6 @@ namespace Yamka
         pos_ = size;
       }
 
-      cache_->truncate(size);
       end_ = size;
       return true;
     }
@@ -617,8 +620,9 @@ namespace Yamka
       return false;
     }
 
+    // large passes let Crc32 use its block algorithms:
     std::size_t bytesPerPass =
-      (std::size_t)(std::min<uint64>(4096, totalBytesToRead));
+      (std::size_t)(std::min<uint64>(65536, totalBytesToRead));
 
     std::vector<unsigned char> data(bytesPerPass);
     unsigned char * dataPtr = &data[0];
@@ -79,14 +79,23 @@ namespace Yamka
 
     for (TReceiptPtrCIter i = receipts_.begin(); i != receipts_.end(); ++i)
     {
-      IStorage::IReceiptPtr srcReceipt = *i;
+      const IStorage::IReceiptPtr & srcReceipt = *i;
       IStorage::IReceiptPtr dstReceipt;
 
+      // shortcut:
+      const unsigned char * srcData = srcReceipt->data();
+
       if (isNullStorage)
       {
         // don't bother copying the data when saving to NULL storage:
         dstReceipt = storage.skipWithReceipt(srcReceipt->numBytes());
       }
+      else if (srcData)
+      {
+        // no need to load a copy of the data first:
+        dstReceipt = storage.save(srcData,
+                                  (std::size_t)(srcReceipt->numBytes()));
+      }
       else
       {
         TByteVec data;
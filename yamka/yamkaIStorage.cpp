@@ -37,12 +37,19 @@ namespace Yamka
   IStorage::IReceiptPtr
   IStorage::IReceipt::saveTo(IStorage & storage, std::size_t maxChunkSz) const
   {
+    const uint64 dataSize = this->numBytes();
+    const unsigned char * addr = this->data();
+    if (addr && dataSize)
+    {
+      // no need to copy the data piece-wise:
+      return storage.save(addr, (std::size_t)dataSize);
+    }
+
     IReceiptPtr receipt = storage.receipt();
 
     std::vector<unsigned char> chunkBuffer(maxChunkSz);
     unsigned char * chunk = &chunkBuffer[0];
 
-    const uint64 dataSize = this->numBytes();
     uint64 offset = 0;
 
     while (offset < dataSize)
@@ -641,6 +648,16 @@ namespace Yamka
                                              (std::size_t)size));
   }
 
+  //----------------------------------------------------------------
+  // HodgePodgeStorage::Receipt::data
+  //
+  const unsigned char *
+  HodgePodgeStorage::Receipt::data() const
+  {
+    const TStorage & bytes = *bytesPtr_;
+    return bytes.empty() ? NULL : &bytes[0] + position_;
+  }
+
 
   //----------------------------------------------------------------
   // MemReceipt::MemReceipt
@@ -181,6 +181,13 @@ namespace Yamka
       // to the given storage, return resulting storage receipt:
       virtual IReceiptPtr saveTo(IStorage & storage,
                                  std::size_t maxChunkSize = 4096) const;
+
+      // if the data referenced by this receipt is directly addressable
+      // (memory, memory mapped file) return a pointer to it,
+      // so it can be accessed without making a copy;
+      // otherwise return NULL and the data must be loaded:
+      virtual const unsigned char * data() const
+      { return NULL; }
     };
 
     // If a storage implementation does not actually load/save
@@ -388,6 +395,9 @@ namespace Yamka
       // virtual:
       IReceiptPtr receipt(uint64 offset, uint64 size) const;
 
+      // virtual:
+      const unsigned char * data() const;
+
     protected:
       TStoragePtr bytesPtr_;
       std::size_t position_;
@@ -427,6 +437,10 @@ namespace Yamka
     // virtual: use at your own risk:
     IStorage::IReceiptPtr receipt(uint64 offset, uint64 size) const;
 
+    // virtual:
+    const unsigned char * data() const
+    { return addr_; }
+
   protected:
     unsigned char * addr_;
     std::size_t numBytes_;
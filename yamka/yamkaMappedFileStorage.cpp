@@ -0,0 +1,445 @@
+// -*- Mode: c++; tab-width: 8; c-basic-offset: 2; indent-tabs-mode: nil -*-
+// NOTE: the first line of this file sets up source code indentation rules
+// for Emacs; it is also a hint to anyone modifying this file.
+
+// Created   : Fri Oct 16 23:12:40 MDT 2026
+// Copyright : Pavel Koshevoy
+// License   : MIT -- http://www.opensource.org/licenses/mit-license.php
+
+// windows includes:
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// yamka includes:
+#include <yamkaFile.h>
+#include <yamkaFileStorage.h>
+#include <yamkaMappedFileStorage.h>
+
+// system includes:
+#include <assert.h>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string.h>
+
+
+namespace Yamka
+{
+
+  //----------------------------------------------------------------
+  // MappedFile::MappedFile
+  //
+  MappedFile::MappedFile(const std::string & pathUTF8):
+    data_(NULL),
+    size_(0)
+#ifdef _WIN32
+    ,
+    file_(NULL),
+    mapping_(NULL)
+#endif
+  {
+    if (!pathUTF8.empty())
+    {
+      open(pathUTF8);
+    }
+  }
+
+  //----------------------------------------------------------------
+  // MappedFile::~MappedFile
+  //
+  MappedFile::~MappedFile()
+  {
+    close();
+  }
+
+  //----------------------------------------------------------------
+  // MappedFile::open
+  //
+  bool
+  MappedFile::open(const std::string & pathUTF8)
+  {
+    close();
+
+#ifdef _WIN32
+    wchar_t * wname = utf8_to_utf16(pathUTF8.c_str());
+    HANDLE file = CreateFileW(wname,
+                              GENERIC_READ,
+                              FILE_SHARE_READ,
+                              NULL,
+                              OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL,
+                              NULL);
+    free(wname);
+
+    if (file == INVALID_HANDLE_VALUE)
+    {
+      return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) ||
+        fileSize.QuadPart <= 0 ||
+        uint64(fileSize.QuadPart) > std::numeric_limits<std::size_t>::max())
+    {
+      CloseHandle(file);
+      return false;
+    }
+
+    HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!mapping)
+    {
+      CloseHandle(file);
+      return false;
+    }
+
+    void * addr = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!addr)
+    {
+      CloseHandle(mapping);
+      CloseHandle(file);
+      return false;
+    }
+
+    file_ = file;
+    mapping_ = mapping;
+    size_ = uint64(fileSize.QuadPart);
+#else
+    int fd = ::open(pathUTF8.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+      return false;
+    }
+
+    // only regular non-empty files can be mapped,
+    // pipes and devices must go through FileStorage:
+    struct stat st;
+    if (fstat(fd, &st) != 0 ||
+        !S_ISREG(st.st_mode) ||
+        st.st_size <= 0 ||
+        uint64(st.st_size) > std::numeric_limits<std::size_t>::max())
+    {
+      ::close(fd);
+      return false;
+    }
+
+    void * addr = mmap(NULL, (std::size_t)st.st_size,
+                       PROT_READ, MAP_PRIVATE, fd, 0);
+
+    // the mapping stays valid after the descriptor is closed:
+    ::close(fd);
+
+    if (addr == MAP_FAILED)
+    {
+      return false;
+    }
+
+    size_ = uint64(st.st_size);
+#endif
+
+    data_ = (const unsigned char *)addr;
+    filename_ = pathUTF8;
+    return true;
+  }
+
+  //----------------------------------------------------------------
+  // MappedFile::close
+  //
+  void
+  MappedFile::close()
+  {
+    if (data_)
+    {
+#ifdef _WIN32
+      UnmapViewOfFile(data_);
+      CloseHandle((HANDLE)mapping_);
+      CloseHandle((HANDLE)file_);
+      mapping_ = NULL;
+      file_ = NULL;
+#else
+      munmap(const_cast<unsigned char *>(data_), (std::size_t)size_);
+#endif
+    }
+
+    data_ = NULL;
+    size_ = 0;
+    filename_.clear();
+  }
+
+  //----------------------------------------------------------------
+  // MappedFile::calcCrc32
+  //
+  bool
+  MappedFile::calcCrc32(uint64 seekToPosition,
+                        uint64 numBytesToRead,
+                        Crc32 & computeCrc32) const
+  {
+    if (!numBytesToRead)
+    {
+      return true;
+    }
+
+    if (seekToPosition + numBytesToRead > size_)
+    {
+      return false;
+    }
+
+    computeCrc32.compute(data_ + seekToPosition,
+                         (std::size_t)numBytesToRead);
+    return true;
+  }
+
+
+  //----------------------------------------------------------------
+  // MappedFileStorage::MappedFileStorage
+  //
+  MappedFileStorage::MappedFileStorage(const std::string & pathUTF8):
+    file_(new MappedFile(pathUTF8)),
+    posn_(0)
+  {}
+
+  //----------------------------------------------------------------
+  // MappedFileStorage::receipt
+  //
+  IStorage::IReceiptPtr
+  MappedFileStorage::receipt() const
+  {
+    return IStorage::IReceiptPtr(new Receipt(file_, posn_));
+  }
+
+  //----------------------------------------------------------------
+  // MappedFileStorage::save
+  //
+  IStorage::IReceiptPtr
+  MappedFileStorage::save(const unsigned char * data, std::size_t size)
+  {
+    (void) data;
+    (void) size;
+    assert(false);
+    return IStorage::IReceiptPtr();
+  }
+
+  //----------------------------------------------------------------
+  // MappedFileStorage::load
+  //
+  IStorage::IReceiptPtr
+  MappedFileStorage::load(unsigned char * data, std::size_t size)
+  {
+    if (posn_ + size > file_->size())
+    {
+      return IStorage::IReceiptPtr();
+    }
+
+    IStorage::IReceiptPtr receipt(new Receipt(file_, posn_, size));
+    memcpy(data, file_->data() + posn_, size);
+    posn_ += size;
+    return receipt;
+  }
+
+  //----------------------------------------------------------------
+  // MappedFileStorage::peek
+  //
+  std::size_t
+  MappedFileStorage::peek(unsigned char * data, std::size_t size)
+  {
+    uint64 fileSize = file_->size();
+    if (posn_ >= fileSize)
+    {
+      return 0;
+    }
+
+    std::size_t nbytes =
+      (posn_ + size <= fileSize) ?
+      size :
+      (std::size_t)(fileSize - posn_);
+
+    memcpy(data, file_->data() + posn_, nbytes);
+    return nbytes;
+  }
+
+  //----------------------------------------------------------------
+  // MappedFileStorage::skip
+  //
+  uint64
+  MappedFileStorage::skip(uint64 numBytes)
+  {
+    // same as FileStorage, skipping past the end of the file
+    // is allowed, but nothing can be loaded from there:
+    posn_ += numBytes;
+    return numBytes;
+  }
+
+  //----------------------------------------------------------------
+  // MappedFileStorage::seekTo
+  //
+  void
+  MappedFileStorage::seekTo(uint64 absolutePosition)
+  {
+    if (!file_->isOpen())
+    {
+      std::ostringstream oss;
+      oss << "MappedFileStorage::seekTo(" << absolutePosition << ") failed";
+
+      throw std::runtime_error(oss.str());
+    }
+
+    posn_ = absolutePosition;
+  }
+
+  //----------------------------------------------------------------
+  // MappedFileStorage::Receipt::Receipt
+  //
+  MappedFileStorage::Receipt::Receipt(const TMappedFilePtr & file,
+                                      uint64 addr,
+                                      uint64 numBytes):
+    file_(file),
+    addr_(addr),
+    numBytes_(numBytes)
+  {}
+
+  //----------------------------------------------------------------
+  // MappedFileStorage::Receipt::position
+  //
+  uint64
+  MappedFileStorage::Receipt::position() const
+  {
+    return addr_;
+  }
+
+  //----------------------------------------------------------------
+  // MappedFileStorage::Receipt::numBytes
+  //
+  uint64
+  MappedFileStorage::Receipt::numBytes() const
+  {
+    return numBytes_;
+  }
+
+  //----------------------------------------------------------------
+  // MappedFileStorage::Receipt::setNumBytes
+  //
+  MappedFileStorage::Receipt &
+  MappedFileStorage::Receipt::setNumBytes(uint64 numBytes)
+  {
+    numBytes_ = numBytes;
+    return *this;
+  }
+
+  //----------------------------------------------------------------
+  // MappedFileStorage::Receipt::add
+  //
+  MappedFileStorage::Receipt &
+  MappedFileStorage::Receipt::add(uint64 numBytes)
+  {
+    numBytes_ += numBytes;
+    return *this;
+  }
+
+  //----------------------------------------------------------------
+  // MappedFileStorage::Receipt::save
+  //
+  bool
+  MappedFileStorage::Receipt::save(const unsigned char * data,
+                                   std::size_t size)
+  {
+    (void) data;
+    (void) size;
+    return false;
+  }
+
+  //----------------------------------------------------------------
+  // MappedFileStorage::Receipt::load
+  //
+  bool
+  MappedFileStorage::Receipt::load(unsigned char * data)
+  {
+    if (addr_ + numBytes_ > file_->size())
+    {
+      return false;
+    }
+
+    memcpy(data, file_->data() + addr_, (std::size_t)numBytes_);
+    return true;
+  }
+
+  //----------------------------------------------------------------
+  // MappedFileStorage::Receipt::calcCrc32
+  //
+  bool
+  MappedFileStorage::Receipt::calcCrc32(Crc32 & computeCrc32,
+                                        const IReceiptPtr & skip)
+  {
+    return Yamka::calcCrc32<MappedFile>(*file_, this, skip, computeCrc32);
+  }
+
+  //----------------------------------------------------------------
+  // MappedFileStorage::Receipt::receipt
+  //
+  IStorage::IReceiptPtr
+  MappedFileStorage::Receipt::receipt(uint64 offset, uint64 size) const
+  {
+    if (offset + size > numBytes_)
+    {
+      assert(false);
+      return IStorage::IReceiptPtr();
+    }
+
+    return IStorage::IReceiptPtr(new Receipt(file_, addr_ + offset, size));
+  }
+
+  //----------------------------------------------------------------
+  // MappedFileStorage::Receipt::data
+  //
+  const unsigned char *
+  MappedFileStorage::Receipt::data() const
+  {
+    if (addr_ + numBytes_ > file_->size())
+    {
+      return NULL;
+    }
+
+    return file_->data() + addr_;
+  }
+
+
+  //----------------------------------------------------------------
+  // openReadOnlyStorage
+  //
+  IStoragePtr
+  openReadOnlyStorage(const std::string & pathUTF8,
+                      uint64 & fileSize,
+                      bool useMapping)
+  {
+    if (useMapping)
+    {
+      MappedFileStorage * mapped = new MappedFileStorage(pathUTF8);
+      IStoragePtr storage(mapped);
+
+      if (mapped->isOpen())
+      {
+        fileSize = mapped->size();
+        return storage;
+      }
+    }
+
+    FileStorage * fileStorage = new FileStorage(pathUTF8, File::kReadOnly);
+    IStoragePtr storage(fileStorage);
+
+    if (!fileStorage->file_.isOpen())
+    {
+      return IStoragePtr();
+    }
+
+    fileSize = fileStorage->file_.size();
+    return storage;
+  }
+
+}
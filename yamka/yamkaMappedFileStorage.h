@@ -0,0 +1,192 @@
+// -*- Mode: c++; tab-width: 8; c-basic-offset: 2; indent-tabs-mode: nil -*-
+// NOTE: the first line of this file sets up source code indentation rules
+// for Emacs; it is also a hint to anyone modifying this file.
+
+// Created   : Fri Oct 16 23:12:40 MDT 2026
+// Copyright : Pavel Koshevoy
+// License   : MIT -- http://www.opensource.org/licenses/mit-license.php
+
+#ifndef YAMKA_MAPPED_FILE_STORAGE_H_
+#define YAMKA_MAPPED_FILE_STORAGE_H_
+
+// yamka includes:
+#include <yamkaIStorage.h>
+#include <yamkaSharedPtr.h>
+
+// system includes:
+#include <string>
+
+
+namespace Yamka
+{
+
+  //----------------------------------------------------------------
+  // MappedFile
+  //
+  // Read-only memory mapping of an entire file.
+  //
+  class MappedFile
+  {
+  public:
+    MappedFile(const std::string & pathUTF8 = std::string());
+    ~MappedFile();
+
+    // unmap current file and map another file,
+    // returns false if the file could not be mapped
+    // (it does not exist, it is empty, it is not a regular file, etc...)
+    bool open(const std::string & pathUTF8);
+
+    // unmap the file:
+    void close();
+
+    // check whether the file is mapped:
+    inline bool isOpen() const
+    { return data_ != NULL; }
+
+    // accessor to the filename (UTF-8):
+    inline const std::string & filename() const
+    { return filename_; }
+
+    // accessor to the mapped file contents:
+    inline const unsigned char * data() const
+    { return data_; }
+
+    // accessor to the mapped file size:
+    inline uint64 size() const
+    { return size_; }
+
+    // calculate CRC-32 checksum over a region of this file:
+    bool calcCrc32(uint64 seekToPosition,
+                   uint64 numBytesToRead,
+                   Crc32 & computeCrc32) const;
+
+  private:
+    // intentionally disabled:
+    MappedFile(const MappedFile &);
+    MappedFile & operator = (const MappedFile &);
+
+    std::string filename_;
+    const unsigned char * data_;
+    uint64 size_;
+
+#ifdef _WIN32
+    void * file_;
+    void * mapping_;
+#endif
+  };
+
+  //----------------------------------------------------------------
+  // TMappedFilePtr
+  //
+  typedef TSharedPtr<MappedFile> TMappedFilePtr;
+
+  //----------------------------------------------------------------
+  // MappedFileStorage
+  //
+  // Read-only storage backed by a memory mapped file.  Loading
+  // and peeking copy straight out of the mapping, without going
+  // through the File cache and without any system calls.
+  //
+  // Storage receipts keep the mapping alive, and provide direct
+  // access to the mapped data via IReceipt::data().
+  //
+  struct MappedFileStorage : public IStorage
+  {
+    MappedFileStorage(const std::string & pathUTF8 = std::string());
+
+    // check whether the file is mapped:
+    inline bool isOpen() const
+    { return file_->isOpen(); }
+
+    // accessor to the mapped file size:
+    inline uint64 size() const
+    { return file_->size(); }
+
+    // accessor:
+    inline const TMappedFilePtr & file() const
+    { return file_; }
+
+    // virtual:
+    IReceiptPtr receipt() const;
+
+    // virtual: not supported for read-only storage:
+    IReceiptPtr save(const unsigned char * data, std::size_t size);
+
+    // virtual:
+    IReceiptPtr load(unsigned char * data, std::size_t size);
+    std::size_t peek(unsigned char * data, std::size_t size);
+    uint64      skip(uint64 numBytes);
+
+    // virtual: this will throw an exception if the seek fails:
+    void        seekTo(uint64 absolutePosition);
+
+    //----------------------------------------------------------------
+    // Receipt
+    //
+    struct Receipt : public IReceipt
+    {
+      Receipt(const TMappedFilePtr & file,
+              uint64 addr,
+              uint64 numBytes = 0);
+
+      // virtual:
+      uint64 position() const;
+
+      // virtual:
+      uint64 numBytes() const;
+
+      // virtual:
+      Receipt & setNumBytes(uint64 numBytes);
+
+      // virtual:
+      Receipt & add(uint64 numBytes);
+
+      // virtual: not supported for read-only storage:
+      bool save(const unsigned char * data, std::size_t size);
+
+      // virtual:
+      bool load(unsigned char * data);
+
+      // virtual:
+      bool calcCrc32(Crc32 & computeCrc32, const IReceiptPtr & receiptSkip);
+
+      // virtual:
+      IReceiptPtr receipt(uint64 offset, uint64 size) const;
+
+      // virtual:
+      const unsigned char * data() const;
+
+    protected:
+      TMappedFilePtr file_;
+      uint64 addr_;
+      uint64 numBytes_;
+    };
+
+  protected:
+    TMappedFilePtr file_;
+    uint64 posn_;
+  };
+
+  //----------------------------------------------------------------
+  // IStoragePtr
+  //
+  typedef TSharedPtr<IStorage> IStoragePtr;
+
+  //----------------------------------------------------------------
+  // openReadOnlyStorage
+  //
+  // memory map a given file, or fall back to FileStorage
+  // if the file can not be mapped (or useMapping is false).
+  //
+  // returns a NULL pointer if the file could not be opened at all,
+  // otherwise passes back the file size:
+  //
+  extern IStoragePtr
+  openReadOnlyStorage(const std::string & pathUTF8,
+                      uint64 & fileSize,
+                      bool useMapping = true);
+
+}
+
+
+#endif // YAMKA_MAPPED_FILE_STORAGE_H_
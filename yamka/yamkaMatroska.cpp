@@ -10,6 +10,7 @@
 #include <yamkaMatroska.h>
 #include <yamkaVersion.h>
 #include <yamkaBytes.h>
+#include <yamkaThread.h>
 
 // system includes:
 #include <string.h>
@@ -19,6 +20,7 @@
 #include <limits>
 #include <time.h>
 #include <map>
+#include <vector>
 
 
 namespace Yamka
@@ -4201,7 +4203,7 @@ namespace Yamka
     *receipt += cues_.save(storage);
     *receipt += chapters_.save(storage);
     *receipt += attachments_.save(storage);
-    *receipt += eltsSave(clusters_, storage);
+    *receipt += saveClusters(storage);
     *receipt += eltsSave(tags_, storage);
 
     // save any remaining seekheads:
@@ -4214,6 +4216,20 @@ namespace Yamka
     return receipt;
   }
 
+  //----------------------------------------------------------------
+  // Segment::saveClusters
+  //
+  IStorage::IReceiptPtr
+  Segment::saveClusters(IStorage & storage) const
+  {
+    if (delegateSaveClusters_)
+    {
+      return delegateSaveClusters_->save(*this, storage);
+    }
+
+    return eltsSave(clusters_, storage);
+  }
+
   //----------------------------------------------------------------
   // Segment::load
   //
@@ -4652,7 +4668,8 @@ namespace Yamka
   // MatroskaDoc::MatroskaDoc
   //
   MatroskaDoc::MatroskaDoc():
-    EbmlDoc("matroska", 1, 1)
+    EbmlDoc("matroska", 1, 1),
+    saveThreads_(1)
   {}
 
   //----------------------------------------------------------------
@@ -4921,224 +4938,820 @@ namespace Yamka
   };
 
   //----------------------------------------------------------------
-  // MatroskaDoc::save
+  // ClusterBuffer
   //
-  IStorage::IReceiptPtr
-  MatroskaDoc::save(IStorage & storage) const
+  // In-memory image of a Cluster that is going to be stored
+  // at a known storage position.  Receipts into the buffer report
+  // positions in the destination storage, and once the buffer
+  // has been written out they forward to the destination receipt.
+  //
+  struct ClusterBuffer
   {
-    IStorage::IReceiptPtr receipt = EbmlDoc::head_.save(storage);
-
-    // shortcut:
-    MatroskaDoc & nonConst = const_cast<MatroskaDoc &>(*this);
+    ClusterBuffer(uint64 position):
+      position_(position)
+    {}
 
-    // discard previous storage receipts:
+    // calculate CRC-32 checksum over a region of the buffer,
+    // same as File::calcCrc32 -- for use with Yamka::calcCrc32:
+    bool calcCrc32(uint64 seekToPosition,
+                   uint64 numBytesToRead,
+                   Crc32 & computeCrc32) const
     {
-      DiscardReceipts crawler;
-      nonConst.eval(crawler);
-    }
+      if (!numBytesToRead)
+      {
+        return true;
+      }
 
-    // reset max number of bytes required to store VEltPosition:
-    {
-      ResetReferences crawler;
-      nonConst.eval(crawler);
+      if (seekToPosition < position_ ||
+          seekToPosition + numBytesToRead > position_ + bytes_.size())
+      {
+        return false;
+      }
+
+      computeCrc32.compute(&bytes_[0] + (seekToPosition - position_),
+                           (std::size_t)numBytesToRead);
+      return true;
     }
 
-    // save using NullStorage to estimate reference position sizes:
-    NullStorage nullStorage(storage.receipt()->position());
-    eltsSave(segments_, nullStorage);
+    // destination storage position of the first buffered byte:
+    uint64 position_;
 
-    // reduce number of bytes required to store VEltPosition:
-    {
-      OptimizeReferences crawler;
-      nonConst.eval(crawler);
-    }
+    // buffered bytes, released once they are written out:
+    TByteVec bytes_;
 
-    // recalculate Cluster PrevSize:
+    // destination storage receipt, once written out:
+    IStorage::IReceiptPtr written_;
+  };
+
+  //----------------------------------------------------------------
+  // TClusterBufferPtr
+  //
+  typedef TSharedPtr<ClusterBuffer> TClusterBufferPtr;
+
+  //----------------------------------------------------------------
+  // ClusterBufferStorage
+  //
+  struct ClusterBufferStorage : public IStorage
+  {
+    ClusterBufferStorage(const TClusterBufferPtr & buffer):
+      buffer_(buffer)
+    {}
+
+    // virtual:
+    IReceiptPtr receipt() const
     {
-      RecalculateClusterPrevSize crawler;
-      nonConst.eval(crawler);
+      return IReceiptPtr(new Receipt(buffer_, buffer_->bytes_.size()));
     }
 
-    // discard NullStorage receipts:
+    // virtual:
+    IReceiptPtr save(const unsigned char * data, std::size_t size)
     {
-      DiscardReceipts crawler;
-      nonConst.eval(crawler);
+      IReceiptPtr receipt = this->receipt();
+      buffer_->bytes_.insert(buffer_->bytes_.end(), data, data + size);
+      receipt->add(size);
+      return receipt;
     }
 
-    // save the segments, for real this time:
-    *receipt += eltsSave(segments_, storage);
+    // virtual: not supported, the buffer is write-only:
+    IReceiptPtr load(unsigned char *, std::size_t)
+    { return IReceiptPtr(); }
 
-    // rewrite element position references (second pass):
+    // virtual: not supported, the buffer is write-only:
+    std::size_t peek(unsigned char *, std::size_t)
+    { return 0; }
+
+    // virtual:
+    uint64 skip(uint64 numBytes)
     {
-      RewriteReferences crawler;
-      nonConst.eval(crawler);
+      buffer_->bytes_.resize(buffer_->bytes_.size() +
+                             (std::size_t)numBytes);
+      return numBytes;
     }
 
-    // replace CRC-32 placeholders (final pass):
+    //----------------------------------------------------------------
+    // Receipt
+    //
+    struct Receipt : public IReceipt
     {
-      ReplaceCrc32Placeholders crawler;
-      nonConst.eval(crawler);
-    }
+      Receipt(const TClusterBufferPtr & buffer,
+              uint64 addr,
+              uint64 numBytes = 0):
+        buffer_(buffer),
+        addr_(addr),
+        numBytes_(numBytes)
+      {}
+
+      // virtual:
+      uint64 position() const
+      { return buffer_->position_ + addr_; }
+
+      // virtual:
+      uint64 numBytes() const
+      { return numBytes_; }
+
+      // virtual:
+      Receipt & setNumBytes(uint64 numBytes)
+      {
+        numBytes_ = numBytes;
+        return *this;
+      }
 
-    return receipt;
-  }
+      // virtual:
+      Receipt & add(uint64 numBytes)
+      {
+        numBytes_ += numBytes;
+        return *this;
+      }
 
-  //----------------------------------------------------------------
-  // MatroskaDoc::load
-  //
-  uint64
-  MatroskaDoc::load(IStorage & storage,
-                    uint64 bytesToRead,
-                    IDelegateLoad * loader)
-  {
-    uint64 bytesReadTotal = loadAndKeepReceipts(storage, bytesToRead, loader);
+      // virtual:
+      bool save(const unsigned char * data, std::size_t size)
+      {
+        if (buffer_->written_)
+        {
+          IReceiptPtr dst = buffer_->written_->receipt(addr_, size);
+          if (!dst || !dst->save(data, size))
+          {
+            return false;
+          }
+        }
+        else if (addr_ + size <= buffer_->bytes_.size())
+        {
+          memcpy(&buffer_->bytes_[0] + addr_, data, size);
+        }
+        else
+        {
+          return false;
+        }
 
-    // discard loaded storage receipts so they wouldn't screw up saving later:
-    discardReceipts();
+        numBytes_ = std::max<uint64>(numBytes_, size);
+        return true;
+      }
 
-    return bytesReadTotal;
-  }
+      // virtual:
+      bool load(unsigned char * data)
+      {
+        if (buffer_->written_)
+        {
+          IReceiptPtr src = buffer_->written_->receipt(addr_, numBytes_);
+          return src && src->load(data);
+        }
 
-  //----------------------------------------------------------------
-  // MatroskaDoc::loadAndKeepReceipts
-  //
-  uint64
-  MatroskaDoc::loadAndKeepReceipts(IStorage & storage,
-                                   uint64 bytesToRead,
-                                   IDelegateLoad * loader)
-  {
-    // let the base class load the EBML header:
-    uint64 bytesReadTotal = EbmlDoc::load(storage, bytesToRead, loader);
-    bytesToRead -= bytesReadTotal;
+        if (addr_ + numBytes_ > buffer_->bytes_.size())
+        {
+          return false;
+        }
 
-    // read Segments:
-    while (true)
-    {
-      uint64 prevBytesToRead = bytesToRead;
+        if (numBytes_)
+        {
+          memcpy(data, &buffer_->bytes_[0] + addr_, (std::size_t)numBytes_);
+        }
 
-      bytesToRead -= eltsLoad(segments_, storage, bytesToRead, loader);
+        return true;
+      }
 
-      uint64 bytesRead = prevBytesToRead - bytesToRead;
-      bytesReadTotal += bytesRead;
+      // virtual:
+      bool calcCrc32(Crc32 & computeCrc32, const IReceiptPtr & receiptSkip)
+      {
+        if (buffer_->written_)
+        {
+          IReceiptPtr src = buffer_->written_->receipt(addr_, numBytes_);
+          return src && src->calcCrc32(computeCrc32, receiptSkip);
+        }
 
-      if (!bytesRead)
+        return Yamka::calcCrc32<ClusterBuffer>(*buffer_,
+                                               this,
+                                               receiptSkip,
+                                               computeCrc32);
+      }
+
+      // virtual:
+      IReceiptPtr receipt(uint64 offset, uint64 size) const
       {
-        break;
+        if (offset + size > numBytes_)
+        {
+          assert(false);
+          return IReceiptPtr();
+        }
+
+        return IReceiptPtr(new Receipt(buffer_, addr_ + offset, size));
       }
-    }
 
-    // resolve positional references (seeks, cues, clusters, etc...):
-    resolveReferences();
+      // virtual:
+      const unsigned char * data() const
+      {
+        if (buffer_->written_)
+        {
+          const unsigned char * dst = buffer_->written_->data();
+          return dst ? dst + addr_ : NULL;
+        }
 
-    return bytesReadTotal;
-  }
+        if (addr_ + numBytes_ > buffer_->bytes_.size() ||
+            buffer_->bytes_.empty())
+        {
+          return NULL;
+        }
 
-  //----------------------------------------------------------------
-  // MatroskaDoc::discardReceipts
-  //
-  void
-  MatroskaDoc::discardReceipts()
-  {
-    DiscardReceipts crawler;
-    eval(crawler);
-  }
+        return &buffer_->bytes_[0] + addr_;
+      }
+
+    protected:
+      TClusterBufferPtr buffer_;
+      uint64 addr_;
+      uint64 numBytes_;
+    };
+
+  protected:
+    TClusterBufferPtr buffer_;
+  };
 
   //----------------------------------------------------------------
-  // MatroskaDoc::resolveReferences
+  // OriginPlaceholder
   //
-  void
-  MatroskaDoc::resolveReferences()
+  // Stands in for the origin of the Cluster Position reference
+  // (the Segment) while a Cluster is saved on a worker thread,
+  // so that the worker does not touch the Segment storage receipt.
+  //
+  struct OriginPlaceholder : public IElement
   {
-    // shortcut:
-    typedef std::list<TSegment>::iterator TSegmentIter;
+    OriginPlaceholder(uint64 payloadPosition = 0):
+      payloadPosition_(payloadPosition)
+    {}
 
-    for (TSegmentIter i = segments_.begin(); i != segments_.end(); ++i)
+    // virtual:
+    uint64 getId() const
+    { return 0; }
+
+    // virtual:
+    const char * getName() const
+    { return "OriginPlaceholder"; }
+
+    // virtual:
+    const IPayload & getPayload() const
+    { return payload_; }
+
+    // virtual:
+    IPayload & getPayload()
+    { return payload_; }
+
+    // virtual:
+    IStorage::IReceiptPtr payloadReceipt() const
     {
-      TSegment & segment = *i;
-      segment.payload_.resolveReferences(&segment);
+      return IStorage::IReceiptPtr
+        (new NullStorage::Receipt(payloadPosition_));
     }
-  }
+
+    uint64 payloadPosition_;
+    VVoid payload_;
+  };
 
   //----------------------------------------------------------------
-  // SeekHeadReader
+  // CanSaveConcurrently
   //
-  // load everything up-to and including the first seekhead,
-  // skip the rest until the end of the segment.
+  // Check whether a Cluster can be saved on a worker thread:
+  // all of its block data must be directly addressable (so that
+  // loading it does not touch a shared File or shared storage
+  // state), and the only positional reference it may contain
+  // is its own Position.
   //
-  struct SeekHeadReader : public IDelegateLoad
+  struct CanSaveConcurrently : public IElementCrawler
   {
-    bool loadedSeekHead_;
-
-    SeekHeadReader():
-      loadedSeekHead_(false)
+    CanSaveConcurrently(const Segment::TCluster & cluster):
+      cluster_(cluster),
+      result_(true)
     {}
 
-    // virtual:
-    uint64 load(IStorage & storage,
-                uint64 payloadBytesToRead,
-                uint64 eltId,
-                IPayload & payload)
+    static bool isAddressable(const HodgePodge & data)
     {
-      if (loadedSeekHead_)
+      typedef std::deque<IStorage::IReceiptPtr>::const_iterator TIter;
+      for (TIter i = data.receipts_.begin(); i != data.receipts_.end(); ++i)
       {
-        storage.skip(payloadBytesToRead);
-        return payloadBytesToRead;
+        const IStorage::IReceiptPtr & receipt = *i;
+        if (receipt->numBytes() && !receipt->data())
+        {
+          return false;
+        }
       }
 
-      if (eltId != MatroskaDoc::TSegment::kId)
+      return true;
+    }
+
+    // virtual:
+    bool evalPayload(IPayload & payload)
+    {
+      const VBinary * binary = dynamic_cast<VBinary *>(&payload);
+      if (binary && !(isAddressable(binary->data_) &&
+                      isAddressable(binary->dataDefault_)))
       {
-        // let the generic load mechanism handle it:
-        return 0;
+        result_ = false;
+        return true;
       }
 
-      // skip/postpone reading the cluster (to shorten file load time):
-      Segment & segment = dynamic_cast<Segment &>(payload);
-
-      uint64 bytesRead = eltsLoad(segment.seekHeads_,
-                                  storage,
-                                  payloadBytesToRead,
-                                  NULL);
-      if (bytesRead)
+      const VEltPosition * eltRef = dynamic_cast<VEltPosition *>(&payload);
+      if (eltRef && (eltRef != &cluster_.payload_.position_.payload_ ||
+                     (eltRef->getElt() && eltRef->getElt() != &cluster_)))
       {
-        loadedSeekHead_ = true;
+        result_ = false;
+        return true;
       }
 
-      return bytesRead;
+      bool done = payload.eval(*this);
+      return done;
     }
+
+    const Segment::TCluster & cluster_;
+    bool result_;
   };
 
   //----------------------------------------------------------------
-  // MatroskaDoc::loadSeekHead
+  // ParallelClusterWriter
   //
-  bool
-  MatroskaDoc::loadSeekHead(IStorage & storage,
-                            uint64 bytesToRead)
+  // Saves Segment Clusters in batches: the position of every Cluster
+  // in the batch is found by saving the batch to NullStorage first,
+  // then the Clusters are encoded concurrently into ClusterBuffers
+  // (CRC-32 checksums included) and the buffers are written out
+  // in order.  Clusters that can not be saved concurrently
+  // are saved directly to the storage, in order.
+  //
+  struct ParallelClusterWriter : public Segment::IDelegateSaveClusters
   {
-    typedef std::list<TSegment>::iterator TSegmentIter;
-    segments_.clear();
+    // batch size limits, per thread:
+    enum
+    {
+      kClustersPerThread = 8,
+      kBytesPerThread = 16 << 20
+    };
+
+    //----------------------------------------------------------------
+    // Job
+    //
+    struct Job
+    {
+      Job(const Segment::TCluster * cluster = NULL):
+        cluster_(cluster),
+        concurrent_(false)
+      {}
+
+      const Segment::TCluster * cluster_;
+      bool concurrent_;
+      OriginPlaceholder origin_;
+      TClusterBufferPtr buffer_;
+      IStorage::IReceiptPtr receipt_;
+    };
+
+    //----------------------------------------------------------------
+    // Worker
+    //
+    // every numWorkers-th concurrent job, starting at the given index:
+    //
+    struct Worker
+    {
+      std::vector<Job *> * jobs_;
+      std::size_t first_;
+      std::size_t stride_;
+    };
 
-    SeekHeadReader seekHeadLoader;
-    uint64 bytesRead = loadAndKeepReceipts(storage,
-                                           bytesToRead,
-                                           &seekHeadLoader);
+    ParallelClusterWriter(std::size_t numThreads):
+      numThreads_(std::max<std::size_t>(1, numThreads))
+    {}
 
-    bool ok = false;
-    for (TSegmentIter i = segments_.begin(); i != segments_.end() && !ok; ++i)
+    //----------------------------------------------------------------
+    // encode
+    //
+    // save the job Cluster into the job buffer:
+    //
+    static void encode(Job & job)
     {
-      TSegment & segment = *i;
-      if (!segment.payload_.seekHeads_.empty())
+      Segment::TCluster & cluster =
+        const_cast<Segment::TCluster &>(*job.cluster_);
+
+      VEltPosition & clusterRef = cluster.payload_.position_.payload_;
+      const IElement * origin = clusterRef.getOrigin();
+      if (origin)
       {
-        ok = true;
+        clusterRef.setOrigin(&job.origin_);
+      }
+
+      ClusterBufferStorage storage(job.buffer_);
+      job.receipt_ = cluster.save(storage);
+      clusterRef.setOrigin(origin);
+
+      if (job.receipt_)
+      {
+        ReplaceCrc32Placeholders crawler;
+        crawler.eval(cluster);
       }
     }
 
-    return ok;
-  }
+    //----------------------------------------------------------------
+    // work
+    //
+    static void work(void * context)
+    {
+      Worker * worker = (Worker *)context;
+      std::vector<Job *> & jobs = *(worker->jobs_);
 
-  //----------------------------------------------------------------
-  // MatroskaDoc::loadViaSeekHead
-  //
-  bool
+      for (std::size_t i = worker->first_;
+           i < jobs.size(); i += worker->stride_)
+      {
+        encode(*(jobs[i]));
+      }
+    }
+
+    // virtual:
+    IStorage::IReceiptPtr
+    save(const Segment & segment, IStorage & storage)
+    {
+      if (numThreads_ < 2 || storage.isNullStorage())
+      {
+        return eltsSave(segment.clusters_, storage);
+      }
+
+      typedef std::list<Segment::TCluster>::const_iterator TClusterIter;
+      IStorage::IReceiptPtr receipt = storage.receipt();
+      TClusterIter next = segment.clusters_.begin();
+
+      while (next != segment.clusters_.end())
+      {
+        // find where each Cluster of the next batch will be stored:
+        std::list<Job> batch;
+        std::vector<Job *> concurrent;
+        uint64 batchBytes = 0;
+
+        NullStorage nullStorage(storage.receipt()->position());
+        while (next != segment.clusters_.end() &&
+               batch.size() < numThreads_ * kClustersPerThread &&
+               batchBytes < uint64(numThreads_) * kBytesPerThread)
+        {
+          const Segment::TCluster & cluster = *next;
+          ++next;
+
+          batch.push_back(Job(&cluster));
+          Job & job = batch.back();
+
+          uint64 position = nullStorage.receipt()->position();
+          IStorage::IReceiptPtr estimate = cluster.save(nullStorage);
+          uint64 numBytes = estimate ? estimate->numBytes() : 0;
+          batchBytes += numBytes;
+
+          CanSaveConcurrently check(cluster);
+          check.eval(const_cast<Segment::TCluster &>(cluster));
+          job.concurrent_ = numBytes && check.result_;
+
+          if (job.concurrent_)
+          {
+            const IElement * origin =
+              cluster.payload_.position_.payload_.getOrigin();
+
+            IStorage::IReceiptPtr originReceipt =
+              origin ? origin->payloadReceipt() : IStorage::IReceiptPtr();
+
+            job.origin_.payloadPosition_ =
+              originReceipt ? originReceipt->position() : 0;
+
+            job.buffer_ = TClusterBufferPtr(new ClusterBuffer(position));
+            job.buffer_->bytes_.reserve((std::size_t)numBytes);
+            concurrent.push_back(&job);
+          }
+        }
+
+        // encode concurrently, this thread takes a share too:
+        std::size_t numWorkers = std::min(numThreads_, concurrent.size());
+        std::vector<Worker> workers(numWorkers);
+        Thread * threads = numWorkers ? new Thread[numWorkers] : NULL;
+
+        for (std::size_t i = 0; i < numWorkers; i++)
+        {
+          workers[i].jobs_ = &concurrent;
+          workers[i].first_ = i;
+          workers[i].stride_ = numWorkers;
+
+          if (i && !threads[i].start(&work, &workers[i]))
+          {
+            // could not start a thread, do it here instead:
+            work(&workers[i]);
+          }
+        }
+
+        if (numWorkers)
+        {
+          work(&workers[0]);
+        }
+
+        // wait for the workers:
+        delete [] threads;
+
+        // write out the batch, in order:
+        for (std::list<Job>::iterator i = batch.begin(); i != batch.end(); ++i)
+        {
+          Job & job = *i;
+
+          if (!job.concurrent_)
+          {
+            *receipt += job.cluster_->save(storage);
+            continue;
+          }
+
+          if (!job.receipt_)
+          {
+            // encoding failed:
+            return IStorage::IReceiptPtr();
+          }
+
+          ClusterBuffer & buffer = *(job.buffer_);
+          assert(buffer.position_ == storage.receipt()->position());
+
+          buffer.written_ = Yamka::save(storage, buffer.bytes_);
+          if (!buffer.written_)
+          {
+            return buffer.written_;
+          }
+
+          TByteVec().swap(buffer.bytes_);
+          *receipt += buffer.written_;
+        }
+      }
+
+      return receipt;
+    }
+
+    std::size_t numThreads_;
+  };
+
+  //----------------------------------------------------------------
+  // ReplaceCrc32PlaceholdersOutsideClusterBuffers
+  //
+  // Cluster CRC-32 checksums calculated by ParallelClusterWriter
+  // workers are already in place, skip those clusters:
+  //
+  struct ReplaceCrc32PlaceholdersOutsideClusterBuffers :
+    public ReplaceCrc32Placeholders
+  {
+    // virtual:
+    bool eval(IElement & elt)
+    {
+      const IStorage::IReceipt * receipt = elt.storageReceipt().get();
+      if (dynamic_cast<const ClusterBufferStorage::Receipt *>(receipt))
+      {
+        return false;
+      }
+
+      return ReplaceCrc32Placeholders::eval(elt);
+    }
+  };
+
+  //----------------------------------------------------------------
+  // MatroskaDoc::save
+  //
+  IStorage::IReceiptPtr
+  MatroskaDoc::save(IStorage & storage) const
+  {
+    IStorage::IReceiptPtr receipt = EbmlDoc::head_.save(storage);
+
+    // shortcut:
+    MatroskaDoc & nonConst = const_cast<MatroskaDoc &>(*this);
+
+    // discard previous storage receipts:
+    {
+      DiscardReceipts crawler;
+      nonConst.eval(crawler);
+    }
+
+    // reset max number of bytes required to store VEltPosition:
+    {
+      ResetReferences crawler;
+      nonConst.eval(crawler);
+    }
+
+    // save using NullStorage to estimate reference position sizes:
+    NullStorage nullStorage(storage.receipt()->position());
+    eltsSave(segments_, nullStorage);
+
+    // reduce number of bytes required to store VEltPosition:
+    {
+      OptimizeReferences crawler;
+      nonConst.eval(crawler);
+    }
+
+    // recalculate Cluster PrevSize:
+    {
+      RecalculateClusterPrevSize crawler;
+      nonConst.eval(crawler);
+    }
+
+    // discard NullStorage receipts:
+    {
+      DiscardReceipts crawler;
+      nonConst.eval(crawler);
+    }
+
+    // shortcut:
+    typedef std::list<TSegment>::const_iterator TSegmentIter;
+
+    std::size_t numThreads =
+      saveThreads_ ? saveThreads_ : Thread::hardwareConcurrency();
+
+    if (numThreads > 1)
+    {
+      for (TSegmentIter i = segments_.begin(); i != segments_.end(); ++i)
+      {
+        const TSegment & segment = *i;
+        segment.payload_.delegateSaveClusters_.
+          reset(new ParallelClusterWriter(numThreads));
+      }
+    }
+
+    // save the segments, for real this time:
+    *receipt += eltsSave(segments_, storage);
+
+    if (numThreads > 1)
+    {
+      for (TSegmentIter i = segments_.begin(); i != segments_.end(); ++i)
+      {
+        const TSegment & segment = *i;
+        segment.payload_.delegateSaveClusters_.reset(NULL);
+      }
+    }
+
+    // rewrite element position references (second pass):
+    {
+      RewriteReferences crawler;
+      nonConst.eval(crawler);
+    }
+
+    // replace CRC-32 placeholders (final pass):
+    {
+      ReplaceCrc32PlaceholdersOutsideClusterBuffers crawler;
+      nonConst.eval(crawler);
+    }
+
+    return receipt;
+  }
+
+  //----------------------------------------------------------------
+  // MatroskaDoc::setSaveThreads
+  //
+  void
+  MatroskaDoc::setSaveThreads(std::size_t numThreads)
+  {
+    saveThreads_ = numThreads;
+  }
+
+  //----------------------------------------------------------------
+  // MatroskaDoc::load
+  //
+  uint64
+  MatroskaDoc::load(IStorage & storage,
+                    uint64 bytesToRead,
+                    IDelegateLoad * loader)
+  {
+    uint64 bytesReadTotal = loadAndKeepReceipts(storage, bytesToRead, loader);
+
+    // discard loaded storage receipts so they wouldn't screw up saving later:
+    discardReceipts();
+
+    return bytesReadTotal;
+  }
+
+  //----------------------------------------------------------------
+  // MatroskaDoc::loadAndKeepReceipts
+  //
+  uint64
+  MatroskaDoc::loadAndKeepReceipts(IStorage & storage,
+                                   uint64 bytesToRead,
+                                   IDelegateLoad * loader)
+  {
+    // let the base class load the EBML header:
+    uint64 bytesReadTotal = EbmlDoc::load(storage, bytesToRead, loader);
+    bytesToRead -= bytesReadTotal;
+
+    // read Segments:
+    while (true)
+    {
+      uint64 prevBytesToRead = bytesToRead;
+
+      bytesToRead -= eltsLoad(segments_, storage, bytesToRead, loader);
+
+      uint64 bytesRead = prevBytesToRead - bytesToRead;
+      bytesReadTotal += bytesRead;
+
+      if (!bytesRead)
+      {
+        break;
+      }
+    }
+
+    // resolve positional references (seeks, cues, clusters, etc...):
+    resolveReferences();
+
+    return bytesReadTotal;
+  }
+
+  //----------------------------------------------------------------
+  // MatroskaDoc::discardReceipts
+  //
+  void
+  MatroskaDoc::discardReceipts()
+  {
+    DiscardReceipts crawler;
+    eval(crawler);
+  }
+
+  //----------------------------------------------------------------
+  // MatroskaDoc::resolveReferences
+  //
+  void
+  MatroskaDoc::resolveReferences()
+  {
+    // shortcut:
+    typedef std::list<TSegment>::iterator TSegmentIter;
+
+    for (TSegmentIter i = segments_.begin(); i != segments_.end(); ++i)
+    {
+      TSegment & segment = *i;
+      segment.payload_.resolveReferences(&segment);
+    }
+  }
+
+  //----------------------------------------------------------------
+  // SeekHeadReader
+  //
+  // load everything up-to and including the first seekhead,
+  // skip the rest until the end of the segment.
+  //
+  struct SeekHeadReader : public IDelegateLoad
+  {
+    bool loadedSeekHead_;
+
+    SeekHeadReader():
+      loadedSeekHead_(false)
+    {}
+
+    // virtual:
+    uint64 load(IStorage & storage,
+                uint64 payloadBytesToRead,
+                uint64 eltId,
+                IPayload & payload)
+    {
+      if (loadedSeekHead_)
+      {
+        storage.skip(payloadBytesToRead);
+        return payloadBytesToRead;
+      }
+
+      if (eltId != MatroskaDoc::TSegment::kId)
+      {
+        // let the generic load mechanism handle it:
+        return 0;
+      }
+
+      // skip/postpone reading the cluster (to shorten file load time):
+      Segment & segment = dynamic_cast<Segment &>(payload);
+
+      uint64 bytesRead = eltsLoad(segment.seekHeads_,
+                                  storage,
+                                  payloadBytesToRead,
+                                  NULL);
+      if (bytesRead)
+      {
+        loadedSeekHead_ = true;
+      }
+
+      return bytesRead;
+    }
+  };
+
+  //----------------------------------------------------------------
+  // MatroskaDoc::loadSeekHead
+  //
+  bool
+  MatroskaDoc::loadSeekHead(IStorage & storage,
+                            uint64 bytesToRead)
+  {
+    typedef std::list<TSegment>::iterator TSegmentIter;
+    segments_.clear();
+
+    SeekHeadReader seekHeadLoader;
+    uint64 bytesRead = loadAndKeepReceipts(storage,
+                                           bytesToRead,
+                                           &seekHeadLoader);
+
+    bool ok = false;
+    for (TSegmentIter i = segments_.begin(); i != segments_.end() && !ok; ++i)
+    {
+      TSegment & segment = *i;
+      if (!segment.payload_.seekHeads_.empty())
+      {
+        ok = true;
+      }
+    }
+
+    return ok;
+  }
+
+  //----------------------------------------------------------------
+  // MatroskaDoc::loadViaSeekHead
+  //
+  bool
   MatroskaDoc::loadViaSeekHead(IStorage & storage,
                                IDelegateLoad * loader,
                                bool loadClusters)
@@ -5177,6 +5790,428 @@ namespace Yamka
     }
   }
 
+  //----------------------------------------------------------------
+  // MatroskaDoc::loadStreaming
+  //
+  uint64
+  MatroskaDoc::loadStreaming(IStorage & storage,
+                             uint64 bytesToRead,
+                             IStreamVisitor & visitor,
+                             IDelegateLoad * loader)
+  {
+    StreamLoader streamLoader(visitor, loader);
+
+    // let the base class load the EBML header:
+    uint64 bytesReadTotal = EbmlDoc::load(storage, bytesToRead, loader);
+    bytesToRead -= bytesReadTotal;
+
+    // read Segments:
+    while (bytesToRead && !streamLoader.stopped())
+    {
+      segments_.push_back(TSegment());
+      TSegment & segment = segments_.back();
+
+      uint64 bytesRead = streamLoader.loadSegment(segment,
+                                                  storage,
+                                                  bytesToRead);
+      if (!bytesRead)
+      {
+        if (!streamLoader.stopped())
+        {
+          segments_.pop_back();
+        }
+
+        break;
+      }
+
+      bytesToRead -= bytesRead;
+      bytesReadTotal += bytesRead;
+    }
+
+    return bytesReadTotal;
+  }
+
+  //----------------------------------------------------------------
+  // MatroskaDoc::IStreamVisitor::beginSegment
+  //
+  bool
+  MatroskaDoc::IStreamVisitor::beginSegment(TSegment &)
+  {
+    return true;
+  }
+
+  //----------------------------------------------------------------
+  // MatroskaDoc::IStreamVisitor::element
+  //
+  bool
+  MatroskaDoc::IStreamVisitor::element(TSegment &, IElement &)
+  {
+    return true;
+  }
+
+  //----------------------------------------------------------------
+  // MatroskaDoc::IStreamVisitor::block
+  //
+  bool
+  MatroskaDoc::IStreamVisitor::block(TSegment &,
+                                     Segment::TCluster & cluster,
+                                     IElement & block)
+  {
+    cluster.payload_.blocks_.push_back(block);
+    return true;
+  }
+
+  //----------------------------------------------------------------
+  // MatroskaDoc::IStreamVisitor::cluster
+  //
+  bool
+  MatroskaDoc::IStreamVisitor::cluster(TSegment &, Segment::TCluster &)
+  {
+    return true;
+  }
+
+  //----------------------------------------------------------------
+  // MatroskaDoc::IStreamVisitor::endSegment
+  //
+  bool
+  MatroskaDoc::IStreamVisitor::endSegment(TSegment &)
+  {
+    return true;
+  }
+
+
+  //----------------------------------------------------------------
+  // StreamLoader::StreamLoader
+  //
+  StreamLoader::StreamLoader(MatroskaDoc::IStreamVisitor & visitor,
+                             IDelegateLoad * loader):
+    visitor_(visitor),
+    loader_(loader),
+    segment_(NULL),
+    cluster_(NULL),
+    beginSegment_(false),
+    stopped_(false)
+  {}
+
+  //----------------------------------------------------------------
+  // StreamLoader::loadSegment
+  //
+  uint64
+  StreamLoader::loadSegment(MatroskaDoc::TSegment & segment,
+                            IStorage & storage,
+                            uint64 bytesToRead)
+  {
+    segment_ = &segment;
+    cluster_ = NULL;
+    beginSegment_ = true;
+
+    uint64 bytesRead = segment.load(storage, bytesToRead, this);
+    segment_ = NULL;
+
+    if (!bytesRead || stopped_)
+    {
+      return 0;
+    }
+
+    // resolve positional references (seeks, cues, etc...):
+    segment.payload_.resolveReferences(&segment);
+
+    if (!visitor_.endSegment(segment))
+    {
+      stopped_ = true;
+    }
+
+    return bytesRead;
+  }
+
+  //----------------------------------------------------------------
+  // StreamLoader::load
+  //
+  uint64
+  StreamLoader::load(IStorage & storage,
+                     uint64 payloadBytesToRead,
+                     uint64 eltId,
+                     IPayload & payload)
+  {
+    if (stopped_)
+    {
+      // don't read any more data:
+      return uintMax[8];
+    }
+
+    if (loader_)
+    {
+      uint64 bytesRead = loader_->load(storage,
+                                       payloadBytesToRead,
+                                       eltId,
+                                       payload);
+      if (bytesRead)
+      {
+        return bytesRead;
+      }
+    }
+
+    if (segment_ &&
+        eltId == MatroskaDoc::TSegment::kId &&
+        &payload == &(segment_->payload_))
+    {
+      if (beginSegment_)
+      {
+        beginSegment_ = false;
+
+        if (!visitor_.beginSegment(*segment_))
+        {
+          stopped_ = true;
+          return uintMax[8];
+        }
+      }
+
+      return loadSegmentChild(storage, payloadBytesToRead);
+    }
+
+    if (cluster_ &&
+        eltId == Segment::TCluster::kId &&
+        &payload == &(cluster_->payload_))
+    {
+      return loadClusterChild(storage, payloadBytesToRead);
+    }
+
+    // let the generic load mechanism handle it:
+    return 0;
+  }
+
+  //----------------------------------------------------------------
+  // StreamLoader::loaded
+  //
+  void
+  StreamLoader::loaded(IElement & elt)
+  {
+    if (loader_)
+    {
+      loader_->loaded(elt);
+    }
+  }
+
+  //----------------------------------------------------------------
+  // StreamLoader::loadSegmentChild
+  //
+  // load one level-1 element (and any Void elements after it):
+  //
+  uint64
+  StreamLoader::loadSegmentChild(IStorage & storage, uint64 bytesToRead)
+  {
+    Segment & segment = segment_->payload_;
+
+    uint64 eltId = 0;
+    {
+      IStorage::TSeek restore(storage);
+      eltId = loadEbmlId(storage);
+    }
+
+    IElement * elt = NULL;
+    uint64 bytesRead = 0;
+
+    if (eltId == Segment::TCluster::kId)
+    {
+      Segment::TCluster cluster;
+
+      cluster_ = &cluster;
+      bytesRead = cluster.load(storage, bytesToRead, this);
+      cluster_ = NULL;
+
+      if (!bytesRead)
+      {
+        return stopped_ ? uintMax[8] : 0;
+      }
+
+      if (!visitor_.cluster(*segment_, cluster))
+      {
+        stopped_ = true;
+      }
+
+      return bytesRead + skipVoids(storage, bytesToRead - bytesRead);
+    }
+
+    if (eltId == Segment::TSeekHead::kId)
+    {
+      segment.seekHeads_.push_back(Segment::TSeekHead());
+      elt = &(segment.seekHeads_.back());
+      bytesRead = elt->load(storage, bytesToRead, this);
+
+      if (!bytesRead)
+      {
+        segment.seekHeads_.pop_back();
+      }
+    }
+    else if (eltId == Segment::TTags::kId)
+    {
+      segment.tags_.push_back(Segment::TTags());
+      elt = &(segment.tags_.back());
+      bytesRead = elt->load(storage, bytesToRead, this);
+
+      if (!bytesRead)
+      {
+        segment.tags_.pop_back();
+      }
+    }
+    else
+    {
+      if (eltId == Segment::TInfo::kId)
+      {
+        elt = &segment.info_;
+      }
+      else if (eltId == Segment::TTracks::kId)
+      {
+        elt = &segment.tracks_;
+      }
+      else if (eltId == Segment::TCues::kId)
+      {
+        elt = &segment.cues_;
+      }
+      else if (eltId == Segment::TChapters::kId)
+      {
+        elt = &segment.chapters_;
+      }
+      else if (eltId == Segment::TAttachment::kId)
+      {
+        elt = &segment.attachments_;
+      }
+      else
+      {
+        // let the generic load mechanism handle Void, CRC-32, etc...
+        return 0;
+      }
+
+      bytesRead = elt->load(storage, bytesToRead, this);
+    }
+
+    if (!bytesRead)
+    {
+      return stopped_ ? uintMax[8] : 0;
+    }
+
+    if (!visitor_.element(*segment_, *elt))
+    {
+      stopped_ = true;
+    }
+
+    return bytesRead + skipVoids(storage, bytesToRead - bytesRead);
+  }
+
+  //----------------------------------------------------------------
+  // StreamLoader::loadClusterChild
+  //
+  // load one Cluster child element (and any Void elements after it):
+  //
+  uint64
+  StreamLoader::loadClusterChild(IStorage & storage, uint64 bytesToRead)
+  {
+    Cluster & cluster = cluster_->payload_;
+
+    uint64 eltId = 0;
+    {
+      IStorage::TSeek restore(storage);
+      eltId = loadEbmlId(storage);
+    }
+
+    if (eltId == Cluster::TSimpleBlock::kId)
+    {
+      Cluster::TSimpleBlock block;
+      return loadBlock(block, storage, bytesToRead);
+    }
+
+    if (eltId == Cluster::TBlockGroup::kId)
+    {
+      Cluster::TBlockGroup block;
+      return loadBlock(block, storage, bytesToRead);
+    }
+
+    if (eltId == Cluster::TEncryptedBlock::kId)
+    {
+      Cluster::TEncryptedBlock block;
+      return loadBlock(block, storage, bytesToRead);
+    }
+
+    IElement * elt = NULL;
+    if (eltId == Cluster::TTimecode::kId)
+    {
+      elt = &cluster.timecode_;
+    }
+    else if (eltId == Cluster::TSilent::kId)
+    {
+      elt = &cluster.silent_;
+    }
+    else if (eltId == Cluster::TPosition::kId)
+    {
+      elt = &cluster.position_;
+    }
+    else if (eltId == Cluster::TPrevSize::kId)
+    {
+      elt = &cluster.prevSize_;
+    }
+    else
+    {
+      // let the generic load mechanism handle Void, CRC-32, etc...
+      return 0;
+    }
+
+    uint64 bytesRead = elt->load(storage, bytesToRead, this);
+    if (!bytesRead)
+    {
+      return 0;
+    }
+
+    return bytesRead + skipVoids(storage, bytesToRead - bytesRead);
+  }
+
+  //----------------------------------------------------------------
+  // StreamLoader::loadBlock
+  //
+  uint64
+  StreamLoader::loadBlock(IElement & block,
+                          IStorage & storage,
+                          uint64 bytesToRead)
+  {
+    uint64 bytesRead = block.load(storage, bytesToRead, this);
+    if (!bytesRead)
+    {
+      return 0;
+    }
+
+    if (!visitor_.block(*segment_, *cluster_, block))
+    {
+      stopped_ = true;
+    }
+
+    return bytesRead + skipVoids(storage, bytesToRead - bytesRead);
+  }
+
+  //----------------------------------------------------------------
+  // StreamLoader::skipVoids
+  //
+  // Void elements are consumed and discarded here, because the generic
+  // load mechanism would try to attach them to the preceding element,
+  // which may have been discarded already:
+  //
+  uint64
+  StreamLoader::skipVoids(IStorage & storage, uint64 bytesToRead)
+  {
+    uint64 bytesRead = 0;
+    while (bytesRead < bytesToRead)
+    {
+      TVoidElt eltVoid;
+      uint64 voidSize = eltVoid.load(storage, bytesToRead - bytesRead, NULL);
+      if (!voidSize)
+      {
+        break;
+      }
+
+      bytesRead += voidSize;
+    }
+
+    return bytesRead;
+  }
+
   //----------------------------------------------------------------
   // Optimizer
   //
@@ -5304,7 +6339,7 @@ namespace Yamka
       *receipt += segment.cues_.save(storage);
       *receipt += segment.attachments_.save(storage);
       *receipt += eltsSave(segment.tags_, storage);
-      *receipt += eltsSave(segment.clusters_, storage);
+      *receipt += segment.saveClusters(storage);
 
       // save any remaining seekheads:
       for (; seekHeadIter != segment.seekHeads_.end(); ++seekHeadIter)
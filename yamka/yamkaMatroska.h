@@ -1105,6 +1105,28 @@ namespace Yamka
 
     // set this if you would like to save this segment "your way":
     mutable TSharedPtr<IDelegateSave> delegateSave_;
+
+    //----------------------------------------------------------------
+    // IDelegateSaveClusters
+    //
+    // Implement this interface if you would like to override
+    // how the Clusters of a Segment should be saved:
+    //
+    struct IDelegateSaveClusters
+    {
+      virtual ~IDelegateSaveClusters() {}
+
+      virtual IStorage::IReceiptPtr
+      save(const Segment & segment, IStorage & storage) = 0;
+    };
+
+    // save the clusters via delegateSaveClusters_, if set;
+    // IDelegateSave implementations should call this
+    // rather than saving clusters_ directly:
+    IStorage::IReceiptPtr saveClusters(IStorage & storage) const;
+
+    // MatroskaDoc::save sets this when saving with multiple threads:
+    mutable TSharedPtr<IDelegateSaveClusters> delegateSaveClusters_;
   };
 
   //----------------------------------------------------------------
@@ -1220,8 +1242,138 @@ namespace Yamka
     // remove all optional elements, optimize lacing:
     void optimize(IStorage & storageForTempData);
 
+    // Clusters are independent of each other once their positions
+    // are known, so save can encode them on multiple threads
+    // into memory buffers and write the buffers out in order.
+    // The result is byte-identical to saving with a single thread.
+    //
+    // Only Clusters whose block data is directly addressable
+    // (see IStorage::IReceipt::data -- HodgePodgeStorage,
+    // MappedFileStorage, etc...) are encoded concurrently,
+    // the rest are saved on the calling thread as usual.
+    //
+    // 1 (the default) saves everything on the calling thread,
+    // 0 uses as many threads as there are CPU cores:
+    void setSaveThreads(std::size_t numThreads);
+
+    inline std::size_t saveThreads() const
+    { return saveThreads_; }
+
+    // forward declaration:
+    struct IStreamVisitor;
+
+    // constant memory alternative to loadAndKeepReceipts:
+    //
+    // level-1 elements are loaded one at a time in storage order
+    // and handed to the visitor.  SeekHeads, Info, Tracks, Cues,
+    // Chapters, Attachments and Tags are kept in the segment,
+    // Clusters are not -- each Cluster (and each of its blocks)
+    // is discarded once the visitor is done with it.
+    //
+    // storage receipts are kept, so the storage must outlive
+    // any blocks the visitor holds on to.
+    //
+    // returns the number of bytes consumed, a segment interrupted
+    // by the visitor is kept but does not count towards the total:
+    uint64 loadStreaming(IStorage & storage,
+                         uint64 bytesToRead,
+                         IStreamVisitor & visitor,
+                         IDelegateLoad * loader = NULL);
+
     TypedefYamkaElt(Segment, 0x18538067, "Segment") TSegment;
     std::list<TSegment> segments_;
+
+    // number of threads used to save clusters:
+    std::size_t saveThreads_;
+
+    //----------------------------------------------------------------
+    // IStreamVisitor
+    //
+    // Implement this interface to receive level-1 elements
+    // and cluster blocks as they are loaded by loadStreaming.
+    //
+    // Return false from any of these to stop loading.
+    //
+    struct IStreamVisitor
+    {
+      virtual ~IStreamVisitor() {}
+
+      // a segment is about to be loaded, only its storage receipt
+      // and payload position are valid at this point:
+      virtual bool beginSegment(TSegment & segment);
+
+      // a level-1 element other than a Cluster (SeekHead, Info,
+      // Tracks, Cues, etc...) has been loaded into the segment:
+      virtual bool element(TSegment & segment, IElement & elt);
+
+      // a BlockGroup, SimpleBlock or EncryptedBlock has been loaded.
+      // The Cluster Timecode, SilentTracks, Position and PrevSize
+      // preceding the block are already loaded into the cluster.
+      //
+      // The block is discarded after this call, unless it is added
+      // to the cluster -- which is what the default implementation
+      // does, so that cluster(...) would see the whole Cluster:
+      virtual bool block(TSegment & segment,
+                         Segment::TCluster & cluster,
+                         IElement & block);
+
+      // a Cluster has been loaded, it will be discarded after this call:
+      virtual bool cluster(TSegment & segment, Segment::TCluster & cluster);
+
+      // the segment has been loaded, its positional references
+      // (except those that refer to Clusters) have been resolved:
+      virtual bool endSegment(TSegment & segment);
+    };
+  };
+
+  //----------------------------------------------------------------
+  // StreamLoader
+  //
+  // A load delegate that streams Segment and Cluster payloads
+  // one child element at a time to a MatroskaDoc::IStreamVisitor,
+  // see MatroskaDoc::loadStreaming.
+  //
+  // An optional nested delegate (progress reporting, skipping
+  // Cluster payloads, etc...) gets the first shot at every element.
+  //
+  struct StreamLoader : public IDelegateLoad
+  {
+    StreamLoader(MatroskaDoc::IStreamVisitor & visitor,
+                 IDelegateLoad * loader = NULL);
+
+    // load a segment, returns the number of bytes consumed,
+    // returns 0 if the segment failed to load or the visitor
+    // stopped the loading:
+    uint64 loadSegment(MatroskaDoc::TSegment & segment,
+                       IStorage & storage,
+                       uint64 bytesToRead);
+
+    // check whether the visitor stopped the loading:
+    inline bool stopped() const
+    { return stopped_; }
+
+    // virtual:
+    uint64 load(IStorage & storage,
+                uint64 payloadBytesToRead,
+                uint64 eltId,
+                IPayload & payload);
+
+    // virtual:
+    void loaded(IElement & elt);
+
+  protected:
+    // helpers:
+    uint64 loadSegmentChild(IStorage & storage, uint64 bytesToRead);
+    uint64 loadClusterChild(IStorage & storage, uint64 bytesToRead);
+    uint64 loadBlock(IElement & block, IStorage & storage, uint64 bytesToRead);
+    uint64 skipVoids(IStorage & storage, uint64 bytesToRead);
+
+    MatroskaDoc::IStreamVisitor & visitor_;
+    IDelegateLoad * loader_;
+    MatroskaDoc::TSegment * segment_;
+    Segment::TCluster * cluster_;
+    bool beginSegment_;
+    bool stopped_;
   };
 
   //----------------------------------------------------------------
@@ -247,6 +247,10 @@ namespace Yamka
         return IStorage::IReceiptPtr();
       }
 
+      // virtual:
+      const unsigned char * data() const
+      { return file_.data() + addr_; }
+
     protected:
       TFile & file_;
       uint64 addr_;
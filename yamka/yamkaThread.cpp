@@ -0,0 +1,264 @@
+// -*- Mode: c++; tab-width: 8; c-basic-offset: 2; indent-tabs-mode: nil -*-
+// NOTE: the first line of this file sets up source code indentation rules
+// for Emacs; it is also a hint to anyone modifying this file.
+
+// Created   : Sat Oct 17 14:05:31 MDT 2026
+// Copyright : Pavel Koshevoy
+// License   : MIT -- http://www.opensource.org/licenses/mit-license.php
+
+// windows includes:
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+// yamka includes:
+#include <yamkaThread.h>
+
+
+namespace Yamka
+{
+
+  //----------------------------------------------------------------
+  // TThreadContext
+  //
+  struct TThreadContext
+  {
+    Thread::TFunction function_;
+    void * context_;
+
+#ifdef _WIN32
+    HANDLE thread_;
+#else
+    pthread_t thread_;
+#endif
+  };
+
+  //----------------------------------------------------------------
+  // threadEntryPoint
+  //
+#ifdef _WIN32
+  static DWORD WINAPI
+  threadEntryPoint(LPVOID arg)
+#else
+  static void *
+  threadEntryPoint(void * arg)
+#endif
+  {
+    TThreadContext * tc = (TThreadContext *)arg;
+    tc->function_(tc->context_);
+    return 0;
+  }
+
+  //----------------------------------------------------------------
+  // Thread::Thread
+  //
+  Thread::Thread():
+    handle_(NULL)
+  {}
+
+  //----------------------------------------------------------------
+  // Thread::~Thread
+  //
+  Thread::~Thread()
+  {
+    join();
+  }
+
+  //----------------------------------------------------------------
+  // Thread::start
+  //
+  bool
+  Thread::start(TFunction function, void * context)
+  {
+    join();
+
+    TThreadContext * tc = new TThreadContext();
+    tc->function_ = function;
+    tc->context_ = context;
+
+#ifdef _WIN32
+    tc->thread_ = CreateThread(NULL, 0, &threadEntryPoint, tc, 0, NULL);
+    bool started = (tc->thread_ != NULL);
+#else
+    bool started =
+      (pthread_create(&tc->thread_, NULL, &threadEntryPoint, tc) == 0);
+#endif
+
+    if (!started)
+    {
+      delete tc;
+      return false;
+    }
+
+    handle_ = tc;
+    return true;
+  }
+
+  //----------------------------------------------------------------
+  // Thread::join
+  //
+  void
+  Thread::join()
+  {
+    TThreadContext * tc = (TThreadContext *)handle_;
+    if (!tc)
+    {
+      return;
+    }
+
+#ifdef _WIN32
+    WaitForSingleObject(tc->thread_, INFINITE);
+    CloseHandle(tc->thread_);
+#else
+    pthread_join(tc->thread_, NULL);
+#endif
+
+    delete tc;
+    handle_ = NULL;
+  }
+
+  //----------------------------------------------------------------
+  // Thread::hardwareConcurrency
+  //
+  std::size_t
+  Thread::hardwareConcurrency()
+  {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    long n = long(info.dwNumberOfProcessors);
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+
+    return (n > 0) ? std::size_t(n) : 1;
+  }
+
+
+#ifdef _WIN32
+  typedef CRITICAL_SECTION TMutexHandle;
+  typedef CONDITION_VARIABLE TConditionHandle;
+#else
+  typedef pthread_mutex_t TMutexHandle;
+  typedef pthread_cond_t TConditionHandle;
+#endif
+
+  //----------------------------------------------------------------
+  // Mutex::Mutex
+  //
+  Mutex::Mutex():
+    handle_(new TMutexHandle)
+  {
+    TMutexHandle * mutex = (TMutexHandle *)handle_;
+#ifdef _WIN32
+    InitializeCriticalSection(mutex);
+#else
+    pthread_mutex_init(mutex, NULL);
+#endif
+  }
+
+  //----------------------------------------------------------------
+  // Mutex::~Mutex
+  //
+  Mutex::~Mutex()
+  {
+    TMutexHandle * mutex = (TMutexHandle *)handle_;
+#ifdef _WIN32
+    DeleteCriticalSection(mutex);
+#else
+    pthread_mutex_destroy(mutex);
+#endif
+    delete mutex;
+  }
+
+  //----------------------------------------------------------------
+  // Mutex::lock
+  //
+  void
+  Mutex::lock()
+  {
+    TMutexHandle * mutex = (TMutexHandle *)handle_;
+#ifdef _WIN32
+    EnterCriticalSection(mutex);
+#else
+    pthread_mutex_lock(mutex);
+#endif
+  }
+
+  //----------------------------------------------------------------
+  // Mutex::unlock
+  //
+  void
+  Mutex::unlock()
+  {
+    TMutexHandle * mutex = (TMutexHandle *)handle_;
+#ifdef _WIN32
+    LeaveCriticalSection(mutex);
+#else
+    pthread_mutex_unlock(mutex);
+#endif
+  }
+
+
+  //----------------------------------------------------------------
+  // Condition::Condition
+  //
+  Condition::Condition():
+    handle_(new TConditionHandle)
+  {
+    TConditionHandle * cond = (TConditionHandle *)handle_;
+#ifdef _WIN32
+    InitializeConditionVariable(cond);
+#else
+    pthread_cond_init(cond, NULL);
+#endif
+  }
+
+  //----------------------------------------------------------------
+  // Condition::~Condition
+  //
+  Condition::~Condition()
+  {
+    TConditionHandle * cond = (TConditionHandle *)handle_;
+#ifndef _WIN32
+    pthread_cond_destroy(cond);
+#endif
+    delete cond;
+  }
+
+  //----------------------------------------------------------------
+  // Condition::wait
+  //
+  void
+  Condition::wait(Mutex & mutex)
+  {
+    TConditionHandle * cond = (TConditionHandle *)handle_;
+    TMutexHandle * m = (TMutexHandle *)(mutex.handle_);
+#ifdef _WIN32
+    SleepConditionVariableCS(cond, m, INFINITE);
+#else
+    pthread_cond_wait(cond, m);
+#endif
+  }
+
+  //----------------------------------------------------------------
+  // Condition::notifyAll
+  //
+  void
+  Condition::notifyAll()
+  {
+    TConditionHandle * cond = (TConditionHandle *)handle_;
+#ifdef _WIN32
+    WakeAllConditionVariable(cond);
+#else
+    pthread_cond_broadcast(cond);
+#endif
+  }
+
+}
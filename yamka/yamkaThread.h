@@ -0,0 +1,135 @@
+// -*- Mode: c++; tab-width: 8; c-basic-offset: 2; indent-tabs-mode: nil -*-
+// NOTE: the first line of this file sets up source code indentation rules
+// for Emacs; it is also a hint to anyone modifying this file.
+
+// Created   : Sat Oct 17 14:05:31 MDT 2026
+// Copyright : Pavel Koshevoy
+// License   : MIT -- http://www.opensource.org/licenses/mit-license.php
+
+#ifndef YAMKA_THREAD_H_
+#define YAMKA_THREAD_H_
+
+// system includes:
+#include <cstddef>
+
+
+namespace Yamka
+{
+
+  //----------------------------------------------------------------
+  // Thread
+  //
+  // Minimal fork-join thread (pthreads or Win32), just enough
+  // to fan work out and wait for it, without pulling in
+  // a threading library dependency.
+  //
+  // NOTE: yamka data structures are not thread safe (see TSharedPtr),
+  // it is up to the caller to ensure that concurrently running
+  // functions do not share any yamka objects.
+  //
+  class Thread
+  {
+    // intentionally disabled:
+    Thread(const Thread &);
+    Thread & operator = (const Thread &);
+
+  public:
+    typedef void(*TFunction)(void * context);
+
+    Thread();
+
+    // joins the thread if it is still running:
+    ~Thread();
+
+    // start executing function(context) on a new thread,
+    // returns false if the thread could not be started:
+    bool start(TFunction function, void * context);
+
+    // wait for the function to return:
+    void join();
+
+    // check whether the thread was started and not joined yet:
+    inline bool isRunning() const
+    { return handle_ != NULL; }
+
+    // number of concurrent threads supported by the hardware,
+    // 1 if it can not be determined:
+    static std::size_t hardwareConcurrency();
+
+  private:
+    void * handle_;
+  };
+
+  //----------------------------------------------------------------
+  // Mutex
+  //
+  class Mutex
+  {
+    // intentionally disabled:
+    Mutex(const Mutex &);
+    Mutex & operator = (const Mutex &);
+
+  public:
+    Mutex();
+    ~Mutex();
+
+    void lock();
+    void unlock();
+
+    //----------------------------------------------------------------
+    // Lock
+    //
+    // scoped lock:
+    //
+    class Lock
+    {
+      // intentionally disabled:
+      Lock(const Lock &);
+      Lock & operator = (const Lock &);
+
+    public:
+      Lock(Mutex & mutex):
+        mutex_(mutex)
+      { mutex_.lock(); }
+
+      ~Lock()
+      { mutex_.unlock(); }
+
+    private:
+      Mutex & mutex_;
+    };
+
+  private:
+    friend class Condition;
+    void * handle_;
+  };
+
+  //----------------------------------------------------------------
+  // Condition
+  //
+  class Condition
+  {
+    // intentionally disabled:
+    Condition(const Condition &);
+    Condition & operator = (const Condition &);
+
+  public:
+    Condition();
+    ~Condition();
+
+    // the mutex must be locked by the calling thread,
+    // it is unlocked while waiting and locked again before returning;
+    // spurious wakeups are possible, so wait in a loop:
+    void wait(Mutex & mutex);
+
+    // wake up all waiting threads:
+    void notifyAll();
+
+  private:
+    void * handle_;
+  };
+
+}
+
+
+#endif // YAMKA_THREAD_H_